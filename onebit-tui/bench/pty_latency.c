@@ -0,0 +1,824 @@
+// End-to-end latency harness for onebit-tui apps
+//
+// Runs a program under a pseudo-terminal, injects keystrokes and mouse
+// sequences from a scenario script, and feeds everything the program writes
+// through a small VT parser. A step completes when the expected text is on
+// the emulated screen after a visible update (outside any synchronized
+// output block), so the numbers include the kernel tty layer, raw-mode
+// termios handling and the app's real input path.
+//
+// Build:  cc -O2 -o pty_latency bench/pty_latency.c -lutil
+// Usage:  pty_latency [options] SCENARIO -- COMMAND [ARGS...]
+//
+//   --cols N / --rows N   terminal size (default 100x30)
+//   --iterations N        how many times the loop section runs (default 50)
+//   --timeout MS          per-step timeout (default 2000)
+//   --max-p99 MS          exit 1 if any step's p99 exceeds this (regression gate)
+//   --json                print results as JSON
+//   --dump                print the final screen to stderr
+//
+// Scenario lines (one command each, '#' starts a comment):
+//
+//   wait TEXT             block until TEXT is on screen (not measured)
+//   send BYTES            write BYTES; C escapes (\e \r \n \t \xNN) allowed
+//   key NAME              write a named key: up down left right enter tab esc
+//                         backspace home end pgup pgdn space
+//   click ROW COL         SGR mouse press+release at 1-based ROW/COL
+//   expect LABEL TEXT     measure time from the last input until TEXT shows
+//   sleep MS              pause without reading the clock
+//   loop                  lines after this repeat --iterations times
+//
+// Lines before "loop" run once (startup, navigation); lines after it are the
+// measured body. The harness answers cursor position and device attribute
+// queries so apps that probe the terminal at startup don't stall.
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pty.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_PARAMS 16
+#define MAX_STEPS 256
+#define MAX_LABELS 32
+#define MAX_TEXT 256
+
+// ---------------------------------------------------------------------------
+// VT parser
+
+typedef struct {
+    int rows, cols;
+    uint32_t* cells;       // active screen
+    uint32_t* primary;     // main screen
+    uint32_t* alternate;   // alternate screen (1049)
+    int cx, cy;            // cursor, 0-based
+    int saved_cx, saved_cy;
+    int top, bottom;       // scroll region, inclusive
+    bool pending_wrap;
+    bool sync;             // inside ?2026 synchronized update
+    uint64_t generation;   // bumped on every visible change
+
+    enum { S_GROUND, S_ESC, S_CSI, S_OSC, S_OSC_ESC, S_DCS, S_DCS_ESC, S_CHARSET } state;
+    int params[MAX_PARAMS];
+    int nparams;
+    char prefix;           // '?', '>', '<', '=' or 0
+    char intermediate;
+
+    uint32_t utf8_code;
+    int utf8_left;
+
+    int reply_fd;          // where query responses go (pty master)
+} Vt;
+
+static uint32_t* vt_cell(Vt* vt, int x, int y) {
+    return &vt->cells[y * vt->cols + x];
+}
+
+static void vt_clear_cells(Vt* vt, int y, int x0, int x1) {
+    if (y < 0 || y >= vt->rows) return;
+    if (x0 < 0) x0 = 0;
+    if (x1 > vt->cols) x1 = vt->cols;
+    for (int x = x0; x < x1; x++) *vt_cell(vt, x, y) = ' ';
+}
+
+static void vt_init(Vt* vt, int rows, int cols, int reply_fd) {
+    memset(vt, 0, sizeof(*vt));
+    vt->rows = rows;
+    vt->cols = cols;
+    vt->primary = calloc((size_t)rows * cols, sizeof(uint32_t));
+    vt->alternate = calloc((size_t)rows * cols, sizeof(uint32_t));
+    vt->cells = vt->primary;
+    vt->bottom = rows - 1;
+    vt->reply_fd = reply_fd;
+    for (int y = 0; y < rows; y++) vt_clear_cells(vt, y, 0, cols);
+    vt->cells = vt->alternate;
+    for (int y = 0; y < rows; y++) vt_clear_cells(vt, y, 0, cols);
+    vt->cells = vt->primary;
+}
+
+static void vt_free(Vt* vt) {
+    free(vt->primary);
+    free(vt->alternate);
+}
+
+static void vt_scroll_up(Vt* vt, int n) {
+    for (int i = 0; i < n; i++) {
+        memmove(vt_cell(vt, 0, vt->top), vt_cell(vt, 0, vt->top + 1),
+                (size_t)(vt->bottom - vt->top) * vt->cols * sizeof(uint32_t));
+        vt_clear_cells(vt, vt->bottom, 0, vt->cols);
+    }
+}
+
+static void vt_scroll_down(Vt* vt, int n) {
+    for (int i = 0; i < n; i++) {
+        memmove(vt_cell(vt, 0, vt->top + 1), vt_cell(vt, 0, vt->top),
+                (size_t)(vt->bottom - vt->top) * vt->cols * sizeof(uint32_t));
+        vt_clear_cells(vt, vt->top, 0, vt->cols);
+    }
+}
+
+static void vt_linefeed(Vt* vt) {
+    if (vt->cy == vt->bottom) {
+        vt_scroll_up(vt, 1);
+    } else if (vt->cy < vt->rows - 1) {
+        vt->cy++;
+    }
+}
+
+static void vt_reply(Vt* vt, const char* fmt, ...) {
+    char buf[64];
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    if (n > 0 && vt->reply_fd >= 0) {
+        ssize_t ignored = write(vt->reply_fd, buf, (size_t)n);
+        (void)ignored;
+    }
+}
+
+// East Asian wide and emoji ranges; enough for layout-sensitive matching
+static int vt_char_width(uint32_t c) {
+    if (c == 0x200D || (c >= 0xFE00 && c <= 0xFE0F) || (c >= 0x300 && c <= 0x36F)) return 0;
+    if ((c >= 0x1100 && c <= 0x115F) || (c >= 0x2E80 && c <= 0xA4CF) ||
+        (c >= 0xAC00 && c <= 0xD7A3) || (c >= 0xF900 && c <= 0xFAFF) ||
+        (c >= 0xFE30 && c <= 0xFE4F) || (c >= 0xFF00 && c <= 0xFF60) ||
+        (c >= 0xFFE0 && c <= 0xFFE6) || (c >= 0x1F300 && c <= 0x1FAFF) ||
+        (c >= 0x20000 && c <= 0x3FFFD))
+        return 2;
+    return 1;
+}
+
+static void vt_put(Vt* vt, uint32_t c) {
+    int w = vt_char_width(c);
+    if (w == 0) return;
+    if (vt->pending_wrap) {
+        vt->cx = 0;
+        vt_linefeed(vt);
+        vt->pending_wrap = false;
+    }
+    if (vt->cx + w > vt->cols) {
+        vt->cx = 0;
+        vt_linefeed(vt);
+    }
+    *vt_cell(vt, vt->cx, vt->cy) = c;
+    // The trailing half of a wide char holds 0 and is skipped when matching
+    if (w == 2) *vt_cell(vt, vt->cx + 1, vt->cy) = 0;
+    vt->cx += w;
+    if (vt->cx >= vt->cols) {
+        vt->cx = vt->cols - 1;
+        vt->pending_wrap = true;
+    }
+    vt->generation++;
+}
+
+static int vt_param(Vt* vt, int i, int def) {
+    if (i >= vt->nparams || vt->params[i] <= 0) return def;
+    return vt->params[i];
+}
+
+static void vt_clamp_cursor(Vt* vt) {
+    if (vt->cx < 0) vt->cx = 0;
+    if (vt->cx >= vt->cols) vt->cx = vt->cols - 1;
+    if (vt->cy < 0) vt->cy = 0;
+    if (vt->cy >= vt->rows) vt->cy = vt->rows - 1;
+    vt->pending_wrap = false;
+}
+
+static void vt_set_mode(Vt* vt, bool on) {
+    if (vt->prefix != '?') return;
+    for (int i = 0; i < vt->nparams; i++) {
+        switch (vt->params[i]) {
+        case 1049:
+        case 1047:
+        case 47:
+            if (on) {
+                vt->saved_cx = vt->cx;
+                vt->saved_cy = vt->cy;
+                vt->cells = vt->alternate;
+                for (int y = 0; y < vt->rows; y++) vt_clear_cells(vt, y, 0, vt->cols);
+            } else {
+                vt->cells = vt->primary;
+                vt->cx = vt->saved_cx;
+                vt->cy = vt->saved_cy;
+            }
+            vt->generation++;
+            break;
+        case 2026:
+            vt->sync = on;
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+static void vt_csi(Vt* vt, char final) {
+    int n = vt_param(vt, 0, 1);
+    if (vt->prefix && final != 'h' && final != 'l') {
+        // Private queries: answer DA, ignore the rest (kitty keyboard, etc.)
+        if (vt->prefix == '>' && final == 'c') vt_reply(vt, "\x1b[>0;0;0c");
+        return;
+    }
+    switch (final) {
+    case 'A': vt->cy -= n; vt_clamp_cursor(vt); break;
+    case 'B': case 'e': vt->cy += n; vt_clamp_cursor(vt); break;
+    case 'C': case 'a': vt->cx += n; vt_clamp_cursor(vt); break;
+    case 'D': vt->cx -= n; vt_clamp_cursor(vt); break;
+    case 'E': vt->cy += n; vt->cx = 0; vt_clamp_cursor(vt); break;
+    case 'F': vt->cy -= n; vt->cx = 0; vt_clamp_cursor(vt); break;
+    case 'G': case '`': vt->cx = n - 1; vt_clamp_cursor(vt); break;
+    case 'd': vt->cy = n - 1; vt_clamp_cursor(vt); break;
+    case 'H': case 'f':
+        vt->cy = vt_param(vt, 0, 1) - 1;
+        vt->cx = vt_param(vt, 1, 1) - 1;
+        vt_clamp_cursor(vt);
+        break;
+    case 'J': {
+        int mode = vt->nparams ? vt->params[0] : 0;
+        if (mode == 0) {
+            vt_clear_cells(vt, vt->cy, vt->cx, vt->cols);
+            for (int y = vt->cy + 1; y < vt->rows; y++) vt_clear_cells(vt, y, 0, vt->cols);
+        } else if (mode == 1) {
+            for (int y = 0; y < vt->cy; y++) vt_clear_cells(vt, y, 0, vt->cols);
+            vt_clear_cells(vt, vt->cy, 0, vt->cx + 1);
+        } else {
+            for (int y = 0; y < vt->rows; y++) vt_clear_cells(vt, y, 0, vt->cols);
+        }
+        vt->generation++;
+        break;
+    }
+    case 'K': {
+        int mode = vt->nparams ? vt->params[0] : 0;
+        if (mode == 0) vt_clear_cells(vt, vt->cy, vt->cx, vt->cols);
+        else if (mode == 1) vt_clear_cells(vt, vt->cy, 0, vt->cx + 1);
+        else vt_clear_cells(vt, vt->cy, 0, vt->cols);
+        vt->generation++;
+        break;
+    }
+    case 'X': vt_clear_cells(vt, vt->cy, vt->cx, vt->cx + n); vt->generation++; break;
+    case 'P': {
+        uint32_t* row = vt_cell(vt, 0, vt->cy);
+        if (n > vt->cols - vt->cx) n = vt->cols - vt->cx;
+        memmove(row + vt->cx, row + vt->cx + n, (size_t)(vt->cols - vt->cx - n) * sizeof(uint32_t));
+        vt_clear_cells(vt, vt->cy, vt->cols - n, vt->cols);
+        vt->generation++;
+        break;
+    }
+    case '@': {
+        uint32_t* row = vt_cell(vt, 0, vt->cy);
+        if (n > vt->cols - vt->cx) n = vt->cols - vt->cx;
+        memmove(row + vt->cx + n, row + vt->cx, (size_t)(vt->cols - vt->cx - n) * sizeof(uint32_t));
+        vt_clear_cells(vt, vt->cy, vt->cx, vt->cx + n);
+        vt->generation++;
+        break;
+    }
+    case 'L': case 'M': {
+        if (vt->cy < vt->top || vt->cy > vt->bottom) break;
+        int saved_top = vt->top;
+        vt->top = vt->cy;
+        if (final == 'L') vt_scroll_down(vt, n); else vt_scroll_up(vt, n);
+        vt->top = saved_top;
+        vt->generation++;
+        break;
+    }
+    case 'S': vt_scroll_up(vt, n); vt->generation++; break;
+    case 'T': vt_scroll_down(vt, n); vt->generation++; break;
+    case 'r':
+        vt->top = vt_param(vt, 0, 1) - 1;
+        vt->bottom = vt_param(vt, 1, vt->rows) - 1;
+        if (vt->top < 0 || vt->bottom >= vt->rows || vt->top >= vt->bottom) {
+            vt->top = 0;
+            vt->bottom = vt->rows - 1;
+        }
+        vt->cx = 0;
+        vt->cy = 0;
+        break;
+    case 's': vt->saved_cx = vt->cx; vt->saved_cy = vt->cy; break;
+    case 'u': vt->cx = vt->saved_cx; vt->cy = vt->saved_cy; vt_clamp_cursor(vt); break;
+    case 'h': vt_set_mode(vt, true); break;
+    case 'l': vt_set_mode(vt, false); break;
+    case 'n':
+        if (vt_param(vt, 0, 0) == 6) vt_reply(vt, "\x1b[%d;%dR", vt->cy + 1, vt->cx + 1);
+        else if (vt_param(vt, 0, 0) == 5) vt_reply(vt, "\x1b[0n");
+        break;
+    case 'c': vt_reply(vt, "\x1b[?62;22c"); break;
+    default: break; // SGR and friends don't affect text content
+    }
+}
+
+static void vt_esc(Vt* vt, unsigned char c) {
+    vt->state = S_GROUND;
+    switch (c) {
+    case '[':
+        vt->state = S_CSI;
+        vt->nparams = 0;
+        vt->params[0] = 0;
+        vt->prefix = 0;
+        vt->intermediate = 0;
+        break;
+    case ']': vt->state = S_OSC; break;
+    case 'P': case '_': case '^': vt->state = S_DCS; break;
+    case '(': case ')': case '*': case '+': vt->state = S_CHARSET; break;
+    case '7': vt->saved_cx = vt->cx; vt->saved_cy = vt->cy; break;
+    case '8': vt->cx = vt->saved_cx; vt->cy = vt->saved_cy; vt_clamp_cursor(vt); break;
+    case 'D': vt_linefeed(vt); break;
+    case 'E': vt->cx = 0; vt_linefeed(vt); break;
+    case 'M':
+        if (vt->cy == vt->top) vt_scroll_down(vt, 1);
+        else if (vt->cy > 0) vt->cy--;
+        vt->generation++;
+        break;
+    case 'c':
+        for (int y = 0; y < vt->rows; y++) vt_clear_cells(vt, y, 0, vt->cols);
+        vt->cx = vt->cy = 0;
+        vt->generation++;
+        break;
+    default: break;
+    }
+}
+
+static void vt_feed_byte(Vt* vt, unsigned char c) {
+    switch (vt->state) {
+    case S_ESC:
+        vt_esc(vt, c);
+        return;
+    case S_CHARSET:
+        vt->state = S_GROUND;
+        return;
+    case S_CSI:
+        if (c >= '0' && c <= '9') {
+            if (vt->nparams == 0) vt->nparams = 1;
+            int* p = &vt->params[vt->nparams - 1];
+            if (*p < 100000) *p = *p * 10 + (c - '0');
+        } else if (c == ';' || c == ':') {
+            if (vt->nparams == 0) vt->nparams = 1;
+            if (vt->nparams < MAX_PARAMS) vt->params[vt->nparams++] = 0;
+        } else if (c == '?' || c == '>' || c == '<' || c == '=') {
+            vt->prefix = (char)c;
+        } else if (c >= 0x20 && c <= 0x2F) {
+            vt->intermediate = (char)c;
+        } else if (c >= 0x40 && c <= 0x7E) {
+            vt->state = S_GROUND;
+            if (!vt->intermediate) vt_csi(vt, (char)c);
+        } else if (c == 0x1b) {
+            vt->state = S_ESC;
+        }
+        return;
+    case S_OSC:
+        if (c == 0x07) vt->state = S_GROUND;
+        else if (c == 0x1b) vt->state = S_OSC_ESC;
+        return;
+    case S_OSC_ESC:
+        vt->state = c == '\\' ? S_GROUND : S_OSC;
+        return;
+    case S_DCS:
+        if (c == 0x1b) vt->state = S_DCS_ESC;
+        return;
+    case S_DCS_ESC:
+        vt->state = c == '\\' ? S_GROUND : S_DCS;
+        return;
+    case S_GROUND:
+        break;
+    }
+
+    if (vt->utf8_left > 0) {
+        if ((c & 0xC0) == 0x80) {
+            vt->utf8_code = (vt->utf8_code << 6) | (c & 0x3F);
+            if (--vt->utf8_left == 0) vt_put(vt, vt->utf8_code);
+            return;
+        }
+        vt->utf8_left = 0;
+        vt_put(vt, 0xFFFD);
+    }
+
+    if (c >= 0xC0) {
+        if (c >= 0xF0) { vt->utf8_code = c & 0x07; vt->utf8_left = 3; }
+        else if (c >= 0xE0) { vt->utf8_code = c & 0x0F; vt->utf8_left = 2; }
+        else { vt->utf8_code = c & 0x1F; vt->utf8_left = 1; }
+        return;
+    }
+    if (c >= 0x80) { vt_put(vt, 0xFFFD); return; }
+    if (c >= 0x20 && c != 0x7F) { vt_put(vt, c); return; }
+
+    switch (c) {
+    case 0x1b: vt->state = S_ESC; break;
+    case '\r': vt->cx = 0; vt->pending_wrap = false; break;
+    case '\n': case 0x0b: case 0x0c: vt_linefeed(vt); vt->pending_wrap = false; break;
+    case '\b': if (vt->cx > 0) vt->cx--; vt->pending_wrap = false; break;
+    case '\t': vt->cx = (vt->cx / 8 + 1) * 8; vt_clamp_cursor(vt); break;
+    default: break;
+    }
+}
+
+// Does TEXT appear on any row? Wide-char trailing cells are skipped.
+static bool vt_contains(Vt* vt, const char* text) {
+    uint32_t needle[MAX_TEXT];
+    int len = 0;
+    for (const unsigned char* p = (const unsigned char*)text; *p && len < MAX_TEXT;) {
+        uint32_t c = *p++;
+        int extra = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : c >= 0xC0 ? 1 : 0;
+        if (extra) c &= 0x3F >> extra;
+        while (extra-- > 0 && *p) c = (c << 6) | (*p++ & 0x3F);
+        if (vt_char_width(c) > 0) needle[len++] = c;
+    }
+    if (len == 0) return true;
+
+    uint32_t row[1024];
+    for (int y = 0; y < vt->rows; y++) {
+        int n = 0;
+        for (int x = 0; x < vt->cols && n < 1024; x++) {
+            uint32_t c = *vt_cell(vt, x, y);
+            if (c != 0) row[n++] = c;
+        }
+        for (int i = 0; i + len <= n; i++) {
+            if (memcmp(row + i, needle, (size_t)len * sizeof(uint32_t)) == 0) return true;
+        }
+    }
+    return false;
+}
+
+static void vt_dump(Vt* vt, FILE* out) {
+    for (int y = 0; y < vt->rows; y++) {
+        for (int x = 0; x < vt->cols; x++) {
+            uint32_t c = *vt_cell(vt, x, y);
+            if (c == 0) continue;
+            if (c < 0x80) fputc((int)c, out);
+            else if (c < 0x800) fprintf(out, "%c%c", 0xC0 | (c >> 6), 0x80 | (c & 0x3F));
+            else if (c < 0x10000) fprintf(out, "%c%c%c", 0xE0 | (c >> 12), 0x80 | ((c >> 6) & 0x3F), 0x80 | (c & 0x3F));
+            else fprintf(out, "%c%c%c%c", 0xF0 | (c >> 18), 0x80 | ((c >> 12) & 0x3F), 0x80 | ((c >> 6) & 0x3F), 0x80 | (c & 0x3F));
+        }
+        fputc('\n', out);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Scenario
+
+typedef enum { STEP_WAIT, STEP_SEND, STEP_EXPECT, STEP_SLEEP } StepKind;
+
+typedef struct {
+    StepKind kind;
+    char data[MAX_TEXT];
+    size_t len;
+    int label;    // STEP_EXPECT: index into labels
+    int ms;       // STEP_SLEEP
+} Step;
+
+typedef struct {
+    char name[64];
+    double* samples;
+    int count;
+    int cap;
+    int timeouts;
+} Label;
+
+static Step steps[MAX_STEPS];
+static int nsteps;
+static int loop_start = -1;
+static Label labels[MAX_LABELS];
+static int nlabels;
+
+static void die(const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    fprintf(stderr, "pty_latency: ");
+    vfprintf(stderr, fmt, args);
+    fputc('\n', stderr);
+    va_end(args);
+    exit(2);
+}
+
+static size_t unescape(const char* in, char* out, size_t cap) {
+    size_t n = 0;
+    while (*in && n < cap) {
+        if (*in != '\\' || !in[1]) { out[n++] = *in++; continue; }
+        in++;
+        switch (*in) {
+        case 'e': out[n++] = 0x1b; in++; break;
+        case 'r': out[n++] = '\r'; in++; break;
+        case 'n': out[n++] = '\n'; in++; break;
+        case 't': out[n++] = '\t'; in++; break;
+        case 's': out[n++] = ' '; in++; break;
+        case 'x': {
+            char hex[3] = {0};
+            in++;
+            for (int i = 0; i < 2 && *in; i++) hex[i] = *in++;
+            out[n++] = (char)strtol(hex, NULL, 16);
+            break;
+        }
+        default: out[n++] = *in++; break;
+        }
+    }
+    return n;
+}
+
+static const struct { const char* name; const char* seq; } named_keys[] = {
+    {"up", "\x1b[A"}, {"down", "\x1b[B"}, {"right", "\x1b[C"}, {"left", "\x1b[D"},
+    {"home", "\x1b[H"}, {"end", "\x1b[F"}, {"pgup", "\x1b[5~"}, {"pgdn", "\x1b[6~"},
+    {"enter", "\r"}, {"tab", "\t"}, {"esc", "\x1b"}, {"backspace", "\x7f"}, {"space", " "},
+};
+
+static int label_index(const char* name) {
+    for (int i = 0; i < nlabels; i++) {
+        if (strcmp(labels[i].name, name) == 0) return i;
+    }
+    if (nlabels == MAX_LABELS) die("too many expect labels");
+    snprintf(labels[nlabels].name, sizeof(labels[nlabels].name), "%s", name);
+    return nlabels++;
+}
+
+static Step* add_step(StepKind kind) {
+    if (nsteps == MAX_STEPS) die("scenario too long (max %d steps)", MAX_STEPS);
+    Step* s = &steps[nsteps++];
+    memset(s, 0, sizeof(*s));
+    s->kind = kind;
+    return s;
+}
+
+static void load_scenario(const char* path) {
+    FILE* f = fopen(path, "r");
+    if (!f) die("cannot open scenario %s: %s", path, strerror(errno));
+    char line[512];
+    int lineno = 0;
+    while (fgets(line, sizeof(line), f)) {
+        lineno++;
+        line[strcspn(line, "\r\n")] = 0;
+        char* p = line;
+        while (*p == ' ' || *p == '\t') p++;
+        if (*p == 0 || *p == '#') continue;
+        char* cmd = p;
+        while (*p && *p != ' ') p++;
+        if (*p) *p++ = 0;
+        while (*p == ' ') p++;
+        char* arg = p;
+
+        if (strcmp(cmd, "loop") == 0) {
+            loop_start = nsteps;
+        } else if (strcmp(cmd, "wait") == 0) {
+            Step* s = add_step(STEP_WAIT);
+            s->len = unescape(arg, s->data, MAX_TEXT - 1);
+        } else if (strcmp(cmd, "send") == 0) {
+            Step* s = add_step(STEP_SEND);
+            s->len = unescape(arg, s->data, MAX_TEXT - 1);
+        } else if (strcmp(cmd, "key") == 0) {
+            const char* seq = NULL;
+            for (size_t i = 0; i < sizeof(named_keys) / sizeof(named_keys[0]); i++) {
+                if (strcmp(named_keys[i].name, arg) == 0) seq = named_keys[i].seq;
+            }
+            if (!seq) die("%s:%d: unknown key '%s'", path, lineno, arg);
+            Step* s = add_step(STEP_SEND);
+            s->len = strlen(seq);
+            memcpy(s->data, seq, s->len);
+        } else if (strcmp(cmd, "click") == 0) {
+            int row, col;
+            if (sscanf(arg, "%d %d", &row, &col) != 2) die("%s:%d: click ROW COL", path, lineno);
+            Step* s = add_step(STEP_SEND);
+            s->len = (size_t)snprintf(s->data, MAX_TEXT, "\x1b[<0;%d;%dM\x1b[<0;%d;%dm", col, row, col, row);
+        } else if (strcmp(cmd, "expect") == 0) {
+            char* text = arg;
+            while (*text && *text != ' ') text++;
+            if (*text) *text++ = 0;
+            if (!*arg || !*text) die("%s:%d: expect LABEL TEXT", path, lineno);
+            Step* s = add_step(STEP_EXPECT);
+            s->label = label_index(arg);
+            s->len = unescape(text, s->data, MAX_TEXT - 1);
+        } else if (strcmp(cmd, "sleep") == 0) {
+            add_step(STEP_SLEEP)->ms = atoi(arg);
+        } else {
+            die("%s:%d: unknown command '%s'", path, lineno, cmd);
+        }
+    }
+    fclose(f);
+    if (loop_start < 0) loop_start = nsteps;
+}
+
+// ---------------------------------------------------------------------------
+// Runner
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e3 + (double)ts.tv_nsec / 1e6;
+}
+
+static int master_fd = -1;
+static pid_t child_pid = -1;
+static Vt vt;
+static uint64_t output_bytes;
+static bool child_exited;
+
+// Read whatever the child has written, waiting at most timeout_ms
+static void pump(int timeout_ms) {
+    struct pollfd pfd = {.fd = master_fd, .events = POLLIN};
+    int r = poll(&pfd, 1, timeout_ms);
+    if (r <= 0) return;
+    if (pfd.revents & (POLLHUP | POLLERR) && !(pfd.revents & POLLIN)) {
+        child_exited = true;
+        return;
+    }
+    unsigned char buf[65536];
+    ssize_t n = read(master_fd, buf, sizeof(buf));
+    if (n <= 0) {
+        if (n == 0 || errno == EIO) child_exited = true;
+        return;
+    }
+    output_bytes += (uint64_t)n;
+    for (ssize_t i = 0; i < n; i++) vt_feed_byte(&vt, buf[i]);
+}
+
+// Wait until text is visible; if since_gen is set the screen must also have
+// changed after that generation. Returns the completion time or -1.
+static double wait_for(const char* text, uint64_t since_gen, bool need_change, int timeout_ms) {
+    double deadline = now_ms() + timeout_ms;
+    for (;;) {
+        bool changed = !need_change || vt.generation > since_gen;
+        if (changed && !vt.sync && vt_contains(&vt, text)) return now_ms();
+        double left = deadline - now_ms();
+        if (left <= 0 || child_exited) return -1;
+        pump(left > 50 ? 50 : (int)left + 1);
+    }
+}
+
+static void send_bytes(const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(master_fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            die("write to pty failed: %s", strerror(errno));
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+}
+
+static void record(Label* l, double ms) {
+    if (l->count == l->cap) {
+        l->cap = l->cap ? l->cap * 2 : 64;
+        l->samples = realloc(l->samples, (size_t)l->cap * sizeof(double));
+    }
+    l->samples[l->count++] = ms;
+}
+
+static bool run_steps(int from, int to, int timeout_ms) {
+    double sent_at = now_ms();
+    uint64_t sent_gen = vt.generation;
+    for (int i = from; i < to; i++) {
+        Step* s = &steps[i];
+        switch (s->kind) {
+        case STEP_SEND:
+            // Drain pending output so the measurement starts from a quiet screen
+            pump(0);
+            sent_gen = vt.generation;
+            send_bytes(s->data, s->len);
+            sent_at = now_ms();
+            break;
+        case STEP_SLEEP:
+            usleep((useconds_t)s->ms * 1000);
+            break;
+        case STEP_WAIT:
+            if (wait_for(s->data, 0, false, timeout_ms) < 0) {
+                fprintf(stderr, "pty_latency: timed out waiting for \"%s\"\n", s->data);
+                return false;
+            }
+            break;
+        case STEP_EXPECT: {
+            double done = wait_for(s->data, sent_gen, true, timeout_ms);
+            if (done < 0) {
+                labels[s->label].timeouts++;
+                if (child_exited) return false;
+            } else {
+                record(&labels[s->label], done - sent_at);
+            }
+            break;
+        }
+        }
+    }
+    return true;
+}
+
+static int cmp_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double* sorted, int n, double p) {
+    if (n == 0) return 0;
+    double rank = p / 100.0 * (n - 1);
+    int lo = (int)rank;
+    int hi = lo + 1 < n ? lo + 1 : lo;
+    return sorted[lo] + (sorted[hi] - sorted[lo]) * (rank - lo);
+}
+
+static void spawn(char** argv, int rows, int cols) {
+    struct winsize ws = {.ws_row = (unsigned short)rows, .ws_col = (unsigned short)cols};
+    child_pid = forkpty(&master_fd, NULL, NULL, &ws);
+    if (child_pid < 0) die("forkpty failed: %s", strerror(errno));
+    if (child_pid == 0) {
+        setenv("TERM", "xterm-256color", 1);
+        setenv("COLORTERM", "truecolor", 1);
+        execvp(argv[0], argv);
+        fprintf(stderr, "exec %s: %s\n", argv[0], strerror(errno));
+        _exit(127);
+    }
+}
+
+int main(int argc, char** argv) {
+    int cols = 100, rows = 30, iterations = 50, timeout_ms = 2000;
+    double max_p99 = -1;
+    bool json = false, dump = false;
+    const char* scenario = NULL;
+    int cmd_index = -1;
+
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        if (strcmp(a, "--") == 0) { cmd_index = i + 1; break; }
+        if (strcmp(a, "--cols") == 0 && i + 1 < argc) cols = atoi(argv[++i]);
+        else if (strcmp(a, "--rows") == 0 && i + 1 < argc) rows = atoi(argv[++i]);
+        else if (strcmp(a, "--iterations") == 0 && i + 1 < argc) iterations = atoi(argv[++i]);
+        else if (strcmp(a, "--timeout") == 0 && i + 1 < argc) timeout_ms = atoi(argv[++i]);
+        else if (strcmp(a, "--max-p99") == 0 && i + 1 < argc) max_p99 = atof(argv[++i]);
+        else if (strcmp(a, "--json") == 0) json = true;
+        else if (strcmp(a, "--dump") == 0) dump = true;
+        else if (!scenario && a[0] != '-') scenario = a;
+        else die("unknown option %s", a);
+    }
+    if (!scenario || cmd_index < 0 || cmd_index >= argc) {
+        fprintf(stderr, "usage: pty_latency [options] SCENARIO -- COMMAND [ARGS...]\n");
+        return 2;
+    }
+    if (cols < 2 || cols > 1024 || rows < 2 || rows > 1024) die("terminal size out of range");
+
+    load_scenario(scenario);
+    signal(SIGPIPE, SIG_IGN);
+    spawn(argv + cmd_index, rows, cols);
+    vt_init(&vt, rows, cols, master_fd);
+
+    bool ok = run_steps(0, loop_start, timeout_ms);
+    uint64_t loop_bytes_start = output_bytes;
+    int completed = 0;
+    for (int it = 0; ok && it < iterations; it++) {
+        ok = run_steps(loop_start, nsteps, timeout_ms);
+        if (ok) completed++;
+    }
+    // Let the last frame land before counting bytes
+    pump(20);
+    uint64_t loop_bytes = output_bytes - loop_bytes_start;
+
+    if (dump) vt_dump(&vt, stderr);
+
+    kill(child_pid, SIGTERM);
+    for (int i = 0; i < 50 && waitpid(child_pid, NULL, WNOHANG) == 0; i++) {
+        pump(10);
+    }
+    if (waitpid(child_pid, NULL, WNOHANG) == 0) {
+        kill(child_pid, SIGKILL);
+        waitpid(child_pid, NULL, 0);
+    }
+
+    bool gate_failed = !ok;
+    if (json) printf("{\"iterations\":%d,\"output_bytes\":%llu,\"loop_bytes_per_iteration\":%.1f,\"steps\":[",
+                     completed, (unsigned long long)output_bytes,
+                     completed ? (double)loop_bytes / completed : 0.0);
+    else printf("%-20s %6s %8s %8s %8s %8s %8s %8s\n", "step", "n", "min", "p50", "p90", "p99", "max", "timeouts");
+
+    for (int i = 0; i < nlabels; i++) {
+        Label* l = &labels[i];
+        qsort(l->samples, (size_t)l->count, sizeof(double), cmp_double);
+        double p50 = percentile(l->samples, l->count, 50);
+        double p90 = percentile(l->samples, l->count, 90);
+        double p99 = percentile(l->samples, l->count, 99);
+        double mn = l->count ? l->samples[0] : 0;
+        double mx = l->count ? l->samples[l->count - 1] : 0;
+        if (max_p99 >= 0 && (p99 > max_p99 || l->timeouts > 0)) gate_failed = true;
+        if (json) {
+            printf("%s{\"label\":\"%s\",\"n\":%d,\"min_ms\":%.3f,\"p50_ms\":%.3f,\"p90_ms\":%.3f,"
+                   "\"p99_ms\":%.3f,\"max_ms\":%.3f,\"timeouts\":%d}",
+                   i ? "," : "", l->name, l->count, mn, p50, p90, p99, mx, l->timeouts);
+        } else {
+            printf("%-20s %6d %8.3f %8.3f %8.3f %8.3f %8.3f %8d\n", l->name, l->count, mn, p50, p90, p99, mx, l->timeouts);
+        }
+        free(l->samples);
+    }
+    if (json) {
+        printf("]}\n");
+    } else {
+        printf("\noutput: %llu bytes total, %.1f bytes/iteration over %d iterations\n",
+               (unsigned long long)output_bytes, completed ? (double)loop_bytes / completed : 0.0, completed);
+        if (!ok) printf("scenario aborted (timeout or child exit)\n");
+    }
+
+    vt_free(&vt);
+    close(master_fd);
+    return gate_failed ? 1 : 0;
+}
@@ -6,6 +6,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdarg.h>
 
 // Import the official OpenTUI C API
 // We'll link against libopentui.dylib which provides these symbols
@@ -43,20 +44,35 @@ extern void setCursorColor(CliRenderer* renderer, const float* color);
 extern void enableMouse(CliRenderer* renderer, bool enableMovement);
 extern void disableMouse(CliRenderer* renderer);
 
+// In-process log ring; never write to stderr while the renderer owns the screen
+extern void logPush(uint8_t level, const uint8_t* msg, size_t msgLen);
+
+enum { MB_LOG_ERROR = 0, MB_LOG_WARN = 1, MB_LOG_INFO = 2, MB_LOG_DEBUG = 3 };
+
+static void mb_log(uint8_t level, const char* fmt, ...) {
+    char msg[240];
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(msg, sizeof(msg), fmt, args);
+    va_end(args);
+    if (n < 0) return;
+    if ((size_t)n >= sizeof(msg)) n = sizeof(msg) - 1;
+    logPush(level, (const uint8_t*)msg, (size_t)n);
+}
+
 // === MoonBit-friendly wrapper functions ===
 // These convert MoonBit's double arrays to float arrays that OpenTUI expects
 
 // Initialize the renderer
 CliRenderer* mb_createRenderer(uint32_t width, uint32_t height) {
-    // Debug output to understand what's happening
-    fprintf(stderr, "mb_createRenderer: Creating renderer %ux%u\n", width, height);
-    
+    mb_log(MB_LOG_DEBUG, "mb_createRenderer: Creating renderer %ux%u", width, height);
+
     CliRenderer* renderer = createRenderer(width, height);
     
     if (renderer == NULL) {
-        fprintf(stderr, "mb_createRenderer: Failed to create renderer\n");
+        mb_log(MB_LOG_ERROR, "mb_createRenderer: Failed to create renderer");
     } else {
-        fprintf(stderr, "mb_createRenderer: Successfully created renderer at %p\n", (void*)renderer);
+        mb_log(MB_LOG_DEBUG, "mb_createRenderer: Created renderer at %p", (void*)renderer);
     }
     
     return renderer;
@@ -160,16 +176,16 @@ void mb_enableMouse(CliRenderer* renderer, bool enableMovement) {
 
 // Test function to verify library is loaded
 int mb_test_library() {
-    fprintf(stderr, "mb_test_library: Testing OpenTUI library availability\n");
-    
+    mb_log(MB_LOG_DEBUG, "mb_test_library: Testing OpenTUI library availability");
+
     // Try to create a small test renderer
     CliRenderer* test = createRenderer(10, 10);
     if (test != NULL) {
-        fprintf(stderr, "mb_test_library: SUCCESS - Library is working\n");
+        mb_log(MB_LOG_INFO, "mb_test_library: Library is working");
         destroyRenderer(test, false, 0);
         return 1; // Success
     } else {
-        fprintf(stderr, "mb_test_library: FAILED - Cannot create renderer\n");
+        mb_log(MB_LOG_ERROR, "mb_test_library: Cannot create renderer");
         return 0; // Failure
     }
 }
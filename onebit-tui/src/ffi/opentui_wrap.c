@@ -2,6 +2,12 @@
 // This wrapper provides a simpler interface for MoonBit FFI and adapts
 // across evolving Zig exports by probing symbols at runtime when needed.
 
+// The pty code needs the XSI pty calls and ptsname_r, which glibc declares
+// only for _GNU_SOURCE and macOS hides unless _DARWIN_C_SOURCE is set
+#define _XOPEN_SOURCE 600
+#define _GNU_SOURCE
+#define _DARWIN_C_SOURCE
+
 #include <stdint.h>
 #include <stdbool.h>
 #include <string.h>
@@ -78,6 +84,28 @@ static void* sym(const char* name) {
 #endif
 }
 
+// Diagnostics go to the in-process log ring (drained by the app once per
+// frame) instead of stderr, which would corrupt the alternate screen.
+typedef void (*fn_logPush)(uint8_t, const uint8_t*, size_t);
+
+void logPushR(uint32_t level, const uint8_t* msg, uint32_t msgLen) {
+    fn_logPush f = (fn_logPush)sym("logPush");
+    if (f) f((uint8_t)level, msg, (size_t)msgLen);
+}
+
+typedef size_t (*fn_logDrain)(uint8_t*, size_t);
+typedef uint32_t (*fn_logTakeDropped)(void);
+
+uint32_t logDrainR(uint8_t* out, uint32_t outLen) {
+    fn_logDrain f = (fn_logDrain)sym("logDrain");
+    return f ? (uint32_t)f(out, (size_t)outLen) : 0;
+}
+
+uint32_t logTakeDroppedR(void) {
+    fn_logTakeDropped f = (fn_logTakeDropped)sym("logTakeDropped");
+    return f ? f() : 0;
+}
+
 static void to_float4(const double* in, float out[4]) {
     for (int i = 0; i < 4; i++) out[i] = (float)in[i];
 }
@@ -114,29 +142,6 @@ void bufferDrawTextMB(BufferPtr buffer, const uint8_t* text, size_t textLen, uin
         fbg[i] = (float)bg[i];
     }
     
-    // Enhanced debug output
-    static int call_count = 0;
-    if (call_count < 20) {
-        FILE* f = fopen("/tmp/moonbit_text_debug.txt", "a");
-        if (f) {
-            fprintf(f, "Call %d: pos=(%u,%u) len=%zu text='", call_count, x, y, textLen);
-            for (size_t i = 0; i < textLen; i++) {
-                if (text[i] >= 32 && text[i] < 127) {
-                    fprintf(f, "%c", text[i]);
-                } else {
-                    fprintf(f, "[%02x]", text[i]);
-                }
-            }
-            fprintf(f, "' bytes=");
-            for (size_t i = 0; i < textLen && i < 10; i++) {
-                fprintf(f, "%02x ", text[i]);
-            }
-            fprintf(f, "\n");
-            fclose(f);
-        }
-    }
-    call_count++;
-    
     bufferDrawText(buffer, text, textLen, x, y, ffg, fbg, attributes);
 }
 
@@ -205,6 +210,330 @@ void disableMouseR(RendererPtr renderer) {
     if (f) f(renderer);
 }
 
+typedef bool (*fn_setupInlineRenderer)(RendererPtr, uint32_t);
+typedef void (*fn_inlinePrint)(RendererPtr, const uint8_t*, size_t);
+
+bool setupInlineRendererR(RendererPtr renderer, uint32_t rows) {
+    fn_setupInlineRenderer f = (fn_setupInlineRenderer)sym("setupInlineRenderer");
+    return f ? f(renderer, rows) : false;
+}
+
+void inlinePrintR(RendererPtr renderer, const uint8_t* text, uint32_t textLen) {
+    fn_inlinePrint f = (fn_inlinePrint)sym("inlinePrint");
+    if (f) f(renderer, text, (size_t)textLen);
+}
+
+typedef void (*fn_startCapabilityProbe)(RendererPtr);
+typedef void (*fn_processCapabilityResponse)(RendererPtr, const uint8_t*, size_t);
+
+void startCapabilityProbeR(RendererPtr renderer) {
+    fn_startCapabilityProbe f = (fn_startCapabilityProbe)sym("startCapabilityProbe");
+    if (f) f(renderer);
+}
+
+void processCapabilityResponseR(RendererPtr renderer, const uint8_t* response, uint32_t responseLen) {
+    fn_processCapabilityResponse f = (fn_processCapabilityResponse)sym("processCapabilityResponse");
+    if (f) f(renderer, response, (size_t)responseLen);
+}
+
+typedef void (*fn_setDebugReport)(RendererPtr, const uint8_t*, size_t);
+
+void setDebugReportR(RendererPtr renderer, const uint8_t* text, uint32_t textLen) {
+    fn_setDebugReport f = (fn_setDebugReport)sym("setDebugReport");
+    if (f) f(renderer, text, (size_t)textLen);
+}
+
+// Display width of UTF-8 text through the native width cache
+typedef uint32_t (*fn_measureText)(const uint8_t*, size_t, uint8_t);
+typedef void (*fn_getWidthCacheStats)(uint64_t*);
+
+uint32_t measureTextR(const uint8_t* text, uint32_t textLen, uint32_t widthMethod) {
+    fn_measureText f = (fn_measureText)sym("measureText");
+    return f ? f(text, (size_t)textLen, (uint8_t)widthMethod) : textLen;
+}
+
+void getWidthCacheStatsR(uint64_t* out) {
+    fn_getWidthCacheStats f = (fn_getWidthCacheStats)sym("getWidthCacheStats");
+    if (f) f(out);
+}
+
+// Retained scene graph; patch records are laid out in scene.zig
+typedef void* ScenePtr;
+typedef ScenePtr (*fn_createScene)(void);
+typedef void (*fn_destroyScene)(ScenePtr);
+typedef bool (*fn_scenePatch)(ScenePtr, const uint32_t*, size_t, const uint8_t*, size_t);
+typedef void (*fn_sceneRender)(ScenePtr, BufferPtr, bool);
+typedef uint32_t (*fn_sceneHitTest)(ScenePtr, int32_t, int32_t);
+typedef void (*fn_sceneGetStats)(ScenePtr, uint32_t*);
+
+ScenePtr createSceneR(void) {
+    fn_createScene f = (fn_createScene)sym("createScene");
+    return f ? f() : NULL;
+}
+
+void destroySceneR(ScenePtr scene) {
+    fn_destroyScene f = (fn_destroyScene)sym("destroyScene");
+    if (f) f(scene);
+}
+
+bool scenePatchR(ScenePtr scene, const uint32_t* words, uint32_t wordCount, const uint8_t* text, uint32_t textLen) {
+    fn_scenePatch f = (fn_scenePatch)sym("scenePatch");
+    return f ? f(scene, words, (size_t)wordCount, text, (size_t)textLen) : false;
+}
+
+void sceneRenderR(ScenePtr scene, BufferPtr buffer, bool full) {
+    fn_sceneRender f = (fn_sceneRender)sym("sceneRender");
+    if (f) f(scene, buffer, full);
+}
+
+uint32_t sceneHitTestR(ScenePtr scene, int32_t x, int32_t y) {
+    fn_sceneHitTest f = (fn_sceneHitTest)sym("sceneHitTest");
+    return f ? f(scene, x, y) : 0;
+}
+
+void sceneGetStatsR(ScenePtr scene, uint32_t* out) {
+    fn_sceneGetStats f = (fn_sceneGetStats)sym("sceneGetStats");
+    if (f) f(scene, out);
+}
+
+// Streaming charts; colors arrive as MoonBit doubles
+typedef void* ChartPtr;
+typedef ChartPtr (*fn_createChart)(uint32_t, uint32_t, uint8_t, uint32_t, uint32_t);
+typedef void (*fn_destroyChart)(ChartPtr);
+typedef int32_t (*fn_chartAddSeries)(ChartPtr, const float*);
+typedef void (*fn_chartSetSeriesColor)(ChartPtr, uint32_t, const float*);
+typedef void (*fn_chartPush)(ChartPtr, uint32_t, float);
+typedef void (*fn_chartPushMany)(ChartPtr, uint32_t, const float*, size_t);
+typedef void (*fn_chartSetRange)(ChartPtr, float, float);
+typedef void (*fn_chartSetFill)(ChartPtr, bool);
+typedef void (*fn_chartSetBackground)(ChartPtr, const float*);
+typedef void (*fn_chartResize)(ChartPtr, uint32_t, uint32_t);
+typedef void (*fn_chartDraw)(ChartPtr, BufferPtr, int32_t, int32_t);
+typedef void (*fn_chartGetStats)(ChartPtr, uint32_t*);
+
+ChartPtr createChartR(uint32_t width, uint32_t height, uint8_t mode, uint32_t capacity, uint32_t samplesPerColumn) {
+    fn_createChart f = (fn_createChart)sym("createChart");
+    return f ? f(width, height, mode, capacity, samplesPerColumn) : NULL;
+}
+
+void destroyChartR(ChartPtr chart) {
+    fn_destroyChart f = (fn_destroyChart)sym("destroyChart");
+    if (f) f(chart);
+}
+
+int32_t chartAddSeriesR(ChartPtr chart, const double* color) {
+    fn_chartAddSeries f = (fn_chartAddSeries)sym("chartAddSeries");
+    if (!f) return -1;
+    float fcolor[4];
+    to_float4(color, fcolor);
+    return f(chart, fcolor);
+}
+
+void chartSetSeriesColorR(ChartPtr chart, uint32_t series, const double* color) {
+    fn_chartSetSeriesColor f = (fn_chartSetSeriesColor)sym("chartSetSeriesColor");
+    if (!f) return;
+    float fcolor[4];
+    to_float4(color, fcolor);
+    f(chart, series, fcolor);
+}
+
+void chartPushR(ChartPtr chart, uint32_t series, double value) {
+    fn_chartPush f = (fn_chartPush)sym("chartPush");
+    if (f) f(chart, series, (float)value);
+}
+
+void chartPushManyR(ChartPtr chart, uint32_t series, const float* values, uint32_t count) {
+    fn_chartPushMany f = (fn_chartPushMany)sym("chartPushMany");
+    if (f) f(chart, series, values, (size_t)count);
+}
+
+void chartSetRangeR(ChartPtr chart, double min, double max) {
+    fn_chartSetRange f = (fn_chartSetRange)sym("chartSetRange");
+    if (f) f(chart, (float)min, (float)max);
+}
+
+void chartSetFillR(ChartPtr chart, bool fill) {
+    fn_chartSetFill f = (fn_chartSetFill)sym("chartSetFill");
+    if (f) f(chart, fill);
+}
+
+void chartSetBackgroundR(ChartPtr chart, const double* color) {
+    fn_chartSetBackground f = (fn_chartSetBackground)sym("chartSetBackground");
+    if (!f) return;
+    float fcolor[4];
+    to_float4(color, fcolor);
+    f(chart, fcolor);
+}
+
+void chartResizeR(ChartPtr chart, uint32_t width, uint32_t height) {
+    fn_chartResize f = (fn_chartResize)sym("chartResize");
+    if (f) f(chart, width, height);
+}
+
+void chartDrawR(ChartPtr chart, BufferPtr buffer, int32_t x, int32_t y) {
+    fn_chartDraw f = (fn_chartDraw)sym("chartDraw");
+    if (f) f(chart, buffer, x, y);
+}
+
+void chartGetStatsR(ChartPtr chart, uint32_t* out) {
+    fn_chartGetStats f = (fn_chartGetStats)sym("chartGetStats");
+    if (f) f(chart, out);
+}
+
+// Terminal emulator panes; the pty itself is opened by ptySpawn below
+typedef void* VtPtr;
+typedef VtPtr (*fn_createVt)(uint32_t, uint32_t, uint32_t);
+typedef void (*fn_destroyVt)(VtPtr);
+typedef bool (*fn_vtAttach)(VtPtr, int32_t);
+typedef void (*fn_vtFeed)(VtPtr, const uint8_t*, size_t);
+typedef bool (*fn_vtWriteInput)(VtPtr, const uint8_t*, size_t);
+typedef void (*fn_vtResize)(VtPtr, uint32_t, uint32_t);
+typedef void (*fn_vtScrollView)(VtPtr, int32_t);
+typedef void (*fn_vtSetColors)(VtPtr, const float*, const float*);
+typedef bool (*fn_vtHasDamage)(VtPtr);
+typedef uint32_t (*fn_vtGetModes)(VtPtr);
+typedef void (*fn_vtDraw)(VtPtr, BufferPtr, int32_t, int32_t, bool, bool);
+typedef void (*fn_vtGetStats)(VtPtr, uint32_t*);
+
+VtPtr createVtR(uint32_t cols, uint32_t rows, uint32_t historyRows) {
+    fn_createVt f = (fn_createVt)sym("createVt");
+    return f ? f(cols, rows, historyRows) : NULL;
+}
+
+void destroyVtR(VtPtr vt) {
+    fn_destroyVt f = (fn_destroyVt)sym("destroyVt");
+    if (f) f(vt);
+}
+
+bool vtAttachR(VtPtr vt, int32_t fd) {
+    fn_vtAttach f = (fn_vtAttach)sym("vtAttach");
+    return f ? f(vt, fd) : false;
+}
+
+void vtFeedR(VtPtr vt, const uint8_t* bytes, uint32_t len) {
+    fn_vtFeed f = (fn_vtFeed)sym("vtFeed");
+    if (f) f(vt, bytes, (size_t)len);
+}
+
+bool vtWriteInputR(VtPtr vt, const uint8_t* bytes, uint32_t len) {
+    fn_vtWriteInput f = (fn_vtWriteInput)sym("vtWriteInput");
+    return f ? f(vt, bytes, (size_t)len) : false;
+}
+
+void vtResizeR(VtPtr vt, uint32_t cols, uint32_t rows) {
+    fn_vtResize f = (fn_vtResize)sym("vtResize");
+    if (f) f(vt, cols, rows);
+}
+
+void vtScrollViewR(VtPtr vt, int32_t delta) {
+    fn_vtScrollView f = (fn_vtScrollView)sym("vtScrollView");
+    if (f) f(vt, delta);
+}
+
+void vtSetColorsR(VtPtr vt, const double* fg, const double* bg) {
+    fn_vtSetColors f = (fn_vtSetColors)sym("vtSetColors");
+    if (!f) return;
+    float ffg[4];
+    float fbg[4];
+    to_float4(fg, ffg);
+    to_float4(bg, fbg);
+    f(vt, ffg, fbg);
+}
+
+bool vtHasDamageR(VtPtr vt) {
+    fn_vtHasDamage f = (fn_vtHasDamage)sym("vtHasDamage");
+    return f ? f(vt) : false;
+}
+
+uint32_t vtGetModesR(VtPtr vt) {
+    fn_vtGetModes f = (fn_vtGetModes)sym("vtGetModes");
+    return f ? f(vt) : 0;
+}
+
+void vtDrawR(VtPtr vt, BufferPtr buffer, int32_t x, int32_t y, bool full, bool showCursor) {
+    fn_vtDraw f = (fn_vtDraw)sym("vtDraw");
+    if (f) f(vt, buffer, x, y, full, showCursor);
+}
+
+void vtGetStatsR(VtPtr vt, uint32_t* out) {
+    fn_vtGetStats f = (fn_vtGetStats)sym("vtGetStats");
+    if (f) f(vt, out);
+}
+
+// Line diffs
+typedef void* DiffPtr;
+typedef DiffPtr (*fn_createDiff)(const uint8_t*, size_t, const uint8_t*, size_t);
+typedef void (*fn_destroyDiff)(DiffPtr);
+typedef void (*fn_diffSetMode)(DiffPtr, uint8_t);
+typedef void (*fn_diffSetContext)(DiffPtr, uint32_t);
+typedef void (*fn_diffSetColors)(DiffPtr, uint8_t, const float*, const float*);
+typedef uint32_t (*fn_diffEnsureRows)(DiffPtr, uint32_t);
+typedef uint32_t (*fn_diffNextChange)(DiffPtr, uint32_t);
+typedef uint32_t (*fn_diffPrevChange)(DiffPtr, uint32_t);
+typedef bool (*fn_diffGetRow)(DiffPtr, uint32_t, uint32_t*);
+typedef void (*fn_diffDraw)(DiffPtr, BufferPtr, int32_t, int32_t, uint32_t, uint32_t, uint32_t);
+typedef void (*fn_diffGetStats)(DiffPtr, uint32_t*);
+
+DiffPtr createDiffR(const uint8_t* oldText, uint32_t oldLen, const uint8_t* newText, uint32_t newLen) {
+    fn_createDiff f = (fn_createDiff)sym("createDiff");
+    return f ? f(oldText, (size_t)oldLen, newText, (size_t)newLen) : NULL;
+}
+
+void destroyDiffR(DiffPtr diff) {
+    fn_destroyDiff f = (fn_destroyDiff)sym("destroyDiff");
+    if (f) f(diff);
+}
+
+void diffSetModeR(DiffPtr diff, uint8_t mode) {
+    fn_diffSetMode f = (fn_diffSetMode)sym("diffSetMode");
+    if (f) f(diff, mode);
+}
+
+void diffSetContextR(DiffPtr diff, uint32_t context) {
+    fn_diffSetContext f = (fn_diffSetContext)sym("diffSetContext");
+    if (f) f(diff, context);
+}
+
+void diffSetColorsR(DiffPtr diff, uint8_t slot, const double* fg, const double* bg) {
+    fn_diffSetColors f = (fn_diffSetColors)sym("diffSetColors");
+    if (!f) return;
+    float ffg[4];
+    float fbg[4];
+    to_float4(fg, ffg);
+    to_float4(bg, fbg);
+    f(diff, slot, ffg, fbg);
+}
+
+uint32_t diffEnsureRowsR(DiffPtr diff, uint32_t count) {
+    fn_diffEnsureRows f = (fn_diffEnsureRows)sym("diffEnsureRows");
+    return f ? f(diff, count) : 0;
+}
+
+uint32_t diffNextChangeR(DiffPtr diff, uint32_t from) {
+    fn_diffNextChange f = (fn_diffNextChange)sym("diffNextChange");
+    return f ? f(diff, from) : UINT32_MAX;
+}
+
+uint32_t diffPrevChangeR(DiffPtr diff, uint32_t from) {
+    fn_diffPrevChange f = (fn_diffPrevChange)sym("diffPrevChange");
+    return f ? f(diff, from) : UINT32_MAX;
+}
+
+bool diffGetRowR(DiffPtr diff, uint32_t index, uint32_t* out) {
+    fn_diffGetRow f = (fn_diffGetRow)sym("diffGetRow");
+    return f ? f(diff, index, out) : false;
+}
+
+void diffDrawR(DiffPtr diff, BufferPtr buffer, int32_t x, int32_t y, uint32_t width, uint32_t height, uint32_t top) {
+    fn_diffDraw f = (fn_diffDraw)sym("diffDraw");
+    if (f) f(diff, buffer, x, y, width, height, top);
+}
+
+void diffGetStatsR(DiffPtr diff, uint32_t* out) {
+    fn_diffGetStats f = (fn_diffGetStats)sym("diffGetStats");
+    if (f) f(diff, out);
+}
+
 void setRenderOffsetR(RendererPtr renderer, uint32_t offset) {
     fn_setRenderOffset_r f = (fn_setRenderOffset_r)sym("setRenderOffset");
     if (f) f(renderer, offset);
@@ -256,6 +585,73 @@ void bufferDrawSuperSampleBufferR(BufferPtr buffer, uint32_t x, uint32_t y, cons
     if (f) f(buffer, x, y, pixelData, (size_t)len, format, alignedBytesPerRow);
 }
 
+// OSC 8 hyperlinks (newer OpenTUI). Link ids are u16 natively; widen for MoonBit.
+typedef uint16_t (*fn_internHyperlink)(const uint8_t*, size_t);
+typedef void (*fn_bufferSetLink)(BufferPtr, uint16_t);
+
+uint32_t internHyperlinkR(const uint8_t* url, uint32_t urlLen) {
+    fn_internHyperlink f = (fn_internHyperlink)sym("internHyperlink");
+    return f ? (uint32_t)f(url, (size_t)urlLen) : 0;
+}
+
+void bufferSetLinkR(BufferPtr buffer, uint32_t linkId) {
+    fn_bufferSetLink f = (fn_bufferSetLink)sym("bufferSetLink");
+    if (f) f(buffer, (uint16_t)linkId);
+}
+
+typedef void (*fn_addHitRegions)(RendererPtr, const int32_t*, uint32_t);
+typedef void (*fn_addToHitGrid)(RendererPtr, int32_t, int32_t, uint32_t, uint32_t, uint32_t);
+
+// Regions are (x, y, width, height, id) int32 quintuples
+void addHitRegionsR(RendererPtr renderer, const int32_t* regions, uint32_t count) {
+    fn_addHitRegions f = (fn_addHitRegions)sym("addHitRegions");
+    if (f) {
+        f(renderer, regions, count);
+        return;
+    }
+    // Older OpenTUI: one call per region
+    fn_addToHitGrid add = (fn_addToHitGrid)sym("addToHitGrid");
+    if (!add) return;
+    for (uint32_t i = 0; i < count; i++) {
+        const int32_t* r = regions + i * 5;
+        add(renderer, r[0], r[1], (uint32_t)r[2], (uint32_t)r[3], (uint32_t)r[4]);
+    }
+}
+
+// Native post-processing filters. MoonBit hands over (kind, p0, p1, p2)
+// double quadruples; the Zig side takes packed {u32, f32, f32, f32} ops.
+typedef struct {
+    uint32_t kind;
+    float p0;
+    float p1;
+    float p2;
+} FilterOpC;
+
+typedef void (*fn_bufferApplyFilters)(BufferPtr, int32_t, int32_t, uint32_t, uint32_t, const FilterOpC*, uint32_t);
+
+#define FILTER_OPS_PER_CALL 32
+
+void bufferApplyFiltersMB(BufferPtr buffer, int32_t x, int32_t y, uint32_t width, uint32_t height, const double* ops, uint32_t count) {
+    fn_bufferApplyFilters f = (fn_bufferApplyFilters)sym("bufferApplyFilters");
+    if (!f) return;
+    FilterOpC packed[FILTER_OPS_PER_CALL];
+    uint32_t done = 0;
+    // Longer chains go over in batches; each batch is still fused natively
+    while (done < count) {
+        uint32_t n = count - done;
+        if (n > FILTER_OPS_PER_CALL) n = FILTER_OPS_PER_CALL;
+        for (uint32_t i = 0; i < n; i++) {
+            const double* op = ops + (size_t)(done + i) * 4;
+            packed[i].kind = (uint32_t)op[0];
+            packed[i].p0 = (float)op[1];
+            packed[i].p1 = (float)op[2];
+            packed[i].p2 = (float)op[3];
+        }
+        f(buffer, x, y, width, height, packed, n);
+        done += n;
+    }
+}
+
 // Terminal input handling functions
 #include <termios.h>
 #include <unistd.h>
@@ -408,6 +804,7 @@ bool isInputAvailable() {
 
 // Signal handling for terminal resize
 #include <signal.h>
+#include <time.h>
 
 static volatile sig_atomic_t terminal_resized = 0;
 static void (*resize_callback)(uint32_t, uint32_t) = NULL;
@@ -469,3 +866,214 @@ void disableMouseTracking() {
 void sleepMs(int milliseconds) {
     usleep(milliseconds * 1000);
 }
+
+// Monotonic clock in milliseconds, used as the animation frame clock
+double monotonicMs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1000000.0;
+}
+
+// Child processes on a pseudo terminal, for terminal panes
+#include <stdlib.h>
+#include <sys/wait.h>
+
+#define PTY_MAX_ARGS 64
+
+extern char** environ;
+
+static char* ptyCopyString(const char* src, size_t len) {
+    char* out = malloc(len + 1);
+    if (!out) return NULL;
+    memcpy(out, src, len);
+    out[len] = '\0';
+    return out;
+}
+
+// The forked child of a multithreaded process may only make async-signal-safe
+// calls, so the environment and the program path are prepared before fork.
+// The environment keeps the parent's entries with TERM replaced.
+static char** ptyBuildEnv(void) {
+    size_t n = 0;
+    while (environ[n]) n++;
+    char** envp = malloc((n + 2) * sizeof(char*));
+    if (!envp) return NULL;
+    size_t k = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (strncmp(environ[i], "TERM=", 5) != 0) envp[k++] = environ[i];
+    }
+    envp[k++] = "TERM=xterm-256color";
+    envp[k] = NULL;
+    return envp;
+}
+
+// Look program up in PATH like execvp. Falls back to the bare name so a
+// missing program still fails in the child with status 127.
+static char* ptyResolvePath(const char* program) {
+    size_t plen = strlen(program);
+    if (strchr(program, '/')) return ptyCopyString(program, plen);
+    const char* path = getenv("PATH");
+    if (!path) path = "/usr/bin:/bin";
+    for (;;) {
+        const char* end = strchr(path, ':');
+        size_t dlen = end ? (size_t)(end - path) : strlen(path);
+        // An empty entry means the current directory
+        const char* dir = dlen > 0 ? path : ".";
+        if (dlen == 0) dlen = 1;
+        char* candidate = malloc(dlen + plen + 2);
+        if (!candidate) return NULL;
+        memcpy(candidate, dir, dlen);
+        candidate[dlen] = '/';
+        memcpy(candidate + dlen + 1, program, plen + 1);
+        if (access(candidate, X_OK) == 0) return candidate;
+        free(candidate);
+        if (!end) break;
+        path = end + 1;
+    }
+    return ptyCopyString(program, plen);
+}
+
+// Start argv (NUL-separated strings in args) on a new pty of the given
+// size. Returns the master fd and stores the child pid, or -1.
+int32_t ptySpawn(const uint8_t* args, uint32_t argsLen, uint32_t cols, uint32_t rows, int32_t* pidOut) {
+    char* copy = malloc(argsLen + 1);
+    if (!copy) return -1;
+    memcpy(copy, args, argsLen);
+    copy[argsLen] = '\0';
+
+    char* argv[PTY_MAX_ARGS + 1];
+    int argc = 0;
+    uint32_t start = 0;
+    for (uint32_t i = 0; i <= argsLen && argc < PTY_MAX_ARGS; i++) {
+        if (copy[i] != '\0') continue;
+        if (i > start) argv[argc++] = copy + start;
+        start = i + 1;
+    }
+    argv[argc] = NULL;
+    if (argc == 0) {
+        free(copy);
+        return -1;
+    }
+
+    char** envp = ptyBuildEnv();
+    char* program = ptyResolvePath(argv[0]);
+    if (!envp || !program) {
+        free(envp);
+        free(program);
+        free(copy);
+        return -1;
+    }
+
+    // Close-on-exec from the start, so a concurrent fork elsewhere in the
+    // process can't inherit the master
+    int master = posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (master < 0 && errno == EINVAL) {
+        // Older systems only take O_RDWR | O_NOCTTY here
+        master = posix_openpt(O_RDWR | O_NOCTTY);
+        if (master >= 0) fcntl(master, F_SETFD, FD_CLOEXEC);
+    }
+    char slaveName[128];
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0 ||
+        ptsname_r(master, slaveName, sizeof(slaveName)) != 0) {
+        if (master >= 0) close(master);
+        free(envp);
+        free(program);
+        free(copy);
+        return -1;
+    }
+
+    struct winsize ws;
+    memset(&ws, 0, sizeof(ws));
+    ws.ws_col = (unsigned short)cols;
+    ws.ws_row = (unsigned short)rows;
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(master);
+        free(envp);
+        free(program);
+        free(copy);
+        return -1;
+    }
+    if (pid == 0) {
+        // exec keeps the signal mask and ignored signals; give the program
+        // a clean slate for the ones the runtime may have changed
+        static const int defaults[] = {
+            SIGHUP, SIGINT, SIGQUIT, SIGPIPE, SIGTERM, SIGCHLD,
+            SIGWINCH, SIGTSTP, SIGTTIN, SIGTTOU,
+        };
+        struct sigaction dfl;
+        memset(&dfl, 0, sizeof(dfl));
+        dfl.sa_handler = SIG_DFL;
+        sigemptyset(&dfl.sa_mask);
+        for (size_t i = 0; i < sizeof(defaults) / sizeof(defaults[0]); i++) {
+            sigaction(defaults[i], &dfl, NULL);
+        }
+        sigset_t none;
+        sigemptyset(&none);
+        sigprocmask(SIG_SETMASK, &none, NULL);
+        setsid();
+        int slave = open(slaveName, O_RDWR);
+        if (slave < 0) _exit(127);
+#ifdef TIOCSCTTY
+        ioctl(slave, TIOCSCTTY, 0);
+#endif
+        ioctl(slave, TIOCSWINSZ, &ws);
+        dup2(slave, STDIN_FILENO);
+        dup2(slave, STDOUT_FILENO);
+        dup2(slave, STDERR_FILENO);
+        if (slave > STDERR_FILENO) close(slave);
+        close(master);
+        execve(program, argv, envp);
+        _exit(127);
+    }
+
+    free(envp);
+    free(program);
+    free(copy);
+    *pidOut = (int32_t)pid;
+    return master;
+}
+
+// Tell the child its pty changed size (it gets SIGWINCH)
+void ptyResize(int32_t fd, uint32_t cols, uint32_t rows) {
+    struct winsize ws;
+    memset(&ws, 0, sizeof(ws));
+    ws.ws_col = (unsigned short)cols;
+    ws.ws_row = (unsigned short)rows;
+    ioctl(fd, TIOCSWINSZ, &ws);
+}
+
+static int32_t ptyExitCode(int status) {
+    if (WIFEXITED(status)) return WEXITSTATUS(status);
+    return 128 + (WIFSIGNALED(status) ? WTERMSIG(status) : 0);
+}
+
+// Exit status of the child once it has exited, -1 while it runs
+int32_t ptyWait(int32_t pid) {
+    int status = 0;
+    if (waitpid((pid_t)pid, &status, WNOHANG) != (pid_t)pid) return -1;
+    return ptyExitCode(status);
+}
+
+// Give a hung-up child graceMs to exit, then SIGKILL it and block until it
+// is reaped, so no zombie is left behind. Returns its exit status.
+int32_t ptyReap(int32_t pid, int32_t graceMs) {
+    int status = 0;
+    for (int32_t waited = 0; waited < graceMs; waited += 5) {
+        pid_t r = waitpid((pid_t)pid, &status, WNOHANG);
+        if (r == (pid_t)pid) return ptyExitCode(status);
+        if (r < 0 && errno != EINTR) return -1;
+        usleep(5000);
+    }
+    kill((pid_t)pid, SIGKILL);
+    for (;;) {
+        pid_t r = waitpid((pid_t)pid, &status, 0);
+        if (r == (pid_t)pid) return ptyExitCode(status);
+        if (r < 0 && errno != EINTR) return -1;
+    }
+}
+
+void ptyKill(int32_t pid, int32_t signal) {
+    kill((pid_t)pid, signal);
+}
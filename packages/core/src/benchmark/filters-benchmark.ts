@@ -0,0 +1,97 @@
+#!/usr/bin/env bun
+
+import { OptimizedBuffer, RGBA } from "../index"
+import { applyGrayscale, applySepia, BrightnessEffect, VignetteEffect, BlurEffect, BloomEffect } from "../post/filters"
+import { NativeFilterChain } from "../post/native-filters"
+import { Command } from "commander"
+
+const program = new Command()
+program
+  .name("filters-benchmark")
+  .description("JS post-processing filters vs the native filter chain")
+  .option("-w, --width <cells>", "buffer width", "200")
+  .option("-h, --height <cells>", "buffer height", "60")
+  .option("-i, --iterations <n>", "iterations per scenario", "200")
+  .parse(process.argv)
+
+const options = program.opts()
+const WIDTH = parseInt(options.width)
+const HEIGHT = parseInt(options.height)
+const ITERATIONS = parseInt(options.iterations)
+
+const buffer = OptimizedBuffer.create(WIDTH, HEIGHT, "unicode", { id: "filters-benchmark" })
+
+function fill(): void {
+  for (let y = 0; y < HEIGHT; y++) {
+    const bg = RGBA.fromValues(y / HEIGHT, 0.4, 1 - y / HEIGHT, 1)
+    buffer.fillRect(0, y, WIDTH, 1, bg)
+    buffer.drawText("filters ".repeat(Math.ceil(WIDTH / 8)).slice(0, WIDTH), 0, y, RGBA.fromValues(0.9, 0.9, 0.8, 1))
+  }
+}
+
+function measure(name: string, run: () => void): number {
+  // Warm up so the JIT and the native pools settle
+  for (let i = 0; i < 10; i++) {
+    fill()
+    run()
+  }
+
+  let total = 0
+  for (let i = 0; i < ITERATIONS; i++) {
+    fill()
+    const start = performance.now()
+    run()
+    total += performance.now() - start
+  }
+  const avg = total / ITERATIONS
+  console.log(`${name.padEnd(40)} ${avg.toFixed(3)} ms/frame`)
+  return avg
+}
+
+function compare(name: string, js: () => void, native: () => void): void {
+  console.log(`\n${name}`)
+  const jsAvg = measure("  js", js)
+  const nativeAvg = measure("  native", native)
+  console.log(`  speedup ${(jsAvg / nativeAvg).toFixed(1)}x`)
+}
+
+console.log(`Buffer ${WIDTH}x${HEIGHT}, ${ITERATIONS} iterations`)
+
+const brightness = new BrightnessEffect(0.7)
+const vignette = new VignetteEffect(0.6)
+const colorChain = new NativeFilterChain().grayscale().brightness(0.7).vignette(0.6)
+compare(
+  "grayscale + brightness + vignette",
+  () => {
+    applyGrayscale(buffer)
+    brightness.apply(buffer)
+    vignette.apply(buffer)
+  },
+  () => colorChain.apply(buffer),
+)
+
+const sepiaChain = new NativeFilterChain().sepia()
+compare(
+  "sepia",
+  () => applySepia(buffer),
+  () => sepiaChain.apply(buffer),
+)
+
+// The JS blur also averages characters, so the native run does strictly less work
+const blur = new BlurEffect(2)
+const blurChain = new NativeFilterChain().blur(2)
+compare(
+  "blur (radius 2)",
+  () => blur.apply(buffer),
+  () => blurChain.apply(buffer),
+)
+
+const bloom = new BloomEffect(0.8, 0.2, 2)
+const bloomChain = new NativeFilterChain().bloom(0.8, 0.2, 2)
+compare(
+  "bloom",
+  () => bloom.apply(buffer),
+  () => bloomChain.apply(buffer),
+)
+
+buffer.destroy()
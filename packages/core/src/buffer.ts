@@ -211,10 +211,24 @@ export class OptimizedBuffer {
     }
   }
 
+  // Cells drawn until the next call link to url, null stops linking
+  public setLink(url: string | null): void {
+    this.guard()
+    const linkId = url ? this.lib.internHyperlink(url) : 0
+    this.lib.bufferSetLink(this.bufferPtr, linkId)
+  }
+
   public fillRect(x: number, y: number, width: number, height: number, bg: RGBA): void {
     this.lib.bufferFillRect(this.bufferPtr, x, y, width, height, bg)
   }
 
+  // Runs packed filter ops (see post/native-filters) over a rect natively
+  public applyFilters(ops: ArrayBuffer, count: number, x: number, y: number, width: number, height: number): void {
+    this.guard()
+    if (count === 0) return
+    this.lib.bufferApplyFilters(this.bufferPtr, x, y, width, height, ops, count)
+  }
+
   public drawFrameBuffer(
     destX: number,
     destY: number,
@@ -5,6 +5,7 @@ export * from "./utils"
 export * from "./buffer"
 export * from "./text-buffer"
 export * from "./post/filters"
+export * from "./post/native-filters"
 export * from "./animation/Timeline"
 export * from "./lib"
 export * from "./renderer"
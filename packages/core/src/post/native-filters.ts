@@ -0,0 +1,108 @@
+import type { OptimizedBuffer } from "../buffer"
+
+export enum NativeFilterKind {
+  Grayscale = 0,
+  Sepia = 1,
+  Invert = 2,
+  Brightness = 3,
+  Blur = 4,
+  Vignette = 5,
+  Bloom = 6,
+}
+
+const OP_BYTES = 16
+
+/**
+ * A chain of post-processing filters run by the native library.
+ * Adjacent color filters are fused and run in a single SIMD pass over the
+ * buffer, so a chain costs far less than calling the JS filters one by one.
+ * Each op is packed as four 32-bit words: kind (u32), then three f32 params.
+ */
+export class NativeFilterChain {
+  private ops: ArrayBuffer
+  private kinds: Uint32Array
+  private params: Float32Array
+  private _count: number = 0
+
+  constructor(capacity: number = 8) {
+    this.ops = new ArrayBuffer(capacity * OP_BYTES)
+    this.kinds = new Uint32Array(this.ops)
+    this.params = new Float32Array(this.ops)
+  }
+
+  get count(): number {
+    return this._count
+  }
+
+  private push(kind: NativeFilterKind, p0: number = 0, p1: number = 0, p2: number = 0): this {
+    if ((this._count + 1) * OP_BYTES > this.ops.byteLength) {
+      const grown = new ArrayBuffer(this.ops.byteLength * 2)
+      new Uint8Array(grown).set(new Uint8Array(this.ops))
+      this.ops = grown
+      this.kinds = new Uint32Array(grown)
+      this.params = new Float32Array(grown)
+    }
+    const base = this._count * 4
+    this.kinds[base] = kind
+    this.params[base + 1] = p0
+    this.params[base + 2] = p1
+    this.params[base + 3] = p2
+    this._count++
+    return this
+  }
+
+  public grayscale(): this {
+    return this.push(NativeFilterKind.Grayscale)
+  }
+
+  public sepia(): this {
+    return this.push(NativeFilterKind.Sepia)
+  }
+
+  public invert(): this {
+    return this.push(NativeFilterKind.Invert)
+  }
+
+  /**
+   * Scales RGB by factor; below 1 dims, above 1 brightens.
+   */
+  public brightness(factor: number): this {
+    return this.push(NativeFilterKind.Brightness, factor)
+  }
+
+  public dim(amount: number = 0.5): this {
+    return this.push(NativeFilterKind.Brightness, 1 - amount)
+  }
+
+  /**
+   * Box blur of the colors only; unlike BlurEffect the characters are left alone.
+   */
+  public blur(radius: number = 1): this {
+    return this.push(NativeFilterKind.Blur, radius)
+  }
+
+  public vignette(strength: number = 0.5): this {
+    return this.push(NativeFilterKind.Vignette, strength)
+  }
+
+  public bloom(threshold: number = 0.8, strength: number = 0.2, radius: number = 2): this {
+    return this.push(NativeFilterKind.Bloom, threshold, strength, radius)
+  }
+
+  public clear(): void {
+    this._count = 0
+  }
+
+  /**
+   * Applies the chain to a rect of the buffer (the whole buffer by default).
+   */
+  public apply(
+    buffer: OptimizedBuffer,
+    x: number = 0,
+    y: number = 0,
+    width: number = buffer.width,
+    height: number = buffer.height,
+  ): void {
+    buffer.applyFilters(this.ops, this._count, x, y, width, height)
+  }
+}
@@ -184,6 +184,8 @@ export class CliRenderer extends EventEmitter implements RenderContext {
 
   private rendering: boolean = false
   private renderingNative: boolean = false
+  private hitRegionBatch: Int32Array = new Int32Array(5 * 256)
+  private hitRegionCount: number = 0
   private renderTimeout: Timer | null = null
   private lastTime: number = 0
   private frameCount: number = 0
@@ -416,10 +418,29 @@ export class CliRenderer extends EventEmitter implements RenderContext {
     this._currentFocusedRenderable = renderable
   }
 
+  // Hit regions are batched during the draw pass and handed to the native side
+  // in one call per frame, as (x, y, width, height, id) int32 quintuples
   public addToHitGrid(x: number, y: number, width: number, height: number, id: number) {
-    if (id !== this.capturedRenderable?.num) {
-      this.lib.addToHitGrid(this.rendererPtr, x, y, width, height, id)
+    if (id === this.capturedRenderable?.num) return
+
+    const offset = this.hitRegionCount * 5
+    if (offset + 5 > this.hitRegionBatch.length) {
+      const grown = new Int32Array(this.hitRegionBatch.length * 2)
+      grown.set(this.hitRegionBatch)
+      this.hitRegionBatch = grown
     }
+    this.hitRegionBatch[offset] = x
+    this.hitRegionBatch[offset + 1] = y
+    this.hitRegionBatch[offset + 2] = width
+    this.hitRegionBatch[offset + 3] = height
+    this.hitRegionBatch[offset + 4] = id
+    this.hitRegionCount++
+  }
+
+  private flushHitRegions(): void {
+    if (this.hitRegionCount === 0) return
+    this.lib.addHitRegions(this.rendererPtr, this.hitRegionBatch, this.hitRegionCount)
+    this.hitRegionCount = 0
   }
 
   public get widthMethod(): WidthMethod {
@@ -644,21 +665,31 @@ export class CliRenderer extends EventEmitter implements RenderContext {
     this.stdin.resume()
     this.stdin.setEncoding("utf8")
 
-    await new Promise((resolve) => {
-      const timeout = setTimeout(() => {
+    // The listener stays attached until the DA1 reply that answers the last
+    // query arrives. Native code ignores chunks that are not probe replies, so
+    // keys, mouse reports and the pixel resolution reply reach stdinListener
+    const probe = new Promise<void>((resolve) => {
+      const finish = () => {
+        clearTimeout(timeout)
         this.stdin.off("data", capListener)
-        resolve(true)
-      }, 100)
+        resolve()
+      }
+      const timeout = setTimeout(finish, 100)
       const capListener = (str: string) => {
-        clearTimeout(timeout)
         this.lib.processCapabilityResponse(this.rendererPtr, str)
-        this.stdin.off("data", capListener)
-        resolve(true)
+        this._capabilities = this.lib.getTerminalCapabilities(this.rendererPtr)
+        if (/\x1b\[\?[\d;]+c/.test(str)) finish()
       }
       this.stdin.on("data", capListener)
       this.lib.setupTerminal(this.rendererPtr, this._useAlternateScreen)
     })
 
+    // With capabilities cached from an earlier run the probe only re-verifies
+    // them in the background, so startup doesn't wait on the round trip
+    if (!this.lib.hasCachedCapabilities(this.rendererPtr)) {
+      await probe
+    }
+
     this._capabilities = this.lib.getTerminalCapabilities(this.rendererPtr)
 
     if (this._useMouse) {
@@ -1242,6 +1273,7 @@ export class CliRenderer extends EventEmitter implements RenderContext {
 
     this._console.renderToBuffer(this.nextRenderBuffer)
 
+    this.flushHitRegions()
     this.renderNative()
 
     const overallFrameTime = performance.now() - overallStart
@@ -91,12 +91,7 @@ export class TextBuffer {
   public getSelectedText(): string {
     this.guard()
     if (this._length === 0) return ""
-    // TODO: The _length should be the text length, need to know the number of bytes for the text though
-    const selectedBytes = this.lib.getSelectedTextBytes(this.bufferPtr, this.length * 4)
-
-    if (!selectedBytes) return ""
-
-    return this.lib.decoder.decode(selectedBytes)
+    return this.lib.getSelectedTextStreamed(this.bufferPtr)
   }
 
   public getPlainText(): string {
@@ -163,6 +158,11 @@ export class TextBuffer {
     return this.getSelection() !== null
   }
 
+  public takeSelectionDirtyRows(): { start: number; end: number } | null {
+    this.guard()
+    return this.lib.textBufferTakeSelectionDirtyRows(this.bufferPtr)
+  }
+
   public insertChunkGroup(index: number, text: string, fg?: RGBA, bg?: RGBA, attributes?: number): void {
     this.guard()
     const textBytes = this.lib.encoder.encode(text)
@@ -33,6 +33,18 @@ function getOpenTUILib(libPath?: string) {
       args: ["ptr", "bool"],
       returns: "void",
     },
+    setRetainedMode: {
+      args: ["ptr", "bool"],
+      returns: "void",
+    },
+    setStyleInterning: {
+      args: ["ptr", "bool"],
+      returns: "bool",
+    },
+    getStyleStats: {
+      args: ["ptr", "ptr"],
+      returns: "void",
+    },
     setBackgroundColor: {
       args: ["ptr", "ptr"],
       returns: "void",
@@ -136,10 +148,22 @@ function getOpenTUILib(libPath?: string) {
       args: ["ptr", "u32", "u32", "u32", "ptr", "ptr", "u8"],
       returns: "void",
     },
+    internHyperlink: {
+      args: ["ptr", "usize"],
+      returns: "u16",
+    },
+    bufferSetLink: {
+      args: ["ptr", "u16"],
+      returns: "void",
+    },
     bufferFillRect: {
       args: ["ptr", "u32", "u32", "u32", "u32", "ptr"],
       returns: "void",
     },
+    bufferApplyFilters: {
+      args: ["ptr", "i32", "i32", "u32", "u32", "ptr", "u32"],
+      returns: "void",
+    },
     bufferResize: {
       args: ["ptr", "u32", "u32"],
       returns: "void",
@@ -169,6 +193,10 @@ function getOpenTUILib(libPath?: string) {
       args: ["ptr", "bool", "u8"],
       returns: "void",
     },
+    setDebugReport: {
+      args: ["ptr", "ptr", "usize"],
+      returns: "void",
+    },
 
     // Terminal control
     clearTerminal: {
@@ -209,6 +237,10 @@ function getOpenTUILib(libPath?: string) {
       args: ["ptr", "i32", "i32", "u32", "u32", "u32"],
       returns: "void",
     },
+    addHitRegions: {
+      args: ["ptr", "ptr", "u32"],
+      returns: "void",
+    },
     checkHit: {
       args: ["ptr", "u32", "u32"],
       returns: "u32",
@@ -292,6 +324,10 @@ function getOpenTUILib(libPath?: string) {
       args: ["ptr", "ptr", "u32", "ptr", "ptr", "ptr"],
       returns: "u32",
     },
+    textBufferWriteAnsi: {
+      args: ["ptr", "ptr", "u32"],
+      returns: "bool",
+    },
     textBufferFinalizeLineInfo: {
       args: ["ptr"],
       returns: "void",
@@ -312,6 +348,14 @@ function getOpenTUILib(libPath?: string) {
       args: ["ptr", "ptr", "usize"],
       returns: "usize",
     },
+    textBufferGetSelectedTextChunk: {
+      args: ["ptr", "u32", "ptr", "u32"],
+      returns: "u64",
+    },
+    textBufferGetSelectionDirtyRows: {
+      args: ["ptr"],
+      returns: "u64",
+    },
     textBufferGetPlainText: {
       args: ["ptr", "ptr", "usize"],
       returns: "usize",
@@ -348,12 +392,230 @@ function getOpenTUILib(libPath?: string) {
       args: ["ptr", "u8"],
       returns: "void",
     },
+    textBufferSearch: {
+      args: ["ptr", "ptr", "u32", "u32", "u32", "u32"],
+      returns: "bool",
+    },
+    textBufferSearchRun: {
+      args: ["ptr", "u32"],
+      returns: "bool",
+    },
+    textBufferSearchClear: {
+      args: ["ptr"],
+      returns: "void",
+    },
+    textBufferSearchGetMatch: {
+      args: ["ptr", "u32", "ptr"],
+      returns: "bool",
+    },
+    textBufferSearchFind: {
+      args: ["ptr", "u32", "bool"],
+      returns: "u32",
+    },
+    textBufferSearchHighlight: {
+      args: ["ptr", "u32", "u32", "u32"],
+      returns: "u32",
+    },
+    textBufferSearchSetColors: {
+      args: ["ptr", "ptr", "ptr", "ptr", "ptr"],
+      returns: "void",
+    },
+    textBufferSearchGetStats: {
+      args: ["ptr", "ptr"],
+      returns: "void",
+    },
 
     getArenaAllocatedBytes: {
       args: [],
       returns: "usize",
     },
 
+    // Display width cache
+    measureText: {
+      args: ["ptr", "usize", "u8"],
+      returns: "u32",
+    },
+    getWidthCacheStats: {
+      args: ["ptr"],
+      returns: "void",
+    },
+    resetWidthCacheStats: {
+      args: [],
+      returns: "void",
+    },
+
+    // Retained scene graph
+    createScene: {
+      args: [],
+      returns: "ptr",
+    },
+    destroyScene: {
+      args: ["ptr"],
+      returns: "void",
+    },
+    scenePatch: {
+      args: ["ptr", "ptr", "usize", "ptr", "usize"],
+      returns: "bool",
+    },
+    sceneRender: {
+      args: ["ptr", "ptr", "bool"],
+      returns: "void",
+    },
+    sceneHitTest: {
+      args: ["ptr", "i32", "i32"],
+      returns: "u32",
+    },
+    sceneGetStats: {
+      args: ["ptr", "ptr"],
+      returns: "void",
+    },
+
+    // Streaming charts
+    createChart: {
+      args: ["u32", "u32", "u8", "u32", "u32"],
+      returns: "ptr",
+    },
+    destroyChart: {
+      args: ["ptr"],
+      returns: "void",
+    },
+    chartAddSeries: {
+      args: ["ptr", "ptr"],
+      returns: "i32",
+    },
+    chartSetSeriesColor: {
+      args: ["ptr", "u32", "ptr"],
+      returns: "void",
+    },
+    chartPush: {
+      args: ["ptr", "u32", "f32"],
+      returns: "void",
+    },
+    chartPushMany: {
+      args: ["ptr", "u32", "ptr", "usize"],
+      returns: "void",
+    },
+    chartSetRange: {
+      args: ["ptr", "f32", "f32"],
+      returns: "void",
+    },
+    chartSetFill: {
+      args: ["ptr", "bool"],
+      returns: "void",
+    },
+    chartSetBackground: {
+      args: ["ptr", "ptr"],
+      returns: "void",
+    },
+    chartResize: {
+      args: ["ptr", "u32", "u32"],
+      returns: "void",
+    },
+    chartDraw: {
+      args: ["ptr", "ptr", "i32", "i32"],
+      returns: "void",
+    },
+    chartGetStats: {
+      args: ["ptr", "ptr"],
+      returns: "void",
+    },
+
+    // Terminal emulator panes
+    createVt: {
+      args: ["u32", "u32", "u32"],
+      returns: "ptr",
+    },
+    destroyVt: {
+      args: ["ptr"],
+      returns: "void",
+    },
+    vtAttach: {
+      args: ["ptr", "i32"],
+      returns: "bool",
+    },
+    vtFeed: {
+      args: ["ptr", "ptr", "usize"],
+      returns: "void",
+    },
+    vtWriteInput: {
+      args: ["ptr", "ptr", "usize"],
+      returns: "bool",
+    },
+    vtResize: {
+      args: ["ptr", "u32", "u32"],
+      returns: "void",
+    },
+    vtScrollView: {
+      args: ["ptr", "i32"],
+      returns: "void",
+    },
+    vtSetColors: {
+      args: ["ptr", "ptr", "ptr"],
+      returns: "void",
+    },
+    vtHasDamage: {
+      args: ["ptr"],
+      returns: "bool",
+    },
+    vtGetModes: {
+      args: ["ptr"],
+      returns: "u32",
+    },
+    vtDraw: {
+      args: ["ptr", "ptr", "i32", "i32", "bool", "bool"],
+      returns: "void",
+    },
+    vtGetStats: {
+      args: ["ptr", "ptr"],
+      returns: "void",
+    },
+
+    // Line diffs
+    createDiff: {
+      args: ["ptr", "usize", "ptr", "usize"],
+      returns: "ptr",
+    },
+    destroyDiff: {
+      args: ["ptr"],
+      returns: "void",
+    },
+    diffSetMode: {
+      args: ["ptr", "u8"],
+      returns: "void",
+    },
+    diffSetContext: {
+      args: ["ptr", "u32"],
+      returns: "void",
+    },
+    diffSetColors: {
+      args: ["ptr", "u8", "ptr", "ptr"],
+      returns: "void",
+    },
+    diffEnsureRows: {
+      args: ["ptr", "u32"],
+      returns: "u32",
+    },
+    diffNextChange: {
+      args: ["ptr", "u32"],
+      returns: "u32",
+    },
+    diffPrevChange: {
+      args: ["ptr", "u32"],
+      returns: "u32",
+    },
+    diffGetRow: {
+      args: ["ptr", "u32", "ptr"],
+      returns: "bool",
+    },
+    diffDraw: {
+      args: ["ptr", "ptr", "i32", "i32", "u32", "u32", "u32"],
+      returns: "void",
+    },
+    diffGetStats: {
+      args: ["ptr", "ptr"],
+      returns: "void",
+    },
+
     bufferDrawTextBuffer: {
       args: ["ptr", "ptr", "i32", "i32", "i32", "i32", "u32", "u32", "bool"],
       returns: "void",
@@ -368,6 +630,18 @@ function getOpenTUILib(libPath?: string) {
       args: ["ptr", "ptr", "usize"],
       returns: "void",
     },
+    hasCachedCapabilities: {
+      args: ["ptr"],
+      returns: "bool",
+    },
+    setupInlineRenderer: {
+      args: ["ptr", "u32"],
+      returns: "bool",
+    },
+    inlinePrint: {
+      args: ["ptr", "ptr", "usize"],
+      returns: "void",
+    },
   })
 
   if (process.env.DEBUG_FFI === "true" || process.env.TRACE_FFI === "true") {
@@ -551,10 +825,113 @@ export interface LineInfo {
   maxLineWidth: number
 }
 
+export interface WidthCacheStats {
+  hits: number
+  misses: number
+  uncached: number
+}
+
+export interface SceneStats {
+  nodes: number
+  records: number
+  layouts: number
+  painted: number
+  damagedCells: number
+}
+
+export type ChartMode = "braille" | "half-block"
+
+export interface ChartStats {
+  rasterizedColumns: number
+  drawnCells: number
+}
+
+export interface VtModes {
+  appCursor: boolean
+  bracketedPaste: boolean
+  exited: boolean
+  scrolledBack: boolean
+}
+
+export interface VtStats {
+  drawnRows: number
+  parsedBytes: number
+  historyRows: number
+}
+
+export type DiffMode = "unified" | "side-by-side"
+
+export type DiffColorSlot = "context" | "delete" | "insert" | "fold" | "gutter"
+
+export type DiffRowKind = "context" | "delete" | "insert" | "change" | "fold"
+
+export interface DiffRow {
+  kind: DiffRowKind
+  /** Zero-based line numbers, null when the row has no line on that side */
+  oldLine: number | null
+  newLine: number | null
+  /** Lines hidden by a fold row */
+  count: number
+}
+
+export interface DiffStats {
+  oldLines: number
+  newLines: number
+  deleted: number
+  inserted: number
+  rows: number
+  complete: boolean
+  bisections: number
+  cutoffs: number
+  drawnRows: number
+}
+
+export interface TextSearchOptions {
+  ignoreCase?: boolean
+  /** `.`, classes, `\d \w \s`, `* + ?` and `^ $`; no groups or alternation */
+  regex?: boolean
+}
+
+export interface TextSearchMatch {
+  start: number
+  end: number
+  /** Virtual line the match starts on */
+  row: number
+}
+
+export interface TextSearchStats {
+  matches: number
+  complete: boolean
+  linesScanned: number
+  cellsScanned: number
+  refined: number
+  highlighted: number
+}
+
+export interface StyleStats {
+  /** Distinct styles interned since the last table reset */
+  styles: number
+  transitions: number
+  transitionBytes: number
+  /** Transitions copied from the cache / formatted */
+  hits: number
+  misses: number
+  resets: number
+}
+
+const SEARCH_NO_MATCH = 0xffffffff
+
+const DIFF_NO_LINE = 0xffffffff
+const DIFF_COLOR_SLOTS: DiffColorSlot[] = ["context", "delete", "insert", "fold", "gutter"]
+const DIFF_ROW_KINDS: DiffRowKind[] = ["context", "delete", "insert", "change", "fold"]
+
 export interface RenderLib {
   createRenderer: (width: number, height: number, options?: { testing: boolean }) => Pointer | null
   destroyRenderer: (renderer: Pointer) => void
   setUseThread: (renderer: Pointer, useThread: boolean) => void
+  setRetainedMode: (renderer: Pointer, enabled: boolean) => void
+  setStyleInterning: (renderer: Pointer, enabled: boolean) => boolean
+  getStyleStats: (renderer: Pointer) => StyleStats
   setBackgroundColor: (renderer: Pointer, color: RGBA) => void
   setRenderOffset: (renderer: Pointer, offset: number) => void
   updateStats: (renderer: Pointer, time: number, fps: number, frameCallbackTime: number) => void
@@ -620,6 +997,17 @@ export interface RenderLib {
     attributes?: number,
   ) => void
   bufferFillRect: (buffer: Pointer, x: number, y: number, width: number, height: number, color: RGBA) => void
+  bufferApplyFilters: (
+    buffer: Pointer,
+    x: number,
+    y: number,
+    width: number,
+    height: number,
+    ops: ArrayBuffer,
+    count: number,
+  ) => void
+  internHyperlink: (url: string) => number
+  bufferSetLink: (buffer: Pointer, linkId: number) => void
   bufferDrawSuperSampleBuffer: (
     buffer: Pointer,
     x: number,
@@ -656,9 +1044,11 @@ export interface RenderLib {
   setCursorStyle: (renderer: Pointer, style: CursorStyle, blinking: boolean) => void
   setCursorColor: (renderer: Pointer, color: RGBA) => void
   setDebugOverlay: (renderer: Pointer, enabled: boolean, corner: DebugOverlayCorner) => void
+  setDebugReport: (renderer: Pointer, text: string) => void
   clearTerminal: (renderer: Pointer) => void
   setTerminalTitle: (renderer: Pointer, title: string) => void
   addToHitGrid: (renderer: Pointer, x: number, y: number, width: number, height: number, id: number) => void
+  addHitRegions: (renderer: Pointer, regions: Int32Array, count: number) => void
   checkHit: (renderer: Pointer, x: number, y: number) => number
   dumpHitGrid: (renderer: Pointer) => void
   dumpBuffers: (renderer: Pointer, timestamp?: number) => void
@@ -704,12 +1094,15 @@ export interface RenderLib {
     bg: RGBA | null,
     attributes: number | null,
   ) => number
+  textBufferWriteAnsi: (buffer: Pointer, textBytes: Uint8Array) => boolean
   textBufferFinalizeLineInfo: (buffer: Pointer) => void
   textBufferGetLineCount: (buffer: Pointer) => number
   textBufferGetLineInfoDirect: (buffer: Pointer, lineStartsPtr: Pointer, lineWidthsPtr: Pointer) => void
   textBufferGetLineInfo: (buffer: Pointer) => LineInfo
   textBufferGetSelection: (buffer: Pointer) => { start: number; end: number } | null
   getSelectedTextBytes: (buffer: Pointer, maxLength: number) => Uint8Array | null
+  getSelectedTextStreamed: (buffer: Pointer, chunkSize?: number) => string
+  textBufferTakeSelectionDirtyRows: (buffer: Pointer) => { start: number; end: number } | null
   getPlainTextBytes: (buffer: Pointer, maxLength: number) => Uint8Array | null
   readonly encoder: TextEncoder
   readonly decoder: TextDecoder
@@ -744,11 +1137,89 @@ export interface RenderLib {
   textBufferGetChunkGroupCount: (buffer: Pointer) => number
   textBufferSetWrapWidth: (buffer: Pointer, width: number) => void
   textBufferSetWrapMode: (buffer: Pointer, mode: "char" | "word") => void
+  textBufferSearch: (
+    buffer: Pointer,
+    pattern: Uint8Array,
+    options: TextSearchOptions,
+    firstRow: number,
+    rowCount: number,
+  ) => boolean
+  textBufferSearchRun: (buffer: Pointer, budget: number) => boolean
+  textBufferSearchClear: (buffer: Pointer) => void
+  textBufferSearchGetMatch: (buffer: Pointer, index: number) => TextSearchMatch | null
+  textBufferSearchFind: (buffer: Pointer, offset: number, backward: boolean) => number | null
+  textBufferSearchHighlight: (buffer: Pointer, firstRow: number, rowCount: number, current: number | null) => number
+  textBufferSearchSetColors: (
+    buffer: Pointer,
+    matchFg: RGBA | null,
+    matchBg: RGBA,
+    currentFg: RGBA | null,
+    currentBg: RGBA,
+  ) => void
+  textBufferSearchGetStats: (buffer: Pointer) => TextSearchStats
 
   getArenaAllocatedBytes: () => number
 
+  measureText: (text: string, widthMethod: WidthMethod) => number
+  getWidthCacheStats: () => WidthCacheStats
+  resetWidthCacheStats: () => void
+
+  createScene: () => Pointer | null
+  destroyScene: (scene: Pointer) => void
+  scenePatch: (scene: Pointer, words: Uint32Array, wordCount: number, text: Uint8Array, textLen: number) => boolean
+  sceneRender: (scene: Pointer, buffer: Pointer, full: boolean) => void
+  sceneHitTest: (scene: Pointer, x: number, y: number) => number
+  sceneGetStats: (scene: Pointer) => SceneStats
+
+  createChart: (
+    width: number,
+    height: number,
+    mode: ChartMode,
+    capacity: number,
+    samplesPerColumn: number,
+  ) => Pointer | null
+  destroyChart: (chart: Pointer) => void
+  chartAddSeries: (chart: Pointer, color: RGBA) => number
+  chartSetSeriesColor: (chart: Pointer, series: number, color: RGBA) => void
+  chartPush: (chart: Pointer, series: number, value: number) => void
+  chartPushMany: (chart: Pointer, series: number, values: Float32Array) => void
+  chartSetRange: (chart: Pointer, min: number, max: number) => void
+  chartSetFill: (chart: Pointer, fill: boolean) => void
+  chartSetBackground: (chart: Pointer, color: RGBA) => void
+  chartResize: (chart: Pointer, width: number, height: number) => void
+  chartDraw: (chart: Pointer, buffer: Pointer, x: number, y: number) => void
+  chartGetStats: (chart: Pointer) => ChartStats
+
+  createVt: (cols: number, rows: number, historyRows: number) => Pointer | null
+  destroyVt: (vt: Pointer) => void
+  vtAttach: (vt: Pointer, fd: number) => boolean
+  vtFeed: (vt: Pointer, bytes: Uint8Array) => void
+  vtWriteInput: (vt: Pointer, bytes: Uint8Array) => boolean
+  vtResize: (vt: Pointer, cols: number, rows: number) => void
+  vtScrollView: (vt: Pointer, delta: number) => void
+  vtSetColors: (vt: Pointer, fg: RGBA, bg: RGBA) => void
+  vtHasDamage: (vt: Pointer) => boolean
+  vtGetModes: (vt: Pointer) => VtModes
+  vtDraw: (vt: Pointer, buffer: Pointer, x: number, y: number, full: boolean, showCursor: boolean) => void
+  vtGetStats: (vt: Pointer) => VtStats
+
+  createDiff: (oldText: Uint8Array, newText: Uint8Array) => Pointer | null
+  destroyDiff: (diff: Pointer) => void
+  diffSetMode: (diff: Pointer, mode: DiffMode) => void
+  diffSetContext: (diff: Pointer, context: number | null) => void
+  diffSetColors: (diff: Pointer, slot: DiffColorSlot, fg: RGBA, bg: RGBA) => void
+  diffEnsureRows: (diff: Pointer, count: number) => number
+  diffNextChange: (diff: Pointer, from: number | null) => number | null
+  diffPrevChange: (diff: Pointer, from: number) => number | null
+  diffGetRow: (diff: Pointer, index: number) => DiffRow | null
+  diffDraw: (diff: Pointer, buffer: Pointer, x: number, y: number, width: number, height: number, top: number) => void
+  diffGetStats: (diff: Pointer) => DiffStats
+
   getTerminalCapabilities: (renderer: Pointer) => any
   processCapabilityResponse: (renderer: Pointer, response: string) => void
+  hasCachedCapabilities: (renderer: Pointer) => boolean
+  setupInlineRenderer: (renderer: Pointer, rows: number) => boolean
+  inlinePrint: (renderer: Pointer, text: string) => void
 }
 
 class FFIRenderLib implements RenderLib {
@@ -756,6 +1227,7 @@ class FFIRenderLib implements RenderLib {
   public readonly encoder: TextEncoder = new TextEncoder()
   public readonly decoder: TextDecoder = new TextDecoder()
   private logCallbackWrapper: any // Store the FFI callback wrapper
+  private hyperlinkIds: Map<string, number> = new Map() // Native link ids are stable, skip the FFI call on reuse
 
   constructor(libPath?: string) {
     this.opentui = getOpenTUILib(libPath)
@@ -831,6 +1303,27 @@ class FFIRenderLib implements RenderLib {
     this.opentui.symbols.setUseThread(renderer, useThread)
   }
 
+  public setRetainedMode(renderer: Pointer, enabled: boolean) {
+    this.opentui.symbols.setRetainedMode(renderer, enabled)
+  }
+
+  public setStyleInterning(renderer: Pointer, enabled: boolean): boolean {
+    return this.opentui.symbols.setStyleInterning(renderer, enabled)
+  }
+
+  public getStyleStats(renderer: Pointer): StyleStats {
+    const stats = new Uint32Array(6)
+    this.opentui.symbols.getStyleStats(renderer, stats)
+    return {
+      styles: stats[0],
+      transitions: stats[1],
+      transitionBytes: stats[2],
+      hits: stats[3],
+      misses: stats[4],
+      resets: stats[5],
+    }
+  }
+
   public setBackgroundColor(renderer: Pointer, color: RGBA) {
     this.opentui.symbols.setBackgroundColor(renderer, color.buffer)
   }
@@ -994,11 +1487,37 @@ class FFIRenderLib implements RenderLib {
     this.opentui.symbols.bufferSetCell(buffer, x, y, charPtr, fg, bg, attributes ?? 0)
   }
 
+  public internHyperlink(url: string): number {
+    const cached = this.hyperlinkIds.get(url)
+    if (cached !== undefined) return cached
+
+    const urlBytes = this.encoder.encode(url)
+    const linkId = this.opentui.symbols.internHyperlink(urlBytes, urlBytes.length)
+    if (linkId !== 0) this.hyperlinkIds.set(url, linkId)
+    return linkId
+  }
+
+  public bufferSetLink(buffer: Pointer, linkId: number): void {
+    this.opentui.symbols.bufferSetLink(buffer, linkId)
+  }
+
   public bufferFillRect(buffer: Pointer, x: number, y: number, width: number, height: number, color: RGBA) {
     const bg = color.buffer
     this.opentui.symbols.bufferFillRect(buffer, x, y, width, height, bg)
   }
 
+  public bufferApplyFilters(
+    buffer: Pointer,
+    x: number,
+    y: number,
+    width: number,
+    height: number,
+    ops: ArrayBuffer,
+    count: number,
+  ): void {
+    this.opentui.symbols.bufferApplyFilters(buffer, x, y, width, height, ops, count)
+  }
+
   public bufferDrawSuperSampleBuffer(
     buffer: Pointer,
     x: number,
@@ -1150,6 +1669,11 @@ class FFIRenderLib implements RenderLib {
     this.opentui.symbols.setDebugOverlay(renderer, enabled, corner)
   }
 
+  public setDebugReport(renderer: Pointer, text: string) {
+    const bytes = this.encoder.encode(text)
+    this.opentui.symbols.setDebugReport(renderer, bytes, bytes.length)
+  }
+
   public clearTerminal(renderer: Pointer) {
     this.opentui.symbols.clearTerminal(renderer)
   }
@@ -1163,6 +1687,10 @@ class FFIRenderLib implements RenderLib {
     this.opentui.symbols.addToHitGrid(renderer, x, y, width, height, id)
   }
 
+  public addHitRegions(renderer: Pointer, regions: Int32Array, count: number): void {
+    this.opentui.symbols.addHitRegions(renderer, regions, count)
+  }
+
   public checkHit(renderer: Pointer, x: number, y: number): number {
     return this.opentui.symbols.checkHit(renderer, x, y)
   }
@@ -1278,6 +1806,11 @@ class FFIRenderLib implements RenderLib {
     )
   }
 
+  /** Append raw terminal output; SGR state carries over between calls */
+  public textBufferWriteAnsi(buffer: Pointer, textBytes: Uint8Array): boolean {
+    return this.opentui.symbols.textBufferWriteAnsi(buffer, textBytes, textBytes.length)
+  }
+
   public textBufferFinalizeLineInfo(buffer: Pointer): void {
     this.opentui.symbols.textBufferFinalizeLineInfo(buffer)
   }
@@ -1330,6 +1863,39 @@ class FFIRenderLib implements RenderLib {
     return outBuffer.slice(0, actualLen)
   }
 
+  public getSelectedTextStreamed(buffer: Pointer, chunkSize: number = 64 * 1024): string {
+    const selection = this.textBufferGetSelection(buffer)
+    if (!selection) return ""
+
+    const outBuffer = new Uint8Array(chunkSize)
+    const decoder = new TextDecoder()
+    let result = ""
+    let from = selection.start
+
+    while (from < selection.end) {
+      const packed = this.opentui.symbols.textBufferGetSelectedTextChunk(buffer, from, ptr(outBuffer), chunkSize)
+      const next = Number(packed >> 32n)
+      const written = Number(packed & 0xffff_ffffn)
+
+      result += decoder.decode(outBuffer.subarray(0, written), { stream: true })
+      // A single character larger than the chunk cannot make progress
+      if (next === from && written === 0) break
+      from = next
+    }
+
+    return result + decoder.decode()
+  }
+
+  public textBufferTakeSelectionDirtyRows(buffer: Pointer): { start: number; end: number } | null {
+    const packedInfo: bigint = this.opentui.symbols.textBufferGetSelectionDirtyRows(buffer)
+
+    if (packedInfo === 0xffff_ffff_ffff_ffffn) {
+      return null
+    }
+
+    return { start: Number(packedInfo >> 32n), end: Number(packedInfo & 0xffff_ffffn) }
+  }
+
   public getPlainTextBytes(buffer: Pointer, maxLength: number): Uint8Array | null {
     const outBuffer = new Uint8Array(maxLength)
 
@@ -1422,11 +1988,320 @@ class FFIRenderLib implements RenderLib {
     this.opentui.symbols.textBufferSetWrapMode(buffer, modeValue)
   }
 
+  /** Start a search; the rows of the viewport are scanned before this returns. False if the pattern is invalid. */
+  public textBufferSearch(
+    buffer: Pointer,
+    pattern: Uint8Array,
+    options: TextSearchOptions,
+    firstRow: number,
+    rowCount: number,
+  ): boolean {
+    const flags = (options.ignoreCase ? 1 : 0) | (options.regex ? 2 : 0)
+    return this.opentui.symbols.textBufferSearch(buffer, pattern, pattern.length, flags, firstRow, rowCount)
+  }
+
+  /** Scan about `budget` more cells; true once the whole buffer has been searched */
+  public textBufferSearchRun(buffer: Pointer, budget: number): boolean {
+    return this.opentui.symbols.textBufferSearchRun(buffer, budget)
+  }
+
+  public textBufferSearchClear(buffer: Pointer): void {
+    this.opentui.symbols.textBufferSearchClear(buffer)
+  }
+
+  public textBufferSearchGetMatch(buffer: Pointer, index: number): TextSearchMatch | null {
+    const out = new Uint32Array(3)
+    if (!this.opentui.symbols.textBufferSearchGetMatch(buffer, index, out)) return null
+    return { start: out[0], end: out[1], row: out[2] }
+  }
+
+  /** Index of the first match at or after a char offset, or with `backward` the last one before it */
+  public textBufferSearchFind(buffer: Pointer, offset: number, backward: boolean): number | null {
+    const index = this.opentui.symbols.textBufferSearchFind(buffer, offset, backward)
+    return index === SEARCH_NO_MATCH ? null : index
+  }
+
+  public textBufferSearchHighlight(buffer: Pointer, firstRow: number, rowCount: number, current: number | null): number {
+    return this.opentui.symbols.textBufferSearchHighlight(
+      buffer,
+      firstRow,
+      rowCount,
+      current === null ? SEARCH_NO_MATCH : current,
+    )
+  }
+
+  public textBufferSearchSetColors(
+    buffer: Pointer,
+    matchFg: RGBA | null,
+    matchBg: RGBA,
+    currentFg: RGBA | null,
+    currentBg: RGBA,
+  ): void {
+    this.opentui.symbols.textBufferSearchSetColors(
+      buffer,
+      matchFg ? matchFg.buffer : null,
+      matchBg.buffer,
+      currentFg ? currentFg.buffer : null,
+      currentBg.buffer,
+    )
+  }
+
+  public textBufferSearchGetStats(buffer: Pointer): TextSearchStats {
+    const stats = new Uint32Array(6)
+    this.opentui.symbols.textBufferSearchGetStats(buffer, stats)
+    return {
+      matches: stats[0],
+      complete: stats[1] !== 0,
+      linesScanned: stats[2],
+      cellsScanned: stats[3],
+      refined: stats[4],
+      highlighted: stats[5],
+    }
+  }
+
   public getArenaAllocatedBytes(): number {
     const result = this.opentui.symbols.getArenaAllocatedBytes()
     return typeof result === "bigint" ? Number(result) : result
   }
 
+  public measureText(text: string, widthMethod: WidthMethod): number {
+    const textBytes = this.encoder.encode(text)
+    const widthMethodCode = widthMethod === "wcwidth" ? 0 : 1
+    return this.opentui.symbols.measureText(textBytes, textBytes.length, widthMethodCode)
+  }
+
+  public getWidthCacheStats(): WidthCacheStats {
+    const stats = new BigUint64Array(3)
+    this.opentui.symbols.getWidthCacheStats(stats)
+    return {
+      hits: Number(stats[0]),
+      misses: Number(stats[1]),
+      uncached: Number(stats[2]),
+    }
+  }
+
+  public resetWidthCacheStats(): void {
+    this.opentui.symbols.resetWidthCacheStats()
+  }
+
+  public createScene(): Pointer | null {
+    return this.opentui.symbols.createScene()
+  }
+
+  public destroyScene(scene: Pointer): void {
+    this.opentui.symbols.destroyScene(scene)
+  }
+
+  public scenePatch(scene: Pointer, words: Uint32Array, wordCount: number, text: Uint8Array, textLen: number): boolean {
+    return this.opentui.symbols.scenePatch(scene, words, wordCount, text, textLen)
+  }
+
+  public sceneRender(scene: Pointer, buffer: Pointer, full: boolean): void {
+    this.opentui.symbols.sceneRender(scene, buffer, full)
+  }
+
+  public sceneHitTest(scene: Pointer, x: number, y: number): number {
+    return this.opentui.symbols.sceneHitTest(scene, x, y)
+  }
+
+  public sceneGetStats(scene: Pointer): SceneStats {
+    const stats = new Uint32Array(5)
+    this.opentui.symbols.sceneGetStats(scene, stats)
+    return {
+      nodes: stats[0],
+      records: stats[1],
+      layouts: stats[2],
+      painted: stats[3],
+      damagedCells: stats[4],
+    }
+  }
+
+  public createChart(
+    width: number,
+    height: number,
+    mode: ChartMode,
+    capacity: number,
+    samplesPerColumn: number,
+  ): Pointer | null {
+    const modeCode = mode === "half-block" ? 1 : 0
+    return this.opentui.symbols.createChart(width, height, modeCode, capacity, samplesPerColumn)
+  }
+
+  public destroyChart(chart: Pointer): void {
+    this.opentui.symbols.destroyChart(chart)
+  }
+
+  public chartAddSeries(chart: Pointer, color: RGBA): number {
+    return this.opentui.symbols.chartAddSeries(chart, color.buffer)
+  }
+
+  public chartSetSeriesColor(chart: Pointer, series: number, color: RGBA): void {
+    this.opentui.symbols.chartSetSeriesColor(chart, series, color.buffer)
+  }
+
+  public chartPush(chart: Pointer, series: number, value: number): void {
+    this.opentui.symbols.chartPush(chart, series, value)
+  }
+
+  public chartPushMany(chart: Pointer, series: number, values: Float32Array): void {
+    this.opentui.symbols.chartPushMany(chart, series, values, values.length)
+  }
+
+  public chartSetRange(chart: Pointer, min: number, max: number): void {
+    this.opentui.symbols.chartSetRange(chart, min, max)
+  }
+
+  public chartSetFill(chart: Pointer, fill: boolean): void {
+    this.opentui.symbols.chartSetFill(chart, fill)
+  }
+
+  public chartSetBackground(chart: Pointer, color: RGBA): void {
+    this.opentui.symbols.chartSetBackground(chart, color.buffer)
+  }
+
+  public chartResize(chart: Pointer, width: number, height: number): void {
+    this.opentui.symbols.chartResize(chart, width, height)
+  }
+
+  public chartDraw(chart: Pointer, buffer: Pointer, x: number, y: number): void {
+    this.opentui.symbols.chartDraw(chart, buffer, x, y)
+  }
+
+  public chartGetStats(chart: Pointer): ChartStats {
+    const stats = new Uint32Array(2)
+    this.opentui.symbols.chartGetStats(chart, stats)
+    return {
+      rasterizedColumns: stats[0],
+      drawnCells: stats[1],
+    }
+  }
+
+  public createVt(cols: number, rows: number, historyRows: number): Pointer | null {
+    return this.opentui.symbols.createVt(cols, rows, historyRows)
+  }
+
+  public destroyVt(vt: Pointer): void {
+    this.opentui.symbols.destroyVt(vt)
+  }
+
+  public vtAttach(vt: Pointer, fd: number): boolean {
+    return this.opentui.symbols.vtAttach(vt, fd)
+  }
+
+  public vtFeed(vt: Pointer, bytes: Uint8Array): void {
+    this.opentui.symbols.vtFeed(vt, bytes, bytes.length)
+  }
+
+  public vtWriteInput(vt: Pointer, bytes: Uint8Array): boolean {
+    return this.opentui.symbols.vtWriteInput(vt, bytes, bytes.length)
+  }
+
+  public vtResize(vt: Pointer, cols: number, rows: number): void {
+    this.opentui.symbols.vtResize(vt, cols, rows)
+  }
+
+  public vtScrollView(vt: Pointer, delta: number): void {
+    this.opentui.symbols.vtScrollView(vt, delta)
+  }
+
+  public vtSetColors(vt: Pointer, fg: RGBA, bg: RGBA): void {
+    this.opentui.symbols.vtSetColors(vt, fg.buffer, bg.buffer)
+  }
+
+  public vtHasDamage(vt: Pointer): boolean {
+    return this.opentui.symbols.vtHasDamage(vt)
+  }
+
+  public vtGetModes(vt: Pointer): VtModes {
+    const modes = this.opentui.symbols.vtGetModes(vt)
+    return {
+      appCursor: (modes & 1) !== 0,
+      bracketedPaste: (modes & 2) !== 0,
+      exited: (modes & 4) !== 0,
+      scrolledBack: (modes & 8) !== 0,
+    }
+  }
+
+  public vtDraw(vt: Pointer, buffer: Pointer, x: number, y: number, full: boolean, showCursor: boolean): void {
+    this.opentui.symbols.vtDraw(vt, buffer, x, y, full, showCursor)
+  }
+
+  public vtGetStats(vt: Pointer): VtStats {
+    const stats = new Uint32Array(3)
+    this.opentui.symbols.vtGetStats(vt, stats)
+    return {
+      drawnRows: stats[0],
+      parsedBytes: stats[1],
+      historyRows: stats[2],
+    }
+  }
+
+  public createDiff(oldText: Uint8Array, newText: Uint8Array): Pointer | null {
+    return this.opentui.symbols.createDiff(oldText, oldText.length, newText, newText.length)
+  }
+
+  public destroyDiff(diff: Pointer): void {
+    this.opentui.symbols.destroyDiff(diff)
+  }
+
+  public diffSetMode(diff: Pointer, mode: DiffMode): void {
+    this.opentui.symbols.diffSetMode(diff, mode === "side-by-side" ? 1 : 0)
+  }
+
+  /** Unchanged lines shown around each change; null shows them all */
+  public diffSetContext(diff: Pointer, context: number | null): void {
+    this.opentui.symbols.diffSetContext(diff, context === null ? DIFF_NO_LINE : context)
+  }
+
+  public diffSetColors(diff: Pointer, slot: DiffColorSlot, fg: RGBA, bg: RGBA): void {
+    this.opentui.symbols.diffSetColors(diff, DIFF_COLOR_SLOTS.indexOf(slot), fg.buffer, bg.buffer)
+  }
+
+  public diffEnsureRows(diff: Pointer, count: number): number {
+    return this.opentui.symbols.diffEnsureRows(diff, count)
+  }
+
+  public diffNextChange(diff: Pointer, from: number | null): number | null {
+    const row = this.opentui.symbols.diffNextChange(diff, from === null ? DIFF_NO_LINE : from)
+    return row === DIFF_NO_LINE ? null : row
+  }
+
+  public diffPrevChange(diff: Pointer, from: number): number | null {
+    const row = this.opentui.symbols.diffPrevChange(diff, from)
+    return row === DIFF_NO_LINE ? null : row
+  }
+
+  public diffGetRow(diff: Pointer, index: number): DiffRow | null {
+    const out = new Uint32Array(4)
+    if (!this.opentui.symbols.diffGetRow(diff, index, out)) return null
+    return {
+      kind: DIFF_ROW_KINDS[out[0]],
+      oldLine: out[1] === DIFF_NO_LINE ? null : out[1],
+      newLine: out[2] === DIFF_NO_LINE ? null : out[2],
+      count: out[3],
+    }
+  }
+
+  public diffDraw(diff: Pointer, buffer: Pointer, x: number, y: number, width: number, height: number, top: number): void {
+    this.opentui.symbols.diffDraw(diff, buffer, x, y, width, height, top)
+  }
+
+  public diffGetStats(diff: Pointer): DiffStats {
+    const stats = new Uint32Array(9)
+    this.opentui.symbols.diffGetStats(diff, stats)
+    return {
+      oldLines: stats[0],
+      newLines: stats[1],
+      deleted: stats[2],
+      inserted: stats[3],
+      rows: stats[4],
+      complete: stats[5] !== 0,
+      bisections: stats[6],
+      cutoffs: stats[7],
+      drawnRows: stats[8],
+    }
+  }
+
   public textBufferGetLineInfo(buffer: Pointer): LineInfo {
     const lineCount = this.textBufferGetLineCount(buffer)
 
@@ -1512,6 +2387,19 @@ class FFIRenderLib implements RenderLib {
     const responseBytes = this.encoder.encode(response)
     this.opentui.symbols.processCapabilityResponse(renderer, responseBytes, responseBytes.length)
   }
+
+  public hasCachedCapabilities(renderer: Pointer): boolean {
+    return this.opentui.symbols.hasCachedCapabilities(renderer)
+  }
+
+  public setupInlineRenderer(renderer: Pointer, rows: number): boolean {
+    return this.opentui.symbols.setupInlineRenderer(renderer, rows)
+  }
+
+  public inlinePrint(renderer: Pointer, text: string): void {
+    const bytes = this.encoder.encode(text)
+    this.opentui.symbols.inlinePrint(renderer, bytes, bytes.length)
+  }
 }
 
 let opentuiLibPath: string | undefined
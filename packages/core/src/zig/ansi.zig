@@ -56,6 +56,13 @@ pub const ANSI = struct {
         std.fmt.format(writer, "\x1b]66;w={d};{s}\x1b\\", .{ width, text }) catch return AnsiError.WriteFailed;
     }
 
+    // OSC 8 hyperlinks, the id param lets terminals join wrapped segments of one link
+    pub fn hyperlinkOpenOutput(writer: anytype, id: u16, url: []const u8) AnsiError!void {
+        std.fmt.format(writer, "\x1b]8;id={d};{s}\x1b\\", .{ id, url }) catch return AnsiError.WriteFailed;
+    }
+
+    pub const hyperlinkClose = "\x1b]8;;\x1b\\";
+
     pub const resetCursorColor = "\x1b]112\x07";
     pub const resetCursorColorFallback = "\x1b]12;default\x07";
     pub const saveCursorState = "\x1b[s";
@@ -8,7 +8,9 @@ const DisplayWidth = @import("DisplayWidth");
 const code_point = @import("code_point");
 const gp = @import("grapheme.zig");
 const gwidth = @import("gwidth.zig");
+const width_cache = @import("width_cache.zig");
 const logger = @import("logger.zig");
+const link = @import("link.zig");
 
 pub const RGBA = ansi.RGBA;
 pub const Vec3f = @Vector(3, f32);
@@ -81,6 +83,7 @@ pub const Cell = struct {
     fg: RGBA,
     bg: RGBA,
     attributes: u8,
+    link: u16 = link.NO_LINK,
 };
 
 fn isRGBAWithAlpha(color: RGBA) bool {
@@ -120,6 +123,7 @@ pub const OptimizedBuffer = struct {
         fg: []RGBA,
         bg: []RGBA,
         attributes: []u8,
+        link: []u16, // Interned hyperlink id per cell, see link.zig
     },
     width: u32,
     height: u32,
@@ -132,6 +136,7 @@ pub const OptimizedBuffer = struct {
     width_method: gwidth.WidthMethod,
     id: []const u8,
     scissor_stack: std.ArrayList(ClipRect),
+    link_pen: u16, // Link id stamped onto every cell written until changed
 
     const InitOptions = struct {
         respectAlpha: bool = false,
@@ -166,6 +171,7 @@ pub const OptimizedBuffer = struct {
                 .fg = allocator.alloc(RGBA, size) catch return BufferError.OutOfMemory,
                 .bg = allocator.alloc(RGBA, size) catch return BufferError.OutOfMemory,
                 .attributes = allocator.alloc(u8, size) catch return BufferError.OutOfMemory,
+                .link = allocator.alloc(u16, size) catch return BufferError.OutOfMemory,
             },
             .width = width,
             .height = height,
@@ -178,12 +184,14 @@ pub const OptimizedBuffer = struct {
             .width_method = options.width_method,
             .id = owned_id,
             .scissor_stack = scissor_stack,
+            .link_pen = link.NO_LINK,
         };
 
         @memset(self.buffer.char, 0);
         @memset(self.buffer.fg, .{ 0.0, 0.0, 0.0, 0.0 });
         @memset(self.buffer.bg, .{ 0.0, 0.0, 0.0, 0.0 });
         @memset(self.buffer.attributes, 0);
+        @memset(self.buffer.link, link.NO_LINK);
 
         self.graphemes_data = graph;
         self.display_width = dw;
@@ -207,7 +215,25 @@ pub const OptimizedBuffer = struct {
         return self.buffer.attributes.ptr;
     }
 
+    pub fn getLinkPtr(self: *OptimizedBuffer) [*]u16 {
+        return self.buffer.link.ptr;
+    }
+
+    /// Set the hyperlink id attached to subsequently drawn cells, NO_LINK to stop linking
+    pub fn setLinkPen(self: *OptimizedBuffer, link_id: u16) void {
+        self.link_pen = link_id;
+    }
+
+    pub fn getLinkPen(self: *const OptimizedBuffer) u16 {
+        return self.link_pen;
+    }
+
     pub fn deinit(self: *OptimizedBuffer) void {
+        self.allocator.free(self.buffer.char);
+        self.allocator.free(self.buffer.fg);
+        self.allocator.free(self.buffer.bg);
+        self.allocator.free(self.buffer.attributes);
+        self.allocator.free(self.buffer.link);
         self.scissor_stack.deinit();
         self.grapheme_tracker.deinit();
         self.allocator.free(self.id);
@@ -297,6 +323,7 @@ pub const OptimizedBuffer = struct {
         self.buffer.fg = self.allocator.realloc(self.buffer.fg, size) catch return BufferError.OutOfMemory;
         self.buffer.bg = self.allocator.realloc(self.buffer.bg, size) catch return BufferError.OutOfMemory;
         self.buffer.attributes = self.allocator.realloc(self.buffer.attributes, size) catch return BufferError.OutOfMemory;
+        self.buffer.link = self.allocator.realloc(self.buffer.link, size) catch return BufferError.OutOfMemory;
 
         self.width = width;
         self.height = height;
@@ -320,6 +347,7 @@ pub const OptimizedBuffer = struct {
         @memset(self.buffer.attributes, 0);
         @memset(self.buffer.fg, .{ 1.0, 1.0, 1.0, 1.0 });
         @memset(self.buffer.bg, bg);
+        @memset(self.buffer.link, link.NO_LINK);
     }
 
     pub fn setRaw(self: *OptimizedBuffer, x: u32, y: u32, cell: Cell) void {
@@ -330,6 +358,7 @@ pub const OptimizedBuffer = struct {
         self.buffer.fg[index] = cell.fg;
         self.buffer.bg[index] = cell.bg;
         self.buffer.attributes[index] = cell.attributes;
+        self.buffer.link[index] = cell.link;
     }
 
     pub fn set(self: *OptimizedBuffer, x: u32, y: u32, cell: Cell) void {
@@ -352,6 +381,7 @@ pub const OptimizedBuffer = struct {
             const span_len = span_end - span_start + 1;
             @memset(self.buffer.char[span_start .. span_start + span_len], @intCast(DEFAULT_SPACE_CHAR));
             @memset(self.buffer.attributes[span_start .. span_start + span_len], 0);
+            @memset(self.buffer.link[span_start .. span_start + span_len], link.NO_LINK);
         }
 
         if (gp.isGraphemeChar(cell.char)) {
@@ -364,6 +394,7 @@ pub const OptimizedBuffer = struct {
                 @memset(self.buffer.attributes[index..end_of_line], cell.attributes);
                 @memset(self.buffer.fg[index..end_of_line], cell.fg);
                 @memset(self.buffer.bg[index..end_of_line], cell.bg);
+                @memset(self.buffer.link[index..end_of_line], cell.link);
                 return;
             }
 
@@ -371,6 +402,7 @@ pub const OptimizedBuffer = struct {
             self.buffer.fg[index] = cell.fg;
             self.buffer.bg[index] = cell.bg;
             self.buffer.attributes[index] = cell.attributes;
+            self.buffer.link[index] = cell.link;
 
             const id: u32 = gp.graphemeIdFromChar(cell.char);
             self.grapheme_tracker.add(id);
@@ -382,6 +414,7 @@ pub const OptimizedBuffer = struct {
                     @memset(self.buffer.fg[index + 1 .. index + 1 + max_right], cell.fg);
                     @memset(self.buffer.bg[index + 1 .. index + 1 + max_right], cell.bg);
                     @memset(self.buffer.attributes[index + 1 .. index + 1 + max_right], cell.attributes);
+                    @memset(self.buffer.link[index + 1 .. index + 1 + max_right], cell.link);
                     var k: u32 = 1;
                     while (k <= max_right) : (k += 1) {
                         const cont = gp.packContinuation(k, max_right - k, id);
@@ -394,6 +427,7 @@ pub const OptimizedBuffer = struct {
             self.buffer.fg[index] = cell.fg;
             self.buffer.bg[index] = cell.bg;
             self.buffer.attributes[index] = cell.attributes;
+            self.buffer.link[index] = cell.link;
         }
     }
 
@@ -406,6 +440,7 @@ pub const OptimizedBuffer = struct {
             .fg = self.buffer.fg[index],
             .bg = self.buffer.bg[index],
             .attributes = self.buffer.attributes[index],
+            .link = self.buffer.link[index],
         };
     }
 
@@ -532,6 +567,7 @@ pub const OptimizedBuffer = struct {
             }
 
             const finalAttributes = if (preserveChar) destCell.attributes else overlayCell.attributes;
+            const finalLink = if (preserveChar) destCell.link else overlayCell.link;
 
             // When overlay background is fully transparent, preserve destination background alpha
             const finalBgAlpha = if (overlayCell.bg[3] == 0.0) destCell.bg[3] else overlayCell.bg[3];
@@ -541,6 +577,7 @@ pub const OptimizedBuffer = struct {
                 .fg = finalFg,
                 .bg = .{ blendedBgRgb[0], blendedBgRgb[1], blendedBgRgb[2], finalBgAlpha },
                 .attributes = finalAttributes,
+                .link = finalLink,
             };
         }
 
@@ -557,7 +594,7 @@ pub const OptimizedBuffer = struct {
         attributes: u8,
     ) !void {
         if (!self.isPointInScissor(@intCast(x), @intCast(y))) return;
-        const overlayCell = Cell{ .char = char, .fg = fg, .bg = bg, .attributes = attributes };
+        const overlayCell = Cell{ .char = char, .fg = fg, .bg = bg, .attributes = attributes, .link = self.link_pen };
 
         if (self.get(x, y)) |destCell| {
             const blendedCell = blendCells(overlayCell, destCell);
@@ -577,7 +614,7 @@ pub const OptimizedBuffer = struct {
         attributes: u8,
     ) !void {
         if (!self.isPointInScissor(@intCast(x), @intCast(y))) return;
-        const overlayCell = Cell{ .char = char, .fg = fg, .bg = bg, .attributes = attributes };
+        const overlayCell = Cell{ .char = char, .fg = fg, .bg = bg, .attributes = attributes, .link = self.link_pen };
 
         if (self.get(x, y)) |destCell| {
             const blendedCell = blendCells(overlayCell, destCell);
@@ -643,6 +680,7 @@ pub const OptimizedBuffer = struct {
                 @memset(rowSliceFg, .{ 1.0, 1.0, 1.0, 1.0 });
                 @memset(rowSliceBg, bg);
                 @memset(rowSliceAttrs, 0);
+                @memset(self.buffer.link[rowStartIndex .. rowStartIndex + rowWidth], self.link_pen);
             }
         }
     }
@@ -680,7 +718,7 @@ pub const OptimizedBuffer = struct {
             }
 
             const gbytes = gc.bytes(text);
-            const cell_width_u16: u16 = gwidth.gwidth(gbytes, self.width_method, &self.display_width);
+            const cell_width_u16: u16 = width_cache.clusterWidth(gbytes, self.width_method, &self.display_width);
             if (cell_width_u16 == 0) {
                 // Zero-width or control cluster: skip rendering and do not advance visible cells
                 continue;
@@ -703,6 +741,7 @@ pub const OptimizedBuffer = struct {
                     .fg = fg,
                     .bg = bgColor,
                     .attributes = attributes,
+                    .link = self.link_pen,
                 });
             }
 
@@ -768,10 +807,15 @@ pub const OptimizedBuffer = struct {
                 @memcpy(self.buffer.fg[destRowStart .. destRowStart + actualCopyWidth], frameBuffer.buffer.fg[srcRowStart .. srcRowStart + actualCopyWidth]);
                 @memcpy(self.buffer.bg[destRowStart .. destRowStart + actualCopyWidth], frameBuffer.buffer.bg[srcRowStart .. srcRowStart + actualCopyWidth]);
                 @memcpy(self.buffer.attributes[destRowStart .. destRowStart + actualCopyWidth], frameBuffer.buffer.attributes[srcRowStart .. srcRowStart + actualCopyWidth]);
+                @memcpy(self.buffer.link[destRowStart .. destRowStart + actualCopyWidth], frameBuffer.buffer.link[srcRowStart .. srcRowStart + actualCopyWidth]);
             }
             return;
         }
 
+        // Cells keep the links they were drawn with in the source buffer
+        const savedLinkPen = self.link_pen;
+        defer self.link_pen = savedLinkPen;
+
         var dY = clippedStartY;
         while (dY <= clippedEndY) : (dY += 1) {
             var lastDrawnGraphemeId: u32 = 0;
@@ -792,6 +836,7 @@ pub const OptimizedBuffer = struct {
                 const srcFg = frameBuffer.buffer.fg[srcIndex];
                 const srcBg = frameBuffer.buffer.bg[srcIndex];
                 const srcAttr = frameBuffer.buffer.attributes[srcIndex];
+                self.link_pen = frameBuffer.buffer.link[srcIndex];
 
                 if (srcBg[3] == 0.0 and srcFg[3] == 0.0) continue;
 
@@ -826,17 +871,32 @@ pub const OptimizedBuffer = struct {
         x: i32,
         y: i32,
         clip_rect: ?ClipRect,
+    ) !void {
+        try self.drawTextBufferRows(text_buffer, x, y, clip_rect, 0, std.math.maxInt(u32));
+    }
+
+    /// Draw only the virtual lines in [row_start, row_end) of a TextBuffer
+    /// Used with TextBuffer.takeSelectionDirtyRows to repaint just the rows a selection drag touched.
+    /// Rows are drawn over the existing cells, so the caller clears them first if backgrounds are translucent.
+    pub fn drawTextBufferRows(
+        self: *OptimizedBuffer,
+        text_buffer: *TextBuffer,
+        x: i32,
+        y: i32,
+        clip_rect: ?ClipRect,
+        row_start: u32,
+        row_end: u32,
     ) !void {
         text_buffer.updateVirtualLines();
 
         if (text_buffer.virtual_lines.items.len == 0) return;
 
-        const firstVisibleLine: u32 = if (y < 0) @intCast(-y) else 0;
+        const firstVisibleLine: u32 = @max(row_start, if (y < 0) @as(u32, @intCast(-y)) else 0);
         const bufferBottomY = self.height;
         const lastPossibleLine = if (y >= bufferBottomY)
             0
         else
-            @min(text_buffer.virtual_lines.items.len, bufferBottomY - @as(u32, @intCast(y)));
+            @min(text_buffer.virtual_lines.items.len, bufferBottomY - @as(u32, @intCast(y)), row_end);
 
         if (firstVisibleLine >= text_buffer.virtual_lines.items.len or lastPossibleLine == 0) return;
         if (firstVisibleLine >= lastPossibleLine) return;
@@ -851,18 +911,32 @@ pub const OptimizedBuffer = struct {
         else
             0;
 
-        for (text_buffer.virtual_lines.items[firstVisibleLine..lastPossibleLine]) |vline| {
+        // Highlights are sorted and chars are drawn in order, so one index serves the whole draw
+        const highlights = text_buffer.highlights.items;
+        var highlightIndex: usize = 0;
+
+        for (text_buffer.virtual_lines.items[firstVisibleLine..lastPossibleLine], firstVisibleLine..) |vline, lineIndex| {
             if (currentY >= bufferBottomY) break;
 
             currentX = x;
 
+            // Resolve selection once per line so lines outside it skip the per-char range check
+            const lineSelection: ?TextSelection = if (text_buffer.selection) |sel| blk: {
+                const lineStart = vline.char_offset;
+                const lineEnd = if (lineIndex + 1 < line_info.starts.len)
+                    line_info.starts[lineIndex + 1]
+                else
+                    std.math.maxInt(u32);
+                break :blk if (sel.start < lineEnd and sel.end > lineStart) sel else null;
+            } else null;
+
             for (vline.chunks.items) |vchunk| {
                 const source_chunk = &text_buffer.lines.items[vchunk.source_line].chunks.items[vchunk.source_chunk];
-                const chars = source_chunk.chars[vchunk.char_start .. vchunk.char_start + vchunk.char_count];
+                const chunkChars = source_chunk.chars.slice(vchunk.char_start, vchunk.char_start + vchunk.char_count);
 
                 if (currentX >= @as(i32, @intCast(self.width))) {
-                    globalCharPos += @intCast(chars.len);
-                    currentX += @intCast(chars.len);
+                    globalCharPos += vchunk.char_count;
+                    currentX += @intCast(vchunk.char_count);
                     continue;
                 }
 
@@ -888,96 +962,111 @@ pub const OptimizedBuffer = struct {
                 }
 
                 var charIndex: u32 = 0;
-                for (chars) |charCode| {
-                    if (charCode == '\n') {
-                        globalCharPos += 1;
-                        charIndex += 1;
-                        continue;
-                    }
+                // Dispatch once per chunk; ASCII chunks are read one byte per cell
+                switch (chunkChars) {
+                    inline else => |chars| for (chars) |cell| {
+                        const charCode: u32 = cell;
+                        if (charCode == '\n') {
+                            globalCharPos += 1;
+                            charIndex += 1;
+                            continue;
+                        }
 
-                    if (currentX < 0) {
-                        globalCharPos += 1;
-                        currentX += 1;
-                        charIndex += 1;
-                        continue;
-                    }
-                    if (currentX >= @as(i32, @intCast(self.width))) {
-                        const remainingChars = chars.len - charIndex;
-                        globalCharPos += @intCast(remainingChars);
-                        currentX += @intCast(remainingChars);
-                        break;
-                    }
+                        if (currentX < 0) {
+                            globalCharPos += 1;
+                            currentX += 1;
+                            charIndex += 1;
+                            continue;
+                        }
+                        if (currentX >= @as(i32, @intCast(self.width))) {
+                            const remainingChars = chars.len - charIndex;
+                            globalCharPos += @intCast(remainingChars);
+                            currentX += @intCast(remainingChars);
+                            break;
+                        }
 
-                    // TODO: Clip rect is currently used in text buffer drawing and cannot be removed yet.
-                    // Using scissor only should work now.
-                    if (clip_rect) |clip| {
-                        if (currentX < clip.x or currentY < clip.y or
-                            currentX >= clip.x + @as(i32, @intCast(clip.width)) or
-                            currentY > clip.y + @as(i32, @intCast(clip.height))) // inclusive
-                        {
+                        // TODO: Clip rect is currently used in text buffer drawing and cannot be removed yet.
+                        // Using scissor only should work now.
+                        if (clip_rect) |clip| {
+                            if (currentX < clip.x or currentY < clip.y or
+                                currentX >= clip.x + @as(i32, @intCast(clip.width)) or
+                                currentY > clip.y + @as(i32, @intCast(clip.height))) // inclusive
+                            {
+                                globalCharPos += 1;
+                                currentX += 1;
+                                charIndex += 1;
+                                continue;
+                            }
+                        }
+
+                        if (!self.isPointInScissor(currentX, currentY)) {
                             globalCharPos += 1;
                             currentX += 1;
                             charIndex += 1;
                             continue;
                         }
-                    }
 
-                    if (!self.isPointInScissor(currentX, currentY)) {
-                        globalCharPos += 1;
-                        currentX += 1;
-                        charIndex += 1;
-                        continue;
-                    }
+                        var finalFg = chunkFg;
+                        var finalBg = chunkBg;
+                        const finalAttributes = chunkAttributes;
 
-                    var finalFg = chunkFg;
-                    var finalBg = chunkBg;
-                    const finalAttributes = chunkAttributes;
-
-                    // Handle selection highlighting
-                    if (text_buffer.selection) |sel| {
-                        const isSelected = globalCharPos >= sel.start and globalCharPos < sel.end;
-                        if (isSelected) {
-                            if (sel.bgColor) |selBg| {
-                                finalBg = selBg;
-                                if (sel.fgColor) |selFg| {
-                                    finalFg = selFg;
+                        if (highlightIndex < highlights.len) {
+                            while (highlightIndex < highlights.len and highlights[highlightIndex].end <= globalCharPos) {
+                                highlightIndex += 1;
+                            }
+                            if (highlightIndex < highlights.len and highlights[highlightIndex].start <= globalCharPos) {
+                                const highlight = highlights[highlightIndex];
+                                finalBg = highlight.bg;
+                                if (highlight.fg) |highlightFg| finalFg = highlightFg;
+                            }
+                        }
+
+                        // Handle selection highlighting
+                        if (lineSelection) |sel| {
+                            const isSelected = globalCharPos >= sel.start and globalCharPos < sel.end;
+                            if (isSelected) {
+                                if (sel.bgColor) |selBg| {
+                                    finalBg = selBg;
+                                    if (sel.fgColor) |selFg| {
+                                        finalFg = selFg;
+                                    }
+                                } else {
+                                    // Swap fg and bg for default selection style
+                                    const temp = finalFg;
+                                    finalFg = if (finalBg[3] > 0) finalBg else RGBA{ 0.0, 0.0, 0.0, 1.0 };
+                                    finalBg = temp;
                                 }
-                            } else {
-                                // Swap fg and bg for default selection style
-                                const temp = finalFg;
-                                finalFg = if (finalBg[3] > 0) finalBg else RGBA{ 0.0, 0.0, 0.0, 1.0 };
-                                finalBg = temp;
                             }
                         }
-                    }
 
-                    var drawFg = finalFg;
-                    var drawBg = finalBg;
-                    const drawAttributes = finalAttributes;
+                        var drawFg = finalFg;
+                        var drawBg = finalBg;
+                        const drawAttributes = finalAttributes;
 
-                    // Wait, isn't that handled by the ansi itself?
-                    if (drawAttributes & (1 << 5) != 0) { // reverse bit
-                        const temp = drawFg;
-                        drawFg = drawBg;
-                        drawBg = temp;
-                    }
+                        // Wait, isn't that handled by the ansi itself?
+                        if (drawAttributes & (1 << 5) != 0) { // reverse bit
+                            const temp = drawFg;
+                            drawFg = drawBg;
+                            drawBg = temp;
+                        }
 
-                    if (graphemeAware) {
-                        try self.setCellWithAlphaBlending(
-                            @intCast(currentX),
-                            @intCast(currentY),
-                            charCode,
-                            drawFg,
-                            drawBg,
-                            drawAttributes,
-                        );
-                    } else {
-                        self.setCellWithAlphaBlendingRaw(@intCast(currentX), @intCast(currentY), charCode, drawFg, drawBg, drawAttributes) catch {};
-                    }
+                        if (graphemeAware) {
+                            try self.setCellWithAlphaBlending(
+                                @intCast(currentX),
+                                @intCast(currentY),
+                                charCode,
+                                drawFg,
+                                drawBg,
+                                drawAttributes,
+                            );
+                        } else {
+                            self.setCellWithAlphaBlendingRaw(@intCast(currentX), @intCast(currentY), charCode, drawFg, drawBg, drawAttributes) catch {};
+                        }
 
-                    globalCharPos += 1;
-                    currentX += 1;
-                    charIndex += 1;
+                        globalCharPos += 1;
+                        currentX += 1;
+                        charIndex += 1;
+                    },
                 }
             }
 
@@ -1023,7 +1112,7 @@ pub const OptimizedBuffer = struct {
 
         if (title) |titleText| {
             if (titleText.len > 0 and borderSides.top and isAtActualTop) {
-                const titleLength = @as(i32, @intCast(gwidth.gwidth(titleText, self.width_method, &self.display_width)));
+                const titleLength = @as(i32, @intCast(width_cache.textWidth(titleText, self.width_method, &self.graphemes_data, &self.display_width)));
                 const minTitleSpace = 4;
 
                 shouldDrawTitle = @as(i32, @intCast(width)) >= titleLength + minTitleSpace;
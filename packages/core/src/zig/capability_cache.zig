@@ -0,0 +1,216 @@
+const std = @import("std");
+const builtin = @import("builtin");
+const Allocator = std.mem.Allocator;
+const Terminal = @import("terminal.zig");
+const gwidth = @import("gwidth.zig");
+
+const Capabilities = Terminal.Capabilities;
+const log = std.log.scoped(.capability_cache);
+
+/// Terminal capability cache
+///
+/// Capability probing needs a round trip to the terminal, so the first frames
+/// either wait for it or run with defaults. Detected capabilities are stored
+/// per terminal identity under $XDG_CACHE_HOME/opentui/capabilities and
+/// applied immediately on the next start; the probe still runs and refreshes
+/// the entry when its answer differs.
+///
+/// File format, one entry per line after a version header:
+///     <key as 16 hex digits> <capability bits as hex>
+pub const FILE_HEADER = "opentui-capabilities 1";
+pub const MAX_ENTRIES = 32;
+
+/// Environment that identifies a terminal emulator and its version
+const KEY_ENV_VARS = [_][]const u8{
+    "TERM",
+    "TERM_PROGRAM",
+    "TERM_PROGRAM_VERSION",
+    "VTE_VERSION",
+    "KONSOLE_VERSION",
+    "WEZTERM_VERSION",
+    "KITTY_PID",
+    "ALACRITTY_SOCKET",
+    "WT_SESSION",
+    "TMUX",
+    "STY",
+    "COLORTERM",
+};
+
+/// Presence, not value, matters for these (their values change per window)
+fn isPresenceOnly(name: []const u8) bool {
+    return std.mem.eql(u8, name, "KITTY_PID") or
+        std.mem.eql(u8, name, "ALACRITTY_SOCKET") or
+        std.mem.eql(u8, name, "WT_SESSION") or
+        std.mem.eql(u8, name, "TMUX") or
+        std.mem.eql(u8, name, "STY");
+}
+
+/// Hash the terminal identity: key env vars plus the tty device class
+pub fn computeKey(env_map: *const std.process.EnvMap) u64 {
+    var hasher = std.hash.Wyhash.init(0x6f70656e747569);
+    for (KEY_ENV_VARS) |name| {
+        hasher.update(name);
+        if (env_map.get(name)) |value| {
+            hasher.update(if (isPresenceOnly(name)) "1" else value);
+        }
+        hasher.update("\x00");
+    }
+    if (ttyMajor()) |major| {
+        hasher.update(std.mem.asBytes(&major));
+    }
+    return hasher.final();
+}
+
+/// Device major number of the controlling tty (pty vs console vs serial)
+fn ttyMajor() ?u32 {
+    if (builtin.os.tag == .windows) return null;
+    const stat = std.posix.fstat(std.posix.STDOUT_FILENO) catch return null;
+    if (!std.posix.S.ISCHR(stat.mode)) return null;
+    return @truncate(@as(u64, @intCast(stat.rdev)) >> 8);
+}
+
+pub fn encode(caps: Capabilities) u32 {
+    var bits: u32 = 0;
+    inline for (std.meta.fields(Capabilities), 0..) |field, i| {
+        const set = switch (field.type) {
+            bool => @field(caps, field.name),
+            gwidth.WidthMethod => @field(caps, field.name) == .unicode,
+            else => @compileError("unhandled capability field " ++ field.name),
+        };
+        if (set) bits |= @as(u32, 1) << i;
+    }
+    return bits;
+}
+
+pub fn decode(bits: u32) Capabilities {
+    var caps = Capabilities{};
+    inline for (std.meta.fields(Capabilities), 0..) |field, i| {
+        const set = bits & (@as(u32, 1) << i) != 0;
+        @field(caps, field.name) = switch (field.type) {
+            bool => set,
+            gwidth.WidthMethod => if (set) .unicode else .wcwidth,
+            else => unreachable,
+        };
+    }
+    return caps;
+}
+
+/// Resolve the cache file path; caller owns the result
+pub fn cachePath(allocator: Allocator, env_map: *const std.process.EnvMap) ?[]u8 {
+    if (env_map.get("OPENTUI_NO_CAPABILITY_CACHE")) |_| return null;
+    if (env_map.get("XDG_CACHE_HOME")) |dir| {
+        if (dir.len > 0) return std.fs.path.join(allocator, &.{ dir, "opentui", "capabilities" }) catch null;
+    }
+    if (env_map.get("HOME")) |home| {
+        return std.fs.path.join(allocator, &.{ home, ".cache", "opentui", "capabilities" }) catch null;
+    }
+    return null;
+}
+
+const Entry = struct { key: u64, bits: u32 };
+
+fn parseEntries(content: []const u8, out: *[MAX_ENTRIES]Entry) usize {
+    var lines = std.mem.splitScalar(u8, content, '\n');
+    const header = lines.next() orelse return 0;
+    if (!std.mem.eql(u8, std.mem.trimRight(u8, header, "\r"), FILE_HEADER)) return 0;
+
+    var count: usize = 0;
+    while (lines.next()) |line| {
+        if (count == MAX_ENTRIES) break;
+        var parts = std.mem.tokenizeScalar(u8, line, ' ');
+        const key_str = parts.next() orelse continue;
+        const bits_str = parts.next() orelse continue;
+        const key = std.fmt.parseInt(u64, key_str, 16) catch continue;
+        const bits = std.fmt.parseInt(u32, std.mem.trimRight(u8, bits_str, "\r"), 16) catch continue;
+        out[count] = .{ .key = key, .bits = bits };
+        count += 1;
+    }
+    return count;
+}
+
+/// Look up cached capabilities; any I/O or format problem is a miss
+pub fn load(path: []const u8, key: u64) ?Capabilities {
+    var buf: [4096]u8 = undefined;
+    const content = std.fs.cwd().readFile(path, &buf) catch return null;
+    var entries: [MAX_ENTRIES]Entry = undefined;
+    const count = parseEntries(content, &entries);
+    for (entries[0..count]) |entry| {
+        if (entry.key == key) return decode(entry.bits);
+    }
+    return null;
+}
+
+/// Insert or replace the entry for key, most recent first, and write the file
+/// atomically (temp file + rename) so concurrent starts never see a torn file
+pub fn store(allocator: Allocator, path: []const u8, key: u64, caps: Capabilities) !void {
+    var entries: [MAX_ENTRIES]Entry = undefined;
+    var count: usize = 0;
+    {
+        var buf: [4096]u8 = undefined;
+        if (std.fs.cwd().readFile(path, &buf)) |content| {
+            count = parseEntries(content, &entries);
+        } else |_| {}
+    }
+
+    var out = std.ArrayList(u8).init(allocator);
+    defer out.deinit();
+    const writer = out.writer();
+    try writer.print("{s}\n{x:0>16} {x}\n", .{ FILE_HEADER, key, encode(caps) });
+    var written: usize = 1;
+    for (entries[0..count]) |entry| {
+        if (entry.key == key) continue;
+        if (written == MAX_ENTRIES) break;
+        try writer.print("{x:0>16} {x}\n", .{ entry.key, entry.bits });
+        written += 1;
+    }
+
+    if (std.fs.path.dirname(path)) |dir| {
+        try std.fs.cwd().makePath(dir);
+    }
+    const tmp_path = try std.fmt.allocPrint(allocator, "{s}.{d}.tmp", .{ path, std.time.milliTimestamp() });
+    defer allocator.free(tmp_path);
+    try std.fs.cwd().writeFile(.{ .sub_path = tmp_path, .data = out.items });
+    std.fs.cwd().rename(tmp_path, path) catch |err| {
+        std.fs.cwd().deleteFile(tmp_path) catch {};
+        return err;
+    };
+}
+
+/// Cache handle held by the renderer for one session
+pub const CapabilityCache = struct {
+    allocator: Allocator,
+    path: ?[]u8,
+    key: u64,
+    cached: ?Capabilities = null,
+
+    pub fn init(allocator: Allocator) CapabilityCache {
+        var env_map = std.process.getEnvMap(allocator) catch return .{ .allocator = allocator, .path = null, .key = 0 };
+        defer env_map.deinit();
+        const path = cachePath(allocator, &env_map);
+        const key = computeKey(&env_map);
+        return .{
+            .allocator = allocator,
+            .path = path,
+            .key = key,
+            .cached = if (path) |p| load(p, key) else null,
+        };
+    }
+
+    pub fn deinit(self: *CapabilityCache) void {
+        if (self.path) |p| self.allocator.free(p);
+        self.path = null;
+    }
+
+    /// Record freshly probed capabilities; only touches the file when they differ
+    pub fn update(self: *CapabilityCache, caps: Capabilities) void {
+        const path = self.path orelse return;
+        if (self.cached) |cached| {
+            if (encode(cached) == encode(caps)) return;
+        }
+        store(self.allocator, path, self.key, caps) catch |err| {
+            log.warn("Failed to write capability cache {s}: {}", .{ path, err });
+            return;
+        };
+        self.cached = caps;
+    }
+};
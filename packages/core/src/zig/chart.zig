@@ -0,0 +1,371 @@
+const std = @import("std");
+const Allocator = std.mem.Allocator;
+const ansi = @import("ansi.zig");
+const buffer = @import("buffer.zig");
+
+const RGBA = ansi.RGBA;
+const OptimizedBuffer = buffer.OptimizedBuffer;
+
+/// Streaming line and area charts rasterized to sub-cell glyphs
+///
+/// Each series keeps its samples in a fixed-capacity ring, so appending is
+/// O(1) and old samples fall off the left edge. The x axis is measured in
+/// buckets of `samples_per_column` consecutive samples; a bucket becomes
+/// one pixel column drawn as the vertical min/max span of its samples, so
+/// series longer than the chart is wide are downsampled without losing
+/// spikes.
+///
+/// Pixels map to braille (2x4 dots per cell) or half blocks (1x2). Cell
+/// columns are cached in a ring keyed by their absolute position on the x
+/// axis: when new samples scroll the chart, the existing columns are reused
+/// as they are and only the columns touched by new samples are rasterized.
+/// A change of y range or size invalidates the whole cache.
+pub const Mode = enum(u8) {
+    braille = 0,
+    half_block = 1,
+};
+
+pub const MAX_SERIES = 8;
+const NO_OWNER: u8 = 0xFF;
+
+/// Braille dot bits by sub-column and pixel row
+const BRAILLE_DOTS = [2][4]u8{
+    .{ 0x01, 0x02, 0x04, 0x40 },
+    .{ 0x08, 0x10, 0x20, 0x80 },
+};
+const HALF_BLOCK_CHARS = [4]u32{ ' ', 0x2580, 0x2584, 0x2588 };
+
+pub const ChartError = error{
+    InvalidDimensions,
+    TooManySeries,
+    OutOfMemory,
+};
+
+pub const Stats = extern struct {
+    /// Cell columns rasterized by the last draw
+    rasterized_columns: u32 = 0,
+    /// Non-empty cells written by the last draw
+    drawn_cells: u32 = 0,
+};
+
+pub const Series = struct {
+    values: []f32,
+    /// Slot of the next sample
+    head: u32 = 0,
+    len: u32 = 0,
+    /// Samples ever pushed; the absolute index of the next sample
+    total: u64 = 0,
+    color: RGBA,
+
+    pub fn push(self: *Series, value: f32) void {
+        self.values[self.head] = value;
+        self.head = (self.head + 1) % @as(u32, @intCast(self.values.len));
+        if (self.len < self.values.len) self.len += 1;
+        self.total += 1;
+    }
+
+    /// Sample by absolute index, if it is still in the ring
+    pub fn at(self: *const Series, index: i64) ?f32 {
+        if (index < 0 or index >= self.total) return null;
+        const back: u64 = self.total - @as(u64, @intCast(index));
+        if (back > self.len) return null;
+        const cap: u64 = self.values.len;
+        return self.values[@intCast((self.head + cap - back) % cap)];
+    }
+};
+
+pub const Chart = struct {
+    allocator: Allocator,
+    width: u32,
+    height: u32,
+    mode: Mode,
+    capacity: u32,
+    samples_per_column: u32,
+    fill: bool = false,
+    auto_range: bool = true,
+    range_min: f32 = 0,
+    range_max: f32 = 0,
+    has_range: bool = false,
+    background: RGBA = .{ 0, 0, 0, 0 },
+    series: [MAX_SERIES]Series = undefined,
+    series_count: u32 = 0,
+    /// Dot masks and owning series per cell, column-major by cache slot
+    masks: []u8,
+    owners: []u8,
+    /// Absolute cell column each cache slot holds
+    column_ids: []i64,
+    /// Columns from here on changed since the last draw
+    dirty_from: i64 = std.math.maxInt(i64),
+    stats: Stats = .{},
+
+    pub fn create(allocator: Allocator, width: u32, height: u32, mode: Mode, capacity: u32, samples_per_column: u32) ChartError!*Chart {
+        if (width == 0 or height == 0 or capacity == 0) return ChartError.InvalidDimensions;
+        const self = try allocator.create(Chart);
+        errdefer allocator.destroy(self);
+        self.* = .{
+            .allocator = allocator,
+            .width = width,
+            .height = height,
+            .mode = mode,
+            .capacity = capacity,
+            .samples_per_column = @max(samples_per_column, 1),
+            .masks = &.{},
+            .owners = &.{},
+            .column_ids = &.{},
+        };
+        try self.allocPlanes();
+        return self;
+    }
+
+    pub fn destroy(self: *Chart) void {
+        for (self.series[0..self.series_count]) |*s| self.allocator.free(s.values);
+        self.freePlanes();
+        self.allocator.destroy(self);
+    }
+
+    fn allocPlanes(self: *Chart) ChartError!void {
+        const cells = @as(usize, self.width) * self.height;
+        const masks = try self.allocator.alloc(u8, cells);
+        errdefer self.allocator.free(masks);
+        const owners = try self.allocator.alloc(u8, cells);
+        errdefer self.allocator.free(owners);
+        const column_ids = try self.allocator.alloc(i64, self.width);
+        self.masks = masks;
+        self.owners = owners;
+        self.column_ids = column_ids;
+        self.invalidate();
+    }
+
+    fn freePlanes(self: *Chart) void {
+        self.allocator.free(self.masks);
+        self.allocator.free(self.owners);
+        self.allocator.free(self.column_ids);
+    }
+
+    /// Drop every cached column
+    pub fn invalidate(self: *Chart) void {
+        @memset(self.column_ids, std.math.minInt(i64));
+    }
+
+    pub fn resize(self: *Chart, width: u32, height: u32) ChartError!void {
+        if (width == 0 or height == 0) return ChartError.InvalidDimensions;
+        if (width == self.width and height == self.height) return;
+        self.freePlanes();
+        self.width = width;
+        self.height = height;
+        self.masks = &.{};
+        self.owners = &.{};
+        self.column_ids = &.{};
+        try self.allocPlanes();
+    }
+
+    pub fn addSeries(self: *Chart, color: RGBA) ChartError!u32 {
+        if (self.series_count == MAX_SERIES) return ChartError.TooManySeries;
+        const values = try self.allocator.alloc(f32, self.capacity);
+        self.series[self.series_count] = .{ .values = values, .color = color };
+        self.series_count += 1;
+        return self.series_count - 1;
+    }
+
+    pub fn setSeriesColor(self: *Chart, index: u32, color: RGBA) void {
+        if (index >= self.series_count) return;
+        self.series[index].color = color;
+    }
+
+    /// Fixed y range; min >= max switches back to auto range
+    pub fn setRange(self: *Chart, min: f32, max: f32) void {
+        if (min < max) {
+            self.auto_range = false;
+            self.range_min = min;
+            self.range_max = max;
+            self.has_range = true;
+        } else {
+            self.auto_range = true;
+            self.has_range = false;
+            self.rescan();
+        }
+        self.invalidate();
+    }
+
+    /// Color of empty cells; fully transparent leaves them untouched
+    pub fn setBackground(self: *Chart, color: RGBA) void {
+        self.background = color;
+    }
+
+    /// Fill the area below the line
+    pub fn setFill(self: *Chart, fill: bool) void {
+        if (self.fill == fill) return;
+        self.fill = fill;
+        self.invalidate();
+    }
+
+    fn colsPerCell(self: *const Chart) u32 {
+        return if (self.mode == .braille) 2 else 1;
+    }
+
+    fn rowsPerCell(self: *const Chart) u32 {
+        return if (self.mode == .braille) 4 else 2;
+    }
+
+    fn cellColumnOf(self: *const Chart, sample: u64) i64 {
+        const bucket = sample / self.samples_per_column;
+        return @intCast(bucket / self.colsPerCell());
+    }
+
+    pub fn push(self: *Chart, index: u32, value: f32) void {
+        if (index >= self.series_count) return;
+        const s = &self.series[index];
+        self.dirty_from = @min(self.dirty_from, self.cellColumnOf(s.total));
+        s.push(value);
+        if (self.auto_range and !std.math.isNan(value)) self.widen(value);
+    }
+
+    pub fn pushMany(self: *Chart, index: u32, values: []const f32) void {
+        for (values) |v| self.push(index, v);
+    }
+
+    /// Grow the auto range to include value. The range only grows, with some
+    /// headroom so a slow climb doesn't invalidate every frame.
+    fn widen(self: *Chart, value: f32) void {
+        if (!self.has_range) {
+            self.range_min = value;
+            self.range_max = value;
+            self.has_range = true;
+            self.invalidate();
+            return;
+        }
+        if (value >= self.range_min and value <= self.range_max) return;
+        const headroom = @max(self.range_max - self.range_min, @abs(value)) * 0.1;
+        if (value < self.range_min) self.range_min = value - headroom;
+        if (value > self.range_max) self.range_max = value + headroom;
+        self.invalidate();
+    }
+
+    /// Recompute the auto range from the samples still held
+    fn rescan(self: *Chart) void {
+        self.has_range = false;
+        for (self.series[0..self.series_count]) |*s| {
+            var i: u32 = 0;
+            while (i < s.len) : (i += 1) {
+                const v = s.values[i];
+                if (!std.math.isNan(v)) self.widen(v);
+            }
+        }
+    }
+
+    fn newestSample(self: *const Chart) u64 {
+        var total: u64 = 0;
+        for (self.series[0..self.series_count]) |*s| total = @max(total, s.total);
+        return total;
+    }
+
+    fn pixelRow(self: *const Chart, value: f32) u32 {
+        const pixel_rows = self.height * self.rowsPerCell();
+        const span = self.range_max - self.range_min;
+        if (!(span > 0)) return pixel_rows / 2;
+        const t = std.math.clamp((self.range_max - value) / span, 0, 1);
+        return @intFromFloat(@round(t * @as(f32, @floatFromInt(pixel_rows - 1))));
+    }
+
+    /// Pixel rows (top, bottom) covered by a bucket of one series
+    fn bucketSpan(self: *const Chart, s: *const Series, bucket: i64) ?[2]u32 {
+        if (bucket < 0) return null;
+        const start = bucket * self.samples_per_column;
+        var lo = std.math.inf(f32);
+        var hi = -std.math.inf(f32);
+        var i = start;
+        while (i < start + self.samples_per_column) : (i += 1) {
+            const v = s.at(i) orelse continue;
+            if (std.math.isNan(v)) continue;
+            lo = @min(lo, v);
+            hi = @max(hi, v);
+        }
+        if (lo > hi) return null;
+        // Reach back to the previous sample so the line stays connected
+        if (!self.fill) {
+            if (s.at(start - 1)) |prev| {
+                if (!std.math.isNan(prev)) {
+                    lo = @min(lo, prev);
+                    hi = @max(hi, prev);
+                }
+            }
+        }
+        const bottom = if (self.fill) self.height * self.rowsPerCell() - 1 else self.pixelRow(lo);
+        return .{ self.pixelRow(hi), bottom };
+    }
+
+    fn rasterizeColumn(self: *Chart, column: i64, slot: u32) void {
+        const base = @as(usize, slot) * self.height;
+        const masks = self.masks[base .. base + self.height];
+        const owners = self.owners[base .. base + self.height];
+        @memset(masks, 0);
+        @memset(owners, NO_OWNER);
+        self.column_ids[slot] = column;
+        self.stats.rasterized_columns += 1;
+
+        const cols = self.colsPerCell();
+        const rows = self.rowsPerCell();
+        for (self.series[0..self.series_count], 0..) |*s, si| {
+            var sub: u32 = 0;
+            while (sub < cols) : (sub += 1) {
+                const span = self.bucketSpan(s, column * cols + sub) orelse continue;
+                var py = span[0];
+                while (py <= span[1]) : (py += 1) {
+                    const row = py / rows;
+                    const bit: u8 = if (self.mode == .braille)
+                        BRAILLE_DOTS[sub][py % rows]
+                    else
+                        @as(u8, 1) << @intCast(py % rows);
+                    masks[row] |= bit;
+                    owners[row] = @intCast(si);
+                }
+            }
+        }
+    }
+
+    fn glyph(self: *const Chart, mask: u8) u32 {
+        return switch (self.mode) {
+            .braille => 0x2800 + @as(u32, mask),
+            .half_block => HALF_BLOCK_CHARS[mask & 3],
+        };
+    }
+
+    /// Bring stale columns up to date and draw the chart with its top-left
+    /// corner at (x, y)
+    pub fn draw(self: *Chart, target: *OptimizedBuffer, x: i32, y: i32) !void {
+        self.stats = .{};
+        const newest = self.newestSample();
+        const last_column: i64 = if (newest == 0) -1 else self.cellColumnOf(newest - 1);
+        const first_column = last_column - (@as(i64, self.width) - 1);
+        const w: i64 = self.width;
+
+        var j: u32 = 0;
+        while (j < self.width) : (j += 1) {
+            const column = first_column + j;
+            const slot: u32 = @intCast(@mod(column, w));
+            if (self.column_ids[slot] != column or column >= self.dirty_from) {
+                self.rasterizeColumn(column, slot);
+            }
+
+            const cx = @as(i64, x) + j;
+            if (cx < 0 or cx >= target.getWidth()) continue;
+            const base = @as(usize, slot) * self.height;
+            var r: u32 = 0;
+            while (r < self.height) : (r += 1) {
+                const cy = @as(i64, y) + r;
+                if (cy < 0 or cy >= target.getHeight()) continue;
+                const mask = self.masks[base + r];
+                if (mask == 0) {
+                    if (self.background[3] > 0) {
+                        try target.setCellWithAlphaBlending(@intCast(cx), @intCast(cy), ' ', self.background, self.background, 0);
+                    }
+                    continue;
+                }
+                const color = self.series[self.owners[base + r]].color;
+                try target.setCellWithAlphaBlending(@intCast(cx), @intCast(cy), self.glyph(mask), color, self.background, 0);
+                self.stats.drawn_cells += 1;
+            }
+        }
+        self.dirty_from = std.math.maxInt(i64);
+    }
+};
@@ -0,0 +1,711 @@
+const std = @import("std");
+const Allocator = std.mem.Allocator;
+const ansi = @import("ansi.zig");
+const buffer = @import("buffer.zig");
+const width_cache = @import("width_cache.zig");
+
+const RGBA = ansi.RGBA;
+const OptimizedBuffer = buffer.OptimizedBuffer;
+
+/// Line diffs of two texts, computed as far as the viewport needs
+///
+/// Both texts are copied and split into lines once; every distinct line is
+/// interned to a u32 id so the diff itself only compares integers. The edit
+/// script comes from linear-space Myers (middle snake bisection) run over
+/// an explicit work stack: ranges are split left-first, so blocks are
+/// emitted in file order and the search stops as soon as the rows asked for
+/// exist. A bisection that needs more than `cost_limit` edits gives up on
+/// an optimal split and cuts at the furthest point it reached, which bounds
+/// the cost on unrelated inputs at the price of a longer script.
+///
+/// Blocks alternate between equal runs and change runs. They are expanded
+/// into display rows for the current mode: unchanged lines further than
+/// `context` from a change fold into a single row, and side-by-side mode
+/// pairs the deleted and inserted lines of a change run.
+pub const Mode = enum(u8) {
+    unified = 0,
+    side_by_side = 1,
+};
+
+pub const RowKind = enum(u8) {
+    context = 0,
+    delete = 1,
+    insert = 2,
+    /// Side-by-side pair of a deleted and an inserted line; either may be absent
+    change = 3,
+    /// `count` unchanged lines starting at old_line/new_line
+    fold = 4,
+};
+
+pub const NO_LINE: u32 = std.math.maxInt(u32);
+/// Context that shows every unchanged line
+pub const FULL_CONTEXT: u32 = std.math.maxInt(u32);
+const MIN_COST_LIMIT: u32 = 256;
+const TAB_WIDTH: u32 = 4;
+
+pub const Row = struct {
+    kind: RowKind,
+    old_line: u32,
+    new_line: u32,
+    count: u32 = 0,
+};
+
+pub const Block = struct {
+    equal: bool,
+    old_start: u32,
+    new_start: u32,
+    old_len: u32,
+    new_len: u32,
+};
+
+const Line = struct {
+    start: u32,
+    len: u32,
+};
+
+const Range = struct {
+    old_start: u32,
+    old_end: u32,
+    new_start: u32,
+    new_end: u32,
+};
+
+const Work = union(enum) {
+    range: Range,
+    /// Common suffix of a range, emitted once its middle is done
+    equal: struct { old: u32, new: u32, len: u32 },
+};
+
+const Split = struct {
+    old: u32,
+    new: u32,
+};
+
+/// Color slots, each with a foreground and a background
+pub const Slot = enum(u8) {
+    context = 0,
+    delete = 1,
+    insert = 2,
+    fold = 3,
+    gutter = 4,
+};
+const SLOT_COUNT = 5;
+
+pub const DiffError = error{
+    TooLarge,
+    OutOfMemory,
+};
+
+pub const Stats = extern struct {
+    old_lines: u32 = 0,
+    new_lines: u32 = 0,
+    /// Lines deleted and inserted by the blocks found so far
+    deleted: u32 = 0,
+    inserted: u32 = 0,
+    /// Display rows expanded so far, and whether that is all of them
+    rows: u32 = 0,
+    complete: u32 = 0,
+    /// Middle snake searches run, and how many hit the cost limit
+    bisections: u32 = 0,
+    cutoffs: u32 = 0,
+    /// Rows painted by the last draw
+    drawn_rows: u32 = 0,
+};
+
+pub const Diff = struct {
+    allocator: Allocator,
+    old_text: []u8,
+    new_text: []u8,
+    old_lines: []Line,
+    new_lines: []Line,
+    old_ids: []u32,
+    new_ids: []u32,
+    /// Furthest x per diagonal for the forward and backward searches
+    v_forward: []i32,
+    v_backward: []i32,
+    work: std.ArrayListUnmanaged(Work) = .{},
+    blocks: std.ArrayListUnmanaged(Block) = .{},
+    rows: std.ArrayListUnmanaged(Row) = .{},
+    /// Blocks already expanded into rows
+    expanded_blocks: u32 = 0,
+    done: bool = false,
+    mode: Mode = .unified,
+    context: u32 = 3,
+    cost_limit: u32,
+    fg: [SLOT_COUNT]RGBA,
+    bg: [SLOT_COUNT]RGBA,
+    stats: Stats = .{},
+
+    pub fn create(allocator: Allocator, old_text: []const u8, new_text: []const u8) DiffError!*Diff {
+        // Offsets and diagonals are 32-bit
+        if (old_text.len + new_text.len >= std.math.maxInt(i32)) return DiffError.TooLarge;
+
+        const self = try allocator.create(Diff);
+        errdefer allocator.destroy(self);
+        self.* = .{
+            .allocator = allocator,
+            .old_text = try allocator.dupe(u8, old_text),
+            .new_text = &.{},
+            .old_lines = &.{},
+            .new_lines = &.{},
+            .old_ids = &.{},
+            .new_ids = &.{},
+            .v_forward = &.{},
+            .v_backward = &.{},
+            .cost_limit = MIN_COST_LIMIT,
+            .fg = .{
+                .{ 0.85, 0.85, 0.85, 1.0 },
+                .{ 1.0, 0.55, 0.55, 1.0 },
+                .{ 0.55, 1.0, 0.55, 1.0 },
+                .{ 0.45, 0.55, 0.75, 1.0 },
+                .{ 0.45, 0.45, 0.5, 1.0 },
+            },
+            .bg = .{
+                .{ 0.0, 0.0, 0.0, 0.0 },
+                .{ 0.3, 0.05, 0.05, 1.0 },
+                .{ 0.05, 0.25, 0.05, 1.0 },
+                .{ 0.0, 0.0, 0.0, 0.0 },
+                .{ 0.0, 0.0, 0.0, 0.0 },
+            },
+        };
+        errdefer self.freeAll();
+        self.new_text = try allocator.dupe(u8, new_text);
+        self.old_lines = try splitLines(allocator, self.old_text);
+        self.new_lines = try splitLines(allocator, self.new_text);
+        self.old_ids = try allocator.alloc(u32, self.old_lines.len);
+        self.new_ids = try allocator.alloc(u32, self.new_lines.len);
+        try self.internLines();
+
+        const total = self.old_lines.len + self.new_lines.len;
+        const diagonals = 2 * ((total + 1) / 2) + 2;
+        self.v_forward = try allocator.alloc(i32, diagonals);
+        self.v_backward = try allocator.alloc(i32, diagonals);
+        const root_cost: u32 = @intFromFloat(@sqrt(@as(f64, @floatFromInt(total))));
+        self.cost_limit = @max(MIN_COST_LIMIT, root_cost);
+
+        self.stats.old_lines = @intCast(self.old_lines.len);
+        self.stats.new_lines = @intCast(self.new_lines.len);
+        try self.work.append(allocator, .{ .range = .{
+            .old_start = 0,
+            .old_end = @intCast(self.old_lines.len),
+            .new_start = 0,
+            .new_end = @intCast(self.new_lines.len),
+        } });
+        return self;
+    }
+
+    pub fn destroy(self: *Diff) void {
+        self.freeAll();
+        self.allocator.destroy(self);
+    }
+
+    fn freeAll(self: *Diff) void {
+        const a = self.allocator;
+        a.free(self.old_text);
+        a.free(self.new_text);
+        a.free(self.old_lines);
+        a.free(self.new_lines);
+        a.free(self.old_ids);
+        a.free(self.new_ids);
+        a.free(self.v_forward);
+        a.free(self.v_backward);
+        self.work.deinit(a);
+        self.blocks.deinit(a);
+        self.rows.deinit(a);
+    }
+
+    fn splitLines(allocator: Allocator, text: []const u8) ![]Line {
+        var count: usize = 0;
+        for (text) |c| {
+            if (c == '\n') count += 1;
+        }
+        if (text.len > 0 and text[text.len - 1] != '\n') count += 1;
+
+        const lines = try allocator.alloc(Line, count);
+        var start: usize = 0;
+        var i: usize = 0;
+        while (start < text.len) : (i += 1) {
+            const end = std.mem.indexOfScalarPos(u8, text, start, '\n') orelse text.len;
+            var len = end - start;
+            if (len > 0 and text[start + len - 1] == '\r') len -= 1;
+            lines[i] = .{ .start = @intCast(start), .len = @intCast(len) };
+            start = end + 1;
+        }
+        return lines;
+    }
+
+    /// Give equal lines equal ids across both texts
+    fn internLines(self: *Diff) !void {
+        var ids = std.StringHashMapUnmanaged(u32){};
+        defer ids.deinit(self.allocator);
+        try ids.ensureTotalCapacity(self.allocator, @intCast(self.old_lines.len + self.new_lines.len));
+
+        for (self.old_ids, 0..) |*id, i| {
+            const entry = ids.getOrPutAssumeCapacity(self.oldLine(@intCast(i)));
+            if (!entry.found_existing) entry.value_ptr.* = ids.count() - 1;
+            id.* = entry.value_ptr.*;
+        }
+        for (self.new_ids, 0..) |*id, i| {
+            const entry = ids.getOrPutAssumeCapacity(self.newLine(@intCast(i)));
+            if (!entry.found_existing) entry.value_ptr.* = ids.count() - 1;
+            id.* = entry.value_ptr.*;
+        }
+    }
+
+    pub fn oldLine(self: *const Diff, index: u32) []const u8 {
+        const line = self.old_lines[index];
+        return self.old_text[line.start .. line.start + line.len];
+    }
+
+    pub fn newLine(self: *const Diff, index: u32) []const u8 {
+        const line = self.new_lines[index];
+        return self.new_text[line.start .. line.start + line.len];
+    }
+
+    fn emitEqual(self: *Diff, old: u32, new: u32, len: u32) !void {
+        if (len == 0) return;
+        if (self.blocks.items.len > 0) {
+            const last = &self.blocks.items[self.blocks.items.len - 1];
+            if (last.equal) {
+                last.old_len += len;
+                last.new_len += len;
+                return;
+            }
+        }
+        try self.blocks.append(self.allocator, .{ .equal = true, .old_start = old, .new_start = new, .old_len = len, .new_len = len });
+    }
+
+    fn emitChange(self: *Diff, old: u32, old_len: u32, new: u32, new_len: u32) !void {
+        if (old_len == 0 and new_len == 0) return;
+        self.stats.deleted += old_len;
+        self.stats.inserted += new_len;
+        if (self.blocks.items.len > 0) {
+            const last = &self.blocks.items[self.blocks.items.len - 1];
+            if (!last.equal) {
+                last.old_len += old_len;
+                last.new_len += new_len;
+                return;
+            }
+        }
+        try self.blocks.append(self.allocator, .{ .equal = false, .old_start = old, .new_start = new, .old_len = old_len, .new_len = new_len });
+    }
+
+    /// Take the next piece of work off the stack
+    fn step(self: *Diff) !void {
+        const item = self.work.pop() orelse {
+            self.done = true;
+            return;
+        };
+        switch (item) {
+            .equal => |e| try self.emitEqual(e.old, e.new, e.len),
+            .range => |r| try self.processRange(r),
+        }
+    }
+
+    fn processRange(self: *Diff, r: Range) !void {
+        var os = r.old_start;
+        var oe = r.old_end;
+        var ns = r.new_start;
+        var ne = r.new_end;
+
+        while (os < oe and ns < ne and self.old_ids[os] == self.new_ids[ns]) {
+            os += 1;
+            ns += 1;
+        }
+        try self.emitEqual(r.old_start, r.new_start, os - r.old_start);
+
+        var suffix: u32 = 0;
+        while (oe > os and ne > ns and self.old_ids[oe - 1] == self.new_ids[ne - 1]) {
+            oe -= 1;
+            ne -= 1;
+            suffix += 1;
+        }
+
+        // Pushed first so it is emitted after everything in between
+        if (suffix > 0) {
+            try self.work.append(self.allocator, .{ .equal = .{ .old = oe, .new = ne, .len = suffix } });
+        }
+        if (os == oe or ns == ne) {
+            try self.emitChange(os, oe - os, ns, ne - ns);
+            return;
+        }
+
+        if (self.bisect(os, oe, ns, ne)) |split| {
+            try self.work.append(self.allocator, .{ .range = .{ .old_start = split.old, .old_end = oe, .new_start = split.new, .new_end = ne } });
+            try self.work.append(self.allocator, .{ .range = .{ .old_start = os, .old_end = split.old, .new_start = ns, .new_end = split.new } });
+        } else {
+            try self.emitChange(os, oe - os, ns, ne - ns);
+        }
+    }
+
+    /// Find where an optimal edit path crosses the middle of the range, or
+    /// the furthest point reached once the cost limit is hit. Null when the
+    /// ranges have nothing in common.
+    fn bisect(self: *Diff, os: u32, oe: u32, ns: u32, ne: u32) ?Split {
+        self.stats.bisections += 1;
+        const a = self.old_ids[os..oe];
+        const b = self.new_ids[ns..ne];
+        const n: i64 = @intCast(a.len);
+        const m: i64 = @intCast(b.len);
+        const max_d: i64 = @divTrunc(n + m + 1, 2);
+        const v_off = max_d;
+        const v_len: i64 = 2 * max_d + 2;
+        const v1 = self.v_forward[0..@intCast(v_len)];
+        const v2 = self.v_backward[0..@intCast(v_len)];
+        @memset(v1, -1);
+        @memset(v2, -1);
+        v1[@intCast(v_off + 1)] = 0;
+        v2[@intCast(v_off + 1)] = 0;
+
+        const delta = n - m;
+        // With an odd delta the paths meet on a forward step, else a backward one
+        const front = @mod(delta, 2) != 0;
+        var k1start: i64 = 0;
+        var k1end: i64 = 0;
+        var k2start: i64 = 0;
+        var k2end: i64 = 0;
+
+        var d: i64 = 0;
+        while (d < max_d) : (d += 1) {
+            if (d > self.cost_limit) {
+                self.stats.cutoffs += 1;
+                return furthestSplit(v1, v2, v_off, d, n, m, os, ns);
+            }
+
+            var k1 = -d + k1start;
+            while (k1 <= d - k1end) : (k1 += 2) {
+                const k1o: usize = @intCast(v_off + k1);
+                var x1: i64 = if (k1 == -d or (k1 != d and v1[k1o - 1] < v1[k1o + 1])) v1[k1o + 1] else v1[k1o - 1] + 1;
+                var y1 = x1 - k1;
+                while (x1 < n and y1 < m and a[@intCast(x1)] == b[@intCast(y1)]) {
+                    x1 += 1;
+                    y1 += 1;
+                }
+                v1[k1o] = @intCast(x1);
+                if (x1 > n) {
+                    k1end += 2;
+                } else if (y1 > m) {
+                    k1start += 2;
+                } else if (front) {
+                    const k2o = v_off + delta - k1;
+                    if (k2o >= 0 and k2o < v_len and v2[@intCast(k2o)] != -1) {
+                        const x2 = n - v2[@intCast(k2o)];
+                        if (x1 >= x2) return .{ .old = os + @as(u32, @intCast(x1)), .new = ns + @as(u32, @intCast(y1)) };
+                    }
+                }
+            }
+
+            var k2 = -d + k2start;
+            while (k2 <= d - k2end) : (k2 += 2) {
+                const k2o: usize = @intCast(v_off + k2);
+                var x2: i64 = if (k2 == -d or (k2 != d and v2[k2o - 1] < v2[k2o + 1])) v2[k2o + 1] else v2[k2o - 1] + 1;
+                var y2 = x2 - k2;
+                while (x2 < n and y2 < m and a[@intCast(n - x2 - 1)] == b[@intCast(m - y2 - 1)]) {
+                    x2 += 1;
+                    y2 += 1;
+                }
+                v2[k2o] = @intCast(x2);
+                if (x2 > n) {
+                    k2end += 2;
+                } else if (y2 > m) {
+                    k2start += 2;
+                } else if (!front) {
+                    const k1o = v_off + delta - k2;
+                    if (k1o >= 0 and k1o < v_len and v1[@intCast(k1o)] != -1) {
+                        const x1: i64 = v1[@intCast(k1o)];
+                        const y1 = v_off + x1 - k1o;
+                        if (x1 >= n - x2) return .{ .old = os + @as(u32, @intCast(x1)), .new = ns + @as(u32, @intCast(y1)) };
+                    }
+                }
+            }
+        }
+        return null;
+    }
+
+    /// Cut at whichever search got furthest from its corner
+    fn furthestSplit(v1: []const i32, v2: []const i32, v_off: i64, d: i64, n: i64, m: i64, os: u32, ns: u32) ?Split {
+        var best: ?Split = null;
+        var best_progress: i64 = 0;
+        var k = -d;
+        while (k <= d) : (k += 1) {
+            const ko: usize = @intCast(v_off + k);
+            if (v1[ko] >= 0) {
+                const x: i64 = v1[ko];
+                const y = x - k;
+                if (x <= n and y >= 0 and y <= m and x + y > best_progress and x + y < n + m) {
+                    best_progress = x + y;
+                    best = .{ .old = os + @as(u32, @intCast(x)), .new = ns + @as(u32, @intCast(y)) };
+                }
+            }
+            if (v2[ko] >= 0) {
+                const x: i64 = v2[ko];
+                const y = x - k;
+                if (x <= n and y >= 0 and y <= m and x + y > best_progress and x + y < n + m) {
+                    best_progress = x + y;
+                    best = .{ .old = os + @as(u32, @intCast(n - x)), .new = ns + @as(u32, @intCast(m - y)) };
+                }
+            }
+        }
+        return best;
+    }
+
+    fn appendRow(self: *Diff, kind: RowKind, old_line: u32, new_line: u32) !void {
+        try self.rows.append(self.allocator, .{ .kind = kind, .old_line = old_line, .new_line = new_line });
+    }
+
+    fn expandBlock(self: *Diff, index: u32) !void {
+        const block = self.blocks.items[index];
+        if (block.equal) {
+            const len = block.old_len;
+            const has_before = index > 0;
+            const has_after = index + 1 < self.blocks.items.len;
+            var head: u32 = 0;
+            var tail: u32 = 0;
+            if (self.context == FULL_CONTEXT) {
+                head = len;
+            } else {
+                if (has_before) head = @min(self.context, len);
+                if (has_after) tail = @min(self.context, len - head);
+            }
+            const hidden = len - head - tail;
+
+            var i: u32 = 0;
+            while (i < head) : (i += 1) {
+                try self.appendRow(.context, block.old_start + i, block.new_start + i);
+            }
+            if (hidden > 0) {
+                try self.rows.append(self.allocator, .{
+                    .kind = .fold,
+                    .old_line = block.old_start + head,
+                    .new_line = block.new_start + head,
+                    .count = hidden,
+                });
+            }
+            i = len - tail;
+            while (i < len) : (i += 1) {
+                try self.appendRow(.context, block.old_start + i, block.new_start + i);
+            }
+            return;
+        }
+
+        switch (self.mode) {
+            .unified => {
+                var i: u32 = 0;
+                while (i < block.old_len) : (i += 1) try self.appendRow(.delete, block.old_start + i, NO_LINE);
+                i = 0;
+                while (i < block.new_len) : (i += 1) try self.appendRow(.insert, NO_LINE, block.new_start + i);
+            },
+            .side_by_side => {
+                var i: u32 = 0;
+                while (i < @max(block.old_len, block.new_len)) : (i += 1) {
+                    try self.appendRow(
+                        .change,
+                        if (i < block.old_len) block.old_start + i else NO_LINE,
+                        if (i < block.new_len) block.new_start + i else NO_LINE,
+                    );
+                }
+            },
+        }
+    }
+
+    /// Diff until at least `count` rows exist or the diff is complete
+    pub fn ensureRows(self: *Diff, count: u32) !void {
+        while (self.rows.items.len < count) {
+            // The last block can still grow until the work stack is empty
+            const expandable: usize = if (self.done) self.blocks.items.len else self.blocks.items.len -| 1;
+            if (self.expanded_blocks < expandable) {
+                try self.expandBlock(self.expanded_blocks);
+                self.expanded_blocks += 1;
+                continue;
+            }
+            if (self.done) break;
+            try self.step();
+        }
+        self.stats.rows = @intCast(self.rows.items.len);
+        self.stats.complete = @intFromBool(self.isComplete());
+    }
+
+    pub fn isComplete(self: *const Diff) bool {
+        return self.done and self.expanded_blocks == self.blocks.items.len;
+    }
+
+    fn resetRows(self: *Diff) void {
+        self.rows.clearRetainingCapacity();
+        self.expanded_blocks = 0;
+        self.stats.rows = 0;
+        self.stats.complete = 0;
+    }
+
+    pub fn setMode(self: *Diff, mode: Mode) void {
+        if (mode == self.mode) return;
+        self.mode = mode;
+        self.resetRows();
+    }
+
+    pub fn setContext(self: *Diff, context: u32) void {
+        if (context == self.context) return;
+        self.context = context;
+        self.resetRows();
+    }
+
+    pub fn setColors(self: *Diff, slot: Slot, fg: RGBA, bg: RGBA) void {
+        self.fg[@intFromEnum(slot)] = fg;
+        self.bg[@intFromEnum(slot)] = bg;
+    }
+
+    fn isChangeRow(row: Row) bool {
+        return row.kind == .delete or row.kind == .insert or row.kind == .change;
+    }
+
+    /// First row of the next change run after `from`, or NO_LINE
+    pub fn nextChange(self: *Diff, from: u32) !u32 {
+        var i: u32 = if (from == NO_LINE) 0 else from + 1;
+        while (true) : (i += 1) {
+            try self.ensureRows(i + 1);
+            if (i >= self.rows.items.len) return NO_LINE;
+            const starts_run = i == 0 or !isChangeRow(self.rows.items[i - 1]);
+            if (isChangeRow(self.rows.items[i]) and starts_run) return i;
+        }
+    }
+
+    /// First row of the previous change run before `from`, or NO_LINE
+    pub fn prevChange(self: *Diff, from: u32) u32 {
+        var i: u32 = @min(from, @as(u32, @intCast(self.rows.items.len)));
+        while (i > 0) {
+            i -= 1;
+            const starts_run = i == 0 or !isChangeRow(self.rows.items[i - 1]);
+            if (isChangeRow(self.rows.items[i]) and starts_run) return i;
+        }
+        return NO_LINE;
+    }
+
+    /// Paint rows [top, top + height) into a width x height area at (x, y)
+    pub fn draw(self: *Diff, target: *OptimizedBuffer, x: i32, y: i32, width: u32, height: u32, top: u32) !void {
+        self.stats.drawn_rows = 0;
+        if (width == 0 or height == 0 or x < 0) return;
+        try self.ensureRows(top +| height);
+
+        const ox: u32 = @intCast(x);
+        const digits = digitCount(@max(self.old_lines.len, self.new_lines.len));
+        var r: u32 = 0;
+        while (r < height) : (r += 1) {
+            const index = top +| r;
+            if (index >= self.rows.items.len) break;
+            const cy = @as(i64, y) + r;
+            if (cy < 0 or cy >= target.getHeight()) continue;
+            const row = self.rows.items[index];
+            const ry: u32 = @intCast(cy);
+
+            if (row.kind == .fold) {
+                try self.drawFold(target, ox, ry, width, row);
+            } else switch (self.mode) {
+                .unified => try self.drawUnifiedRow(target, ox, ry, width, digits, row),
+                .side_by_side => try self.drawSideRow(target, ox, ry, width, digits, row),
+            }
+            self.stats.drawn_rows += 1;
+        }
+    }
+
+    fn drawFold(self: *Diff, target: *OptimizedBuffer, x: u32, y: u32, width: u32, row: Row) !void {
+        const slot = @intFromEnum(Slot.fold);
+        if (self.bg[slot][3] > 0) try target.fillRect(x, y, width, 1, self.bg[slot]);
+        var text: [64]u8 = undefined;
+        const label = std.fmt.bufPrint(&text, "\u{22EF} {d} unchanged line{s}", .{ row.count, if (row.count == 1) "" else "s" }) catch return;
+        try target.pushScissorRect(@intCast(x), @intCast(y), width, 1);
+        defer target.popScissorRect();
+        try target.drawText(label, x + 1, y, self.fg[slot], null, 0);
+    }
+
+    fn drawUnifiedRow(self: *Diff, target: *OptimizedBuffer, x: u32, y: u32, width: u32, digits: u32, row: Row) !void {
+        const slot: Slot = switch (row.kind) {
+            .delete => .delete,
+            .insert => .insert,
+            else => .context,
+        };
+        try target.pushScissorRect(@intCast(x), @intCast(y), width, 1);
+        defer target.popScissorRect();
+
+        const s = @intFromEnum(slot);
+        if (self.bg[s][3] > 0) try target.fillRect(x, y, width, 1, self.bg[s]);
+        try self.drawNumber(target, row.old_line, x, y, digits);
+        try self.drawNumber(target, row.new_line, x + digits + 1, y, digits);
+        const text_x = x + 2 * digits + 2;
+        const sign: []const u8 = switch (row.kind) {
+            .delete => "-",
+            .insert => "+",
+            else => " ",
+        };
+        try target.drawText(sign, text_x, y, self.fg[s], null, 0);
+        const line = if (row.kind == .insert) self.newLine(row.new_line) else self.oldLine(row.old_line);
+        try drawLine(target, line, text_x + 2, y, self.fg[s]);
+    }
+
+    fn drawSideRow(self: *Diff, target: *OptimizedBuffer, x: u32, y: u32, width: u32, digits: u32, row: Row) !void {
+        const half = (width -| 1) / 2;
+        const changed = row.kind == .change;
+        try self.drawHalf(target, x, y, half, digits, row.old_line, if (changed) .delete else .context, true);
+        try self.drawHalf(target, x + half + 1, y, width -| (half + 1), digits, row.new_line, if (changed) .insert else .context, false);
+        if (half < width and x + half < target.getWidth()) {
+            const s = @intFromEnum(Slot.gutter);
+            try target.setCellWithAlphaBlending(x + half, y, 0x2502, self.fg[s], self.bg[s], 0);
+        }
+    }
+
+    fn drawHalf(self: *Diff, target: *OptimizedBuffer, x: u32, y: u32, width: u32, digits: u32, line: u32, slot: Slot, old_side: bool) !void {
+        if (width == 0 or line == NO_LINE) return;
+        try target.pushScissorRect(@intCast(x), @intCast(y), width, 1);
+        defer target.popScissorRect();
+
+        const s = @intFromEnum(slot);
+        if (self.bg[s][3] > 0) try target.fillRect(x, y, width, 1, self.bg[s]);
+        try self.drawNumber(target, line, x, y, digits);
+        const sign: []const u8 = switch (slot) {
+            .delete => "-",
+            .insert => "+",
+            else => " ",
+        };
+        try target.drawText(sign, x + digits + 1, y, self.fg[s], null, 0);
+        const text = if (old_side) self.oldLine(line) else self.newLine(line);
+        try drawLine(target, text, x + digits + 3, y, self.fg[s]);
+    }
+
+    fn drawNumber(self: *Diff, target: *OptimizedBuffer, line: u32, x: u32, y: u32, digits: u32) !void {
+        if (line == NO_LINE) return;
+        var text: [16]u8 = undefined;
+        const number = std.fmt.bufPrint(&text, "{d}", .{line + 1}) catch return;
+        const pad: u32 = digits -| @as(u32, @intCast(number.len));
+        try target.drawText(number, x + pad, y, self.fg[@intFromEnum(Slot.gutter)], null, 0);
+    }
+};
+
+fn digitCount(value: usize) u32 {
+    var digits: u32 = 1;
+    var v = value;
+    while (v >= 10) : (v /= 10) digits += 1;
+    return digits;
+}
+
+/// Draw one line of text, expanding tabs to TAB_WIDTH stops
+fn drawLine(target: *OptimizedBuffer, text: []const u8, x: u32, y: u32, fg: RGBA) !void {
+    var col: u32 = 0;
+    var rest = text;
+    while (true) {
+        const tab = std.mem.indexOfScalar(u8, rest, '\t');
+        const segment = rest[0 .. tab orelse rest.len];
+        if (x + col >= target.getWidth()) return;
+        try target.drawText(segment, x + col, y, fg, null, 0);
+        const i = tab orelse return;
+        col += segmentWidth(target, segment);
+        col += TAB_WIDTH - col % TAB_WIDTH;
+        rest = rest[i + 1 ..];
+    }
+}
+
+fn segmentWidth(target: *OptimizedBuffer, text: []const u8) u32 {
+    var width: u32 = 0;
+    var iter = target.graphemes_data.iterator(text);
+    while (iter.next()) |gc| {
+        width += width_cache.clusterWidth(gc.bytes(text), target.width_method, &target.display_width);
+    }
+    return width;
+}
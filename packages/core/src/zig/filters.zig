@@ -0,0 +1,410 @@
+const std = @import("std");
+const Allocator = std.mem.Allocator;
+const buf = @import("buffer.zig");
+
+const OptimizedBuffer = buf.OptimizedBuffer;
+
+pub const FilterKind = enum(u32) {
+    grayscale = 0,
+    sepia = 1,
+    invert = 2,
+    /// p0 = factor (< 1 dims, > 1 brightens)
+    brightness = 3,
+    /// p0 = radius in cells
+    blur = 4,
+    /// p0 = strength
+    vignette = 5,
+    /// p0 = threshold, p1 = strength, p2 = radius in cells
+    bloom = 6,
+};
+
+/// One step of a filter chain; the FFI layout is four consecutive 32-bit words
+pub const FilterOp = extern struct {
+    kind: u32,
+    p0: f32 = 0,
+    p1: f32 = 0,
+    p2: f32 = 0,
+};
+
+pub const FilterError = error{
+    OutOfMemory,
+    InvalidFilter,
+    TooManyFilters,
+};
+
+const MAX_POINT_STAGES = 16;
+
+/// Cells processed per SIMD step (4 cells x RGBA = 16 lanes)
+const CELLS_PER_VEC = 4;
+
+const V4 = @Vector(4, f32);
+
+/// Affine color transform: out = cr*r + cg*g + cb*b + ca*a + off
+/// Alpha is always passed through unchanged
+const Affine = struct {
+    cr: V4,
+    cg: V4,
+    cb: V4,
+    ca: V4 = .{ 0, 0, 0, 1 },
+    off: V4 = .{ 0, 0, 0, 0 },
+    /// Clamp to [0, 1] after this stage, as the JS filters do after each step
+    clamp: bool = false,
+
+    fn apply(self: Affine, c: V4) V4 {
+        return self.cr * @as(V4, @splat(c[0])) +
+            self.cg * @as(V4, @splat(c[1])) +
+            self.cb * @as(V4, @splat(c[2])) +
+            self.ca * @as(V4, @splat(c[3])) +
+            self.off;
+    }
+
+    /// self applied after first
+    fn compose(self: Affine, first: Affine) Affine {
+        return .{
+            .cr = self.apply(first.cr) - self.off,
+            .cg = self.apply(first.cg) - self.off,
+            .cb = self.apply(first.cb) - self.off,
+            .ca = self.apply(first.ca) - self.off,
+            .off = self.apply(first.off),
+        };
+    }
+
+    /// Whether some color in [0, 1] maps outside [0, 1]. Stages that cannot
+    /// need no clamp, so fusing past them gives the same result as running
+    /// the filters one by one.
+    fn leavesRange(self: Affine) bool {
+        const zero: V4 = @splat(0);
+        const hi = self.off + @max(self.cr, zero) + @max(self.cg, zero) + @max(self.cb, zero);
+        const lo = self.off + @min(self.cr, zero) + @min(self.cg, zero) + @min(self.cb, zero);
+        inline for (0..3) |i| {
+            if (lo[i] < -1e-5 or hi[i] > 1 + 1e-5) return true;
+        }
+        return false;
+    }
+
+    fn withClamp(self: Affine) Affine {
+        var m = self;
+        m.clamp = m.leavesRange();
+        return m;
+    }
+};
+
+fn affineFor(op: FilterOp) ?Affine {
+    return switch (@as(FilterKind, @enumFromInt(op.kind))) {
+        .grayscale => .{
+            .cr = .{ 0.299, 0.299, 0.299, 0 },
+            .cg = .{ 0.587, 0.587, 0.587, 0 },
+            .cb = .{ 0.114, 0.114, 0.114, 0 },
+        },
+        .sepia => .{
+            .cr = .{ 0.393, 0.349, 0.272, 0 },
+            .cg = .{ 0.769, 0.686, 0.534, 0 },
+            .cb = .{ 0.189, 0.168, 0.131, 0 },
+        },
+        .invert => .{
+            .cr = .{ -1, 0, 0, 0 },
+            .cg = .{ 0, -1, 0, 0 },
+            .cb = .{ 0, 0, -1, 0 },
+            .off = .{ 1, 1, 1, 0 },
+        },
+        .brightness => blk: {
+            const f = @max(0, op.p0);
+            break :blk .{
+                .cr = .{ f, 0, 0, 0 },
+                .cg = .{ 0, f, 0, 0 },
+                .cb = .{ 0, 0, f, 0 },
+            };
+        },
+        else => null,
+    };
+}
+
+/// Pointwise stage: adjacent affine filters are fused into one matrix as
+/// long as the earlier ones keep colors in [0, 1]
+const PointStage = union(enum) {
+    affine: Affine,
+    vignette: f32,
+};
+
+const Rect = struct {
+    x: u32,
+    y: u32,
+    width: u32,
+    height: u32,
+};
+
+fn clipRect(buffer: *const OptimizedBuffer, x: i32, y: i32, width: u32, height: u32) ?Rect {
+    const startX: i64 = @max(0, x);
+    const startY: i64 = @max(0, y);
+    const endX: i64 = @min(@as(i64, buffer.width), @as(i64, x) + width);
+    const endY: i64 = @min(@as(i64, buffer.height), @as(i64, y) + height);
+    if (startX >= endX or startY >= endY) return null;
+    return .{
+        .x = @intCast(startX),
+        .y = @intCast(startY),
+        .width = @intCast(endX - startX),
+        .height = @intCast(endY - startY),
+    };
+}
+
+fn channelMask(comptime cells: usize, comptime channel: usize) @Vector(cells * 4, i32) {
+    var mask: [cells * 4]i32 = undefined;
+    for (0..cells * 4) |i| mask[i] = @intCast((i / 4) * 4 + channel);
+    return mask;
+}
+
+fn tileMask(comptime cells: usize) @Vector(cells * 4, i32) {
+    var mask: [cells * 4]i32 = undefined;
+    for (0..cells * 4) |i| mask[i] = @intCast(i % 4);
+    return mask;
+}
+
+/// Repeat one RGBA column for every cell in the vector
+fn tile(comptime cells: usize, v: V4) @Vector(cells * 4, f32) {
+    return @shuffle(f32, v, undefined, comptime tileMask(cells));
+}
+
+/// Apply pointwise stages to `cells` consecutive RGBA cells held in one vector
+fn applyStages(
+    comptime cells: usize,
+    c: @Vector(cells * 4, f32),
+    stages: []const PointStage,
+    vignette_base: [cells]f32,
+) @Vector(cells * 4, f32) {
+    const VN = @Vector(cells * 4, f32);
+    var v = c;
+    for (stages) |stage| {
+        switch (stage) {
+            .affine => |m| {
+                const r = @shuffle(f32, v, undefined, comptime channelMask(cells, 0));
+                const g = @shuffle(f32, v, undefined, comptime channelMask(cells, 1));
+                const b = @shuffle(f32, v, undefined, comptime channelMask(cells, 2));
+                const a = @shuffle(f32, v, undefined, comptime channelMask(cells, 3));
+                v = tile(cells, m.cr) * r + tile(cells, m.cg) * g + tile(cells, m.cb) * b + tile(cells, m.ca) * a + tile(cells, m.off);
+                if (m.clamp) v = @min(@max(v, @as(VN, @splat(0))), @as(VN, @splat(1)));
+            },
+            .vignette => |strength| {
+                var factors: [cells * 4]f32 = undefined;
+                inline for (0..cells) |i| {
+                    const f = @max(0, 1 - vignette_base[i] * strength);
+                    factors[i * 4] = f;
+                    factors[i * 4 + 1] = f;
+                    factors[i * 4 + 2] = f;
+                    factors[i * 4 + 3] = 1;
+                }
+                v *= @as(VN, factors);
+            },
+        }
+    }
+    return @min(@max(v, @as(VN, @splat(0))), @as(VN, @splat(1)));
+}
+
+fn colorPlane(plane: []buf.RGBA) []f32 {
+    const ptr: [*]f32 = @ptrCast(plane.ptr);
+    return ptr[0 .. plane.len * 4];
+}
+
+/// Run fused pointwise stages over the rect in one pass over fg and bg
+fn runPointStages(buffer: *OptimizedBuffer, rect: Rect, stages: []const PointStage) void {
+    if (stages.len == 0) return;
+
+    var needs_vignette = false;
+    for (stages) |stage| {
+        if (stage == .vignette) needs_vignette = true;
+    }
+
+    const planes = [_][]f32{ colorPlane(buffer.buffer.fg), colorPlane(buffer.buffer.bg) };
+    const centerX = @as(f32, @floatFromInt(rect.width)) / 2;
+    const centerY = @as(f32, @floatFromInt(rect.height)) / 2;
+    const maxDistSq = centerX * centerX + centerY * centerY;
+    const safeMaxDistSq = if (maxDistSq == 0) 1 else maxDistSq;
+
+    for (0..rect.height) |ry| {
+        const dy = @as(f32, @floatFromInt(ry)) - centerY;
+        const dySq = dy * dy;
+        const rowStart = ((rect.y + ry) * buffer.width + rect.x) * 4;
+
+        var rx: u32 = 0;
+        while (rx + CELLS_PER_VEC <= rect.width) : (rx += CELLS_PER_VEC) {
+            var base: [CELLS_PER_VEC]f32 = .{ 0, 0, 0, 0 };
+            if (needs_vignette) {
+                inline for (0..CELLS_PER_VEC) |i| {
+                    const dx = @as(f32, @floatFromInt(rx + i)) - centerX;
+                    base[i] = @min(1, (dx * dx + dySq) / safeMaxDistSq);
+                }
+            }
+            const offset = rowStart + rx * 4;
+            for (planes) |plane| {
+                const chunk: *[CELLS_PER_VEC * 4]f32 = plane[offset..][0 .. CELLS_PER_VEC * 4];
+                chunk.* = applyStages(CELLS_PER_VEC, chunk.*, stages, base);
+            }
+        }
+        while (rx < rect.width) : (rx += 1) {
+            var base: [1]f32 = .{0};
+            if (needs_vignette) {
+                const dx = @as(f32, @floatFromInt(rx)) - centerX;
+                base[0] = @min(1, (dx * dx + dySq) / safeMaxDistSq);
+            }
+            const offset = rowStart + rx * 4;
+            for (planes) |plane| {
+                const cell: *[4]f32 = plane[offset..][0..4];
+                cell.* = applyStages(1, cell.*, stages, base);
+            }
+        }
+    }
+}
+
+/// Separable box blur of fg and bg inside the rect, clamped at the rect edges
+fn runBlur(allocator: Allocator, buffer: *OptimizedBuffer, rect: Rect, radius_f: f32) FilterError!void {
+    const radius: i64 = @intFromFloat(@round(@max(0, radius_f)));
+    if (radius == 0) return;
+
+    const cells = @as(usize, rect.width) * rect.height;
+    const temp = allocator.alloc(V4, cells) catch return FilterError.OutOfMemory;
+    defer allocator.free(temp);
+
+    const window: V4 = @splat(@floatFromInt(radius * 2 + 1));
+    const w: i64 = rect.width;
+    const h: i64 = rect.height;
+
+    for ([_][]buf.RGBA{ buffer.buffer.fg, buffer.buffer.bg }) |plane| {
+        // Horizontal pass into temp
+        for (0..rect.height) |ry| {
+            const row = (rect.y + ry) * buffer.width + rect.x;
+            var sum: V4 = @splat(0);
+            var k: i64 = -radius;
+            while (k <= radius) : (k += 1) {
+                sum += @as(V4, plane[row + @as(usize, @intCast(std.math.clamp(k, 0, w - 1)))]);
+            }
+            for (0..rect.width) |rx| {
+                temp[ry * rect.width + rx] = sum / window;
+                const leaving = std.math.clamp(@as(i64, @intCast(rx)) - radius, 0, w - 1);
+                const entering = std.math.clamp(@as(i64, @intCast(rx)) + radius + 1, 0, w - 1);
+                sum -= @as(V4, plane[row + @as(usize, @intCast(leaving))]);
+                sum += @as(V4, plane[row + @as(usize, @intCast(entering))]);
+            }
+        }
+        // Vertical pass back into the plane
+        for (0..rect.width) |rx| {
+            var sum: V4 = @splat(0);
+            var k: i64 = -radius;
+            while (k <= radius) : (k += 1) {
+                sum += temp[@as(usize, @intCast(std.math.clamp(k, 0, h - 1))) * rect.width + rx];
+            }
+            for (0..rect.height) |ry| {
+                plane[(rect.y + ry) * buffer.width + rect.x + rx] = sum / window;
+                const leaving = std.math.clamp(@as(i64, @intCast(ry)) - radius, 0, h - 1);
+                const entering = std.math.clamp(@as(i64, @intCast(ry)) + radius + 1, 0, h - 1);
+                sum -= temp[@as(usize, @intCast(leaving)) * rect.width + rx];
+                sum += temp[@as(usize, @intCast(entering)) * rect.width + rx];
+            }
+        }
+    }
+}
+
+fn luminance(c: buf.RGBA) f32 {
+    return 0.299 * c[0] + 0.587 * c[1] + 0.114 * c[2];
+}
+
+/// Spread light from cells brighter than the threshold onto their neighbours
+fn runBloom(allocator: Allocator, buffer: *OptimizedBuffer, rect: Rect, threshold_f: f32, strength: f32, radius_f: f32) FilterError!void {
+    const threshold = std.math.clamp(threshold_f, 0, 1);
+    const radius: i64 = @intFromFloat(@round(@max(0, radius_f)));
+    if (strength <= 0 or radius == 0) return;
+
+    // Intensities are taken from the unbloomed colors so bloom never compounds
+    const cells = @as(usize, rect.width) * rect.height;
+    const intensity = allocator.alloc(f32, cells) catch return FilterError.OutOfMemory;
+    defer allocator.free(intensity);
+
+    var any = false;
+    for (0..rect.height) |ry| {
+        for (0..rect.width) |rx| {
+            const idx = (rect.y + ry) * buffer.width + rect.x + rx;
+            const lum = @max(luminance(buffer.buffer.fg[idx]), luminance(buffer.buffer.bg[idx]));
+            const i = if (lum > threshold) @max(0, (lum - threshold) / (1 - threshold + 1e-6)) else 0;
+            intensity[ry * rect.width + rx] = i;
+            if (i > 0) any = true;
+        }
+    }
+    if (!any) return;
+
+    const radiusSq: f32 = @floatFromInt(radius * radius);
+    const w: i64 = rect.width;
+    const h: i64 = rect.height;
+    const one: V4 = .{ 1, 1, 1, std.math.floatMax(f32) };
+
+    for (0..rect.height) |ry| {
+        for (0..rect.width) |rx| {
+            const i = intensity[ry * rect.width + rx];
+            if (i == 0) continue;
+            var ky: i64 = -radius;
+            while (ky <= radius) : (ky += 1) {
+                const sy = @as(i64, @intCast(ry)) + ky;
+                if (sy < 0 or sy >= h) continue;
+                var kx: i64 = -radius;
+                while (kx <= radius) : (kx += 1) {
+                    if (kx == 0 and ky == 0) continue;
+                    const sx = @as(i64, @intCast(rx)) + kx;
+                    if (sx < 0 or sx >= w) continue;
+                    const distSq: f32 = @floatFromInt(kx * kx + ky * ky);
+                    if (distSq > radiusSq) continue;
+
+                    const amount = i * strength * (1 - distSq / radiusSq);
+                    const add: V4 = .{ amount, amount, amount, 0 };
+                    const idx = (rect.y + @as(usize, @intCast(sy))) * buffer.width + rect.x + @as(usize, @intCast(sx));
+                    buffer.buffer.fg[idx] = @min(@as(V4, buffer.buffer.fg[idx]) + add, one);
+                    buffer.buffer.bg[idx] = @min(@as(V4, buffer.buffer.bg[idx]) + add, one);
+                }
+            }
+        }
+    }
+}
+
+/// Apply a filter chain to a rect of the buffer
+/// Runs of pointwise filters (grayscale, sepia, invert, brightness, vignette)
+/// share a single pass; blur and bloom need neighbours and run as their own passes
+pub fn applyFilterChain(buffer: *OptimizedBuffer, x: i32, y: i32, width: u32, height: u32, ops: []const FilterOp) FilterError!void {
+    const rect = clipRect(buffer, x, y, width, height) orelse return;
+
+    var stages: [MAX_POINT_STAGES]PointStage = undefined;
+    var stage_count: usize = 0;
+
+    for (ops) |op| {
+        if (op.kind > @intFromEnum(FilterKind.bloom)) return FilterError.InvalidFilter;
+        const kind: FilterKind = @enumFromInt(op.kind);
+
+        if (affineFor(op)) |m| {
+            // A stage whose output is clamped has to run on its own first
+            if (stage_count > 0 and stages[stage_count - 1] == .affine and !stages[stage_count - 1].affine.clamp) {
+                stages[stage_count - 1].affine = m.compose(stages[stage_count - 1].affine).withClamp();
+                continue;
+            }
+            if (stage_count == MAX_POINT_STAGES) return FilterError.TooManyFilters;
+            stages[stage_count] = .{ .affine = m.withClamp() };
+            stage_count += 1;
+            continue;
+        }
+
+        switch (kind) {
+            .vignette => {
+                if (stage_count == MAX_POINT_STAGES) return FilterError.TooManyFilters;
+                stages[stage_count] = .{ .vignette = @max(0, op.p0) };
+                stage_count += 1;
+            },
+            .blur => {
+                runPointStages(buffer, rect, stages[0..stage_count]);
+                stage_count = 0;
+                try runBlur(buffer.allocator, buffer, rect, op.p0);
+            },
+            .bloom => {
+                runPointStages(buffer, rect, stages[0..stage_count]);
+                stage_count = 0;
+                try runBloom(buffer.allocator, buffer, rect, op.p0, op.p1, op.p2);
+            },
+            else => unreachable,
+        }
+    }
+
+    runPointStages(buffer, rect, stages[0..stage_count]);
+}
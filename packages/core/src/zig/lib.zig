@@ -9,6 +9,15 @@ const text_buffer = @import("text-buffer.zig");
 const terminal = @import("terminal.zig");
 const gwidth = @import("gwidth.zig");
 const logger = @import("logger.zig");
+const link = @import("link.zig");
+const filters = @import("filters.zig");
+const width_cache = @import("width_cache.zig");
+const scene = @import("scene.zig");
+const chart = @import("chart.zig");
+const vt = @import("vt.zig");
+const diff = @import("diff.zig");
+const text_search = @import("search.zig");
+const style_table = @import("style_table.zig");
 
 pub const OptimizedBuffer = buffer.OptimizedBuffer;
 pub const CliRenderer = renderer.CliRenderer;
@@ -19,6 +28,20 @@ export fn setLogCallback(callback: ?*const fn (level: u8, msgPtr: [*]const u8, m
     logger.setLogCallback(callback);
 }
 
+// Push a preformatted message into the log ring; never blocks
+export fn logPush(level: u8, msgPtr: [*]const u8, msgLen: usize) void {
+    _ = logger.getLogRing().push(level, msgPtr[0..msgLen]);
+}
+
+// Drain pending log records into outPtr, returns bytes written (see LogRing.drain)
+export fn logDrain(outPtr: [*]u8, outLen: usize) usize {
+    return logger.getLogRing().drain(outPtr[0..outLen]);
+}
+
+export fn logTakeDropped() u32 {
+    return logger.getLogRing().takeDropped();
+}
+
 fn f32PtrToRGBA(ptr: [*]const f32) RGBA {
     return .{ ptr[0], ptr[1], ptr[2], ptr[3] };
 }
@@ -50,6 +73,22 @@ export fn setUseThread(rendererPtr: *renderer.CliRenderer, useThread: bool) void
     rendererPtr.setUseThread(useThread);
 }
 
+export fn setRetainedMode(rendererPtr: *renderer.CliRenderer, enabled: bool) void {
+    rendererPtr.setRetainedMode(enabled);
+}
+
+export fn setStyleInterning(rendererPtr: *renderer.CliRenderer, enabled: bool) bool {
+    rendererPtr.setStyleInterning(enabled) catch |err| {
+        logger.warn("Failed to enable style interning: {}", .{err});
+        return false;
+    };
+    return true;
+}
+
+export fn getStyleStats(rendererPtr: *renderer.CliRenderer, statsPtr: *style_table.Stats) void {
+    statsPtr.* = rendererPtr.getStyleStats() orelse .{};
+}
+
 export fn destroyRenderer(rendererPtr: *renderer.CliRenderer) void {
     rendererPtr.destroy();
 }
@@ -90,6 +129,21 @@ export fn render(rendererPtr: *renderer.CliRenderer, force: bool) void {
     rendererPtr.render(force);
 }
 
+// Display width of a line of text, through the shared width cache
+export fn measureText(textPtr: [*]const u8, textLen: usize, widthMethod: u8) u32 {
+    const graphemes_ptr, const display_width_ptr = gp.initGlobalUnicodeData(globalArena);
+    const wMethod: gwidth.WidthMethod = if (widthMethod == 0) .wcwidth else .unicode;
+    return width_cache.textWidth(textPtr[0..textLen], wMethod, graphemes_ptr, display_width_ptr);
+}
+
+export fn getWidthCacheStats(statsPtr: *width_cache.Stats) void {
+    statsPtr.* = width_cache.getStats();
+}
+
+export fn resetWidthCacheStats() void {
+    width_cache.resetStats();
+}
+
 export fn createOptimizedBuffer(width: u32, height: u32, respectAlpha: bool, widthMethod: u8, idPtr: [*]const u8, idLen: usize) ?*buffer.OptimizedBuffer {
     if (width == 0 or height == 0) {
         logger.warn("Invalid buffer dimensions: {}x{}", .{ width, height });
@@ -144,6 +198,29 @@ export fn processCapabilityResponse(rendererPtr: *renderer.CliRenderer, response
     rendererPtr.processCapabilityResponse(response);
 }
 
+// Probe without setupTerminal, for hosts that own the screen and input modes
+export fn startCapabilityProbe(rendererPtr: *renderer.CliRenderer) void {
+    rendererPtr.startCapabilityProbe();
+}
+
+export fn hasCachedCapabilities(rendererPtr: *renderer.CliRenderer) bool {
+    return rendererPtr.hasCachedCapabilities();
+}
+
+export fn setupInlineRenderer(rendererPtr: *renderer.CliRenderer, rows: u32) bool {
+    rendererPtr.setupInline(rows) catch |err| {
+        logger.warn("Failed to set up inline renderer: {}", .{err});
+        return false;
+    };
+    return true;
+}
+
+export fn inlinePrint(rendererPtr: *renderer.CliRenderer, textPtr: [*]const u8, textLen: usize) void {
+    rendererPtr.printAbove(textPtr[0..textLen]) catch |err| {
+        logger.warn("Failed to queue inline output: {}", .{err});
+    };
+}
+
 export fn setCursorStyle(rendererPtr: *renderer.CliRenderer, stylePtr: [*]const u8, styleLen: usize, blinking: bool) void {
     const style = stylePtr[0..styleLen];
     const cursorStyle = std.meta.stringToEnum(terminal.CursorStyle, style) orelse .block;
@@ -165,6 +242,12 @@ export fn setDebugOverlay(rendererPtr: *renderer.CliRenderer, enabled: bool, cor
     rendererPtr.setDebugOverlay(enabled, cornerEnum);
 }
 
+export fn setDebugReport(rendererPtr: *renderer.CliRenderer, textPtr: [*]const u8, textLen: usize) void {
+    rendererPtr.setDebugReport(textPtr[0..textLen]) catch |err| {
+        logger.warn("Failed to set debug report: {}", .{err});
+    };
+}
+
 export fn clearTerminal(rendererPtr: *renderer.CliRenderer) void {
     rendererPtr.clearTerminal();
 }
@@ -197,6 +280,10 @@ export fn bufferGetAttributesPtr(bufferPtr: *buffer.OptimizedBuffer) [*]u8 {
     return bufferPtr.getAttributesPtr();
 }
 
+export fn bufferGetLinkPtr(bufferPtr: *buffer.OptimizedBuffer) [*]u16 {
+    return bufferPtr.getLinkPtr();
+}
+
 export fn bufferGetRespectAlpha(bufferPtr: *buffer.OptimizedBuffer) bool {
     return bufferPtr.getRespectAlpha();
 }
@@ -227,6 +314,29 @@ export fn bufferDrawText(bufferPtr: *buffer.OptimizedBuffer, text: [*]const u8,
     bufferPtr.drawText(text[0..textLen], x, y, rgbaFg, rgbaBg, attributes) catch {};
 }
 
+var linkPoolFullLogged = false;
+
+// Intern a hyperlink URL, returns its id (0 for an empty URL, a URL holding
+// control bytes, or when the table is full)
+export fn internHyperlink(urlPtr: [*]const u8, urlLen: usize) u16 {
+    const pool = link.initGlobalLinkPool(globalArena);
+    return pool.intern(urlPtr[0..urlLen]) catch |err| {
+        switch (err) {
+            error.TooManyLinks => if (!linkPoolFullLogged) {
+                linkPoolFullLogged = true;
+                logger.warn("Hyperlink table full ({d} URLs), further links are drawn as plain text", .{link.MAX_LINKS});
+            },
+            else => logger.warn("Failed to intern hyperlink: {}", .{err}),
+        }
+        return link.NO_LINK;
+    };
+}
+
+// Cells drawn into the buffer after this carry the given link id, 0 stops linking
+export fn bufferSetLink(bufferPtr: *buffer.OptimizedBuffer, linkId: u16) void {
+    bufferPtr.setLinkPen(linkId);
+}
+
 export fn bufferSetCellWithAlphaBlending(bufferPtr: *buffer.OptimizedBuffer, x: u32, y: u32, char: u32, fg: [*]const f32, bg: [*]const f32, attributes: u8) void {
     const rgbaFg = f32PtrToRGBA(fg);
     const rgbaBg = f32PtrToRGBA(bg);
@@ -241,6 +351,7 @@ export fn bufferSetCell(bufferPtr: *buffer.OptimizedBuffer, x: u32, y: u32, char
         .fg = rgbaFg,
         .bg = rgbaBg,
         .attributes = attributes,
+        .link = bufferPtr.getLinkPen(),
     };
     bufferPtr.set(x, y, cell);
 }
@@ -250,6 +361,12 @@ export fn bufferFillRect(bufferPtr: *buffer.OptimizedBuffer, x: u32, y: u32, wid
     bufferPtr.fillRect(x, y, width, height, rgbaBg) catch {};
 }
 
+export fn bufferApplyFilters(bufferPtr: *buffer.OptimizedBuffer, x: i32, y: i32, width: u32, height: u32, opsPtr: [*]const filters.FilterOp, count: u32) void {
+    filters.applyFilterChain(bufferPtr, x, y, width, height, opsPtr[0..count]) catch |err| {
+        logger.warn("Failed to apply filter chain: {}", .{err});
+    };
+}
+
 export fn bufferDrawPackedBuffer(bufferPtr: *buffer.OptimizedBuffer, data: [*]const u8, dataLen: usize, posX: u32, posY: u32, terminalWidthCells: u32, terminalHeightCells: u32) void {
     bufferPtr.drawPackedBuffer(data, dataLen, posX, posY, terminalWidthCells, terminalHeightCells);
 }
@@ -322,6 +439,10 @@ export fn addToHitGrid(rendererPtr: *renderer.CliRenderer, x: i32, y: i32, width
     rendererPtr.addToHitGrid(x, y, width, height, id);
 }
 
+export fn addHitRegions(rendererPtr: *renderer.CliRenderer, regionsPtr: [*]const renderer.HitRegion, count: u32) void {
+    rendererPtr.addHitRegions(regionsPtr[0..count]);
+}
+
 export fn checkHit(rendererPtr: *renderer.CliRenderer, x: u32, y: u32) u32 {
     return rendererPtr.checkHit(x, y);
 }
@@ -422,6 +543,15 @@ export fn textBufferWriteChunk(tb: *text_buffer.TextBuffer, textBytes: [*]const
     return tb.writeChunk(textSlice, fgColor, bgColor, attrValue) catch 0;
 }
 
+// Append raw terminal output; SGR sequences become chunk styles (see sgr.zig)
+export fn textBufferWriteAnsi(tb: *text_buffer.TextBuffer, textBytes: [*]const u8, textLen: u32) bool {
+    tb.writeAnsi(textBytes[0..textLen]) catch |err| {
+        logger.warn("Failed to write ANSI text: {}", .{err});
+        return false;
+    };
+    return true;
+}
+
 export fn textBufferFinalizeLineInfo(tb: *text_buffer.TextBuffer) void {
     tb.finalizeLineInfo();
 }
@@ -460,6 +590,29 @@ export fn bufferDrawTextBuffer(
     bufferPtr.drawTextBuffer(textBufferPtr, x, y, clip_rect) catch {};
 }
 
+export fn bufferDrawTextBufferRows(
+    bufferPtr: *buffer.OptimizedBuffer,
+    textBufferPtr: *text_buffer.TextBuffer,
+    x: i32,
+    y: i32,
+    clipX: i32,
+    clipY: i32,
+    clipWidth: u32,
+    clipHeight: u32,
+    hasClipRect: bool,
+    rowStart: u32,
+    rowEnd: u32,
+) void {
+    const clip_rect = if (hasClipRect) buffer.ClipRect{
+        .x = clipX,
+        .y = clipY,
+        .width = clipWidth,
+        .height = clipHeight,
+    } else null;
+
+    bufferPtr.drawTextBufferRows(textBufferPtr, x, y, clip_rect, rowStart, rowEnd) catch {};
+}
+
 // Get selection info as packed u64: [start:u32][end:u32]
 // Returns 0xFFFFFFFF_FFFFFFFF if no selection
 export fn textBufferGetSelectionInfo(tb: *text_buffer.TextBuffer) u64 {
@@ -471,6 +624,20 @@ export fn textBufferGetSelectedText(tb: *text_buffer.TextBuffer, outPtr: [*]u8,
     return tb.getSelectedTextIntoBuffer(outBuffer);
 }
 
+// Stream selected text starting at char offset fromChar
+// Returns packed u64: [next:u32][written:u32], next equals the selection end when done
+export fn textBufferGetSelectedTextChunk(tb: *text_buffer.TextBuffer, fromChar: u32, outPtr: [*]u8, maxLen: u32) u64 {
+    const outBuffer = outPtr[0..maxLen];
+    const chunk = tb.getSelectedTextChunk(outBuffer, fromChar);
+    return (@as(u64, chunk.next) << 32) | @as(u64, @intCast(chunk.written));
+}
+
+// Get rows whose selection state changed since the last call as packed u64: [start:u32][end:u32]
+// Returns 0xFFFFFFFF_FFFFFFFF if nothing changed
+export fn textBufferGetSelectionDirtyRows(tb: *text_buffer.TextBuffer) u64 {
+    return tb.packSelectionDirtyRows();
+}
+
 export fn textBufferGetPlainText(tb: *text_buffer.TextBuffer, outPtr: [*]u8, maxLen: usize) usize {
     const outBuffer = outPtr[0..maxLen];
     return tb.getPlainTextIntoBuffer(outBuffer);
@@ -522,3 +689,296 @@ export fn textBufferSetWrapMode(tb: *text_buffer.TextBuffer, mode: u8) void {
     };
     tb.setWrapMode(wrapMode);
 }
+
+// Text search (see search.zig); flags: 1 = ignore case, 2 = regex subset
+
+/// Start a search, scanning the lines under the given rows first; false if
+/// the pattern is invalid
+export fn textBufferSearch(tb: *text_buffer.TextBuffer, patternPtr: [*]const u8, patternLen: u32, flags: u32, firstRow: u32, rowCount: u32) bool {
+    const search = tb.getSearch() catch return false;
+    search.setPattern(patternPtr[0..patternLen], flags, firstRow, rowCount) catch |err| {
+        if (err != error.InvalidPattern) logger.warn("Search failed: {}", .{err});
+        return false;
+    };
+    return true;
+}
+
+/// Scan about `budget` more cells; true once the whole buffer is searched
+export fn textBufferSearchRun(tb: *text_buffer.TextBuffer, budget: u32) bool {
+    const search = tb.search orelse return true;
+    return search.run(budget) catch |err| {
+        logger.warn("Search failed: {}", .{err});
+        return true;
+    };
+}
+
+export fn textBufferSearchClear(tb: *text_buffer.TextBuffer) void {
+    if (tb.search) |search| search.clear();
+}
+
+/// outPtr receives start, end and the virtual row the match starts on
+export fn textBufferSearchGetMatch(tb: *text_buffer.TextBuffer, index: u32, outPtr: *[3]u32) bool {
+    const search = tb.search orelse return false;
+    const match = search.getMatch(index) orelse return false;
+    tb.updateVirtualLines();
+    outPtr.* = .{ match.start, match.end, @intCast(tb.findVirtualLineForChar(match.start)) };
+    return true;
+}
+
+/// Index of the first match at or after a char offset, or the last one
+/// before it; 0xFFFFFFFF if there is none
+export fn textBufferSearchFind(tb: *text_buffer.TextBuffer, offset: u32, backward: bool) u32 {
+    const search = tb.search orelse return text_search.NO_MATCH;
+    return search.findMatch(offset, backward);
+}
+
+/// Highlight the matches under the given rows; `current` is a match index
+export fn textBufferSearchHighlight(tb: *text_buffer.TextBuffer, firstRow: u32, rowCount: u32, current: u32) u32 {
+    const search = tb.search orelse return 0;
+    return search.highlight(firstRow, rowCount, current) catch |err| {
+        logger.warn("Search highlight failed: {}", .{err});
+        return 0;
+    };
+}
+
+export fn textBufferSearchSetColors(tb: *text_buffer.TextBuffer, matchFg: ?[*]const f32, matchBg: [*]const f32, currentFg: ?[*]const f32, currentBg: [*]const f32) void {
+    const search = tb.getSearch() catch return;
+    search.setColors(
+        if (matchFg) |fg| f32PtrToRGBA(fg) else null,
+        f32PtrToRGBA(matchBg),
+        if (currentFg) |fg| f32PtrToRGBA(fg) else null,
+        f32PtrToRGBA(currentBg),
+    );
+}
+
+export fn textBufferSearchGetStats(tb: *text_buffer.TextBuffer, statsPtr: *text_search.Stats) void {
+    statsPtr.* = if (tb.search) |search| search.getStats() else .{};
+}
+
+// Retained scene graph (see scene.zig for the patch record format)
+
+export fn createScene() ?*scene.Scene {
+    const graphemes_ptr, const display_width_ptr = gp.initGlobalUnicodeData(globalArena);
+    return scene.Scene.create(std.heap.page_allocator, graphemes_ptr, display_width_ptr) catch |err| {
+        logger.warn("Failed to create scene: {}", .{err});
+        return null;
+    };
+}
+
+export fn destroyScene(scenePtr: *scene.Scene) void {
+    scenePtr.destroy();
+}
+
+export fn scenePatch(scenePtr: *scene.Scene, wordsPtr: [*]const u32, wordCount: usize, textPtr: [*]const u8, textLen: usize) bool {
+    scenePtr.applyPatch(wordsPtr[0..wordCount], textPtr[0..textLen]) catch |err| {
+        logger.warn("Scene patch rejected after {d} records: {}", .{ scenePtr.stats.records, err });
+        return false;
+    };
+    return true;
+}
+
+export fn sceneRender(scenePtr: *scene.Scene, bufferPtr: *buffer.OptimizedBuffer, full: bool) void {
+    scenePtr.render(bufferPtr, full) catch |err| {
+        logger.warn("Scene render failed: {}", .{err});
+    };
+}
+
+export fn sceneHitTest(scenePtr: *scene.Scene, x: i32, y: i32) u32 {
+    return scenePtr.hitTest(x, y);
+}
+
+export fn sceneGetStats(scenePtr: *scene.Scene, statsPtr: *scene.Stats) void {
+    statsPtr.* = scenePtr.stats;
+}
+
+// Streaming charts (see chart.zig)
+
+export fn createChart(width: u32, height: u32, mode: u8, capacity: u32, samplesPerColumn: u32) ?*chart.Chart {
+    const chartMode: chart.Mode = if (mode == 1) .half_block else .braille;
+    return chart.Chart.create(std.heap.page_allocator, width, height, chartMode, capacity, samplesPerColumn) catch |err| {
+        logger.warn("Failed to create chart: {}", .{err});
+        return null;
+    };
+}
+
+export fn destroyChart(chartPtr: *chart.Chart) void {
+    chartPtr.destroy();
+}
+
+// Returns the series index, or -1
+export fn chartAddSeries(chartPtr: *chart.Chart, color: [*]const f32) i32 {
+    const index = chartPtr.addSeries(f32PtrToRGBA(color)) catch |err| {
+        logger.warn("Failed to add chart series: {}", .{err});
+        return -1;
+    };
+    return @intCast(index);
+}
+
+export fn chartSetSeriesColor(chartPtr: *chart.Chart, series: u32, color: [*]const f32) void {
+    chartPtr.setSeriesColor(series, f32PtrToRGBA(color));
+}
+
+export fn chartPush(chartPtr: *chart.Chart, series: u32, value: f32) void {
+    chartPtr.push(series, value);
+}
+
+export fn chartPushMany(chartPtr: *chart.Chart, series: u32, valuesPtr: [*]const f32, count: usize) void {
+    chartPtr.pushMany(series, valuesPtr[0..count]);
+}
+
+export fn chartSetRange(chartPtr: *chart.Chart, min: f32, max: f32) void {
+    chartPtr.setRange(min, max);
+}
+
+export fn chartSetFill(chartPtr: *chart.Chart, fill: bool) void {
+    chartPtr.setFill(fill);
+}
+
+export fn chartSetBackground(chartPtr: *chart.Chart, color: [*]const f32) void {
+    chartPtr.setBackground(f32PtrToRGBA(color));
+}
+
+export fn chartResize(chartPtr: *chart.Chart, width: u32, height: u32) void {
+    chartPtr.resize(width, height) catch |err| {
+        logger.warn("Failed to resize chart: {}", .{err});
+    };
+}
+
+export fn chartDraw(chartPtr: *chart.Chart, bufferPtr: *buffer.OptimizedBuffer, x: i32, y: i32) void {
+    chartPtr.draw(bufferPtr, x, y) catch |err| {
+        logger.warn("Chart draw failed: {}", .{err});
+    };
+}
+
+export fn chartGetStats(chartPtr: *chart.Chart, statsPtr: *chart.Stats) void {
+    statsPtr.* = chartPtr.stats;
+}
+
+// Terminal emulator panes (see vt.zig)
+
+export fn createVt(cols: u32, rows: u32, historyRows: u32) ?*vt.Emulator {
+    const display_width_ptr = gp.initGlobalUnicodeData(globalArena)[1];
+    return vt.Emulator.create(std.heap.page_allocator, cols, rows, historyRows, display_width_ptr) catch |err| {
+        logger.warn("Failed to create terminal emulator: {}", .{err});
+        return null;
+    };
+}
+
+export fn destroyVt(vtPtr: *vt.Emulator) void {
+    vtPtr.destroy();
+}
+
+export fn vtAttach(vtPtr: *vt.Emulator, fd: i32) bool {
+    vtPtr.attach(fd) catch |err| {
+        logger.warn("Failed to attach terminal emulator: {}", .{err});
+        return false;
+    };
+    return true;
+}
+
+export fn vtFeed(vtPtr: *vt.Emulator, bytesPtr: [*]const u8, bytesLen: usize) void {
+    vtPtr.feed(bytesPtr[0..bytesLen]);
+}
+
+export fn vtWriteInput(vtPtr: *vt.Emulator, bytesPtr: [*]const u8, bytesLen: usize) bool {
+    vtPtr.writeInput(bytesPtr[0..bytesLen]) catch |err| {
+        logger.warn("Terminal input write failed: {}", .{err});
+        return false;
+    };
+    return true;
+}
+
+export fn vtResize(vtPtr: *vt.Emulator, cols: u32, rows: u32) void {
+    vtPtr.resize(cols, rows) catch |err| {
+        logger.warn("Failed to resize terminal emulator: {}", .{err});
+    };
+}
+
+export fn vtScrollView(vtPtr: *vt.Emulator, delta: i32) void {
+    vtPtr.scrollView(delta);
+}
+
+export fn vtSetColors(vtPtr: *vt.Emulator, fg: [*]const f32, bg: [*]const f32) void {
+    vtPtr.setColors(f32PtrToRGBA(fg), f32PtrToRGBA(bg));
+}
+
+export fn vtHasDamage(vtPtr: *vt.Emulator) bool {
+    return vtPtr.hasDamage();
+}
+
+export fn vtGetModes(vtPtr: *vt.Emulator) u32 {
+    return vtPtr.modes();
+}
+
+export fn vtDraw(vtPtr: *vt.Emulator, bufferPtr: *buffer.OptimizedBuffer, x: i32, y: i32, full: bool, showCursor: bool) void {
+    vtPtr.draw(bufferPtr, x, y, full, showCursor) catch |err| {
+        logger.warn("Terminal emulator draw failed: {}", .{err});
+    };
+}
+
+export fn vtGetStats(vtPtr: *vt.Emulator, statsPtr: *vt.Stats) void {
+    statsPtr.* = vtPtr.stats;
+}
+
+// Line diffs (see diff.zig)
+
+export fn createDiff(oldPtr: [*]const u8, oldLen: usize, newPtr: [*]const u8, newLen: usize) ?*diff.Diff {
+    return diff.Diff.create(std.heap.page_allocator, oldPtr[0..oldLen], newPtr[0..newLen]) catch |err| {
+        logger.warn("Failed to create diff: {}", .{err});
+        return null;
+    };
+}
+
+export fn destroyDiff(diffPtr: *diff.Diff) void {
+    diffPtr.destroy();
+}
+
+export fn diffSetMode(diffPtr: *diff.Diff, mode: u8) void {
+    diffPtr.setMode(if (mode == 1) .side_by_side else .unified);
+}
+
+export fn diffSetContext(diffPtr: *diff.Diff, context: u32) void {
+    diffPtr.setContext(context);
+}
+
+export fn diffSetColors(diffPtr: *diff.Diff, slot: u8, fg: [*]const f32, bg: [*]const f32) void {
+    const colorSlot = std.meta.intToEnum(diff.Slot, slot) catch return;
+    diffPtr.setColors(colorSlot, f32PtrToRGBA(fg), f32PtrToRGBA(bg));
+}
+
+/// Diff until `count` rows exist; returns the rows available
+export fn diffEnsureRows(diffPtr: *diff.Diff, count: u32) u32 {
+    diffPtr.ensureRows(count) catch |err| {
+        logger.warn("Diff failed: {}", .{err});
+    };
+    return @intCast(diffPtr.rows.items.len);
+}
+
+export fn diffNextChange(diffPtr: *diff.Diff, from: u32) u32 {
+    return diffPtr.nextChange(from) catch |err| {
+        logger.warn("Diff failed: {}", .{err});
+        return diff.NO_LINE;
+    };
+}
+
+export fn diffPrevChange(diffPtr: *diff.Diff, from: u32) u32 {
+    return diffPtr.prevChange(from);
+}
+
+/// Kind, old line, new line and fold count of a row already produced
+export fn diffGetRow(diffPtr: *diff.Diff, index: u32, outPtr: *[4]u32) bool {
+    if (index >= diffPtr.rows.items.len) return false;
+    const row = diffPtr.rows.items[index];
+    outPtr.* = .{ @intFromEnum(row.kind), row.old_line, row.new_line, row.count };
+    return true;
+}
+
+export fn diffDraw(diffPtr: *diff.Diff, bufferPtr: *buffer.OptimizedBuffer, x: i32, y: i32, width: u32, height: u32, top: u32) void {
+    diffPtr.draw(bufferPtr, x, y, width, height, top) catch |err| {
+        logger.warn("Diff draw failed: {}", .{err});
+    };
+}
+
+export fn diffGetStats(diffPtr: *diff.Diff, statsPtr: *diff.Stats) void {
+    statsPtr.* = diffPtr.stats;
+}
@@ -0,0 +1,90 @@
+const std = @import("std");
+const Allocator = std.mem.Allocator;
+
+/// Link id 0 means "no link" in every cell plane
+pub const NO_LINK: u16 = 0;
+pub const MAX_LINKS: usize = std.math.maxInt(u16);
+
+pub const LinkPoolError = error{
+    OutOfMemory,
+    TooManyLinks,
+    InvalidUrl,
+};
+
+/// Interned hyperlink table
+/// Each distinct URL is stored once and referenced from buffer cells by a 1-based u16 id.
+/// Ids are never released, since any cell may still carry one, so at most MAX_LINKS
+/// distinct URLs can be linked per process; past that intern fails with TooManyLinks.
+pub const LinkPool = struct {
+    allocator: Allocator,
+    urls: std.ArrayListUnmanaged([]const u8),
+    ids: std.StringHashMapUnmanaged(u16),
+
+    pub fn init(allocator: Allocator) LinkPool {
+        return .{
+            .allocator = allocator,
+            .urls = .{},
+            .ids = .{},
+        };
+    }
+
+    pub fn deinit(self: *LinkPool) void {
+        for (self.urls.items) |url| {
+            self.allocator.free(url);
+        }
+        self.urls.deinit(self.allocator);
+        self.ids.deinit(self.allocator);
+    }
+
+    /// Returns the id for a URL, storing it on first use
+    /// An empty URL maps to NO_LINK. URLs are written raw inside OSC 8, so one
+    /// holding a control byte (which could end the sequence early) is rejected.
+    pub fn intern(self: *LinkPool, url: []const u8) LinkPoolError!u16 {
+        if (url.len == 0) return NO_LINK;
+        for (url) |b| {
+            if (b < 0x20 or b == 0x7f) return LinkPoolError.InvalidUrl;
+        }
+        if (self.ids.get(url)) |id| return id;
+        if (self.urls.items.len >= MAX_LINKS) return LinkPoolError.TooManyLinks;
+
+        const owned = self.allocator.dupe(u8, url) catch return LinkPoolError.OutOfMemory;
+        errdefer self.allocator.free(owned);
+
+        self.urls.append(self.allocator, owned) catch return LinkPoolError.OutOfMemory;
+        errdefer _ = self.urls.pop();
+
+        const id: u16 = @intCast(self.urls.items.len);
+        self.ids.put(self.allocator, owned, id) catch return LinkPoolError.OutOfMemory;
+        return id;
+    }
+
+    pub fn get(self: *const LinkPool, id: u16) ?[]const u8 {
+        if (id == NO_LINK or id > self.urls.items.len) return null;
+        return self.urls.items[id - 1];
+    }
+
+    pub fn count(self: *const LinkPool) usize {
+        return self.urls.items.len;
+    }
+};
+
+var GLOBAL_LINK_POOL_STORAGE: ?LinkPool = null;
+
+pub fn initGlobalLinkPool(allocator: Allocator) *LinkPool {
+    if (GLOBAL_LINK_POOL_STORAGE == null) {
+        GLOBAL_LINK_POOL_STORAGE = LinkPool.init(allocator);
+    }
+    return &GLOBAL_LINK_POOL_STORAGE.?;
+}
+
+pub fn getGlobalLinkPool() ?*LinkPool {
+    if (GLOBAL_LINK_POOL_STORAGE) |*p| return p;
+    return null;
+}
+
+pub fn deinitGlobalLinkPool() void {
+    if (GLOBAL_LINK_POOL_STORAGE) |*p| {
+        p.deinit();
+        GLOBAL_LINK_POOL_STORAGE = null;
+    }
+}
@@ -8,6 +8,95 @@ pub const LogLevel = enum(u8) {
     debug = 3,
 };
 
+// In-process log ring, used whenever no callback is registered (MoonBit, C
+// wrappers). Bounded MPSC queue: producers claim a slot with one CAS and
+// never block; when the ring is full the message is dropped and counted.
+// Only one thread may drain it (the render loop, once per frame).
+pub const LOG_RING_SLOTS = 256;
+pub const LOG_MESSAGE_MAX = 240;
+
+const LogSlot = struct {
+    seq: std.atomic.Value(usize),
+    level: u8 = 0,
+    len: u16 = 0,
+    msg: [LOG_MESSAGE_MAX]u8 = undefined,
+};
+
+pub const LogRing = struct {
+    slots: [LOG_RING_SLOTS]LogSlot,
+    head: std.atomic.Value(usize) align(std.atomic.cache_line) = std.atomic.Value(usize).init(0),
+    tail: usize align(std.atomic.cache_line) = 0,
+    dropped: std.atomic.Value(u32) = std.atomic.Value(u32).init(0),
+
+    pub fn init() LogRing {
+        var ring = LogRing{ .slots = undefined };
+        for (&ring.slots, 0..) |*slot, i| {
+            slot.* = .{ .seq = std.atomic.Value(usize).init(i) };
+        }
+        return ring;
+    }
+
+    /// Safe from any thread. Messages longer than LOG_MESSAGE_MAX are truncated.
+    pub fn push(self: *LogRing, level: u8, msg: []const u8) bool {
+        var pos = self.head.load(.monotonic);
+        while (true) {
+            const slot = &self.slots[pos % LOG_RING_SLOTS];
+            const seq = slot.seq.load(.acquire);
+            const diff = @as(isize, @bitCast(seq -% pos));
+            if (diff == 0) {
+                if (self.head.cmpxchgWeak(pos, pos +% 1, .monotonic, .monotonic)) |actual| {
+                    pos = actual;
+                    continue;
+                }
+                const n = @min(msg.len, LOG_MESSAGE_MAX);
+                @memcpy(slot.msg[0..n], msg[0..n]);
+                slot.level = level;
+                slot.len = @intCast(n);
+                slot.seq.store(pos +% 1, .release);
+                return true;
+            } else if (diff < 0) {
+                // Consumer hasn't freed this slot yet: ring is full
+                _ = self.dropped.fetchAdd(1, .monotonic);
+                return false;
+            } else {
+                pos = self.head.load(.monotonic);
+            }
+        }
+    }
+
+    /// Copy pending entries into out as [level u8][len u16 LE][bytes] records.
+    /// Stops at the first entry that doesn't fit; returns the bytes written.
+    /// Single consumer only.
+    pub fn drain(self: *LogRing, out: []u8) usize {
+        var written: usize = 0;
+        while (true) {
+            const slot = &self.slots[self.tail % LOG_RING_SLOTS];
+            const seq = slot.seq.load(.acquire);
+            if (seq != self.tail +% 1) break;
+            const record_len = 3 + @as(usize, slot.len);
+            if (written + record_len > out.len) break;
+            out[written] = slot.level;
+            std.mem.writeInt(u16, out[written + 1 ..][0..2], slot.len, .little);
+            @memcpy(out[written + 3 .. written + record_len], slot.msg[0..slot.len]);
+            written += record_len;
+            slot.seq.store(self.tail +% LOG_RING_SLOTS, .release);
+            self.tail +%= 1;
+        }
+        return written;
+    }
+
+    /// Number of messages dropped because the ring was full; resets the count
+    pub fn takeDropped(self: *LogRing) u32 {
+        return self.dropped.swap(0, .monotonic);
+    }
+};
+
+var global_log_ring: LogRing = LogRing.init();
+
+pub fn getLogRing() *LogRing {
+    return &global_log_ring;
+}
+
 // Global logger state
 var global_log_callback: ?*const fn (level: u8, msgPtr: [*]const u8, msgLen: usize) callconv(.C) void = null;
 
@@ -29,8 +118,13 @@ pub fn logMessage(level: LogLevel, comptime format: []const u8, args: anytype) v
         };
         // msg is a slice that points into buf, with the actual formatted length
         callback(@intFromEnum(level), msg.ptr, msg.len);
+    } else {
+        // No callback: queue it for whoever drains the ring. Only the ring's
+        // slot size is ever kept, so format into a buffer of that size.
+        var buf: [LOG_MESSAGE_MAX]u8 = undefined;
+        const msg = std.fmt.bufPrint(&buf, format, args) catch buf[0..];
+        _ = global_log_ring.push(@intFromEnum(level), msg);
     }
-    // If no callback registered, drop the log
 }
 
 // Convenience functions for different log levels
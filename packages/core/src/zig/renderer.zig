@@ -5,6 +5,9 @@ const buf = @import("buffer.zig");
 const gp = @import("grapheme.zig");
 const Terminal = @import("terminal.zig");
 const logger = @import("logger.zig");
+const link = @import("link.zig");
+const capability_cache = @import("capability_cache.zig");
+const style_table = @import("style_table.zig");
 
 pub const RGBA = ansi.RGBA;
 pub const OptimizedBuffer = buf.OptimizedBuffer;
@@ -17,6 +20,7 @@ const STAT_SAMPLE_CAPACITY = 30;
 
 const COLOR_EPSILON_DEFAULT: f32 = 0.00001;
 const OUTPUT_BUFFER_SIZE = 1024 * 1024 * 2; // 2MB
+const DEBUG_REPORT_MAX_LINES = 12;
 
 pub const RendererError = error{
     OutOfMemory,
@@ -25,12 +29,7 @@ pub const RendererError = error{
     WriteFailed,
 };
 
-fn rgbaComponentToU8(component: f32) u8 {
-    if (!std.math.isFinite(component)) return 0;
-
-    const clamped = std.math.clamp(component, 0.0, 1.0);
-    return @intFromFloat(@round(clamped * 255.0));
-}
+const rgbaComponentToU8 = style_table.componentToU8;
 
 pub const DebugOverlayCorner = enum {
     topLeft,
@@ -39,6 +38,24 @@ pub const DebugOverlayCorner = enum {
     bottomRight,
 };
 
+/// One hit-testing rectangle; the FFI layout is five consecutive 32-bit words
+pub const HitRegion = extern struct {
+    x: i32,
+    y: i32,
+    width: u32,
+    height: u32,
+    id: u32,
+};
+
+/// Style-id planes for the encoder. `current` holds the id of every cell in
+/// the current buffer; `row` holds the next buffer's ids for the row being
+/// encoded, so the next buffer never needs a full plane.
+const StylePlanes = struct {
+    table: style_table.StyleTable,
+    current: []style_table.StyleId,
+    row: []style_table.StyleId,
+};
+
 pub const CliRenderer = struct {
     width: u32,
     height: u32,
@@ -51,6 +68,28 @@ pub const CliRenderer = struct {
     testing: bool = false,
     useAlternateScreen: bool = true,
     terminalSetup: bool = false,
+    capabilityCache: ?capability_cache.CapabilityCache = null,
+    // Progress of the capability probe sent by setupTerminal. The first reply
+    // replaces cached capabilities instead of adding to them, and the cache is
+    // written once when the DA1 reply closes the probe
+    probeState: enum { idle, awaiting, receiving } = .idle,
+
+    // Inline mode: the renderer owns `height` rows anchored at the cursor
+    // instead of the whole screen. The absolute row is never known, so every
+    // move is emitted relative to inlineRow, the region row the terminal
+    // cursor was last left on. Log lines queued with printAbove are written
+    // above the region at the start of the next frame.
+    inlineMode: bool = false,
+    inlineRow: u32 = 0,
+    inlinePending: std.ArrayListUnmanaged(u8) = .{},
+
+    // Retained mode: the next buffer keeps its content across frames instead
+    // of being cleared, so the app only redraws what changed
+    retainNextBuffer: bool = false,
+
+    // Style interning: cells are compared and encoded by style id instead of
+    // by float color, and SGR transitions come from the table's cache
+    styles: ?StylePlanes = null,
 
     renderStats: struct {
         lastFrameTime: f64,
@@ -87,6 +126,8 @@ pub const CliRenderer = struct {
         .enabled = false,
         .corner = .bottomRight,
     },
+    // Extra lines the host shows under the overlay's stats, e.g. a profile
+    debugReport: std.ArrayListUnmanaged(u8) = .{},
     // Threading
     useThread: bool = false,
     renderMutex: std.Thread.Mutex = .{},
@@ -97,10 +138,14 @@ pub const CliRenderer = struct {
     currentOutputBuffer: []u8 = &[_]u8{},
     currentOutputLen: usize = 0,
 
+    // Hit regions are collected per frame and only rasterized into
+    // currentHitGrid when checkHit is called after the swap
     currentHitGrid: []u32,
-    nextHitGrid: []u32,
     hitGridWidth: u32,
     hitGridHeight: u32,
+    hitGridStale: bool = false,
+    currentHitRegions: std.ArrayListUnmanaged(HitRegion) = .{},
+    nextHitRegions: std.ArrayListUnmanaged(HitRegion) = .{},
 
     mouseEnabled: bool,
     mouseMovementEnabled: bool,
@@ -171,9 +216,7 @@ pub const CliRenderer = struct {
 
         const hitGridSize = width * height;
         const currentHitGrid = try allocator.alloc(u32, hitGridSize);
-        const nextHitGrid = try allocator.alloc(u32, hitGridSize);
         @memset(currentHitGrid, 0); // Initialize with 0 (no renderable)
-        @memset(nextHitGrid, 0);
 
         self.* = .{
             .width = width,
@@ -214,7 +257,6 @@ pub const CliRenderer = struct {
             .allocator = allocator,
             .stdoutWriter = stdoutWriter,
             .currentHitGrid = currentHitGrid,
-            .nextHitGrid = nextHitGrid,
             .hitGridWidth = width,
             .hitGridHeight = height,
             .mouseEnabled = false,
@@ -256,8 +298,13 @@ pub const CliRenderer = struct {
         self.statSamples.cellsUpdated.deinit();
         self.statSamples.frameCallbackTime.deinit();
 
+        self.setStyleInterning(false) catch {};
         self.allocator.free(self.currentHitGrid);
-        self.allocator.free(self.nextHitGrid);
+        self.currentHitRegions.deinit(self.allocator);
+        self.nextHitRegions.deinit(self.allocator);
+        if (self.capabilityCache) |*cache| cache.deinit();
+        self.inlinePending.deinit(self.allocator);
+        self.debugReport.deinit(self.allocator);
 
         self.allocator.destroy(self);
     }
@@ -271,9 +318,9 @@ pub const CliRenderer = struct {
 
         writer.writeAll(ansi.ANSI.saveCursorState) catch {};
 
-        self.terminal.queryTerminalSend(writer.any()) catch {
-            // If capability detection fails, continue with defaults
-        };
+        if (self.sendCapabilityProbe(writer.any())) {
+            self.terminal.enableDetectedFeatures(writer.any()) catch {};
+        }
 
         if (useAlternateScreen) {
             self.terminal.enterAltScreen(writer.any()) catch {};
@@ -286,6 +333,35 @@ pub const CliRenderer = struct {
         bufferedWriter.flush() catch {};
     }
 
+    /// Apply cached capabilities and send the probe that re-verifies them.
+    /// Returns whether a cached entry was applied.
+    fn sendCapabilityProbe(self: *CliRenderer, writer: std.io.AnyWriter) bool {
+        // Start from what this terminal reported last time so the first frames
+        // already use the right width/sync paths; the probe re-verifies
+        if (self.capabilityCache) |*old| old.deinit();
+        var cache = capability_cache.CapabilityCache.init(self.allocator);
+        const cached = cache.cached;
+        self.capabilityCache = cache;
+        if (cached) |caps| {
+            self.terminal.caps = caps;
+        }
+        self.probeState = .awaiting;
+
+        self.terminal.queryTerminalSend(writer) catch {
+            // If capability detection fails, continue with defaults
+        };
+        return cached != null;
+    }
+
+    /// Probe capabilities for hosts that manage the screen and input modes
+    /// themselves instead of calling setupTerminal. Replies (fed back through
+    /// processCapabilityResponse) only change how frames are encoded; no
+    /// terminal mode is switched on.
+    pub fn startCapabilityProbe(self: *CliRenderer) void {
+        _ = self.sendCapabilityProbe(self.stdoutWriter.writer().any());
+        self.stdoutWriter.flush() catch {};
+    }
+
     pub fn performShutdownSequence(self: *CliRenderer) void {
         if (!self.terminalSetup) return;
 
@@ -293,6 +369,26 @@ pub const CliRenderer = struct {
 
         self.disableMouse();
 
+        if (self.inlineMode) {
+            // Leave the last frame in the scrollback and put the cursor below
+            // it; log lines that never made it into a frame follow the frame
+            self.moveCursorOutput(direct, 1, self.height);
+            direct.writeAll(ansi.ANSI.reset ++ "\r\n") catch {};
+            if (self.inlinePending.items.len > 0) {
+                var lines = std.mem.splitScalar(u8, std.mem.trimRight(u8, self.inlinePending.items, "\n"), '\n');
+                while (lines.next()) |line| {
+                    direct.writeAll(line) catch {};
+                    direct.writeAll(ansi.ANSI.reset ++ "\r\n") catch {};
+                }
+                self.inlinePending.clearRetainingCapacity();
+            }
+            self.inlineMode = false;
+            self.terminal.resetState(direct.any()) catch {};
+            direct.writeAll(ansi.ANSI.defaultCursorStyle ++ ansi.ANSI.showCursor) catch {};
+            self.stdoutWriter.flush() catch {};
+            return;
+        }
+
         self.terminal.resetState(direct.any()) catch {};
 
         if (self.useAlternateScreen) {
@@ -344,6 +440,46 @@ pub const CliRenderer = struct {
         }
     }
 
+    /// Keep the next buffer's content after each frame instead of clearing
+    /// it. After a flush it matches what is on screen, so the app only draws
+    /// cells that change; it must still repaint fully after a resize.
+    pub fn setRetainedMode(self: *CliRenderer, enabled: bool) void {
+        self.retainNextBuffer = enabled;
+    }
+
+    /// Compare and encode cells by interned style id. Colors are compared at
+    /// the 8-bit precision they are written with, and each style change is
+    /// written as the cached difference from the terminal's current SGR
+    /// state rather than a reset and a full restyle.
+    pub fn setStyleInterning(self: *CliRenderer, enabled: bool) !void {
+        if (enabled == (self.styles != null)) return;
+
+        if (!enabled) {
+            var planes = self.styles.?;
+            planes.table.deinit();
+            self.allocator.free(planes.current);
+            self.allocator.free(planes.row);
+            self.styles = null;
+            return;
+        }
+
+        const current = try self.allocator.alloc(style_table.StyleId, self.width * self.height);
+        errdefer self.allocator.free(current);
+        const row = try self.allocator.alloc(style_table.StyleId, self.width);
+        // Nothing on screen has an id yet, so the first frame repaints by style
+        @memset(current, style_table.NO_STYLE);
+        self.styles = .{
+            .table = style_table.StyleTable.init(self.allocator),
+            .current = current,
+            .row = row,
+        };
+    }
+
+    pub fn getStyleStats(self: *CliRenderer) ?style_table.Stats {
+        if (self.styles) |*planes| return planes.table.getStats();
+        return null;
+    }
+
     pub fn setUseThread(self: *CliRenderer, useThread: bool) void {
         if (self.useThread == useThread) return;
 
@@ -380,7 +516,9 @@ pub const CliRenderer = struct {
         self.renderStats.arrayBuffers = arrayBuffers;
     }
 
-    pub fn resize(self: *CliRenderer, width: u32, height: u32) !void {
+    pub fn resize(self: *CliRenderer, width: u32, requestedHeight: u32) !void {
+        // An inline region keeps its row count; only the width follows the terminal
+        const height = if (self.inlineMode) self.height else requestedHeight;
         if (self.width == width and self.height == height) return;
 
         self.width = width;
@@ -392,20 +530,23 @@ pub const CliRenderer = struct {
         try self.currentRenderBuffer.clear(.{ 0.0, 0.0, 0.0, 1.0 }, CLEAR_CHAR);
         try self.nextRenderBuffer.clear(.{ self.backgroundColor[0], self.backgroundColor[1], self.backgroundColor[2], 1.0 }, null);
 
+        if (self.styles) |*planes| {
+            planes.current = try self.allocator.realloc(planes.current, width * height);
+            planes.row = try self.allocator.realloc(planes.row, width);
+            @memset(planes.current, style_table.NO_STYLE);
+        }
+
         const newHitGridSize = width * height;
         const currentHitGridSize = self.hitGridWidth * self.hitGridHeight;
         if (newHitGridSize > currentHitGridSize) {
             const newCurrentHitGrid = try self.allocator.alloc(u32, newHitGridSize);
-            const newNextHitGrid = try self.allocator.alloc(u32, newHitGridSize);
             @memset(newCurrentHitGrid, 0);
-            @memset(newNextHitGrid, 0);
 
             self.allocator.free(self.currentHitGrid);
-            self.allocator.free(self.nextHitGrid);
             self.currentHitGrid = newCurrentHitGrid;
-            self.nextHitGrid = newNextHitGrid;
             self.hitGridWidth = width;
             self.hitGridHeight = height;
+            self.hitGridStale = true;
         }
 
         const cursor = self.terminal.getCursorPosition();
@@ -420,6 +561,79 @@ pub const CliRenderer = struct {
         self.renderOffset = offset;
     }
 
+    /// Switch to inline mode: render into `rows` lines starting at the cursor,
+    /// below whatever the program printed so far. Replaces setupTerminal; the
+    /// capability probe is skipped because its replies move the cursor, so
+    /// only cached capabilities (if any) are applied.
+    pub fn setupInline(self: *CliRenderer, rows: u32) !void {
+        if (rows == 0) return RendererError.InvalidDimensions;
+        try self.resize(self.width, rows);
+        self.inlineMode = true;
+        self.inlineRow = 0;
+        self.useAlternateScreen = false;
+        self.terminalSetup = true;
+
+        if (self.capabilityCache) |*old| old.deinit();
+        self.capabilityCache = capability_cache.CapabilityCache.init(self.allocator);
+        if (self.capabilityCache.?.cached) |caps| {
+            self.terminal.caps = caps;
+        }
+
+        const writer = self.stdoutWriter.writer();
+        writer.writeAll("\r") catch {};
+        ansi.ANSI.makeRoomForRendererOutput(writer, rows) catch {};
+        self.terminal.setCursorPosition(1, 1, false);
+        self.stdoutWriter.flush() catch {};
+    }
+
+    /// Queue text to be printed above the inline region on the next frame.
+    /// The region moves down by the rows the text wraps to and is repainted.
+    pub fn printAbove(self: *CliRenderer, text: []const u8) !void {
+        if (!self.inlineMode) return;
+        try self.inlinePending.appendSlice(self.allocator, text);
+        if (text.len == 0 or text[text.len - 1] != '\n') {
+            try self.inlinePending.append(self.allocator, '\n');
+        }
+    }
+
+    fn moveCursorOutput(self: *CliRenderer, writer: anytype, x: u32, y: u32) void {
+        if (!self.inlineMode) {
+            ansi.ANSI.moveToOutput(writer, x, y + self.renderOffset) catch {};
+            return;
+        }
+        const row = y -| 1;
+        if (row < self.inlineRow) {
+            std.fmt.format(writer, "\x1b[{d}A", .{self.inlineRow - row}) catch {};
+        } else if (row > self.inlineRow) {
+            std.fmt.format(writer, "\x1b[{d}B", .{row - self.inlineRow}) catch {};
+        }
+        std.fmt.format(writer, "\x1b[{d}G", .{x}) catch {};
+        self.inlineRow = row;
+    }
+
+    /// Write queued log lines above the region. The region is erased from
+    /// its top row down, the lines are written there and room for the region
+    /// is made again below them. Whether the screen scrolled on the way
+    /// depends on where the region sits, which is never known, so the whole
+    /// region is repainted on the next diff.
+    fn flushInlineLog(self: *CliRenderer, writer: anytype) void {
+        const text = std.mem.trimRight(u8, self.inlinePending.items, "\n");
+        defer self.inlinePending.clearRetainingCapacity();
+
+        writer.writeAll(ansi.ANSI.reset) catch {};
+        self.moveCursorOutput(writer, 1, 1);
+        writer.writeAll(ansi.ANSI.eraseBelowCursor) catch {};
+
+        var lines = std.mem.splitScalar(u8, text, '\n');
+        while (lines.next()) |line| {
+            writer.writeAll(line) catch {};
+            writer.writeAll(ansi.ANSI.reset ++ "\r\n") catch {};
+        }
+        ansi.ANSI.makeRoomForRendererOutput(writer, self.height) catch {};
+        self.inlineRow = 0;
+        @memset(self.currentRenderBuffer.buffer.char, CLEAR_CHAR);
+    }
+
     fn renderThreadFn(self: *CliRenderer) void {
         while (true) {
             self.renderMutex.lock();
@@ -529,19 +743,36 @@ pub const CliRenderer = struct {
 
         writer.writeAll(ansi.ANSI.hideCursor) catch {};
 
+        if (self.inlineMode and self.inlinePending.items.len > 0) {
+            self.flushInlineLog(writer);
+        }
+
         var currentFg: ?RGBA = null;
         var currentBg: ?RGBA = null;
         var currentAttributes: i16 = -1;
+        var activeStyle: style_table.StyleId = style_table.NO_STYLE;
         var utf8Buf: [4]u8 = undefined;
 
+        // OSC 8 state is only emitted when the link id changes between written cells
+        const linkPool: ?*link.LinkPool = if (self.terminal.getCapabilities().hyperlinks) link.getGlobalLinkPool() else null;
+        var currentLink: u16 = link.NO_LINK;
+
         const colorEpsilon: f32 = COLOR_EPSILON_DEFAULT;
 
         for (0..self.height) |uy| {
             const y = @as(u32, @intCast(uy));
 
+            // Static rows cost one memcmp per plane instead of a per-cell compare
+            if (!force and self.rowUnchanged(y)) continue;
+
             var runStart: i64 = -1;
             var runLength: u32 = 0;
 
+            // With interning the row's styles are ids and the terminal's SGR
+            // state is tracked across runs, so skipping cells needs no reset
+            const rowStyles = self.internRowStyles(y, &activeStyle);
+            const rowOffset = y * self.width;
+
             for (0..self.width) |ux| {
                 const x = @as(u32, @intCast(ux));
                 const currentCell = self.currentRenderBuffer.get(x, y);
@@ -551,14 +782,17 @@ pub const CliRenderer = struct {
 
                 if (!force) {
                     const charEqual = currentCell.?.char == nextCell.?.char;
-                    const attrEqual = currentCell.?.attributes == nextCell.?.attributes;
+                    const linkEqual = currentCell.?.link == nextCell.?.link;
+                    const styleEqual = if (rowStyles) |styles|
+                        self.styles.?.current[rowOffset + x] == styles[x]
+                    else
+                        currentCell.?.attributes == nextCell.?.attributes and
+                            buf.rgbaEqual(currentCell.?.fg, nextCell.?.fg, colorEpsilon) and
+                            buf.rgbaEqual(currentCell.?.bg, nextCell.?.bg, colorEpsilon);
 
-                    if (charEqual and attrEqual and
-                        buf.rgbaEqual(currentCell.?.fg, nextCell.?.fg, colorEpsilon) and
-                        buf.rgbaEqual(currentCell.?.bg, nextCell.?.bg, colorEpsilon))
-                    {
+                    if (charEqual and linkEqual and styleEqual) {
                         if (runLength > 0) {
-                            writer.writeAll(ansi.ANSI.reset) catch {};
+                            if (rowStyles == null) writer.writeAll(ansi.ANSI.reset) catch {};
                             runStart = -1;
                             runLength = 0;
                         }
@@ -568,36 +802,54 @@ pub const CliRenderer = struct {
 
                 const cell = nextCell.?;
 
-                const fgMatch = currentFg != null and buf.rgbaEqual(currentFg.?, cell.fg, colorEpsilon);
-                const bgMatch = currentBg != null and buf.rgbaEqual(currentBg.?, cell.bg, colorEpsilon);
-                const sameAttributes = fgMatch and bgMatch and @as(i16, cell.attributes) == currentAttributes;
-
-                if (!sameAttributes or runStart == -1) {
-                    if (runLength > 0) {
-                        writer.writeAll(ansi.ANSI.reset) catch {};
+                if (rowStyles) |styles| {
+                    if (runStart == -1) {
+                        runStart = @intCast(x);
+                        runLength = 0;
+                        self.moveCursorOutput(writer, x + 1, y + 1);
                     }
+                    if (styles[x] != activeStyle) {
+                        if (self.styles.?.table.transition(activeStyle, styles[x])) |bytes| {
+                            writer.writeAll(bytes) catch {};
+                        } else |_| {
+                            writer.writeAll(ansi.ANSI.reset) catch {};
+                            writeCellStyleOutput(writer, cell);
+                        }
+                        activeStyle = styles[x];
+                    }
+                } else {
+                    const fgMatch = currentFg != null and buf.rgbaEqual(currentFg.?, cell.fg, colorEpsilon);
+                    const bgMatch = currentBg != null and buf.rgbaEqual(currentBg.?, cell.bg, colorEpsilon);
+                    const sameAttributes = fgMatch and bgMatch and @as(i16, cell.attributes) == currentAttributes;
 
-                    runStart = @intCast(x);
-                    runLength = 0;
-
-                    currentFg = cell.fg;
-                    currentBg = cell.bg;
-                    currentAttributes = @intCast(cell.attributes);
-
-                    ansi.ANSI.moveToOutput(writer, x + 1, y + 1 + self.renderOffset) catch {};
+                    if (!sameAttributes or runStart == -1) {
+                        if (runLength > 0) {
+                            writer.writeAll(ansi.ANSI.reset) catch {};
+                        }
 
-                    const fgR = rgbaComponentToU8(cell.fg[0]);
-                    const fgG = rgbaComponentToU8(cell.fg[1]);
-                    const fgB = rgbaComponentToU8(cell.fg[2]);
+                        runStart = @intCast(x);
+                        runLength = 0;
 
-                    const bgR = rgbaComponentToU8(cell.bg[0]);
-                    const bgG = rgbaComponentToU8(cell.bg[1]);
-                    const bgB = rgbaComponentToU8(cell.bg[2]);
+                        currentFg = cell.fg;
+                        currentBg = cell.bg;
+                        currentAttributes = @intCast(cell.attributes);
 
-                    ansi.ANSI.fgColorOutput(writer, fgR, fgG, fgB) catch {};
-                    ansi.ANSI.bgColorOutput(writer, bgR, bgG, bgB) catch {};
+                        self.moveCursorOutput(writer, x + 1, y + 1);
+                        writeCellStyleOutput(writer, cell);
+                    }
+                }
 
-                    ansi.TextAttributes.applyAttributesOutputWriter(writer, cell.attributes) catch {};
+                if (linkPool) |pool| {
+                    if (cell.link != currentLink) {
+                        if (currentLink != link.NO_LINK) {
+                            writer.writeAll(ansi.ANSI.hyperlinkClose) catch {};
+                        }
+                        currentLink = link.NO_LINK;
+                        if (pool.get(cell.link)) |url| {
+                            ansi.ANSI.hyperlinkOpenOutput(writer, cell.link, url) catch {};
+                            currentLink = cell.link;
+                        }
+                    }
                 }
 
                 // Handle grapheme characters
@@ -626,6 +878,7 @@ pub const CliRenderer = struct {
 
                 // Update the current buffer with the new cell
                 self.currentRenderBuffer.setRaw(x, y, nextCell.?);
+                if (rowStyles) |styles| self.styles.?.current[rowOffset + x] = styles[x];
 
                 // If this is a grapheme start, also update all continuation cells
                 if (gp.isGraphemeChar(nextCell.?.char)) {
@@ -634,6 +887,7 @@ pub const CliRenderer = struct {
                     while (k <= rightExtent and x + k < self.width) : (k += 1) {
                         if (self.nextRenderBuffer.get(x + k, y)) |contCell| {
                             self.currentRenderBuffer.setRaw(x + k, y, contCell);
+                            if (rowStyles) |styles| self.styles.?.current[rowOffset + x + k] = styles[x + k];
                         }
                     }
                 }
@@ -642,6 +896,9 @@ pub const CliRenderer = struct {
             }
         }
 
+        if (currentLink != link.NO_LINK) {
+            writer.writeAll(ansi.ANSI.hyperlinkClose) catch {};
+        }
         writer.writeAll(ansi.ANSI.reset) catch {};
 
         const cursorPos = self.terminal.getCursorPosition();
@@ -678,7 +935,7 @@ pub const CliRenderer = struct {
 
             ansi.ANSI.cursorColorOutputWriter(writer, cursorR, cursorG, cursorB) catch {};
             writer.writeAll(cursorStyleCode) catch {};
-            ansi.ANSI.moveToOutput(writer, cursorPos.x, cursorPos.y + self.renderOffset) catch {};
+            self.moveCursorOutput(writer, cursorPos.x, cursorPos.y);
             writer.writeAll(ansi.ANSI.showCursor) catch {};
         } else {
             writer.writeAll(ansi.ANSI.hideCursor) catch {};
@@ -690,12 +947,80 @@ pub const CliRenderer = struct {
         self.renderStats.cellsUpdated = cellsUpdated;
         self.renderStats.renderTime = renderTime;
 
-        self.nextRenderBuffer.clear(.{ self.backgroundColor[0], self.backgroundColor[1], self.backgroundColor[2], 1.0 }, null) catch {};
+        if (!self.retainNextBuffer) {
+            self.nextRenderBuffer.clear(.{ self.backgroundColor[0], self.backgroundColor[1], self.backgroundColor[2], 1.0 }, null) catch {};
+        }
+        self.nextRenderBuffer.setLinkPen(link.NO_LINK);
+
+        self.swapHitRegions();
+    }
+
+    fn writeCellStyleOutput(writer: anytype, cell: buf.Cell) void {
+        const fgR = rgbaComponentToU8(cell.fg[0]);
+        const fgG = rgbaComponentToU8(cell.fg[1]);
+        const fgB = rgbaComponentToU8(cell.fg[2]);
+
+        const bgR = rgbaComponentToU8(cell.bg[0]);
+        const bgG = rgbaComponentToU8(cell.bg[1]);
+        const bgB = rgbaComponentToU8(cell.bg[2]);
+
+        ansi.ANSI.fgColorOutput(writer, fgR, fgG, fgB) catch {};
+        ansi.ANSI.bgColorOutput(writer, bgR, bgG, bgB) catch {};
+
+        ansi.TextAttributes.applyAttributesOutputWriter(writer, cell.attributes) catch {};
+    }
+
+    /// Style ids for row y of the next buffer, or null without interning.
+    /// Runs of bitwise equal cells share one lookup. A full table is reset,
+    /// which also forgets the ids of everything on screen: those cells and
+    /// the SGR state (activeStyle) count as unknown and repaint. Interning is
+    /// switched off if the table cannot even be refilled.
+    fn internRowStyles(self: *CliRenderer, y: u32, activeStyle: *style_table.StyleId) ?[]const style_table.StyleId {
+        const planes = if (self.styles) |*p| p else return null;
+        const next = &self.nextRenderBuffer.buffer;
+        const start = y * self.width;
+
+        var attempt: u32 = 0;
+        while (attempt < 2) : (attempt += 1) {
+            var ok = true;
+            for (0..self.width) |ux| {
+                const i = start + ux;
+                if (ux > 0 and next.attributes[i] == next.attributes[i - 1] and
+                    std.mem.eql(f32, &next.fg[i], &next.fg[i - 1]) and
+                    std.mem.eql(f32, &next.bg[i], &next.bg[i - 1]))
+                {
+                    planes.row[ux] = planes.row[ux - 1];
+                    continue;
+                }
+                planes.row[ux] = planes.table.intern(next.fg[i], next.bg[i], next.attributes[i]) catch {
+                    ok = false;
+                    break;
+                };
+            }
+            if (ok) return planes.row;
+
+            planes.table.reset();
+            @memset(planes.current, style_table.NO_STYLE);
+            activeStyle.* = style_table.NO_STYLE;
+        }
+
+        self.setStyleInterning(false) catch {};
+        return null;
+    }
 
-        const temp = self.currentHitGrid;
-        self.currentHitGrid = self.nextHitGrid;
-        self.nextHitGrid = temp;
-        @memset(self.nextHitGrid, 0);
+    /// Bitwise row equality between the current and next buffer. Only a fast
+    /// path: rows that differ bitwise may still be equal within epsilon and
+    /// fall through to the per-cell compare.
+    fn rowUnchanged(self: *CliRenderer, y: u32) bool {
+        const start = y * self.width;
+        const end = start + self.width;
+        const cur = &self.currentRenderBuffer.buffer;
+        const next = &self.nextRenderBuffer.buffer;
+        return std.mem.eql(u32, cur.char[start..end], next.char[start..end]) and
+            std.mem.eql(u8, cur.attributes[start..end], next.attributes[start..end]) and
+            std.mem.eql(u16, cur.link[start..end], next.link[start..end]) and
+            std.mem.eql(u8, std.mem.sliceAsBytes(cur.fg[start..end]), std.mem.sliceAsBytes(next.fg[start..end])) and
+            std.mem.eql(u8, std.mem.sliceAsBytes(cur.bg[start..end]), std.mem.sliceAsBytes(next.bg[start..end]));
     }
 
     pub fn setDebugOverlay(self: *CliRenderer, enabled: bool, corner: DebugOverlayCorner) void {
@@ -703,6 +1028,13 @@ pub const CliRenderer = struct {
         self.debugOverlay.corner = corner;
     }
 
+    /// Replace the text shown under the debug overlay's stats. Lines past
+    /// DEBUG_REPORT_MAX_LINES or wider than the overlay are cut off.
+    pub fn setDebugReport(self: *CliRenderer, text: []const u8) !void {
+        self.debugReport.clearRetainingCapacity();
+        try self.debugReport.appendSlice(self.allocator, std.mem.trimRight(u8, text, "\n"));
+    }
+
     pub fn clearTerminal(self: *CliRenderer) void {
         var bufferedWriter = &self.stdoutWriter;
         bufferedWriter.writer().writeAll(ansi.ANSI.clearAndHome) catch {};
@@ -710,25 +1042,48 @@ pub const CliRenderer = struct {
     }
 
     pub fn addToHitGrid(self: *CliRenderer, x: i32, y: i32, width: u32, height: u32, id: u32) void {
-        const startX = @max(0, x);
-        const startY = @max(0, y);
-        const endX = @min(@as(i32, @intCast(self.hitGridWidth)), x + @as(i32, @intCast(width)));
-        const endY = @min(@as(i32, @intCast(self.hitGridHeight)), y + @as(i32, @intCast(height)));
+        self.nextHitRegions.append(self.allocator, .{ .x = x, .y = y, .width = width, .height = height, .id = id }) catch {
+            logger.warn("Failed to record hit region {d}", .{id});
+        };
+    }
+
+    /// Submit a whole frame's hit regions in one call; later regions win on overlap
+    pub fn addHitRegions(self: *CliRenderer, regions: []const HitRegion) void {
+        self.nextHitRegions.appendSlice(self.allocator, regions) catch {
+            logger.warn("Failed to record {d} hit regions", .{regions.len});
+        };
+    }
+
+    fn swapHitRegions(self: *CliRenderer) void {
+        const temp = self.currentHitRegions;
+        self.currentHitRegions = self.nextHitRegions;
+        self.nextHitRegions = temp;
+        self.nextHitRegions.clearRetainingCapacity();
+        self.hitGridStale = true;
+    }
+
+    fn rasterizeHitGrid(self: *CliRenderer) void {
+        @memset(self.currentHitGrid, 0);
+        const gridWidth: i64 = self.hitGridWidth;
+        const gridHeight: i64 = self.hitGridHeight;
 
-        if (startX >= endX or startY >= endY) return;
+        for (self.currentHitRegions.items) |region| {
+            const startX = @max(0, @as(i64, region.x));
+            const startY = @max(0, @as(i64, region.y));
+            const endX = @min(gridWidth, @as(i64, region.x) + region.width);
+            const endY = @min(gridHeight, @as(i64, region.y) + region.height);
 
-        const uStartX: u32 = @intCast(startX);
-        const uStartY: u32 = @intCast(startY);
-        const uEndX: u32 = @intCast(endX);
-        const uEndY: u32 = @intCast(endY);
+            if (startX >= endX or startY >= endY) continue;
 
-        for (uStartY..uEndY) |row| {
-            const rowStart = row * self.hitGridWidth;
-            const startIdx = rowStart + uStartX;
-            const endIdx = rowStart + uEndX;
+            const uStartX: u32 = @intCast(startX);
+            const uEndX: u32 = @intCast(endX);
 
-            @memset(self.nextHitGrid[startIdx..endIdx], id);
+            for (@as(u32, @intCast(startY))..@as(u32, @intCast(endY))) |row| {
+                const rowStart = row * self.hitGridWidth;
+                @memset(self.currentHitGrid[rowStart + uStartX .. rowStart + uEndX], region.id);
+            }
         }
+        self.hitGridStale = false;
     }
 
     pub fn checkHit(self: *CliRenderer, x: u32, y: u32) u32 {
@@ -736,11 +1091,15 @@ pub const CliRenderer = struct {
             return 0;
         }
 
+        if (self.hitGridStale) self.rasterizeHitGrid();
+
         const index = y * self.hitGridWidth + x;
         return self.currentHitGrid[index];
     }
 
     pub fn dumpHitGrid(self: *CliRenderer) void {
+        if (self.hitGridStale) self.rasterizeHitGrid();
+
         const timestamp = std.time.timestamp();
         var filename_buf: [64]u8 = undefined;
         const filename = std.fmt.bufPrint(&filename_buf, "hitgrid_{d}.txt", .{timestamp}) catch return;
@@ -888,9 +1247,29 @@ pub const CliRenderer = struct {
     }
 
     pub fn processCapabilityResponse(self: *CliRenderer, response: []const u8) void {
+        // Cursor position reports double as modified F3 keys, so they only
+        // count while a probe is outstanding
+        if (!Terminal.isCapabilityResponse(response, self.probeState != .idle)) return;
+        if (self.probeState == .awaiting) {
+            self.probeState = .receiving;
+            self.terminal.caps = .{};
+        }
         self.terminal.processCapabilityResponse(response);
-        const writer = self.stdoutWriter.writer();
-        self.terminal.enableDetectedFeatures(writer.any()) catch {};
+        if (self.terminalSetup) {
+            const writer = self.stdoutWriter.writer();
+            self.terminal.enableDetectedFeatures(writer.any()) catch {};
+        }
+        if (self.probeState == .receiving and Terminal.isProbeComplete(response)) {
+            self.probeState = .idle;
+            if (self.capabilityCache) |*cache| cache.update(self.terminal.caps);
+        }
+    }
+
+    /// True when setup applied capabilities from the cache, so callers need
+    /// not wait for the probe response before rendering
+    pub fn hasCachedCapabilities(self: *CliRenderer) bool {
+        if (self.capabilityCache) |cache| return cache.cached != null;
+        return false;
     }
 
     pub fn setCursorPosition(self: *CliRenderer, x: u32, y: u32, visible: bool) void {
@@ -909,7 +1288,12 @@ pub const CliRenderer = struct {
         if (!self.debugOverlay.enabled) return;
 
         const width: u32 = 40;
-        const height: u32 = 11;
+        const reportLines: u32 = if (self.debugReport.items.len == 0)
+            0
+        else
+            @min(@as(u32, @intCast(std.mem.count(u8, self.debugReport.items, "\n") + 1)), DEBUG_REPORT_MAX_LINES);
+        // Room for every stat line, a blank separator and the report
+        const height: u32 = if (reportLines > 0) 14 + reportLines else 11;
         var x: u32 = 0;
         var y: u32 = 0;
 
@@ -1020,5 +1404,17 @@ pub const CliRenderer = struct {
         const isThreadedLen = std.fmt.bufPrint(&isThreadedText, "Threaded: {s}", .{if (self.useThread) "Yes" else "No"}) catch return;
         self.nextRenderBuffer.drawText(isThreadedLen, x + 1, y + row, fg, bg, 0) catch {};
         row += 1;
+
+        if (reportLines == 0) return;
+        row += 1;
+        self.nextRenderBuffer.pushScissorRect(@intCast(x + 1), @intCast(y + row), width - 2, reportLines) catch return;
+        defer self.nextRenderBuffer.popScissorRect();
+        var lines = std.mem.splitScalar(u8, self.debugReport.items, '\n');
+        var drawn: u32 = 0;
+        while (lines.next()) |line| : (drawn += 1) {
+            if (drawn == reportLines) break;
+            self.nextRenderBuffer.drawText(line, x + 1, y + row, fg, bg, 0) catch {};
+            row += 1;
+        }
     }
 };
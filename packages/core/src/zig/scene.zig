@@ -0,0 +1,723 @@
+const std = @import("std");
+const Allocator = std.mem.Allocator;
+const ansi = @import("ansi.zig");
+const buffer = @import("buffer.zig");
+const Graphemes = @import("Graphemes");
+const DisplayWidth = @import("DisplayWidth");
+const width_cache = @import("width_cache.zig");
+
+const RGBA = ansi.RGBA;
+const OptimizedBuffer = buffer.OptimizedBuffer;
+
+/// Native retained scene graph
+///
+/// The host keeps its own view tree and sends only what changed as a flat
+/// stream of u32 patch records. Layout, culling, painting and hit testing
+/// then run here in one pass, without an FFI crossing per node. Layout is a
+/// flexbox subset in whole cells: direction, fixed/percent/auto sizes,
+/// flex-grow, cross-axis stretch, padding, gap and absolute offsets.
+///
+/// Painting is incremental: patches and layout changes record damaged rects,
+/// and only those are cleared and repainted. The target buffer therefore has
+/// to keep its contents between frames (renderer retained mode) unless the
+/// caller asks for a full repaint.
+///
+/// Patch records, one u32 per field:
+///     create    1 id
+///     remove    2 id                  removes the whole subtree
+///     insert    3 id parent index     NO_NODE index appends; moves if attached
+///     set       4 id prop value
+///     set_text  5 id offset len       bytes in the side text buffer
+///     set_title 6 id offset len
+pub const NO_NODE: u32 = std.math.maxInt(u32);
+pub const ROOT: u32 = 0;
+pub const MAX_NODES: u32 = 1 << 20;
+const MAX_DAMAGE_RECTS = 16;
+
+pub const Op = enum(u32) {
+    create = 1,
+    remove = 2,
+    insert = 3,
+    set = 4,
+    set_text = 5,
+    set_title = 6,
+};
+
+pub const Prop = enum(u32) {
+    direction = 0, // 0 column, 1 row
+    width = 1, // see DIM_AUTO / DIM_PERCENT
+    height = 2,
+    flex_grow = 3, // f32 bits
+    padding_top = 4,
+    padding_right = 5,
+    padding_bottom = 6,
+    padding_left = 7,
+    gap = 8,
+    position = 9, // 0 relative, 1 absolute
+    left = 10, // i32 bits
+    top = 11,
+    fg = 12, // 0xRRGGBBAA
+    bg = 13,
+    border = 14, // 0 none, 1 single, 2 double, 3 rounded
+    border_color = 15,
+    title_align = 16, // 0 left, 1 center, 2 right
+    clip = 17,
+    hit_id = 18,
+};
+
+/// Size encoding: DIM_AUTO, DIM_PERCENT | hundredths of a percent, or cells
+pub const DIM_AUTO: u32 = NO_NODE;
+pub const DIM_PERCENT: u32 = 0x8000_0000;
+
+pub const PatchError = error{
+    Truncated,
+    UnknownOp,
+    UnknownProp,
+    BadNode,
+    BadText,
+    OutOfMemory,
+};
+
+const BORDER_CHARS = [_][11]u32{
+    .{ 0x250C, 0x2510, 0x2514, 0x2518, 0x2500, 0x2502, 0x252C, 0x2534, 0x251C, 0x2524, 0x253C },
+    .{ 0x2554, 0x2557, 0x255A, 0x255D, 0x2550, 0x2551, 0x2566, 0x2569, 0x2560, 0x2563, 0x256C },
+    .{ 0x256D, 0x256E, 0x2570, 0x256F, 0x2500, 0x2502, 0x252C, 0x2534, 0x251C, 0x2524, 0x253C },
+};
+
+pub const Rect = struct {
+    x: i32 = 0,
+    y: i32 = 0,
+    w: u32 = 0,
+    h: u32 = 0,
+
+    fn right(self: Rect) i64 {
+        return @as(i64, self.x) + self.w;
+    }
+
+    fn bottom(self: Rect) i64 {
+        return @as(i64, self.y) + self.h;
+    }
+
+    fn isEmpty(self: Rect) bool {
+        return self.w == 0 or self.h == 0;
+    }
+
+    fn eql(a: Rect, b: Rect) bool {
+        return a.x == b.x and a.y == b.y and a.w == b.w and a.h == b.h;
+    }
+
+    fn intersects(a: Rect, b: Rect) bool {
+        if (a.isEmpty() or b.isEmpty()) return false;
+        return a.x < b.right() and b.x < a.right() and a.y < b.bottom() and b.y < a.bottom();
+    }
+
+    fn contains(self: Rect, x: i32, y: i32) bool {
+        return x >= self.x and x < self.right() and y >= self.y and y < self.bottom();
+    }
+
+    fn unite(a: Rect, b: Rect) Rect {
+        if (a.isEmpty()) return b;
+        if (b.isEmpty()) return a;
+        const x = @min(a.x, b.x);
+        const y = @min(a.y, b.y);
+        return .{
+            .x = x,
+            .y = y,
+            .w = @intCast(@max(a.right(), b.right()) - x),
+            .h = @intCast(@max(a.bottom(), b.bottom()) - y),
+        };
+    }
+
+    fn intersect(a: Rect, b: Rect) Rect {
+        const x = @max(a.x, b.x);
+        const y = @max(a.y, b.y);
+        const r = @min(a.right(), b.right());
+        const btm = @min(a.bottom(), b.bottom());
+        if (r <= x or btm <= y) return .{};
+        return .{ .x = x, .y = y, .w = @intCast(r - x), .h = @intCast(btm - y) };
+    }
+};
+
+const Style = struct {
+    row: bool = false,
+    width: u32 = DIM_AUTO,
+    height: u32 = DIM_AUTO,
+    flex_grow: f32 = 0,
+    padding: [4]u32 = .{ 0, 0, 0, 0 }, // top, right, bottom, left
+    gap: u32 = 0,
+    absolute: bool = false,
+    left: i32 = 0,
+    top: i32 = 0,
+    fg: u32 = 0xE6E6E6FF,
+    bg: u32 = 0,
+    border: u32 = 0,
+    border_color: u32 = 0x808080FF,
+    title_align: u32 = 0,
+    clip: bool = false,
+    hit_id: u32 = 0,
+};
+
+const Node = struct {
+    alive: bool = false,
+    parent: u32 = NO_NODE,
+    children: std.ArrayListUnmanaged(u32) = .{},
+    style: Style = .{},
+    text: std.ArrayListUnmanaged(u8) = .{},
+    title: std.ArrayListUnmanaged(u8) = .{},
+    text_w: u32 = 0,
+    text_h: u32 = 0,
+    /// Absolute layout output in cells
+    rect: Rect = .{},
+    /// rect united with every descendant's bounds, for culling
+    bounds: Rect = .{},
+    /// Intrinsic outer size, valid while measured_gen matches the scene
+    measured_gen: u32 = 0,
+    intrinsic_w: u32 = 0,
+    intrinsic_h: u32 = 0,
+};
+
+/// Counters for the last patch and frame
+pub const Stats = extern struct {
+    nodes: u32 = 0,
+    records: u32 = 0,
+    layouts: u32 = 0,
+    painted: u32 = 0,
+    damaged_cells: u32 = 0,
+};
+
+pub const Scene = struct {
+    allocator: Allocator,
+    graphemes: *const Graphemes,
+    display_width: *const DisplayWidth,
+    nodes: std.ArrayListUnmanaged(Node) = .{},
+    damage: std.ArrayListUnmanaged(Rect) = .{},
+    layout_dirty: bool = true,
+    full_damage: bool = true,
+    layout_gen: u32 = 0,
+    viewport: Rect = .{},
+    stats: Stats = .{},
+
+    pub fn create(allocator: Allocator, graphemes: *const Graphemes, display_width: *const DisplayWidth) !*Scene {
+        const self = try allocator.create(Scene);
+        self.* = .{
+            .allocator = allocator,
+            .graphemes = graphemes,
+            .display_width = display_width,
+        };
+        errdefer self.destroy();
+        try self.nodes.append(allocator, .{ .alive = true });
+        self.stats.nodes = 1;
+        return self;
+    }
+
+    pub fn destroy(self: *Scene) void {
+        for (self.nodes.items) |*node| {
+            self.freeNodeData(node);
+        }
+        self.nodes.deinit(self.allocator);
+        self.damage.deinit(self.allocator);
+        self.allocator.destroy(self);
+    }
+
+    fn freeNodeData(self: *Scene, node: *Node) void {
+        node.children.deinit(self.allocator);
+        node.text.deinit(self.allocator);
+        node.title.deinit(self.allocator);
+    }
+
+    fn liveNode(self: *Scene, id: u32) PatchError!*Node {
+        if (id >= self.nodes.items.len) return PatchError.BadNode;
+        const node = &self.nodes.items[id];
+        if (!node.alive) return PatchError.BadNode;
+        return node;
+    }
+
+    /// Apply a batch of patch records. Records before a malformed one stay
+    /// applied; the error says which problem stopped the batch.
+    pub fn applyPatch(self: *Scene, words: []const u32, text: []const u8) PatchError!void {
+        self.stats.records = 0;
+        var i: usize = 0;
+        while (i < words.len) {
+            const op = std.meta.intToEnum(Op, words[i]) catch return PatchError.UnknownOp;
+            const argc: usize = switch (op) {
+                .create, .remove => 1,
+                .insert, .set, .set_text, .set_title => 3,
+            };
+            if (i + 1 + argc > words.len) return PatchError.Truncated;
+            const args = words[i + 1 .. i + 1 + argc];
+            switch (op) {
+                .create => try self.createNode(args[0]),
+                .remove => try self.removeNode(args[0]),
+                .insert => try self.insertNode(args[0], args[1], args[2]),
+                .set => try self.setProp(args[0], args[1], args[2]),
+                .set_text, .set_title => {
+                    const start: usize = args[1];
+                    const end = start + @as(usize, args[2]);
+                    if (end > text.len) return PatchError.BadText;
+                    try self.setText(args[0], text[start..end], op == .set_title);
+                },
+            }
+            i += 1 + argc;
+            self.stats.records += 1;
+        }
+    }
+
+    fn createNode(self: *Scene, id: u32) PatchError!void {
+        if (id == ROOT or id >= MAX_NODES) return PatchError.BadNode;
+        if (id >= self.nodes.items.len) {
+            try self.nodes.appendNTimes(self.allocator, .{}, id + 1 - self.nodes.items.len);
+        }
+        const node = &self.nodes.items[id];
+        if (node.alive) return PatchError.BadNode;
+        // Keep the allocations of a recycled slot
+        var children = node.children;
+        var text = node.text;
+        var title = node.title;
+        children.clearRetainingCapacity();
+        text.clearRetainingCapacity();
+        title.clearRetainingCapacity();
+        node.* = .{ .alive = true, .children = children, .text = text, .title = title };
+        self.stats.nodes += 1;
+    }
+
+    fn detach(self: *Scene, id: u32) void {
+        const node = &self.nodes.items[id];
+        if (node.parent == NO_NODE) return;
+        const siblings = &self.nodes.items[node.parent].children;
+        if (std.mem.indexOfScalar(u32, siblings.items, id)) |pos| {
+            _ = siblings.orderedRemove(pos);
+        }
+        node.parent = NO_NODE;
+        self.addDamage(node.bounds);
+        self.layout_dirty = true;
+    }
+
+    fn removeNode(self: *Scene, id: u32) PatchError!void {
+        if (id == ROOT) return PatchError.BadNode;
+        _ = try self.liveNode(id);
+        self.detach(id);
+        self.releaseSubtree(id);
+    }
+
+    fn releaseSubtree(self: *Scene, id: u32) void {
+        const node = &self.nodes.items[id];
+        for (node.children.items) |child| {
+            self.releaseSubtree(child);
+        }
+        node.children.clearRetainingCapacity();
+        node.alive = false;
+        node.parent = NO_NODE;
+        self.stats.nodes -= 1;
+    }
+
+    fn insertNode(self: *Scene, id: u32, parent: u32, index: u32) PatchError!void {
+        if (id == ROOT) return PatchError.BadNode;
+        _ = try self.liveNode(id);
+        _ = try self.liveNode(parent);
+        // Refuse to make a node its own ancestor
+        var up = parent;
+        while (up != NO_NODE) : (up = self.nodes.items[up].parent) {
+            if (up == id) return PatchError.BadNode;
+        }
+        self.detach(id);
+        const children = &self.nodes.items[parent].children;
+        const at = @min(@as(usize, index), children.items.len);
+        try children.insert(self.allocator, at, id);
+        self.nodes.items[id].parent = parent;
+        self.layout_dirty = true;
+    }
+
+    fn setProp(self: *Scene, id: u32, prop_raw: u32, value: u32) PatchError!void {
+        const node = try self.liveNode(id);
+        const prop = std.meta.intToEnum(Prop, prop_raw) catch return PatchError.UnknownProp;
+        const style = &node.style;
+        switch (prop) {
+            .direction => style.row = value == 1,
+            .width => style.width = value,
+            .height => style.height = value,
+            .flex_grow => style.flex_grow = @bitCast(value),
+            .padding_top => style.padding[0] = value,
+            .padding_right => style.padding[1] = value,
+            .padding_bottom => style.padding[2] = value,
+            .padding_left => style.padding[3] = value,
+            .gap => style.gap = value,
+            .position => style.absolute = value == 1,
+            .left => style.left = @bitCast(value),
+            .top => style.top = @bitCast(value),
+            .fg => style.fg = value,
+            .bg => style.bg = value,
+            .border => style.border = value,
+            .border_color => style.border_color = value,
+            .title_align => style.title_align = value,
+            .clip => style.clip = value != 0,
+            .hit_id => style.hit_id = value,
+        }
+        switch (prop) {
+            .fg, .bg, .border_color, .title_align, .clip => self.addDamage(node.bounds),
+            .hit_id => {},
+            else => self.layout_dirty = true,
+        }
+    }
+
+    fn setText(self: *Scene, id: u32, bytes: []const u8, is_title: bool) PatchError!void {
+        const node = try self.liveNode(id);
+        const target = if (is_title) &node.title else &node.text;
+        target.clearRetainingCapacity();
+        try target.appendSlice(self.allocator, bytes);
+        self.addDamage(node.rect);
+        if (is_title) return;
+
+        var w: u32 = 0;
+        var h: u32 = 0;
+        if (bytes.len > 0) {
+            var lines = std.mem.splitScalar(u8, bytes, '\n');
+            while (lines.next()) |line| {
+                w = @max(w, width_cache.textWidth(line, .unicode, self.graphemes, self.display_width));
+                h += 1;
+            }
+        }
+        if (w != node.text_w or h != node.text_h) {
+            node.text_w = w;
+            node.text_h = h;
+            self.layout_dirty = true;
+        }
+    }
+
+    fn addDamage(self: *Scene, rect: Rect) void {
+        if (rect.isEmpty() or self.full_damage) return;
+        if (self.damage.items.len >= MAX_DAMAGE_RECTS) {
+            // Too fragmented: collapse into one bounding rect
+            var all = rect;
+            for (self.damage.items) |r| all = all.unite(r);
+            self.damage.clearRetainingCapacity();
+            self.damage.appendAssumeCapacity(all);
+            return;
+        }
+        self.damage.append(self.allocator, rect) catch {
+            self.full_damage = true;
+        };
+    }
+
+    // Layout
+
+    fn inset(node: *const Node) u32 {
+        return if (node.style.border != 0) 1 else 0;
+    }
+
+    fn innerRect(node: *const Node) Rect {
+        const r = node.rect;
+        const b = inset(node);
+        const left = b + node.style.padding[3];
+        const top = b + node.style.padding[0];
+        const horizontal = left + b + node.style.padding[1];
+        const vertical = top + b + node.style.padding[2];
+        return .{
+            .x = r.x + @as(i32, @intCast(left)),
+            .y = r.y + @as(i32, @intCast(top)),
+            .w = r.w -| horizontal,
+            .h = r.h -| vertical,
+        };
+    }
+
+    /// Resolve a size against the available space; null for auto
+    fn resolveDim(dim: u32, available: u32) ?u32 {
+        if (dim == DIM_AUTO) return null;
+        if (dim & DIM_PERCENT != 0) {
+            const hundredths: u64 = dim & ~DIM_PERCENT;
+            return @intCast(@as(u64, available) * hundredths / 10000);
+        }
+        return dim;
+    }
+
+    /// Outer size from content alone (percent sizes count as auto here)
+    fn measure(self: *Scene, id: u32) struct { w: u32, h: u32 } {
+        const node = &self.nodes.items[id];
+        if (node.measured_gen == self.layout_gen) {
+            return .{ .w = node.intrinsic_w, .h = node.intrinsic_h };
+        }
+        const style = node.style;
+        var main: u32 = 0;
+        var cross: u32 = 0;
+        var count: u32 = 0;
+        for (node.children.items) |child_id| {
+            const child = &self.nodes.items[child_id];
+            if (child.style.absolute) continue;
+            const size = self.measure(child_id);
+            const w = fixedDim(child.style.width) orelse size.w;
+            const h = fixedDim(child.style.height) orelse size.h;
+            if (style.row) {
+                main += w;
+                cross = @max(cross, h);
+            } else {
+                main += h;
+                cross = @max(cross, w);
+            }
+            count += 1;
+        }
+        if (count > 1) main += style.gap * (count - 1);
+        var content_w = if (style.row) main else cross;
+        var content_h = if (style.row) cross else main;
+        content_w = @max(content_w, node.text_w);
+        content_h = @max(content_h, node.text_h);
+
+        const b = inset(node);
+        const w = content_w + 2 * b + style.padding[1] + style.padding[3];
+        const h = content_h + 2 * b + style.padding[0] + style.padding[2];
+        node.intrinsic_w = w;
+        node.intrinsic_h = h;
+        node.measured_gen = self.layout_gen;
+        return .{ .w = w, .h = h };
+    }
+
+    fn fixedDim(dim: u32) ?u32 {
+        if (dim == DIM_AUTO or dim & DIM_PERCENT != 0) return null;
+        return dim;
+    }
+
+    fn runLayout(self: *Scene) void {
+        self.layout_gen +%= 1;
+        if (self.layout_gen == 0) self.layout_gen = 1;
+        self.layoutNode(ROOT, self.viewport);
+        self.stats.layouts += 1;
+    }
+
+    fn placeNode(self: *Scene, id: u32, rect: Rect) void {
+        const node = &self.nodes.items[id];
+        if (!node.rect.eql(rect)) {
+            self.addDamage(node.rect);
+            self.addDamage(rect);
+            node.rect = rect;
+        }
+    }
+
+    fn layoutNode(self: *Scene, id: u32, rect: Rect) void {
+        self.placeNode(id, rect);
+        const node = &self.nodes.items[id];
+        const inner = innerRect(node);
+        const style = node.style;
+        const main_avail: u32 = if (style.row) inner.w else inner.h;
+        const cross_avail: u32 = if (style.row) inner.h else inner.w;
+
+        // Flex basis of every in-flow child, then share out what is left
+        var total_basis: u64 = 0;
+        var total_grow: f32 = 0;
+        var count: u32 = 0;
+        for (node.children.items) |child_id| {
+            const child = &self.nodes.items[child_id];
+            if (child.style.absolute) continue;
+            total_basis += self.mainBasis(child_id, style.row, main_avail);
+            total_grow += @max(child.style.flex_grow, 0);
+            count += 1;
+        }
+        const gaps: u64 = if (count > 1) @as(u64, style.gap) * (count - 1) else 0;
+        const free: u64 = (@as(u64, main_avail) -| total_basis) -| gaps;
+
+        var offset: i64 = 0;
+        var grow_seen: f32 = 0;
+        var given: u64 = 0;
+        for (node.children.items) |child_id| {
+            const child_style = self.nodes.items[child_id].style;
+            if (child_style.absolute) {
+                self.layoutAbsolute(child_id, rect);
+                continue;
+            }
+            var main = self.mainBasis(child_id, style.row, main_avail);
+            if (free > 0 and total_grow > 0 and child_style.flex_grow > 0) {
+                // Share by running total so rounding never loses a cell
+                grow_seen += child_style.flex_grow;
+                const share = @min(grow_seen / total_grow, 1.0);
+                const target: u64 = @max(given, @as(u64, @intFromFloat(@as(f32, @floatFromInt(free)) * share)));
+                main += @intCast(target - given);
+                given = target;
+            }
+            const cross_dim = if (style.row) child_style.height else child_style.width;
+            const cross = resolveDim(cross_dim, cross_avail) orelse cross_avail;
+            const pos_main = @as(i64, if (style.row) inner.x else inner.y) + offset;
+            var child_rect: Rect = if (style.row)
+                .{ .x = @intCast(pos_main), .y = inner.y, .w = main, .h = cross }
+            else
+                .{ .x = inner.x, .y = @intCast(pos_main), .w = cross, .h = main };
+            child_rect.x += child_style.left;
+            child_rect.y += child_style.top;
+            self.layoutNode(child_id, child_rect);
+            offset += @as(i64, main) + style.gap;
+        }
+
+        var bounds = node.rect;
+        for (node.children.items) |child_id| {
+            bounds = bounds.unite(self.nodes.items[child_id].bounds);
+        }
+        node.bounds = bounds;
+    }
+
+    fn mainBasis(self: *Scene, id: u32, row: bool, main_avail: u32) u32 {
+        const style = self.nodes.items[id].style;
+        const dim = if (row) style.width else style.height;
+        if (resolveDim(dim, main_avail)) |v| return v;
+        const size = self.measure(id);
+        return if (row) size.w else size.h;
+    }
+
+    fn layoutAbsolute(self: *Scene, id: u32, parent_rect: Rect) void {
+        const style = self.nodes.items[id].style;
+        const size = self.measure(id);
+        const w = resolveDim(style.width, parent_rect.w) orelse size.w;
+        const h = resolveDim(style.height, parent_rect.h) orelse size.h;
+        self.layoutNode(id, .{
+            .x = parent_rect.x + style.left,
+            .y = parent_rect.y + style.top,
+            .w = w,
+            .h = h,
+        });
+    }
+
+    // Painting
+
+    /// Lay out if needed and repaint the damaged parts of target. Pass full
+    /// when target does not hold the previous frame.
+    pub fn render(self: *Scene, target: *OptimizedBuffer, full: bool) !void {
+        const viewport = Rect{ .w = target.getWidth(), .h = target.getHeight() };
+        if (!viewport.eql(self.viewport)) {
+            self.viewport = viewport;
+            self.layout_dirty = true;
+            self.full_damage = true;
+        }
+        if (full) self.full_damage = true;
+        if (self.layout_dirty) {
+            self.runLayout();
+            self.layout_dirty = false;
+        }
+        if (self.full_damage) {
+            self.damage.clearRetainingCapacity();
+            try self.damage.append(self.allocator, viewport);
+            self.full_damage = false;
+        }
+
+        self.stats.painted = 0;
+        self.stats.damaged_cells = 0;
+        const root_bg = self.nodes.items[ROOT].style.bg;
+        const background = if (root_bg & 0xff != 0) unpackColor(root_bg) else RGBA{ 0.0, 0.0, 0.0, 1.0 };
+
+        target.clearScissorRects();
+        for (self.damage.items) |damaged| {
+            const area = damaged.intersect(viewport);
+            if (area.isEmpty()) continue;
+            self.stats.damaged_cells += area.w * area.h;
+            try target.pushScissorRect(area.x, area.y, area.w, area.h);
+            defer target.popScissorRect();
+            try target.fillRect(@intCast(area.x), @intCast(area.y), area.w, area.h, background);
+            try self.paintNode(target, ROOT, area);
+        }
+        self.damage.clearRetainingCapacity();
+    }
+
+    fn paintNode(self: *Scene, target: *OptimizedBuffer, id: u32, area: Rect) !void {
+        const node = &self.nodes.items[id];
+        if (!node.bounds.intersects(area)) return;
+        const rect = node.rect;
+        const style = node.style;
+        const visible = rect.intersects(area);
+
+        if (visible) {
+            self.stats.painted += 1;
+            if (id != ROOT and style.bg & 0xff != 0) {
+                const clipped = rect.intersect(self.viewport);
+                if (!clipped.isEmpty()) {
+                    try target.fillRect(@intCast(clipped.x), @intCast(clipped.y), clipped.w, clipped.h, unpackColor(style.bg));
+                }
+            }
+            if (node.text.items.len > 0) {
+                paintText(target, node);
+            }
+        }
+
+        var paint_children = node.children.items.len > 0;
+        var clipped_children = false;
+        if (paint_children and style.clip) {
+            const inner = innerRect(node);
+            if (target.clipRectToScissor(inner.x, inner.y, inner.w, inner.h)) |clip| {
+                try target.pushScissorRect(clip.x, clip.y, clip.width, clip.height);
+                clipped_children = true;
+            } else {
+                paint_children = false;
+            }
+        }
+        if (paint_children) {
+            for (node.children.items) |child_id| {
+                try self.paintNode(target, child_id, area);
+            }
+        }
+        if (clipped_children) target.popScissorRect();
+
+        if (visible and style.border != 0 and style.border <= BORDER_CHARS.len) {
+            const title: ?[]const u8 = if (node.title.items.len > 0) node.title.items else null;
+            try target.drawBox(
+                rect.x,
+                rect.y,
+                rect.w,
+                rect.h,
+                &BORDER_CHARS[style.border - 1],
+                .{ .top = true, .right = true, .bottom = true, .left = true },
+                unpackColor(style.border_color),
+                unpackColor(style.bg),
+                false,
+                title,
+                @intCast(@min(style.title_align, 2)),
+            );
+        }
+    }
+
+    fn paintText(target: *OptimizedBuffer, node: *const Node) void {
+        const inner = innerRect(node);
+        // Vertically centered in the content box, like the MoonBit renderer
+        const center: i32 = if (inner.h > node.text_h) @intCast((inner.h - node.text_h) / 2) else 0;
+        const clip = target.clipRectToScissor(inner.x, inner.y, inner.w, inner.h) orelse return;
+        target.pushScissorRect(clip.x, clip.y, clip.width, clip.height) catch return;
+        defer target.popScissorRect();
+        var y = inner.y + center;
+        var lines = std.mem.splitScalar(u8, node.text.items, '\n');
+        while (lines.next()) |line| : (y += 1) {
+            if (y < 0 or inner.x < 0 or line.len == 0) continue;
+            target.drawText(line, @intCast(inner.x), @intCast(y), unpackColor(node.style.fg), null, 0) catch {};
+        }
+    }
+
+    /// hit_id of the topmost node under (x, y), or 0
+    pub fn hitTest(self: *Scene, x: i32, y: i32) u32 {
+        if (self.layout_dirty) {
+            self.runLayout();
+            self.layout_dirty = false;
+        }
+        return self.hitNode(ROOT, x, y);
+    }
+
+    fn hitNode(self: *Scene, id: u32, x: i32, y: i32) u32 {
+        const node = &self.nodes.items[id];
+        if (!node.bounds.contains(x, y)) return 0;
+        if (!node.style.clip or innerRect(node).contains(x, y)) {
+            var i = node.children.items.len;
+            while (i > 0) {
+                i -= 1;
+                const hit = self.hitNode(node.children.items[i], x, y);
+                if (hit != 0) return hit;
+            }
+        }
+        if (node.style.hit_id != 0 and node.rect.contains(x, y)) return node.style.hit_id;
+        return 0;
+    }
+
+    /// Layout rect of a node, for hosts that position overlays against it
+    pub fn getRect(self: *Scene, id: u32) ?Rect {
+        const node = self.liveNode(id) catch return null;
+        return node.rect;
+    }
+};
+
+fn unpackColor(c: u32) RGBA {
+    return .{
+        @as(f32, @floatFromInt((c >> 24) & 0xff)) / 255.0,
+        @as(f32, @floatFromInt((c >> 16) & 0xff)) / 255.0,
+        @as(f32, @floatFromInt((c >> 8) & 0xff)) / 255.0,
+        @as(f32, @floatFromInt(c & 0xff)) / 255.0,
+    };
+}
@@ -0,0 +1,833 @@
+const std = @import("std");
+const Allocator = std.mem.Allocator;
+const gp = @import("grapheme.zig");
+const width_cache = @import("width_cache.zig");
+const tb = @import("text-buffer.zig");
+
+const RGBA = tb.RGBA;
+const TextBuffer = tb.TextBuffer;
+const TextChunk = tb.TextChunk;
+const Highlight = tb.Highlight;
+
+/// Incremental search over the cells of a TextBuffer
+///
+/// Matches are char ranges in the same coordinates selections use, so they
+/// can be highlighted and scrolled to without going through UTF-8. A search
+/// first scans the lines under the viewport, then streams through the rest
+/// of the buffer in budgeted steps and finally wraps around to the lines
+/// above the viewport. Output appended while a search is open is picked up
+/// by the next step; other edits restart it.
+///
+/// Patterns are literal unless FLAG_REGEX is set, which enables a small
+/// subset: `.`, `[...]` and `[^...]` classes, `\d \w \s` and their upper-case
+/// negations, the postfix `* + ?` and the anchors `^` and `$`. There are no
+/// groups or alternation. FLAG_IGNORE_CASE folds ASCII letters only. Matches
+/// never span lines and are never empty.
+///
+/// When a match must start with an ASCII character, candidates are found
+/// with a vector scan of each chunk's cells, on the one-byte cells of ASCII
+/// chunks as well as the u32 cells of encoded ones. Only the candidates are
+/// matched cell by cell, across chunk boundaries.
+pub const FLAG_IGNORE_CASE: u32 = 1;
+pub const FLAG_REGEX: u32 = 2;
+
+pub const NO_MATCH: u32 = std.math.maxInt(u32);
+
+/// Longest query accepted, in bytes
+pub const MAX_PATTERN_LEN = 1024;
+
+const SCAN_LANES = 16;
+
+pub const SearchError = error{
+    OutOfMemory,
+    InvalidPattern,
+};
+
+pub const Match = struct {
+    start: u32,
+    end: u32,
+};
+
+pub const Stats = extern struct {
+    matches: u32 = 0,
+    complete: u32 = 0,
+    /// Work since the search started
+    lines_scanned: u32 = 0,
+    cells_scanned: u32 = 0,
+    /// Previous matches re-checked because the query only grew
+    refined: u32 = 0,
+    /// Matches painted by the last highlight
+    highlighted: u32 = 0,
+};
+
+const Quant = enum {
+    one,
+    optional,
+    star,
+    plus,
+};
+
+const Range = struct {
+    lo: u21,
+    hi: u21,
+};
+
+const Class = struct {
+    start: u32,
+    len: u32,
+    negated: bool,
+};
+
+const AtomKind = union(enum) {
+    /// A single code point, folded when ignoring case
+    char: u21,
+    /// A grapheme of several code points, compared with the pool bytes;
+    /// the bytes live in Pattern.bytes
+    cluster: struct { start: u32, len: u32 },
+    any,
+    class: u32,
+};
+
+const Atom = struct {
+    kind: AtomKind,
+    quant: Quant = .one,
+};
+
+const DIGIT = [_]Range{.{ .lo = '0', .hi = '9' }};
+const WORD = [_]Range{
+    .{ .lo = '0', .hi = '9' },
+    .{ .lo = 'A', .hi = 'Z' },
+    .{ .lo = '_', .hi = '_' },
+    .{ .lo = 'a', .hi = 'z' },
+};
+const SPACE = [_]Range{ .{ .lo = ' ', .hi = ' ' }, .{ .lo = '\t', .hi = '\t' } };
+
+fn shorthandRanges(c: u8) ?[]const Range {
+    return switch (c) {
+        'd' => &DIGIT,
+        'w' => &WORD,
+        's' => &SPACE,
+        else => null,
+    };
+}
+
+fn fold(cp: u21) u21 {
+    return if (cp >= 'A' and cp <= 'Z') cp + 32 else cp;
+}
+
+fn isOp(cluster: []const u8, op: u8) bool {
+    return cluster.len == 1 and cluster[0] == op;
+}
+
+/// The code point of bytes that hold exactly one
+fn singleCodepoint(bytes: []const u8) ?u21 {
+    if (bytes.len == 0) return null;
+    const len = std.unicode.utf8ByteSequenceLength(bytes[0]) catch return null;
+    if (len != bytes.len) return null;
+    return std.unicode.utf8Decode(bytes) catch null;
+}
+
+fn firstCodepoint(bytes: []const u8) u21 {
+    if (bytes.len == 0) return 0xFFFD;
+    const len = std.unicode.utf8ByteSequenceLength(bytes[0]) catch return 0xFFFD;
+    if (len > bytes.len) return 0xFFFD;
+    return std.unicode.utf8Decode(bytes[0..len]) catch 0xFFFD;
+}
+
+fn inRanges(ranges: []const Range, cp: u21) bool {
+    for (ranges) |r| {
+        if (cp >= r.lo and cp <= r.hi) return true;
+    }
+    return false;
+}
+
+/// Index of the first cell at or after `from` equal to a or b
+fn findCell(cells: anytype, from: usize, a: u8, b: u8) ?usize {
+    const T = std.meta.Elem(@TypeOf(cells));
+    const Lanes = @Vector(SCAN_LANES, T);
+    const want_a: Lanes = @splat(@as(T, a));
+    const want_b: Lanes = @splat(@as(T, b));
+    var i = from;
+    while (i + SCAN_LANES <= cells.len) : (i += SCAN_LANES) {
+        const lanes: Lanes = cells[i..][0..SCAN_LANES].*;
+        const hits = @as(u16, @bitCast(lanes == want_a)) | @as(u16, @bitCast(lanes == want_b));
+        if (hits != 0) return i + @ctz(hits);
+    }
+    while (i < cells.len) : (i += 1) {
+        if (cells[i] == a or cells[i] == b) return i;
+    }
+    return null;
+}
+
+/// A compiled query
+const Pattern = struct {
+    atoms: std.ArrayListUnmanaged(Atom) = .{},
+    classes: std.ArrayListUnmanaged(Class) = .{},
+    ranges: std.ArrayListUnmanaged(Range) = .{},
+    bytes: std.ArrayListUnmanaged(u8) = .{},
+    anchor_start: bool = false,
+    anchor_end: bool = false,
+    ignore_case: bool = false,
+
+    fn deinit(self: *Pattern, allocator: Allocator) void {
+        self.atoms.deinit(allocator);
+        self.classes.deinit(allocator);
+        self.ranges.deinit(allocator);
+        self.bytes.deinit(allocator);
+    }
+
+    fn isEmpty(self: *const Pattern) bool {
+        return self.atoms.items.len == 0;
+    }
+
+    /// Whether this query is `prev` with atoms appended. Atoms are compared
+    /// rather than bytes, since appended text can merge into the last
+    /// grapheme (a combining mark after its base letter) and change it.
+    fn extends(self: *const Pattern, prev: *const Pattern) bool {
+        const n = prev.atoms.items.len;
+        if (n == 0 or self.atoms.items.len <= n) return false;
+        for (prev.atoms.items, self.atoms.items[0..n]) |old, new| {
+            if (old.quant != new.quant) return false;
+            switch (old.kind) {
+                .char => |cp| if (new.kind != .char or new.kind.char != cp) return false,
+                .cluster => |c| {
+                    if (new.kind != .cluster) return false;
+                    const d = new.kind.cluster;
+                    const old_bytes = prev.bytes.items[c.start..][0..c.len];
+                    if (!std.mem.eql(u8, old_bytes, self.bytes.items[d.start..][0..d.len])) return false;
+                },
+                .any => if (new.kind != .any) return false,
+                // Classes index per-pattern tables; regex queries are never refined
+                .class => return false,
+            }
+        }
+        return true;
+    }
+
+    /// The query is split into graphemes the way the buffer splits text, so
+    /// a grapheme in the query lines up with a cell
+    fn compile(self: *Pattern, allocator: Allocator, text_buffer: *TextBuffer, source: []const u8, flags: u32) SearchError!void {
+        self.ignore_case = flags & FLAG_IGNORE_CASE != 0;
+
+        var clusters = std.ArrayList([]const u8).init(allocator);
+        defer clusters.deinit();
+        var iter = text_buffer.graphemes_data.iterator(source);
+        while (iter.next()) |gc| {
+            const bytes = gc.bytes(source);
+            if (bytes[0] == '\n' or bytes[0] == '\r') return SearchError.InvalidPattern;
+            // Zero-width clusters never make it into the cells
+            if (width_cache.clusterWidth(bytes, text_buffer.width_method, &text_buffer.display_width) == 0) continue;
+            try clusters.append(bytes);
+        }
+
+        if (flags & FLAG_REGEX != 0) {
+            try self.parseRegex(allocator, clusters.items);
+        } else {
+            for (clusters.items) |cluster| {
+                try self.atoms.append(allocator, .{ .kind = try self.literal(allocator, cluster) });
+            }
+        }
+    }
+
+    fn literal(self: *Pattern, allocator: Allocator, cluster: []const u8) SearchError!AtomKind {
+        if (singleCodepoint(cluster)) |cp| {
+            return .{ .char = if (self.ignore_case) fold(cp) else cp };
+        }
+        const start: u32 = @intCast(self.bytes.items.len);
+        try self.bytes.appendSlice(allocator, cluster);
+        return .{ .cluster = .{ .start = start, .len = @intCast(cluster.len) } };
+    }
+
+    fn parseRegex(self: *Pattern, allocator: Allocator, clusters: []const []const u8) SearchError!void {
+        var i: usize = 0;
+        if (clusters.len > 0 and isOp(clusters[0], '^')) {
+            self.anchor_start = true;
+            i = 1;
+        }
+
+        while (i < clusters.len) {
+            const c = clusters[i];
+            i += 1;
+
+            var kind: AtomKind = undefined;
+            if (c.len != 1) {
+                kind = try self.literal(allocator, c);
+            } else switch (c[0]) {
+                '$' => {
+                    if (i == clusters.len) {
+                        self.anchor_end = true;
+                        break;
+                    }
+                    kind = .{ .char = '$' };
+                },
+                '.' => kind = .any,
+                '[' => kind = .{ .class = try self.parseClass(allocator, clusters, &i) },
+                '\\' => {
+                    if (i == clusters.len) return SearchError.InvalidPattern;
+                    const escaped = clusters[i];
+                    i += 1;
+                    kind = if (try self.escapeClass(allocator, escaped)) |class|
+                        .{ .class = class }
+                    else
+                        try self.literal(allocator, escaped);
+                },
+                '*', '+', '?' => return SearchError.InvalidPattern,
+                else => kind = try self.literal(allocator, c),
+            }
+
+            var quant: Quant = .one;
+            if (i < clusters.len and clusters[i].len == 1) {
+                quant = switch (clusters[i][0]) {
+                    '*' => .star,
+                    '+' => .plus,
+                    '?' => .optional,
+                    else => .one,
+                };
+                if (quant != .one) i += 1;
+            }
+            try self.atoms.append(allocator, .{ .kind = kind, .quant = quant });
+        }
+    }
+
+    fn addClass(self: *Pattern, allocator: Allocator, start: usize, negated: bool) SearchError!u32 {
+        const index: u32 = @intCast(self.classes.items.len);
+        try self.classes.append(allocator, .{
+            .start = @intCast(start),
+            .len = @intCast(self.ranges.items.len - start),
+            .negated = negated,
+        });
+        return index;
+    }
+
+    /// Class for `\d`, `\w`, `\s` and their upper-case negations
+    fn escapeClass(self: *Pattern, allocator: Allocator, escaped: []const u8) SearchError!?u32 {
+        if (escaped.len != 1) return null;
+        const ranges = shorthandRanges(std.ascii.toLower(escaped[0])) orelse return null;
+        const start = self.ranges.items.len;
+        try self.ranges.appendSlice(allocator, ranges);
+        return try self.addClass(allocator, start, std.ascii.isUpper(escaped[0]));
+    }
+
+    /// Bracket class; `i` starts just past the `[` and ends just past the `]`
+    fn parseClass(self: *Pattern, allocator: Allocator, clusters: []const []const u8, i: *usize) SearchError!u32 {
+        const start = self.ranges.items.len;
+        var negated = false;
+        if (i.* < clusters.len and isOp(clusters[i.*], '^')) {
+            negated = true;
+            i.* += 1;
+        }
+
+        // A `]` right after the opening bracket is literal
+        var first = true;
+        while (true) : (first = false) {
+            if (i.* >= clusters.len) return SearchError.InvalidPattern;
+            const c = clusters[i.*];
+            i.* += 1;
+            if (isOp(c, ']') and !first) break;
+
+            var lo = firstCodepoint(c);
+            if (isOp(c, '\\')) {
+                if (i.* >= clusters.len) return SearchError.InvalidPattern;
+                const escaped = clusters[i.*];
+                i.* += 1;
+                if (escaped.len == 1) {
+                    if (shorthandRanges(escaped[0])) |ranges| {
+                        try self.ranges.appendSlice(allocator, ranges);
+                        continue;
+                    }
+                }
+                lo = firstCodepoint(escaped);
+            }
+
+            var hi = lo;
+            if (i.* + 1 < clusters.len and isOp(clusters[i.*], '-') and !isOp(clusters[i.* + 1], ']')) {
+                hi = firstCodepoint(clusters[i.* + 1]);
+                i.* += 2;
+                if (hi < lo) return SearchError.InvalidPattern;
+            }
+            try self.ranges.append(allocator, .{ .lo = lo, .hi = hi });
+        }
+        return self.addClass(allocator, start, negated);
+    }
+
+    fn inClass(self: *const Pattern, index: u32, cp: u21) bool {
+        const class = self.classes.items[index];
+        const ranges = self.ranges.items[class.start..][0..class.len];
+        var hit = inRanges(ranges, cp);
+        if (!hit and self.ignore_case and cp < 0x80) {
+            const c: u8 = @intCast(cp);
+            const other = if (std.ascii.isLower(c)) std.ascii.toUpper(c) else std.ascii.toLower(c);
+            hit = other != c and inRanges(ranges, other);
+        }
+        return hit != class.negated;
+    }
+
+    /// ASCII byte every match starts with, if there is one
+    fn firstByte(self: *const Pattern) ?u8 {
+        if (self.anchor_start or self.atoms.items.len == 0) return null;
+        const first = self.atoms.items[0];
+        if (first.quant != .one and first.quant != .plus) return null;
+        return switch (first.kind) {
+            .char => |cp| if (cp < 0x80) @intCast(cp) else null,
+            else => null,
+        };
+    }
+};
+
+/// Position in the cells of one line, walking across chunk boundaries
+const Cursor = struct {
+    chunks: []const TextChunk,
+    chunk: usize = 0,
+    index: usize = 0,
+    /// Cells from the start of the line
+    pos: u32 = 0,
+
+    /// Cell under the cursor, or null at the end of the line
+    fn peek(self: *Cursor) ?u32 {
+        while (self.chunk < self.chunks.len) {
+            const chars = self.chunks[self.chunk].chars;
+            if (self.index < chars.len()) {
+                const cell = chars.at(self.index);
+                return if (cell == '\n') null else cell;
+            }
+            self.chunk += 1;
+            self.index = 0;
+        }
+        return null;
+    }
+
+    /// Step over the cell under the cursor and the continuation cells of a wide grapheme
+    fn advance(self: *Cursor) void {
+        self.index += 1;
+        self.pos += 1;
+        while (self.peek()) |cell| {
+            if (!gp.isContinuationChar(cell)) break;
+            self.index += 1;
+            self.pos += 1;
+        }
+    }
+};
+
+fn cursorAt(chunks: []const TextChunk, pos: u32) Cursor {
+    var cur = Cursor{ .chunks = chunks, .pos = pos };
+    var left: usize = pos;
+    while (cur.chunk < chunks.len) : (cur.chunk += 1) {
+        const len = chunks[cur.chunk].chars.len();
+        if (left < len) {
+            cur.index = left;
+            return cur;
+        }
+        left -= len;
+    }
+    return cur;
+}
+
+pub const TextSearch = struct {
+    allocator: Allocator,
+    text_buffer: *TextBuffer,
+    pattern: Pattern = .{},
+    flags: u32 = 0,
+
+    /// Matches in the lines before start_line, and from start_line on. Both
+    /// are appended in line order, so head followed by tail is sorted.
+    head: std.ArrayListUnmanaged(Match) = .{},
+    tail: std.ArrayListUnmanaged(Match) = .{},
+    start_line: u32 = 0,
+    /// Next line to scan in each range
+    tail_next: u32 = 0,
+    head_next: u32 = 0,
+    /// Last line of the buffer when the tail was finished, and the char
+    /// count then; output appended since may have extended that line
+    open_line: u32 = NO_MATCH,
+    scanned_chars: u32 = 0,
+    generation: u32 = 0,
+
+    /// Backtracking positions of repeated atoms
+    stack: std.ArrayListUnmanaged(Cursor) = .{},
+    highlights: std.ArrayListUnmanaged(Highlight) = .{},
+
+    match_fg: ?RGBA = .{ 0.0, 0.0, 0.0, 1.0 },
+    match_bg: RGBA = .{ 0.8, 0.7, 0.2, 1.0 },
+    current_fg: ?RGBA = .{ 0.0, 0.0, 0.0, 1.0 },
+    current_bg: RGBA = .{ 1.0, 0.5, 0.0, 1.0 },
+
+    stats: Stats = .{},
+
+    pub fn create(allocator: Allocator, text_buffer: *TextBuffer) !*TextSearch {
+        const self = try allocator.create(TextSearch);
+        self.* = .{
+            .allocator = allocator,
+            .text_buffer = text_buffer,
+            .generation = text_buffer.edit_generation,
+        };
+        return self;
+    }
+
+    pub fn destroy(self: *TextSearch) void {
+        self.pattern.deinit(self.allocator);
+        self.head.deinit(self.allocator);
+        self.tail.deinit(self.allocator);
+        self.stack.deinit(self.allocator);
+        self.highlights.deinit(self.allocator);
+        self.allocator.destroy(self);
+    }
+
+    /// Search for `source`, scanning the lines under rows [first_row,
+    /// first_row + row_count) before returning; `run` does the rest. A
+    /// literal query that extends the previous one only re-checks the
+    /// previous matches. On error the previous search is left as it was.
+    pub fn setPattern(self: *TextSearch, source: []const u8, flags: u32, first_row: u32, row_count: u32) SearchError!void {
+        if (source.len > MAX_PATTERN_LEN) return SearchError.InvalidPattern;
+
+        var pattern = Pattern{};
+        errdefer pattern.deinit(self.allocator);
+        try pattern.compile(self.allocator, self.text_buffer, source, flags);
+
+        self.sync();
+        const extends = flags & FLAG_REGEX == 0 and flags == self.flags and pattern.extends(&self.pattern);
+
+        self.pattern.deinit(self.allocator);
+        self.pattern = pattern;
+        self.flags = flags;
+
+        if (extends) {
+            self.stats.refined = 0;
+            try self.refine(&self.head);
+            try self.refine(&self.tail);
+            return;
+        }
+
+        self.restart(self.lineForRow(first_row));
+        const last_line = self.lineForRow((first_row +| row_count) -| 1);
+        while (self.tail_next <= last_line) {
+            _ = (try self.step()) orelse break;
+        }
+    }
+
+    /// Drop the query and its highlights
+    pub fn clear(self: *TextSearch) void {
+        self.pattern.deinit(self.allocator);
+        self.pattern = .{};
+        self.flags = 0;
+        self.restart(0);
+        self.text_buffer.clearHighlights();
+    }
+
+    /// Scan lines until about `budget` cells have been read; true once the
+    /// whole buffer has been searched
+    pub fn run(self: *TextSearch, budget: u32) SearchError!bool {
+        self.sync();
+        var spent: u32 = 0;
+        while (spent < budget) {
+            spent +|= (try self.step()) orelse break;
+        }
+        return self.isComplete();
+    }
+
+    pub fn isComplete(self: *const TextSearch) bool {
+        if (self.pattern.isEmpty()) return true;
+        return self.generation == self.text_buffer.edit_generation and
+            self.tail_next >= self.text_buffer.lines.items.len and
+            self.head_next >= self.start_line and
+            self.scanned_chars == self.text_buffer.char_count;
+    }
+
+    pub fn matchCount(self: *const TextSearch) u32 {
+        return @intCast(self.head.items.len + self.tail.items.len);
+    }
+
+    /// Match by index in buffer order, among those found so far
+    pub fn getMatch(self: *const TextSearch, index: u32) ?Match {
+        if (index < self.head.items.len) return self.head.items[index];
+        const i = index - self.head.items.len;
+        return if (i < self.tail.items.len) self.tail.items[i] else null;
+    }
+
+    /// Index of the first match starting at or after `offset`, or with
+    /// `backward` of the last one starting before it; NO_MATCH if none
+    pub fn findMatch(self: *const TextSearch, offset: u32, backward: bool) u32 {
+        const i = self.lowerBound("start", offset);
+        if (backward) return if (i > 0) i - 1 else NO_MATCH;
+        return if (i < self.matchCount()) i else NO_MATCH;
+    }
+
+    /// Paint the matches under rows [first_row, first_row + row_count) into
+    /// the TextBuffer, the one at index `current` in the current-match
+    /// colors; returns how many were painted
+    pub fn highlight(self: *TextSearch, first_row: u32, row_count: u32, current: u32) SearchError!u32 {
+        self.sync();
+        const info = self.text_buffer.getCachedLineInfo();
+        const char_count = self.text_buffer.char_count;
+        const rows_end = first_row +| row_count;
+        const start = if (first_row < info.starts.len) info.starts[first_row] else char_count;
+        const end = if (rows_end < info.starts.len) info.starts[rows_end] else char_count;
+
+        self.highlights.clearRetainingCapacity();
+        var i = self.lowerBound("end", start +| 1);
+        while (self.getMatch(i)) |m| : (i += 1) {
+            if (m.start >= end) break;
+            const is_current = i == current;
+            try self.highlights.append(self.allocator, .{
+                .start = m.start,
+                .end = m.end,
+                .fg = if (is_current) self.current_fg else self.match_fg,
+                .bg = if (is_current) self.current_bg else self.match_bg,
+            });
+        }
+        self.text_buffer.setHighlights(self.highlights.items) catch return SearchError.OutOfMemory;
+        self.stats.highlighted = @intCast(self.highlights.items.len);
+        return self.stats.highlighted;
+    }
+
+    pub fn setColors(self: *TextSearch, match_fg: ?RGBA, match_bg: RGBA, current_fg: ?RGBA, current_bg: RGBA) void {
+        self.match_fg = match_fg;
+        self.match_bg = match_bg;
+        self.current_fg = current_fg;
+        self.current_bg = current_bg;
+    }
+
+    pub fn getStats(self: *const TextSearch) Stats {
+        var stats = self.stats;
+        stats.matches = self.matchCount();
+        stats.complete = @intFromBool(self.isComplete());
+        return stats;
+    }
+
+    /// Index of the first match whose `field` is at least `offset`
+    fn lowerBound(self: *const TextSearch, comptime field: []const u8, offset: u32) u32 {
+        var lo: u32 = 0;
+        var hi: u32 = self.matchCount();
+        while (lo < hi) {
+            const mid = lo + (hi - lo) / 2;
+            if (@field(self.getMatch(mid).?, field) < offset) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        return lo;
+    }
+
+    fn lineForRow(self: *TextSearch, row: u32) u32 {
+        const info = self.text_buffer.getCachedLineInfo();
+        const offset = if (row < info.starts.len) info.starts[row] else self.text_buffer.char_count;
+        return @intCast(self.text_buffer.findLineForChar(offset));
+    }
+
+    fn restart(self: *TextSearch, start_line: u32) void {
+        self.head.clearRetainingCapacity();
+        self.tail.clearRetainingCapacity();
+        const last_line: u32 = @intCast(self.text_buffer.lines.items.len - 1);
+        self.start_line = @min(start_line, last_line);
+        self.tail_next = self.start_line;
+        self.head_next = 0;
+        self.open_line = NO_MATCH;
+        self.scanned_chars = 0;
+        self.generation = self.text_buffer.edit_generation;
+        self.stats = .{};
+    }
+
+    /// Catch up with writes since the last call. Appends only rescan the
+    /// line that was last; any other edit restarts the search.
+    fn sync(self: *TextSearch) void {
+        if (self.generation != self.text_buffer.edit_generation) {
+            self.restart(self.start_line);
+            return;
+        }
+        if (self.tail_next > self.open_line and self.scanned_chars != self.text_buffer.char_count) {
+            const from = self.text_buffer.lines.items[self.open_line].char_offset;
+            while (self.tail.items.len > 0 and self.tail.getLast().start >= from) {
+                _ = self.tail.pop();
+            }
+            self.tail_next = self.open_line;
+            self.open_line = NO_MATCH;
+        }
+    }
+
+    /// Scan the next line in search order and return its cell count; null
+    /// once every line has been scanned
+    fn step(self: *TextSearch) SearchError!?u32 {
+        if (self.pattern.isEmpty()) return null;
+        const line_count: u32 = @intCast(self.text_buffer.lines.items.len);
+        var cells: u32 = 0;
+        if (self.tail_next < line_count) {
+            cells = try self.scanLine(self.tail_next, &self.tail);
+            self.tail_next += 1;
+            if (self.tail_next == line_count) {
+                self.open_line = line_count - 1;
+                self.scanned_chars = self.text_buffer.char_count;
+            }
+        } else if (self.head_next < self.start_line) {
+            cells = try self.scanLine(self.head_next, &self.head);
+            self.head_next += 1;
+        } else {
+            return null;
+        }
+        self.stats.lines_scanned += 1;
+        self.stats.cells_scanned +|= cells;
+        return cells;
+    }
+
+    /// Append the matches in one line; returns the line's cell count
+    fn scanLine(self: *TextSearch, line_index: u32, out: *std.ArrayListUnmanaged(Match)) SearchError!u32 {
+        const lines = self.text_buffer.lines.items;
+        const line = &lines[line_index];
+        const chunks = line.chunks.items;
+        const base = line.char_offset;
+        const line_end = if (line_index + 1 < lines.len) lines[line_index + 1].char_offset else self.text_buffer.char_count;
+        const cells = line_end -| base;
+        const atoms = self.pattern.atoms.items;
+
+        if (self.pattern.anchor_start) {
+            if (try self.matchAt(atoms, .{ .chunks = chunks })) |end| {
+                if (end.pos > 0) try out.append(self.allocator, .{ .start = base, .end = base + end.pos });
+            }
+            return cells;
+        }
+
+        if (self.pattern.firstByte()) |first| {
+            const other: u8 = if (self.pattern.ignore_case) std.ascii.toUpper(first) else first;
+            // Line position the next match may start at; matches do not overlap
+            var resume_at: u32 = 0;
+            var chunk_pos: u32 = 0;
+            for (chunks, 0..) |chunk, chunk_index| {
+                const len: u32 = @intCast(chunk.chars.len());
+                var from: usize = resume_at -| chunk_pos;
+                while (from < len) {
+                    const hit = switch (chunk.chars) {
+                        inline else => |chars| findCell(chars, from, first, other),
+                    } orelse break;
+                    const cur = Cursor{
+                        .chunks = chunks,
+                        .chunk = chunk_index,
+                        .index = hit,
+                        .pos = chunk_pos + @as(u32, @intCast(hit)),
+                    };
+                    if (try self.matchAt(atoms, cur)) |end| {
+                        try out.append(self.allocator, .{ .start = base + cur.pos, .end = base + end.pos });
+                        resume_at = end.pos;
+                        from = resume_at -| chunk_pos;
+                    } else {
+                        from = hit + 1;
+                    }
+                }
+                chunk_pos += len;
+            }
+            return cells;
+        }
+
+        var cur = Cursor{ .chunks = chunks };
+        while (cur.peek() != null) {
+            if (try self.matchAt(atoms, cur)) |end| {
+                if (end.pos > cur.pos) {
+                    try out.append(self.allocator, .{ .start = base + cur.pos, .end = base + end.pos });
+                    cur = end;
+                    continue;
+                }
+            }
+            cur.advance();
+        }
+        return cells;
+    }
+
+    /// Keep the matches of a query that extends the previous one. Every new
+    /// match is also a match of the old query, so it starts at an old match
+    /// or inside one the old scan stepped over. Each old match yields at most
+    /// one new match, which lets the list be compacted in place.
+    fn refine(self: *TextSearch, list: *std.ArrayListUnmanaged(Match)) SearchError!void {
+        const atoms = self.pattern.atoms.items;
+        var kept: usize = 0;
+        var last_end: u32 = 0;
+        for (0..list.items.len) |i| {
+            const old = list.items[i];
+            const line = &self.text_buffer.lines.items[self.text_buffer.findLineForChar(old.start)];
+            const base = line.char_offset;
+            var cur = cursorAt(line.chunks.items, old.start - base);
+            while (base + cur.pos < old.end and cur.peek() != null) : (cur.advance()) {
+                if (base + cur.pos < last_end) continue;
+                if (try self.matchAt(atoms, cur)) |end| {
+                    list.items[kept] = .{ .start = base + cur.pos, .end = base + end.pos };
+                    kept += 1;
+                    last_end = base + end.pos;
+                    break;
+                }
+            }
+        }
+        const rechecked: u32 = @intCast(list.items.len);
+        self.stats.refined +|= rechecked;
+        list.shrinkRetainingCapacity(kept);
+    }
+
+    /// Where a match of `atoms` starting at `start` ends, or null
+    fn matchAt(self: *TextSearch, atoms: []const Atom, start: Cursor) SearchError!?Cursor {
+        var cur = start;
+        for (atoms, 0..) |atom, i| {
+            if (atom.quant != .one) return self.matchRepeat(atom, atoms[i + 1 ..], cur);
+            const cell = cur.peek() orelse return null;
+            if (!self.cellMatches(atom.kind, cell)) return null;
+            cur.advance();
+        }
+        if (self.pattern.anchor_end and cur.peek() != null) return null;
+        return cur;
+    }
+
+    /// Greedy repeat with backtracking. The position after each repetition
+    /// goes on a shared stack instead of the call stack, so a long run of
+    /// repeats does not recurse.
+    fn matchRepeat(self: *TextSearch, atom: Atom, rest: []const Atom, start: Cursor) SearchError!?Cursor {
+        const base = self.stack.items.len;
+        defer self.stack.shrinkRetainingCapacity(base);
+
+        try self.stack.append(self.allocator, start);
+        var cur = start;
+        while (atom.quant != .optional or self.stack.items.len - base < 2) {
+            const cell = cur.peek() orelse break;
+            if (!self.cellMatches(atom.kind, cell)) break;
+            cur.advance();
+            try self.stack.append(self.allocator, cur);
+        }
+
+        const min: usize = if (atom.quant == .plus) 1 else 0;
+        var taken = self.stack.items.len - base;
+        while (taken > min) {
+            taken -= 1;
+            // Copy out first: matching the rest may grow the stack
+            const at = self.stack.items[base + taken];
+            if (try self.matchAt(rest, at)) |end| return end;
+        }
+        return null;
+    }
+
+    fn cellMatches(self: *TextSearch, kind: AtomKind, cell: u32) bool {
+        switch (kind) {
+            .any => return true,
+            .char => |cp| {
+                if (cell < 0x80) {
+                    const c: u21 = @intCast(cell);
+                    return (if (self.pattern.ignore_case) fold(c) else c) == cp;
+                }
+                if (!gp.isGraphemeChar(cell)) return cell == cp;
+                const bytes = self.graphemeBytes(cell) orelse return false;
+                return if (singleCodepoint(bytes)) |c| c == cp else false;
+            },
+            .cluster => |ref| {
+                if (!gp.isGraphemeChar(cell)) return false;
+                const bytes = self.graphemeBytes(cell) orelse return false;
+                return std.mem.eql(u8, bytes, self.pattern.bytes.items[ref.start..][0..ref.len]);
+            },
+            .class => |index| {
+                const cp: u21 = if (cell < 0x80)
+                    @intCast(cell)
+                else if (gp.isGraphemeChar(cell))
+                    firstCodepoint(self.graphemeBytes(cell) orelse return false)
+                else
+                    std.math.cast(u21, cell) orelse return false;
+                return self.pattern.inClass(index, cp);
+            },
+        }
+    }
+
+    fn graphemeBytes(self: *TextSearch, cell: u32) ?[]const u8 {
+        return self.text_buffer.pool.get(gp.graphemeIdFromChar(cell)) catch null;
+    }
+};
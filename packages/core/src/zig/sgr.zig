@@ -0,0 +1,308 @@
+const std = @import("std");
+const ansi = @import("ansi.zig");
+
+const RGBA = ansi.RGBA;
+const Attr = ansi.TextAttributes;
+
+/// Streaming ANSI ingest: splits raw terminal output into styled text runs
+///
+/// Text between escape sequences goes to the sink unchanged (newlines
+/// included); SGR sequences update the current style and every other
+/// escape (cursor moves, OSC titles, DCS strings) is dropped. All parser
+/// state lives in the struct, so a stream can be fed in arbitrary slices:
+/// an escape sequence or a UTF-8 character cut at a slice boundary is
+/// completed by the next call.
+///
+/// The sink needs `writeChunk(bytes, fg: ?RGBA, bg: ?RGBA, attr: ?u8)`; null
+/// means the sink's default, as after `ESC[0m`.
+pub const MAX_PARAMS = 32;
+
+const ESC: u8 = 0x1B;
+const SCAN_LANES = 16;
+
+const State = enum(u8) {
+    ground,
+    escape,
+    csi,
+    /// OSC, DCS, SOS, PM and APC: skipped up to BEL or ST
+    string,
+    string_escape,
+};
+
+/// The 16 ANSI colors, xterm defaults
+const BASIC_COLORS = [16][3]u8{
+    .{ 0, 0, 0 },       .{ 205, 0, 0 },   .{ 0, 205, 0 },   .{ 205, 205, 0 },
+    .{ 0, 0, 238 },     .{ 205, 0, 205 }, .{ 0, 205, 205 }, .{ 229, 229, 229 },
+    .{ 127, 127, 127 }, .{ 255, 0, 0 },   .{ 0, 255, 0 },   .{ 255, 255, 0 },
+    .{ 92, 92, 255 },   .{ 255, 0, 255 }, .{ 0, 255, 255 }, .{ 255, 255, 255 },
+};
+
+fn rgb(r: u32, g: u32, b: u32) RGBA {
+    return .{
+        @as(f32, @floatFromInt(@min(r, 255))) / 255.0,
+        @as(f32, @floatFromInt(@min(g, 255))) / 255.0,
+        @as(f32, @floatFromInt(@min(b, 255))) / 255.0,
+        1.0,
+    };
+}
+
+/// xterm 256-color palette entry
+pub fn paletteColor(index: u8) RGBA {
+    if (index < 16) {
+        const c = BASIC_COLORS[index];
+        return rgb(c[0], c[1], c[2]);
+    }
+    if (index < 232) {
+        const i = index - 16;
+        const steps = [6]u32{ 0, 95, 135, 175, 215, 255 };
+        return rgb(steps[i / 36], steps[(i / 6) % 6], steps[i % 6]);
+    }
+    const level: u32 = 8 + @as(u32, index - 232) * 10;
+    return rgb(level, level, level);
+}
+
+/// Index of the first ESC in bytes, or bytes.len
+pub fn findEscape(bytes: []const u8) usize {
+    const Lanes = @Vector(SCAN_LANES, u8);
+    const escapes: Lanes = @splat(ESC);
+    var i: usize = 0;
+    while (i + SCAN_LANES <= bytes.len) : (i += SCAN_LANES) {
+        const lanes: Lanes = bytes[i..][0..SCAN_LANES].*;
+        const hits: u16 = @bitCast(lanes == escapes);
+        if (hits != 0) return i + @ctz(hits);
+    }
+    while (i < bytes.len) : (i += 1) {
+        if (bytes[i] == ESC) return i;
+    }
+    return bytes.len;
+}
+
+/// Length of the incomplete UTF-8 sequence at the end of bytes, if any
+fn partialUtf8Tail(bytes: []const u8) usize {
+    var back: usize = 0;
+    while (back < 3 and back < bytes.len) : (back += 1) {
+        const b = bytes[bytes.len - 1 - back];
+        if (b & 0xC0 != 0x80) {
+            const need: usize = if (b >= 0xF0) 4 else if (b >= 0xE0) 3 else if (b >= 0xC0) 2 else 1;
+            return if (need > back + 1) back + 1 else 0;
+        }
+    }
+    return 0;
+}
+
+fn isSub(params: []const u32, subparams: u32, i: usize) bool {
+    return i < params.len and i < MAX_PARAMS and (subparams >> @intCast(i)) & 1 != 0;
+}
+
+/// Extended color after 38/48 at params[i]; returns the color and the index
+/// of the last param it used
+fn extendedColor(p: []const u32, subparams: u32, i: usize) struct { color: ?RGBA, last: usize } {
+    const n = p.len;
+    if (i + 1 >= n) return .{ .color = null, .last = n - 1 };
+    if (isSub(p, subparams, i + 1)) {
+        // Colon form: 38:5:n, 38:2:r:g:b or 38:2:colorspace:r:g:b
+        var last = i + 1;
+        while (isSub(p, subparams, last + 1)) last += 1;
+        const args = p[i + 2 .. last + 1];
+        const color: ?RGBA = switch (p[i + 1]) {
+            5 => if (args.len >= 1) paletteColor(@intCast(@min(args[0], 255))) else null,
+            2 => if (args.len >= 3) rgb(args[args.len - 3], args[args.len - 2], args[args.len - 1]) else null,
+            else => null,
+        };
+        return .{ .color = color, .last = last };
+    }
+    // Semicolon form: 38;5;n or 38;2;r;g;b
+    return switch (p[i + 1]) {
+        5 => if (i + 2 < n)
+            .{ .color = paletteColor(@intCast(@min(p[i + 2], 255))), .last = i + 2 }
+        else
+            .{ .color = null, .last = n - 1 },
+        2 => if (i + 4 < n)
+            .{ .color = rgb(p[i + 2], p[i + 3], p[i + 4]), .last = i + 4 }
+        else
+            .{ .color = null, .last = n - 1 },
+        else => .{ .color = null, .last = i + 1 },
+    };
+}
+
+pub const SgrParser = struct {
+    fg: ?RGBA = null,
+    bg: ?RGBA = null,
+    attributes: ?u8 = null,
+
+    state: State = .ground,
+    params: [MAX_PARAMS]u32 = undefined,
+    /// Bit i set: param i was joined to the previous one by ':'
+    subparams: u32 = 0,
+    param_count: u8 = 0,
+    /// The CSI has a private marker or intermediate bytes, so it isn't SGR
+    csi_other: bool = false,
+
+    /// UTF-8 bytes held back from the end of the previous slice
+    carry: [4]u8 = undefined,
+    carry_len: u8 = 0,
+
+    pub fn reset(self: *SgrParser) void {
+        self.* = .{};
+    }
+
+    /// Parse bytes and write the text runs to sink
+    pub fn feed(self: *SgrParser, sink: anytype, bytes: []const u8) !void {
+        var i: usize = 0;
+        if (self.carry_len > 0) i = try self.finishCarry(sink, bytes);
+
+        while (i < bytes.len) {
+            if (self.state == .ground) {
+                const end = i + findEscape(bytes[i..]);
+                var run = bytes[i..end];
+                // Hold back a character cut off by the end of the input
+                if (end == bytes.len) {
+                    const tail = partialUtf8Tail(run);
+                    if (tail > 0) {
+                        @memcpy(self.carry[0..tail], run[run.len - tail ..]);
+                        self.carry_len = @intCast(tail);
+                        run = run[0 .. run.len - tail];
+                    }
+                }
+                if (run.len > 0) _ = try sink.writeChunk(run, self.fg, self.bg, self.attributes);
+                if (end == bytes.len) return;
+                self.state = .escape;
+                i = end + 1;
+                continue;
+            }
+            self.step(bytes[i]);
+            i += 1;
+        }
+    }
+
+    /// Complete the held-back character with the first bytes of the new
+    /// slice; returns how many bytes it took
+    fn finishCarry(self: *SgrParser, sink: anytype, bytes: []const u8) !usize {
+        const lead = self.carry[0];
+        const need: usize = if (lead >= 0xF0) 4 else if (lead >= 0xE0) 3 else 2;
+        var taken: usize = 0;
+        while (self.carry_len < need and taken < bytes.len and bytes[taken] & 0xC0 == 0x80) {
+            self.carry[self.carry_len] = bytes[taken];
+            self.carry_len += 1;
+            taken += 1;
+        }
+        // Still short: wait for more input, unless the sequence is broken
+        if (self.carry_len < need and taken == bytes.len) return taken;
+        _ = try sink.writeChunk(self.carry[0..self.carry_len], self.fg, self.bg, self.attributes);
+        self.carry_len = 0;
+        return taken;
+    }
+
+    fn step(self: *SgrParser, b: u8) void {
+        switch (self.state) {
+            .ground => unreachable,
+            .escape => switch (b) {
+                '[' => {
+                    self.state = .csi;
+                    self.param_count = 0;
+                    self.subparams = 0;
+                    self.csi_other = false;
+                },
+                ']', 'P', 'X', '^', '_' => self.state = .string,
+                ESC => {},
+                // Intermediate bytes of a two-byte escape such as ESC ( B
+                0x20...0x2F => {},
+                else => self.state = .ground,
+            },
+            .csi => switch (b) {
+                '0'...'9' => {
+                    if (self.param_count == 0) self.pushParam(false);
+                    const p = &self.params[self.param_count - 1];
+                    p.* = @min(p.* *| 10 +| (b - '0'), 0xFFFF);
+                },
+                ';', ':' => {
+                    if (self.param_count == 0) self.pushParam(false);
+                    self.pushParam(b == ':');
+                },
+                0x3C...0x3F, 0x20...0x2F => self.csi_other = true,
+                0x40...0x7E => {
+                    if (b == 'm' and !self.csi_other) self.applySgr();
+                    self.state = .ground;
+                },
+                ESC => self.state = .escape,
+                else => {},
+            },
+            .string => switch (b) {
+                0x07 => self.state = .ground,
+                ESC => self.state = .string_escape,
+                else => {},
+            },
+            .string_escape => self.state = if (b == '\\') .ground else .string,
+        }
+    }
+
+    fn pushParam(self: *SgrParser, sub: bool) void {
+        if (self.param_count == MAX_PARAMS) return;
+        self.params[self.param_count] = 0;
+        if (sub) self.subparams |= @as(u32, 1) << @intCast(self.param_count);
+        self.param_count += 1;
+    }
+
+    fn setAttr(self: *SgrParser, bits: u8, on: bool) void {
+        const current = self.attributes orelse 0;
+        self.attributes = if (on) current | bits else current & ~bits;
+    }
+
+    fn applySgr(self: *SgrParser) void {
+        self.applyParams(self.params[0..self.param_count], self.subparams);
+    }
+
+    /// Apply the parameters of one SGR sequence to the current style; bit i
+    /// of subparams marks params[i] as joined to the one before by ':'
+    pub fn applyParams(self: *SgrParser, params: []const u32, subparams: u32) void {
+        // ESC[m is a reset
+        if (params.len == 0) {
+            self.fg = null;
+            self.bg = null;
+            self.attributes = null;
+            return;
+        }
+        var i: usize = 0;
+        while (i < params.len) : (i += 1) {
+            const p = params[i];
+            switch (p) {
+                0 => {
+                    self.fg = null;
+                    self.bg = null;
+                    self.attributes = null;
+                },
+                1 => self.setAttr(Attr.BOLD, true),
+                2 => self.setAttr(Attr.DIM, true),
+                3 => self.setAttr(Attr.ITALIC, true),
+                4 => self.setAttr(Attr.UNDERLINE, true),
+                5, 6 => self.setAttr(Attr.BLINK, true),
+                7 => self.setAttr(Attr.INVERSE, true),
+                8 => self.setAttr(Attr.HIDDEN, true),
+                9 => self.setAttr(Attr.STRIKETHROUGH, true),
+                22 => self.setAttr(Attr.BOLD | Attr.DIM, false),
+                23 => self.setAttr(Attr.ITALIC, false),
+                24 => self.setAttr(Attr.UNDERLINE, false),
+                25 => self.setAttr(Attr.BLINK, false),
+                27 => self.setAttr(Attr.INVERSE, false),
+                28 => self.setAttr(Attr.HIDDEN, false),
+                29 => self.setAttr(Attr.STRIKETHROUGH, false),
+                30...37 => self.fg = paletteColor(@intCast(p - 30)),
+                39 => self.fg = null,
+                40...47 => self.bg = paletteColor(@intCast(p - 40)),
+                49 => self.bg = null,
+                90...97 => self.fg = paletteColor(@intCast(p - 90 + 8)),
+                100...107 => self.bg = paletteColor(@intCast(p - 100 + 8)),
+                38, 48 => {
+                    const ext = extendedColor(params, subparams, i);
+                    if (ext.color) |c| {
+                        if (p == 38) self.fg = c else self.bg = c;
+                    }
+                    i = ext.last;
+                },
+                // Underline color and other extensions carry their own arguments
+                58 => i = extendedColor(params, subparams, i).last,
+                else => {},
+            }
+        }
+    }
+};
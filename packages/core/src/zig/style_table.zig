@@ -0,0 +1,197 @@
+const std = @import("std");
+const Allocator = std.mem.Allocator;
+const ansi = @import("ansi.zig");
+
+const RGBA = ansi.RGBA;
+const Attr = ansi.TextAttributes;
+
+/// Interned cell styles and cached SGR transitions for the frame encoder
+///
+/// A style is what the terminal actually gets for a cell: 8-bit RGB for fg
+/// and bg plus the attribute bits, packed into one u64 key. Each distinct
+/// key gets a u16 id, so comparing two cells' styles is one integer compare
+/// and colors that only differ below the 8-bit output precision (or in
+/// alpha) count as the same style. Screens rarely use more than a few dozen
+/// styles, and the transitions the encoder emits between them repeat from
+/// frame to frame, so the SGR bytes for each (from, to) pair are formatted
+/// once and copied after that.
+pub const StyleId = u16;
+
+/// The terminal's SGR state is unknown, as at the start of a frame
+pub const NO_STYLE: StyleId = std.math.maxInt(StyleId);
+
+const MAX_STYLES = NO_STYLE;
+/// The transition cache is dropped and rebuilt when it outgrows this
+const MAX_TRANSITION_BYTES = 64 * 1024;
+
+pub const StyleTableError = error{
+    OutOfMemory,
+    /// Every id is taken; reset the table and everything holding its ids
+    TableFull,
+};
+
+pub const Stats = extern struct {
+    styles: u32 = 0,
+    transitions: u32 = 0,
+    transition_bytes: u32 = 0,
+    /// Transitions copied from the cache / formatted, since the last reset
+    hits: u32 = 0,
+    misses: u32 = 0,
+    resets: u32 = 0,
+};
+
+pub fn componentToU8(component: f32) u8 {
+    if (!std.math.isFinite(component)) return 0;
+
+    const clamped = std.math.clamp(component, 0.0, 1.0);
+    return @intFromFloat(@round(clamped * 255.0));
+}
+
+pub fn styleKey(fg: RGBA, bg: RGBA, attributes: u8) u64 {
+    return @as(u64, componentToU8(fg[0])) << 56 |
+        @as(u64, componentToU8(fg[1])) << 48 |
+        @as(u64, componentToU8(fg[2])) << 40 |
+        @as(u64, componentToU8(bg[0])) << 32 |
+        @as(u64, componentToU8(bg[1])) << 24 |
+        @as(u64, componentToU8(bg[2])) << 16 |
+        attributes;
+}
+
+fn keyFg(key: u64) u32 {
+    return @truncate(key >> 40);
+}
+
+fn keyBg(key: u64) u32 {
+    return @truncate((key >> 16) & 0xFFFFFF);
+}
+
+fn keyAttributes(key: u64) u8 {
+    return @truncate(key);
+}
+
+const Span = struct {
+    start: u32,
+    len: u32,
+};
+
+pub const StyleTable = struct {
+    allocator: Allocator,
+    /// id -> key
+    keys: std.ArrayListUnmanaged(u64) = .{},
+    ids: std.AutoHashMapUnmanaged(u64, StyleId) = .{},
+    /// (from << 16 | to) -> bytes in transition_bytes
+    transitions: std.AutoHashMapUnmanaged(u32, Span) = .{},
+    transition_bytes: std.ArrayListUnmanaged(u8) = .{},
+    hits: u32 = 0,
+    misses: u32 = 0,
+    resets: u32 = 0,
+
+    pub fn init(allocator: Allocator) StyleTable {
+        return .{ .allocator = allocator };
+    }
+
+    pub fn deinit(self: *StyleTable) void {
+        self.keys.deinit(self.allocator);
+        self.ids.deinit(self.allocator);
+        self.transitions.deinit(self.allocator);
+        self.transition_bytes.deinit(self.allocator);
+    }
+
+    /// Forget every style; ids handed out before are meaningless afterwards
+    pub fn reset(self: *StyleTable) void {
+        self.keys.clearRetainingCapacity();
+        self.ids.clearRetainingCapacity();
+        self.transitions.clearRetainingCapacity();
+        self.transition_bytes.clearRetainingCapacity();
+        self.hits = 0;
+        self.misses = 0;
+        self.resets += 1;
+    }
+
+    pub fn count(self: *const StyleTable) u32 {
+        return @intCast(self.keys.items.len);
+    }
+
+    pub fn intern(self: *StyleTable, fg: RGBA, bg: RGBA, attributes: u8) StyleTableError!StyleId {
+        return self.internKey(styleKey(fg, bg, attributes));
+    }
+
+    pub fn internKey(self: *StyleTable, key: u64) StyleTableError!StyleId {
+        const entry = try self.ids.getOrPut(self.allocator, key);
+        if (entry.found_existing) return entry.value_ptr.*;
+
+        if (self.keys.items.len >= MAX_STYLES) {
+            self.ids.removeByPtr(entry.key_ptr);
+            return StyleTableError.TableFull;
+        }
+        const id: StyleId = @intCast(self.keys.items.len);
+        self.keys.append(self.allocator, key) catch |err| {
+            self.ids.removeByPtr(entry.key_ptr);
+            return err;
+        };
+        entry.value_ptr.* = id;
+        return id;
+    }
+
+    pub fn getKey(self: *const StyleTable, id: StyleId) ?u64 {
+        if (id >= self.keys.items.len) return null;
+        return self.keys.items[id];
+    }
+
+    /// SGR bytes that take the terminal from style `from` to style `to`. Only
+    /// what differs is written; a reset is needed when `from` is unknown or
+    /// has attributes `to` lacks, since SGR has no portable per-attribute
+    /// off switch. The slice is valid until the next call.
+    pub fn transition(self: *StyleTable, from: StyleId, to: StyleId) StyleTableError![]const u8 {
+        const pair = @as(u32, from) << 16 | to;
+        if (self.transitions.get(pair)) |span| {
+            self.hits += 1;
+            return self.transition_bytes.items[span.start .. span.start + span.len];
+        }
+
+        const to_key = self.getKey(to) orelse return &.{};
+        if (self.transition_bytes.items.len >= MAX_TRANSITION_BYTES) {
+            self.transitions.clearRetainingCapacity();
+            self.transition_bytes.clearRetainingCapacity();
+        }
+        self.misses += 1;
+
+        const start = self.transition_bytes.items.len;
+        errdefer self.transition_bytes.shrinkRetainingCapacity(start);
+        const writer = self.transition_bytes.writer(self.allocator);
+
+        // Without a known previous state everything is written after a reset
+        const from_key = self.getKey(from);
+        const to_attributes = keyAttributes(to_key);
+        const full = if (from_key) |key| keyAttributes(key) & ~to_attributes != 0 else true;
+        const from_attributes: u8 = if (full) 0 else keyAttributes(from_key.?);
+
+        if (full) {
+            try writer.writeAll(ansi.ANSI.reset);
+        }
+        const fg = keyFg(to_key);
+        if (full or keyFg(from_key.?) != fg) {
+            try std.fmt.format(writer, "\x1b[38;2;{d};{d};{d}m", .{ fg >> 16, (fg >> 8) & 0xFF, fg & 0xFF });
+        }
+        const bg = keyBg(to_key);
+        if (full or keyBg(from_key.?) != bg) {
+            try std.fmt.format(writer, "\x1b[48;2;{d};{d};{d}m", .{ bg >> 16, (bg >> 8) & 0xFF, bg & 0xFF });
+        }
+        Attr.applyAttributesOutputWriter(writer, to_attributes & ~from_attributes) catch return StyleTableError.OutOfMemory;
+
+        const span = Span{ .start = @intCast(start), .len = @intCast(self.transition_bytes.items.len - start) };
+        try self.transitions.put(self.allocator, pair, span);
+        return self.transition_bytes.items[span.start .. span.start + span.len];
+    }
+
+    pub fn getStats(self: *const StyleTable) Stats {
+        return .{
+            .styles = self.count(),
+            .transitions = self.transitions.count(),
+            .transition_bytes = @intCast(self.transition_bytes.items.len),
+            .hits = self.hits,
+            .misses = self.misses,
+            .resets = self.resets,
+        };
+    }
+};
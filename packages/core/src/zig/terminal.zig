@@ -270,6 +270,37 @@ pub fn setKittyKeyboard(self: *Terminal, tty: AnyWriter, enable: bool, flags: u8
     }
 }
 
+/// Whether response holds `ESC [ ? params` followed by `final`, params being
+/// digits and ';'
+fn hasPrivateReply(response: []const u8, final: []const u8) bool {
+    var start: usize = 0;
+    while (std.mem.indexOfPos(u8, response, start, "\x1b[?")) |pos| {
+        var i = pos + 3;
+        while (i < response.len and (std.ascii.isDigit(response[i]) or response[i] == ';')) : (i += 1) {}
+        if (i > pos + 3 and std.mem.startsWith(u8, response[i..], final)) return true;
+        start = pos + 3;
+    }
+    return false;
+}
+
+/// Whether the input holds a reply to the queries queryTerminalSend writes.
+/// Keystrokes, mouse reports and other replies share stdin with the probe
+/// and must not be mistaken for it. The cursor position reports are also
+/// what Shift/Alt+F3 send, so they only count when `probing` is set.
+pub fn isCapabilityResponse(response: []const u8, probing: bool) bool {
+    return hasPrivateReply(response, "$y") or // DECRPM
+        hasPrivateReply(response, "c") or // DA1
+        std.mem.indexOf(u8, response, "\x1bP>|") != null or // XTVERSION
+        std.mem.indexOf(u8, response, "\x1b_G") != null or
+        (probing and (std.mem.indexOf(u8, response, "\x1b[1;2R") != null or
+            std.mem.indexOf(u8, response, "\x1b[1;3R") != null));
+}
+
+/// DA1 is queried last, so its reply marks the end of the probe
+pub fn isProbeComplete(response: []const u8) bool {
+    return hasPrivateReply(response, "c");
+}
+
 /// The responses look like these:
 /// kitty - '\x1B[?1016;2$y\x1B[?2027;0$y\x1B[?2031;2$y\x1B[?1004;1$y\x1B[?2026;2$y\x1B[1;2R\x1B[1;3R\x1BP>|kitty(0.40.1)\x1B\\\x1B[?0u\x1B_Gi=1;EINVAL:Zero width/height not allowed\x1B\\\x1B[?62;c'
 /// ghostty - '\x1B[?1016;1$y\x1B[?2027;1$y\x1B[?2031;2$y\x1B[?1004;1$y\x1B[?2004;2$y\x1B[?2026;2$y\x1B[1;1R\x1B[1;1R\x1BP>|ghostty 1.1.3\x1B\\\x1B[?0u\x1B_Gi=1;OK\x1B\\\x1B[?62;22c'
@@ -309,8 +340,9 @@ pub fn processCapabilityResponse(self: *Terminal, response: []const u8) void {
         self.caps.scaled_text = true;
     }
 
-    // Kitty detection
-    if (std.mem.indexOf(u8, response, "kitty")) |_| {
+    // Kitty detection, only inside the XTVERSION reply
+    const version = if (std.mem.indexOf(u8, response, "\x1bP>|")) |pos| response[pos..] else "";
+    if (std.mem.indexOf(u8, version, "kitty")) |_| {
         self.caps.kitty_keyboard = true;
         self.caps.kitty_graphics = true;
         self.caps.unicode = .unicode;
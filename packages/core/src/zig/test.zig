@@ -2,11 +2,41 @@ const std = @import("std");
 
 // Import all test modules
 const text_buffer_tests = @import("tests/text-buffer_test.zig");
+const link_tests = @import("tests/link_test.zig");
+const filters_tests = @import("tests/filters_test.zig");
+const logger_tests = @import("tests/logger_test.zig");
+const capability_cache_tests = @import("tests/capability_cache_test.zig");
+const inline_tests = @import("tests/inline_test.zig");
+const retained_tests = @import("tests/retained_test.zig");
+const width_cache_tests = @import("tests/width_cache_test.zig");
+const scene_tests = @import("tests/scene_test.zig");
+const chart_tests = @import("tests/chart_test.zig");
+const sgr_tests = @import("tests/sgr_test.zig");
+const vt_tests = @import("tests/vt_test.zig");
+const diff_tests = @import("tests/diff_test.zig");
+const search_tests = @import("tests/search_test.zig");
+const style_table_tests = @import("tests/style_table_test.zig");
+const debug_report_tests = @import("tests/debug_report_test.zig");
 // const example_tests = @import("example_test.zig");
 
 // Re-export test declarations from individual test files
 // This allows `zig test index.zig` to run all tests
 comptime {
     _ = text_buffer_tests;
+    _ = link_tests;
+    _ = filters_tests;
+    _ = logger_tests;
+    _ = capability_cache_tests;
+    _ = inline_tests;
+    _ = retained_tests;
+    _ = width_cache_tests;
+    _ = scene_tests;
+    _ = chart_tests;
+    _ = sgr_tests;
+    _ = vt_tests;
+    _ = diff_tests;
+    _ = search_tests;
+    _ = style_table_tests;
+    _ = debug_report_tests;
     // _ = example_tests;
 }
@@ -0,0 +1,127 @@
+const std = @import("std");
+const capability_cache = @import("../capability_cache.zig");
+const Terminal = @import("../terminal.zig");
+
+const Capabilities = Terminal.Capabilities;
+
+test "capability cache - encode/decode round trip" {
+    const caps = Capabilities{
+        .kitty_keyboard = true,
+        .rgb = true,
+        .unicode = .unicode,
+        .explicit_width = true,
+        .sync = true,
+        .hyperlinks = true,
+    };
+    const decoded = capability_cache.decode(capability_cache.encode(caps));
+    try std.testing.expectEqual(caps, decoded);
+    try std.testing.expectEqual(Capabilities{}, capability_cache.decode(0));
+}
+
+test "capability cache - store then load by key" {
+    var tmp = std.testing.tmpDir(.{});
+    defer tmp.cleanup();
+    const allocator = std.testing.allocator;
+
+    const dir = try tmp.dir.realpathAlloc(allocator, ".");
+    defer allocator.free(dir);
+    const path = try std.fs.path.join(allocator, &.{ dir, "nested", "capabilities" });
+    defer allocator.free(path);
+
+    try std.testing.expect(capability_cache.load(path, 1) == null);
+
+    const a = Capabilities{ .sync = true, .unicode = .unicode };
+    const b = Capabilities{ .bracketed_paste = true };
+    try capability_cache.store(allocator, path, 1, a);
+    try capability_cache.store(allocator, path, 2, b);
+
+    try std.testing.expectEqual(a, capability_cache.load(path, 1).?);
+    try std.testing.expectEqual(b, capability_cache.load(path, 2).?);
+    try std.testing.expect(capability_cache.load(path, 3) == null);
+
+    // Replacing an entry keeps one line per key
+    const a2 = Capabilities{ .explicit_width = true };
+    try capability_cache.store(allocator, path, 1, a2);
+    try std.testing.expectEqual(a2, capability_cache.load(path, 1).?);
+    try std.testing.expectEqual(b, capability_cache.load(path, 2).?);
+
+    var buf: [4096]u8 = undefined;
+    const content = try std.fs.cwd().readFile(path, &buf);
+    try std.testing.expectEqual(@as(usize, 3), std.mem.count(u8, content, "\n"));
+}
+
+test "capability cache - keeps at most MAX_ENTRIES, newest first" {
+    var tmp = std.testing.tmpDir(.{});
+    defer tmp.cleanup();
+    const allocator = std.testing.allocator;
+
+    const dir = try tmp.dir.realpathAlloc(allocator, ".");
+    defer allocator.free(dir);
+    const path = try std.fs.path.join(allocator, &.{ dir, "capabilities" });
+    defer allocator.free(path);
+
+    var key: u64 = 0;
+    while (key < capability_cache.MAX_ENTRIES + 4) : (key += 1) {
+        try capability_cache.store(allocator, path, key, .{ .rgb = true });
+    }
+    try std.testing.expect(capability_cache.load(path, 0) == null);
+    try std.testing.expect(capability_cache.load(path, capability_cache.MAX_ENTRIES + 3) != null);
+}
+
+test "capability cache - ignores files with a foreign header" {
+    var tmp = std.testing.tmpDir(.{});
+    defer tmp.cleanup();
+    const allocator = std.testing.allocator;
+
+    try tmp.dir.writeFile(.{ .sub_path = "capabilities", .data = "something else\n0000000000000001 1\n" });
+    const path = try tmp.dir.realpathAlloc(allocator, "capabilities");
+    defer allocator.free(path);
+
+    try std.testing.expect(capability_cache.load(path, 1) == null);
+}
+
+test "capability cache - key depends on terminal identity" {
+    const allocator = std.testing.allocator;
+    var env_a = std.process.EnvMap.init(allocator);
+    defer env_a.deinit();
+    var env_b = std.process.EnvMap.init(allocator);
+    defer env_b.deinit();
+
+    try env_a.put("TERM", "xterm-kitty");
+    try env_b.put("TERM", "xterm-kitty");
+    try std.testing.expectEqual(capability_cache.computeKey(&env_a), capability_cache.computeKey(&env_b));
+
+    // Per-window values only count by presence
+    try env_a.put("KITTY_PID", "100");
+    try env_b.put("KITTY_PID", "200");
+    try std.testing.expectEqual(capability_cache.computeKey(&env_a), capability_cache.computeKey(&env_b));
+
+    try env_b.put("TERM_PROGRAM_VERSION", "0.40");
+    try std.testing.expect(capability_cache.computeKey(&env_a) != capability_cache.computeKey(&env_b));
+}
+
+test "capability cache - probe replies are told apart from other input" {
+    const kitty = "\x1b[?1016;2$y\x1b[?2026;2$y\x1b[1;2R\x1bP>|kitty(0.40.1)\x1b\\\x1b[?62;c";
+    try std.testing.expect(Terminal.isCapabilityResponse(kitty, true));
+    try std.testing.expect(Terminal.isProbeComplete(kitty));
+    try std.testing.expect(Terminal.isCapabilityResponse("\x1b[?1016;2$y", false));
+    try std.testing.expect(!Terminal.isProbeComplete("\x1b[?1016;2$y"));
+
+    // Keys, mouse reports and the pixel resolution reply are left alone
+    try std.testing.expect(!Terminal.isCapabilityResponse("kitty", true));
+    try std.testing.expect(!Terminal.isCapabilityResponse("\x1b[A", true));
+    try std.testing.expect(!Terminal.isCapabilityResponse("\x1b[<0;10;5M", true));
+    try std.testing.expect(!Terminal.isCapabilityResponse("\x1b[4;600;800t", true));
+    try std.testing.expect(!Terminal.isCapabilityResponse("\x1b[?u", true));
+
+    // Shift+F3 reads like the explicit width reply outside a probe
+    try std.testing.expect(Terminal.isCapabilityResponse("\x1b[1;2R", true));
+    try std.testing.expect(!Terminal.isCapabilityResponse("\x1b[1;2R", false));
+
+    var term = Terminal.init(.{});
+    term.processCapabilityResponse("kitty");
+    try std.testing.expect(!term.caps.kitty_keyboard);
+    term.processCapabilityResponse(kitty);
+    try std.testing.expect(term.caps.kitty_keyboard);
+    try std.testing.expect(term.caps.sync);
+}
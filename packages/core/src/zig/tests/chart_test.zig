@@ -0,0 +1,93 @@
+const std = @import("std");
+const buffer = @import("../buffer.zig");
+const gp = @import("../grapheme.zig");
+const chart = @import("../chart.zig");
+
+const Chart = chart.Chart;
+const WHITE = [4]f32{ 1, 1, 1, 1 };
+
+test "Chart - series ring keeps the newest samples" {
+    const c = try Chart.create(std.testing.allocator, 4, 1, .braille, 4, 1);
+    defer c.destroy();
+    const s = try c.addSeries(WHITE);
+
+    c.pushMany(s, &[_]f32{ 1, 2, 3, 4, 5, 6 });
+    const series = &c.series[s];
+    try std.testing.expectEqual(@as(u32, 4), series.len);
+    try std.testing.expectEqual(@as(?f32, null), series.at(1));
+    try std.testing.expectEqual(@as(?f32, 3), series.at(2));
+    try std.testing.expectEqual(@as(?f32, 6), series.at(5));
+    try std.testing.expectEqual(@as(?f32, null), series.at(6));
+}
+
+test "Chart - braille rasterization and incremental scrolling" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const allocator = arena.allocator();
+
+    const pool = gp.initGlobalPool(allocator);
+    defer gp.deinitGlobalPool();
+    const gd = gp.initGlobalUnicodeData(allocator);
+    defer gp.deinitGlobalUnicodeData(allocator);
+    const graphemes_ptr, const display_width_ptr = gd;
+
+    var target = try buffer.OptimizedBuffer.init(allocator, 4, 2, .{ .pool = pool }, graphemes_ptr, display_width_ptr);
+    defer target.deinit();
+
+    const c = try Chart.create(allocator, 2, 1, .braille, 64, 1);
+    defer c.destroy();
+    const s = try c.addSeries(WHITE);
+    c.setRange(0, 3);
+
+    // Top dot on the left, then a line down to the bottom on the right
+    c.pushMany(s, &[_]f32{ 3, 0 });
+    try c.draw(target, 0, 0);
+    try std.testing.expectEqual(@as(u32, 2), c.stats.rasterized_columns);
+    try std.testing.expectEqual(@as(u32, 0x2800 + 0xB9), target.get(1, 0).?.char);
+
+    // Two more samples fill one new column; the old one scrolls left as is
+    c.pushMany(s, &[_]f32{ 0, 0 });
+    try c.draw(target, 0, 0);
+    try std.testing.expectEqual(@as(u32, 1), c.stats.rasterized_columns);
+    try std.testing.expectEqual(@as(u32, 0x2800 + 0xB9), target.get(0, 0).?.char);
+    try std.testing.expectEqual(@as(u32, 0x2800 + 0xC0), target.get(1, 0).?.char);
+
+    // Nothing new, nothing rasterized
+    try c.draw(target, 0, 0);
+    try std.testing.expectEqual(@as(u32, 0), c.stats.rasterized_columns);
+
+    // A new range redraws everything
+    c.setRange(0, 6);
+    try c.draw(target, 0, 0);
+    try std.testing.expectEqual(@as(u32, 2), c.stats.rasterized_columns);
+}
+
+test "Chart - downsampled buckets keep their min/max span" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const allocator = arena.allocator();
+
+    const pool = gp.initGlobalPool(allocator);
+    defer gp.deinitGlobalPool();
+    const gd = gp.initGlobalUnicodeData(allocator);
+    defer gp.deinitGlobalUnicodeData(allocator);
+    const graphemes_ptr, const display_width_ptr = gd;
+
+    var target = try buffer.OptimizedBuffer.init(allocator, 2, 1, .{ .pool = pool }, graphemes_ptr, display_width_ptr);
+    defer target.deinit();
+
+    const c = try Chart.create(allocator, 1, 1, .half_block, 16, 4);
+    defer c.destroy();
+    const s = try c.addSeries(WHITE);
+    c.setRange(0, 1);
+
+    // A single spike in a bucket of four still covers both half rows
+    c.pushMany(s, &[_]f32{ 0, 0, 1, 0 });
+    try c.draw(target, 0, 0);
+    try std.testing.expectEqual(@as(u32, 0x2588), target.get(0, 0).?.char);
+
+    // A flat low bucket is just the lower half
+    c.pushMany(s, &[_]f32{ 0, 0, 0, 0 });
+    try c.draw(target, 0, 0);
+    try std.testing.expectEqual(@as(u32, 0x2584), target.get(0, 0).?.char);
+}
@@ -0,0 +1,44 @@
+const std = @import("std");
+const renderer = @import("../renderer.zig");
+const gp = @import("../grapheme.zig");
+
+const CliRenderer = renderer.CliRenderer;
+
+test "Debug overlay - host report is drawn under the stats" {
+    const allocator = std.testing.allocator;
+
+    const pool = gp.initGlobalPool(allocator);
+    defer gp.deinitGlobalPool();
+
+    const gd = gp.initGlobalUnicodeData(allocator);
+    defer gp.deinitGlobalUnicodeData(allocator);
+    const graphemes_ptr, const display_width_ptr = gd;
+
+    const r = try CliRenderer.create(allocator, 60, 40, pool, graphemes_ptr, display_width_ptr, true);
+    defer r.destroy();
+
+    r.setDebugOverlay(true, .topLeft);
+    try r.setDebugReport("List#1003 1.20ms\n" ++ "x" ** 50 ++ "\n");
+    r.render(false);
+
+    const current = r.getCurrentBuffer();
+    var reportRow: ?u32 = null;
+    var y: u32 = 0;
+    while (y < 40) : (y += 1) {
+        if (current.get(2, y).?.char == 'L' and current.get(3, y).?.char == 'i') {
+            reportRow = y;
+            break;
+        }
+    }
+    try std.testing.expect(reportRow != null);
+
+    // A long line stops at the overlay's inner edge
+    const long = reportRow.? + 1;
+    try std.testing.expectEqual(@as(u32, 'x'), current.get(39, long).?.char);
+    try std.testing.expect(current.get(40, long).?.char != 'x');
+
+    // Without a report the overlay keeps its usual size
+    try r.setDebugReport("");
+    r.render(false);
+    try std.testing.expect(r.getCurrentBuffer().get(2, reportRow.?).?.char != 'L');
+}
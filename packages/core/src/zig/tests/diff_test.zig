@@ -0,0 +1,174 @@
+const std = @import("std");
+const buffer = @import("../buffer.zig");
+const gp = @import("../grapheme.zig");
+const diff = @import("../diff.zig");
+
+const Diff = diff.Diff;
+const RowKind = diff.RowKind;
+const NO_LINE = diff.NO_LINE;
+
+fn finish(d: *Diff) !void {
+    try d.ensureRows(std.math.maxInt(u32));
+    try std.testing.expect(d.isComplete());
+}
+
+fn expectKinds(d: *Diff, expected: []const RowKind) !void {
+    try std.testing.expectEqual(expected.len, d.rows.items.len);
+    for (expected, d.rows.items) |kind, row| {
+        try std.testing.expectEqual(kind, row.kind);
+    }
+}
+
+/// Blocks must tile both texts in order, and equal blocks must match
+fn expectValidScript(d: *Diff) !void {
+    var old: u32 = 0;
+    var new: u32 = 0;
+    for (d.blocks.items, 0..) |block, i| {
+        try std.testing.expectEqual(old, block.old_start);
+        try std.testing.expectEqual(new, block.new_start);
+        if (i > 0) try std.testing.expect(block.equal != d.blocks.items[i - 1].equal);
+        if (block.equal) {
+            var k: u32 = 0;
+            while (k < block.old_len) : (k += 1) {
+                try std.testing.expectEqualStrings(d.oldLine(old + k), d.newLine(new + k));
+            }
+        }
+        old += block.old_len;
+        new += block.new_len;
+    }
+    try std.testing.expectEqual(@as(u32, @intCast(d.old_lines.len)), old);
+    try std.testing.expectEqual(@as(u32, @intCast(d.new_lines.len)), new);
+}
+
+test "Diff - unified rows with full context" {
+    const d = try Diff.create(std.testing.allocator, "a\nb\nc\nd\n", "a\nB\nc\nd\ne");
+    defer d.destroy();
+    d.setContext(diff.FULL_CONTEXT);
+    try finish(d);
+
+    try expectKinds(d, &.{ .context, .delete, .insert, .context, .context, .insert });
+    try std.testing.expectEqual(@as(u32, 1), d.rows.items[1].old_line);
+    try std.testing.expectEqual(@as(u32, 4), d.rows.items[5].new_line);
+    try std.testing.expectEqual(@as(u32, 1), d.stats.deleted);
+    try std.testing.expectEqual(@as(u32, 2), d.stats.inserted);
+    try expectValidScript(d);
+}
+
+test "Diff - unchanged lines fold outside the context" {
+    const old = "0\n1\n2\n3\n4\n5\n6\n7\n8\n9\n";
+    const new = "0\n1\n2\n3\n4\nfive\n6\n7\n8\n9\n";
+    const d = try Diff.create(std.testing.allocator, old, new);
+    defer d.destroy();
+    d.setContext(1);
+    try finish(d);
+
+    try expectKinds(d, &.{ .fold, .context, .delete, .insert, .context, .fold });
+    try std.testing.expectEqual(@as(u32, 4), d.rows.items[0].count);
+    try std.testing.expectEqual(@as(u32, 7), d.rows.items[5].old_line);
+    try std.testing.expectEqual(@as(u32, 3), d.rows.items[5].count);
+
+    // Identical texts fold entirely
+    const same = try Diff.create(std.testing.allocator, old, old);
+    defer same.destroy();
+    try finish(same);
+    try expectKinds(same, &.{.fold});
+}
+
+test "Diff - side by side pairs deletions with insertions" {
+    const d = try Diff.create(std.testing.allocator, "x\ny\nz\n", "p\nz\n");
+    defer d.destroy();
+    try finish(d);
+    try expectKinds(d, &.{ .delete, .delete, .insert, .context });
+
+    d.setMode(.side_by_side);
+    try finish(d);
+    try expectKinds(d, &.{ .change, .change, .context });
+    try std.testing.expectEqual(@as(u32, 0), d.rows.items[0].new_line);
+    try std.testing.expectEqual(NO_LINE, d.rows.items[1].new_line);
+    try std.testing.expectEqual(@as(u32, 1), d.rows.items[1].old_line);
+}
+
+test "Diff - rows are produced lazily" {
+    var old = std.ArrayList(u8).init(std.testing.allocator);
+    defer old.deinit();
+    var new = std.ArrayList(u8).init(std.testing.allocator);
+    defer new.deinit();
+    var i: u32 = 0;
+    while (i < 20000) : (i += 1) {
+        try old.writer().print("line {d}\n", .{i});
+        if (i % 1000 == 500) {
+            try new.writer().print("changed {d}\n", .{i});
+        } else {
+            try new.writer().print("line {d}\n", .{i});
+        }
+    }
+
+    const d = try Diff.create(std.testing.allocator, old.items, new.items);
+    defer d.destroy();
+    try d.ensureRows(10);
+    try std.testing.expect(d.rows.items.len >= 10);
+    try std.testing.expect(!d.isComplete());
+    // Only the first change has been found
+    try std.testing.expect(d.stats.deleted < 20);
+
+    // A fold and three context rows lead up to the first change
+    try std.testing.expectEqual(@as(u32, 4), try d.nextChange(NO_LINE));
+    try finish(d);
+    try std.testing.expectEqual(@as(u32, 20), d.stats.deleted);
+    try std.testing.expectEqual(@as(u32, 20), d.stats.inserted);
+    try expectValidScript(d);
+}
+
+test "Diff - cost limit still yields a valid script" {
+    var old = std.ArrayList(u8).init(std.testing.allocator);
+    defer old.deinit();
+    var new = std.ArrayList(u8).init(std.testing.allocator);
+    defer new.deinit();
+    var prng = std.Random.DefaultPrng.init(42);
+    const random = prng.random();
+    var i: u32 = 0;
+    while (i < 400) : (i += 1) {
+        try old.writer().print("{d}\n", .{random.uintLessThan(u32, 8)});
+        try new.writer().print("{d}\n", .{random.uintLessThan(u32, 8)});
+    }
+
+    const d = try Diff.create(std.testing.allocator, old.items, new.items);
+    defer d.destroy();
+    d.cost_limit = 4;
+    try finish(d);
+    try std.testing.expect(d.stats.cutoffs > 0);
+    try expectValidScript(d);
+}
+
+test "Diff - draw unified and side by side rows" {
+    const allocator = std.testing.allocator;
+
+    const pool = gp.initGlobalPool(allocator);
+    defer gp.deinitGlobalPool();
+    const gd = gp.initGlobalUnicodeData(allocator);
+    defer gp.deinitGlobalUnicodeData(allocator);
+    const graphemes_ptr, const display_width_ptr = gd;
+
+    const target = try buffer.OptimizedBuffer.init(allocator, 20, 4, .{ .pool = pool }, graphemes_ptr, display_width_ptr);
+    defer target.deinit();
+
+    const d = try Diff.create(allocator, "keep\nold\n", "keep\nnew\n");
+    defer d.destroy();
+
+    // Gutter is "1 1 " then the sign and a space
+    try d.draw(target, 0, 0, 20, 4, 0);
+    try std.testing.expectEqual(@as(u32, 3), d.stats.drawn_rows);
+    try std.testing.expectEqual(@as(u32, '-'), target.get(4, 1).?.char);
+    try std.testing.expectEqual(@as(u32, 'o'), target.get(6, 1).?.char);
+    try std.testing.expectEqual(@as(u32, '+'), target.get(4, 2).?.char);
+    try std.testing.expectEqual(@as(u32, 'n'), target.get(6, 2).?.char);
+
+    d.setMode(.side_by_side);
+    try target.clear(.{ 0, 0, 0, 1 }, null);
+    try d.draw(target, 0, 0, 20, 4, 0);
+    try std.testing.expectEqual(@as(u32, 2), d.stats.drawn_rows);
+    // The old side takes 9 columns, then the separator, then the new side
+    try std.testing.expectEqual(@as(u32, 0x2502), target.get(9, 1).?.char);
+    try std.testing.expectEqual(@as(u32, 'o'), target.get(4, 1).?.char);
+    try std.testing.expectEqual(@as(u32, 'n'), target.get(14, 1).?.char);
+}
@@ -0,0 +1,139 @@
+const std = @import("std");
+const filters = @import("../filters.zig");
+const buffer = @import("../buffer.zig");
+const gp = @import("../grapheme.zig");
+
+const OptimizedBuffer = buffer.OptimizedBuffer;
+const FilterOp = filters.FilterOp;
+
+fn op(kind: filters.FilterKind, p0: f32) FilterOp {
+    return .{ .kind = @intFromEnum(kind), .p0 = p0 };
+}
+
+test "applyFilterChain - pointwise chain is restricted to the rect" {
+    const allocator = std.testing.allocator;
+
+    const pool = gp.initGlobalPool(allocator);
+    defer gp.deinitGlobalPool();
+
+    const gd = gp.initGlobalUnicodeData(allocator);
+    defer gp.deinitGlobalUnicodeData(allocator);
+    const graphemes_ptr, const display_width_ptr = gd;
+
+    const buf = try OptimizedBuffer.init(allocator, 9, 3, .{ .pool = pool }, graphemes_ptr, display_width_ptr);
+    defer buf.deinit();
+
+    try buf.clear(.{ 0.2, 0.4, 0.6, 1.0 }, null);
+
+    // Invert then dim by half: fused into a single affine pass
+    const chain = [_]FilterOp{ op(.invert, 0), op(.brightness, 0.5) };
+    try filters.applyFilterChain(buf, 1, 1, 7, 5, &chain);
+
+    const eps = 0.0001;
+    // Inside the rect, including the scalar tail past the 4-cell vectors
+    for ([_]u32{ 1, 4, 5, 7 }) |x| {
+        const bg = buf.get(x, 1).?.bg;
+        try std.testing.expectApproxEqAbs(@as(f32, 0.4), bg[0], eps);
+        try std.testing.expectApproxEqAbs(@as(f32, 0.3), bg[1], eps);
+        try std.testing.expectApproxEqAbs(@as(f32, 0.2), bg[2], eps);
+        try std.testing.expectApproxEqAbs(@as(f32, 1.0), bg[3], eps);
+    }
+    // Outside the rect is untouched
+    try std.testing.expectApproxEqAbs(@as(f32, 0.2), buf.get(0, 1).?.bg[0], eps);
+    try std.testing.expectApproxEqAbs(@as(f32, 0.2), buf.get(8, 1).?.bg[0], eps);
+    try std.testing.expectApproxEqAbs(@as(f32, 0.2), buf.get(4, 0).?.bg[0], eps);
+
+    // Blur of a uniform area is a no-op
+    const blur = [_]FilterOp{op(.blur, 2)};
+    try filters.applyFilterChain(buf, 1, 1, 7, 2, &blur);
+    try std.testing.expectApproxEqAbs(@as(f32, 0.4), buf.get(3, 2).?.bg[0], eps);
+
+    const bad = [_]FilterOp{.{ .kind = 99 }};
+    try std.testing.expectError(filters.FilterError.InvalidFilter, filters.applyFilterChain(buf, 0, 0, 9, 3, &bad));
+}
+
+/// The JS filters in post/filters.ts, one pass per filter with their clamps
+fn referenceFilter(step: FilterOp, colors: []buffer.RGBA, width: u32, height: u32) void {
+    const centerX = @as(f32, @floatFromInt(width)) / 2;
+    const centerY = @as(f32, @floatFromInt(height)) / 2;
+    const maxDistSq = centerX * centerX + centerY * centerY;
+    for (colors, 0..) |*c, i| {
+        const r = c.*[0];
+        const g = c.*[1];
+        const b = c.*[2];
+        const a = c.*[3];
+        switch (@as(filters.FilterKind, @enumFromInt(step.kind))) {
+            .grayscale => {
+                const lum = 0.299 * r + 0.587 * g + 0.114 * b;
+                c.* = .{ lum, lum, lum, a };
+            },
+            .sepia => c.* = .{
+                @min(1, r * 0.393 + g * 0.769 + b * 0.189),
+                @min(1, r * 0.349 + g * 0.686 + b * 0.168),
+                @min(1, r * 0.272 + g * 0.534 + b * 0.131),
+                a,
+            },
+            .invert => c.* = .{ 1 - r, 1 - g, 1 - b, a },
+            .brightness => {
+                const f = @max(0, step.p0);
+                c.* = .{ @min(1, r * f), @min(1, g * f), @min(1, b * f), a };
+            },
+            .vignette => {
+                const dx = @as(f32, @floatFromInt(i % width)) - centerX;
+                const dy = @as(f32, @floatFromInt(i / width)) - centerY;
+                const f = @max(0, 1 - @min(1, (dx * dx + dy * dy) / maxDistSq) * step.p0);
+                c.* = .{ r * f, g * f, b * f, a };
+            },
+            else => unreachable,
+        }
+    }
+}
+
+test "applyFilterChain - fused chains match the JS filters run one by one" {
+    const allocator = std.testing.allocator;
+
+    const pool = gp.initGlobalPool(allocator);
+    defer gp.deinitGlobalPool();
+
+    const gd = gp.initGlobalUnicodeData(allocator);
+    defer gp.deinitGlobalUnicodeData(allocator);
+    const graphemes_ptr, const display_width_ptr = gd;
+
+    const width = 7;
+    const height = 3;
+    const buf = try OptimizedBuffer.init(allocator, width, height, .{ .pool = pool }, graphemes_ptr, display_width_ptr);
+    defer buf.deinit();
+
+    // Sepia and brightness > 1 push colors past 1, so the later stages see
+    // clamped input in the JS chain
+    const warm = [_]FilterOp{ op(.sepia, 0), op(.brightness, 1.4) };
+    const washed = [_]FilterOp{ op(.brightness, 1.8), op(.invert, 0) };
+    const faded = [_]FilterOp{ op(.sepia, 0), op(.grayscale, 0), op(.invert, 0), op(.brightness, 0.6) };
+    const framed = [_]FilterOp{ op(.invert, 0), op(.sepia, 0), op(.vignette, 0.7), op(.brightness, 1.3) };
+    const chains = [_][]const FilterOp{ &warm, &washed, &faded, &framed };
+
+    var expected_fg: [width * height]buffer.RGBA = undefined;
+    var expected_bg: [width * height]buffer.RGBA = undefined;
+    for (chains) |chain| {
+        for (0..width * height) |i| {
+            const t: f32 = @floatFromInt(i);
+            buf.buffer.fg[i] = .{ @mod(t * 0.37, 1), @mod(t * 0.61, 1), @mod(t * 0.13, 1), 1 };
+            buf.buffer.bg[i] = .{ @mod(0.5 + t * 0.23, 1), @mod(0.9 - t * 0.07, 1), @mod(t * 0.41, 1), 1 };
+        }
+        @memcpy(&expected_fg, buf.buffer.fg);
+        @memcpy(&expected_bg, buf.buffer.bg);
+        for (chain) |step| {
+            referenceFilter(step, &expected_fg, width, height);
+            referenceFilter(step, &expected_bg, width, height);
+        }
+
+        try filters.applyFilterChain(buf, 0, 0, width, height, chain);
+
+        for (0..width * height) |i| {
+            inline for (0..4) |ch| {
+                try std.testing.expectApproxEqAbs(expected_fg[i][ch], buf.buffer.fg[i][ch], 0.0001);
+                try std.testing.expectApproxEqAbs(expected_bg[i][ch], buf.buffer.bg[i][ch], 0.0001);
+            }
+        }
+    }
+}
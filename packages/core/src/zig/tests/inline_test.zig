@@ -0,0 +1,54 @@
+const std = @import("std");
+const renderer = @import("../renderer.zig");
+const gp = @import("../grapheme.zig");
+
+const CliRenderer = renderer.CliRenderer;
+
+fn drawStatus(r: *CliRenderer) !void {
+    const next = r.getNextBuffer();
+    for (0..r.height) |y| {
+        try next.drawText("status", 0, @intCast(y), .{ 1.0, 1.0, 1.0, 1.0 }, null, 0);
+    }
+}
+
+test "Inline renderer - log lines move the region down and repaint it" {
+    const allocator = std.testing.allocator;
+
+    const pool = gp.initGlobalPool(allocator);
+    defer gp.deinitGlobalPool();
+
+    const gd = gp.initGlobalUnicodeData(allocator);
+    defer gp.deinitGlobalUnicodeData(allocator);
+    const graphemes_ptr, const display_width_ptr = gd;
+
+    const r = try CliRenderer.create(allocator, 10, 24, pool, graphemes_ptr, display_width_ptr, true);
+    defer r.destroy();
+
+    try r.setupInline(3);
+    try std.testing.expectEqual(@as(u32, 3), r.height);
+
+    try drawStatus(r);
+    r.render(false);
+    try std.testing.expectEqual(@as(u32, 30), r.renderStats.cellsUpdated);
+
+    try drawStatus(r);
+    r.render(false);
+    try std.testing.expectEqual(@as(u32, 0), r.renderStats.cellsUpdated);
+
+    // Whether the log line scrolled the screen is not known, so the whole
+    // region is written again below it
+    try r.printAbove("step 1");
+    try drawStatus(r);
+    r.render(false);
+    try std.testing.expectEqual(@as(u32, 30), r.renderStats.cellsUpdated);
+    try std.testing.expectEqual(@as(usize, 0), r.inlinePending.items.len);
+
+    try drawStatus(r);
+    r.render(false);
+    try std.testing.expectEqual(@as(u32, 0), r.renderStats.cellsUpdated);
+
+    // The region keeps its row count when the terminal resizes
+    try r.resize(40, 50);
+    try std.testing.expectEqual(@as(u32, 40), r.width);
+    try std.testing.expectEqual(@as(u32, 3), r.height);
+}
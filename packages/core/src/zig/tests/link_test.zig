@@ -0,0 +1,86 @@
+const std = @import("std");
+const link = @import("../link.zig");
+const buffer = @import("../buffer.zig");
+const gp = @import("../grapheme.zig");
+const ansi = @import("../ansi.zig");
+
+const LinkPool = link.LinkPool;
+const OptimizedBuffer = buffer.OptimizedBuffer;
+
+test "LinkPool - interns each URL once" {
+    var pool = LinkPool.init(std.testing.allocator);
+    defer pool.deinit();
+
+    const a = try pool.intern("https://example.com/a");
+    const b = try pool.intern("https://example.com/b");
+    const a2 = try pool.intern("https://example.com/a");
+
+    try std.testing.expectEqual(@as(u16, 1), a);
+    try std.testing.expectEqual(@as(u16, 2), b);
+    try std.testing.expectEqual(a, a2);
+    try std.testing.expectEqual(@as(usize, 2), pool.count());
+    try std.testing.expectEqualStrings("https://example.com/b", pool.get(b).?);
+    try std.testing.expect(pool.get(link.NO_LINK) == null);
+    try std.testing.expectEqual(link.NO_LINK, try pool.intern(""));
+}
+
+test "LinkPool - rejects URLs with control bytes" {
+    var pool = LinkPool.init(std.testing.allocator);
+    defer pool.deinit();
+
+    try std.testing.expectError(link.LinkPoolError.InvalidUrl, pool.intern("https://a\x1b]52;c;x\x07"));
+    try std.testing.expectError(link.LinkPoolError.InvalidUrl, pool.intern("https://a\x07"));
+    try std.testing.expectError(link.LinkPoolError.InvalidUrl, pool.intern("https://a\nb"));
+    try std.testing.expectError(link.LinkPoolError.InvalidUrl, pool.intern("https://a\x7f"));
+    try std.testing.expectEqual(@as(usize, 0), pool.count());
+
+    // Non-ASCII bytes are fine
+    try std.testing.expectEqual(@as(u16, 1), try pool.intern("https://example.com/caf\xc3\xa9"));
+}
+
+test "OSC 8 - open and close bytes" {
+    var out: [64]u8 = undefined;
+    var stream = std.io.fixedBufferStream(&out);
+    try ansi.ANSI.hyperlinkOpenOutput(stream.writer(), 3, "https://example.com/a");
+    try std.testing.expectEqualStrings("\x1b]8;id=3;https://example.com/a\x1b\\", stream.getWritten());
+    try std.testing.expectEqualStrings("\x1b]8;;\x1b\\", ansi.ANSI.hyperlinkClose);
+}
+
+test "OptimizedBuffer links - pen stamps drawn cells only" {
+    const allocator = std.testing.allocator;
+
+    const pool = gp.initGlobalPool(allocator);
+    defer gp.deinitGlobalPool();
+
+    const gd = gp.initGlobalUnicodeData(allocator);
+    defer gp.deinitGlobalUnicodeData(allocator);
+    const graphemes_ptr, const display_width_ptr = gd;
+
+    var buf = try OptimizedBuffer.init(allocator, 20, 2, .{ .pool = pool }, graphemes_ptr, display_width_ptr);
+    defer buf.deinit();
+
+    const fg: buffer.RGBA = .{ 1.0, 1.0, 1.0, 1.0 };
+    const bg: buffer.RGBA = .{ 0.0, 0.0, 0.0, 1.0 };
+
+    try buf.drawText("see ", 0, 0, fg, bg, 0);
+    buf.setLinkPen(7);
+    try buf.drawText("docs", 4, 0, fg, bg, 0);
+    buf.setLinkPen(link.NO_LINK);
+    try buf.drawText(" now", 8, 0, fg, bg, 0);
+
+    try std.testing.expectEqual(link.NO_LINK, buf.get(3, 0).?.link);
+    try std.testing.expectEqual(@as(u16, 7), buf.get(4, 0).?.link);
+    try std.testing.expectEqual(@as(u16, 7), buf.get(7, 0).?.link);
+    try std.testing.expectEqual(link.NO_LINK, buf.get(8, 0).?.link);
+
+    // Copying into another buffer keeps the source links
+    var dest = try OptimizedBuffer.init(allocator, 20, 2, .{ .pool = pool, .respectAlpha = true }, graphemes_ptr, display_width_ptr);
+    defer dest.deinit();
+    try dest.clear(bg, null);
+    dest.drawFrameBuffer(0, 1, buf, 0, 0, 20, 1);
+    try std.testing.expectEqual(@as(u16, 7), dest.get(5, 1).?.link);
+    try std.testing.expectEqual(link.NO_LINK, dest.get(9, 1).?.link);
+
+    try buf.clear(bg, null);
+    try std.testing.expectEqual(link.NO_LINK, buf.get(5, 0).?.link);
+}
@@ -0,0 +1,92 @@
+const std = @import("std");
+const logger = @import("../logger.zig");
+
+const LogRing = logger.LogRing;
+
+fn newRing() !*LogRing {
+    const ring = try std.testing.allocator.create(LogRing);
+    ring.* = LogRing.init();
+    return ring;
+}
+
+test "LogRing - drains records in order" {
+    const ring = try newRing();
+    defer std.testing.allocator.destroy(ring);
+
+    try std.testing.expect(ring.push(@intFromEnum(logger.LogLevel.warn), "first"));
+    try std.testing.expect(ring.push(@intFromEnum(logger.LogLevel.info), "second"));
+
+    var out: [64]u8 = undefined;
+    const n = ring.drain(&out);
+    try std.testing.expectEqual(@as(usize, 3 + 5 + 3 + 6), n);
+    try std.testing.expectEqual(@as(u8, 1), out[0]);
+    try std.testing.expectEqual(@as(u16, 5), std.mem.readInt(u16, out[1..3], .little));
+    try std.testing.expectEqualStrings("first", out[3..8]);
+    try std.testing.expectEqual(@as(u8, 2), out[8]);
+    try std.testing.expectEqualStrings("second", out[11..17]);
+    try std.testing.expectEqual(@as(usize, 0), ring.drain(&out));
+}
+
+test "LogRing - keeps records that don't fit for the next drain" {
+    const ring = try newRing();
+    defer std.testing.allocator.destroy(ring);
+
+    _ = ring.push(0, "abcdef");
+    _ = ring.push(0, "ghijkl");
+
+    var out: [12]u8 = undefined;
+    try std.testing.expectEqual(@as(usize, 9), ring.drain(&out));
+    try std.testing.expectEqualStrings("abcdef", out[3..9]);
+    try std.testing.expectEqual(@as(usize, 9), ring.drain(&out));
+    try std.testing.expectEqualStrings("ghijkl", out[3..9]);
+}
+
+test "LogRing - drops and counts when full, truncates long messages" {
+    const ring = try newRing();
+    defer std.testing.allocator.destroy(ring);
+
+    for (0..logger.LOG_RING_SLOTS) |_| {
+        try std.testing.expect(ring.push(0, "x"));
+    }
+    try std.testing.expect(!ring.push(0, "overflow"));
+    try std.testing.expectEqual(@as(u32, 1), ring.takeDropped());
+    try std.testing.expectEqual(@as(u32, 0), ring.takeDropped());
+
+    var out: [4096]u8 = undefined;
+    _ = ring.drain(&out);
+
+    const long = [_]u8{'y'} ** (logger.LOG_MESSAGE_MAX + 50);
+    try std.testing.expect(ring.push(0, &long));
+    try std.testing.expectEqual(@as(usize, 3 + logger.LOG_MESSAGE_MAX), ring.drain(&out));
+}
+
+test "LogRing - concurrent producers lose nothing below capacity" {
+    const ring = try newRing();
+    defer std.testing.allocator.destroy(ring);
+
+    const per_thread = 50;
+    const Producer = struct {
+        fn run(r: *LogRing, id: u8) void {
+            for (0..per_thread) |_| {
+                _ = r.push(id, "msg");
+            }
+        }
+    };
+
+    var threads: [4]std.Thread = undefined;
+    for (&threads, 0..) |*t, i| {
+        t.* = try std.Thread.spawn(.{}, Producer.run, .{ ring, @as(u8, @intCast(i)) });
+    }
+    for (threads) |t| t.join();
+
+    var counts = [_]usize{0} ** 4;
+    var out: [4096]u8 = undefined;
+    const n = ring.drain(&out);
+    var pos: usize = 0;
+    while (pos < n) {
+        counts[out[pos]] += 1;
+        pos += 3 + std.mem.readInt(u16, out[pos + 1 ..][0..2], .little);
+    }
+    for (counts) |c| try std.testing.expectEqual(@as(usize, per_thread), c);
+    try std.testing.expectEqual(@as(u32, 0), ring.takeDropped());
+}
@@ -0,0 +1,41 @@
+const std = @import("std");
+const renderer = @import("../renderer.zig");
+const gp = @import("../grapheme.zig");
+
+const CliRenderer = renderer.CliRenderer;
+const white: renderer.RGBA = .{ 1.0, 1.0, 1.0, 1.0 };
+
+test "Retained mode - next buffer survives the frame" {
+    const allocator = std.testing.allocator;
+
+    const pool = gp.initGlobalPool(allocator);
+    defer gp.deinitGlobalPool();
+
+    const gd = gp.initGlobalUnicodeData(allocator);
+    defer gp.deinitGlobalUnicodeData(allocator);
+    const graphemes_ptr, const display_width_ptr = gd;
+
+    const r = try CliRenderer.create(allocator, 10, 3, pool, graphemes_ptr, display_width_ptr, true);
+    defer r.destroy();
+
+    r.setRetainedMode(true);
+    try r.getNextBuffer().drawText("status", 0, 1, white, null, 0);
+    r.render(false);
+    try std.testing.expectEqual(@as(u32, 30), r.renderStats.cellsUpdated);
+
+    // Nothing drawn: nothing changes and the text is still in the next buffer
+    r.render(false);
+    try std.testing.expectEqual(@as(u32, 0), r.renderStats.cellsUpdated);
+    try std.testing.expectEqual(@as(u32, 's'), r.getNextBuffer().get(0, 1).?.char);
+
+    // A partial update costs only the cells it touches
+    try r.getNextBuffer().drawText("S", 0, 1, white, null, 0);
+    r.render(false);
+    try std.testing.expectEqual(@as(u32, 1), r.renderStats.cellsUpdated);
+
+    // Back in immediate mode the next buffer is cleared after the frame
+    r.setRetainedMode(false);
+    r.render(false);
+    r.render(false);
+    try std.testing.expectEqual(@as(u32, 6), r.renderStats.cellsUpdated);
+}
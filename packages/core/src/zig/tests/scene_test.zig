@@ -0,0 +1,157 @@
+const std = @import("std");
+const buffer = @import("../buffer.zig");
+const gp = @import("../grapheme.zig");
+const scene = @import("../scene.zig");
+
+const Scene = scene.Scene;
+
+fn op(o: scene.Op) u32 {
+    return @intFromEnum(o);
+}
+
+fn prop(p: scene.Prop) u32 {
+    return @intFromEnum(p);
+}
+
+const GROW: u32 = @bitCast(@as(f32, 1.0));
+
+test "Scene - row layout with fixed, percent and flex-grow children" {
+    const gd = gp.initGlobalUnicodeData(std.testing.allocator);
+    defer gp.deinitGlobalUnicodeData(std.testing.allocator);
+    const graphemes_ptr, const display_width_ptr = gd;
+
+    const s = try Scene.create(std.testing.allocator, graphemes_ptr, display_width_ptr);
+    defer s.destroy();
+
+    const words = [_]u32{
+        op(.create), 1,
+        op(.insert), 1, 0, scene.NO_NODE,
+        op(.set), 1, prop(.direction), 1,
+        op(.set), 1, prop(.gap), 1,
+        op(.set), 1, prop(.flex_grow), GROW,
+        op(.create), 2,
+        op(.insert), 2, 1, scene.NO_NODE,
+        op(.set), 2, prop(.width), 10,
+        op(.create), 3,
+        op(.insert), 3, 1, scene.NO_NODE,
+        op(.set), 3, prop(.width), scene.DIM_PERCENT | 2500,
+        op(.create), 4,
+        op(.insert), 4, 1, scene.NO_NODE,
+        op(.set), 4, prop(.flex_grow), GROW,
+    };
+    try s.applyPatch(&words, "");
+    try std.testing.expectEqual(@as(u32, 16), s.stats.records);
+    try std.testing.expectEqual(@as(u32, 5), s.stats.nodes);
+
+    s.viewport = .{ .w = 80, .h = 24 };
+    _ = s.hitTest(0, 0);
+
+    // 80 wide: 10 fixed, 20 percent, 2 gaps, the rest grows
+    const r3 = s.getRect(3).?;
+    const r4 = s.getRect(4).?;
+    try std.testing.expectEqual(@as(u32, 10), s.getRect(2).?.w);
+    try std.testing.expectEqual(@as(i32, 11), r3.x);
+    try std.testing.expectEqual(@as(u32, 20), r3.w);
+    try std.testing.expectEqual(@as(i32, 32), r4.x);
+    try std.testing.expectEqual(@as(u32, 48), r4.w);
+    // Cross axis stretches to the grown row
+    try std.testing.expectEqual(@as(u32, 24), r4.h);
+}
+
+test "Scene - only damaged regions are repainted" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const allocator = arena.allocator();
+
+    const pool = gp.initGlobalPool(allocator);
+    defer gp.deinitGlobalPool();
+    const gd = gp.initGlobalUnicodeData(allocator);
+    defer gp.deinitGlobalUnicodeData(allocator);
+    const graphemes_ptr, const display_width_ptr = gd;
+
+    var target = try buffer.OptimizedBuffer.init(allocator, 20, 6, .{ .pool = pool }, graphemes_ptr, display_width_ptr);
+    defer target.deinit();
+
+    const s = try Scene.create(allocator, graphemes_ptr, display_width_ptr);
+    defer s.destroy();
+
+    const text = "helloworld";
+    const words = [_]u32{
+        op(.create), 1,
+        op(.insert), 1, 0, scene.NO_NODE,
+        op(.set_text), 1, 0, 5,
+        op(.set), 1, prop(.hit_id), 7,
+        op(.create), 2,
+        op(.insert), 2, 0, scene.NO_NODE,
+        op(.set_text), 2, 5, 5,
+        op(.set), 2, prop(.border), 1,
+    };
+    try s.applyPatch(&words, text);
+    try s.render(target, false);
+    try std.testing.expectEqual(@as(u32, 120), s.stats.damaged_cells);
+    try std.testing.expectEqual(@as(u32, 'h'), target.get(0, 0).?.char);
+    // Bordered box below the first line, text inside the border
+    try std.testing.expectEqual(@as(u32, 0x250C), target.get(0, 1).?.char);
+    try std.testing.expectEqual(@as(u32, 'w'), target.get(1, 2).?.char);
+
+    // Recoloring one line damages just that line
+    const recolor = [_]u32{ op(.set), 1, prop(.fg), 0xFF0000FF };
+    try s.applyPatch(&recolor, "");
+    try s.render(target, false);
+    try std.testing.expectEqual(@as(u32, 20), s.stats.damaged_cells);
+    try std.testing.expectEqual(@as(u32, 'w'), target.get(1, 2).?.char);
+
+    // Nothing changed, nothing painted
+    try s.render(target, false);
+    try std.testing.expectEqual(@as(u32, 0), s.stats.damaged_cells);
+    try std.testing.expectEqual(@as(u32, 0), s.stats.painted);
+
+    try std.testing.expectEqual(@as(u32, 7), s.hitTest(3, 0));
+    try std.testing.expectEqual(@as(u32, 0), s.hitTest(3, 2));
+}
+
+test "Scene - remove and reinsert" {
+    const gd = gp.initGlobalUnicodeData(std.testing.allocator);
+    defer gp.deinitGlobalUnicodeData(std.testing.allocator);
+    const graphemes_ptr, const display_width_ptr = gd;
+
+    const s = try Scene.create(std.testing.allocator, graphemes_ptr, display_width_ptr);
+    defer s.destroy();
+
+    const build = [_]u32{
+        op(.create), 1,
+        op(.insert), 1, 0, scene.NO_NODE,
+        op(.create), 2,
+        op(.insert), 2, 1, scene.NO_NODE,
+        op(.create), 3,
+        op(.insert), 3, 0, 0,
+    };
+    try s.applyPatch(&build, "");
+    try std.testing.expectEqual(@as(u32, 4), s.stats.nodes);
+
+    // Removing a parent releases its subtree; the ids can be created again
+    const remove = [_]u32{ op(.remove), 1, op(.create), 2 };
+    try s.applyPatch(&remove, "");
+    try std.testing.expectEqual(@as(u32, 3), s.stats.nodes);
+
+    // A node cannot become its own ancestor
+    const cycle = [_]u32{ op(.insert), 3, 2, 0, op(.insert), 2, 3, 0 };
+    try std.testing.expectError(scene.PatchError.BadNode, s.applyPatch(&cycle, ""));
+    try std.testing.expectEqual(@as(u32, 1), s.stats.records);
+}
+
+test "Scene - malformed patches are rejected" {
+    const gd = gp.initGlobalUnicodeData(std.testing.allocator);
+    defer gp.deinitGlobalUnicodeData(std.testing.allocator);
+    const graphemes_ptr, const display_width_ptr = gd;
+
+    const s = try Scene.create(std.testing.allocator, graphemes_ptr, display_width_ptr);
+    defer s.destroy();
+
+    try std.testing.expectError(scene.PatchError.Truncated, s.applyPatch(&[_]u32{ op(.insert), 1 }, ""));
+    try std.testing.expectError(scene.PatchError.UnknownOp, s.applyPatch(&[_]u32{99}, ""));
+    try std.testing.expectError(scene.PatchError.BadNode, s.applyPatch(&[_]u32{ op(.set), 5, prop(.bg), 0 }, ""));
+    try std.testing.expectError(scene.PatchError.UnknownProp, s.applyPatch(&[_]u32{ op(.set), 0, 200, 0 }, ""));
+    try std.testing.expectError(scene.PatchError.BadText, s.applyPatch(&[_]u32{ op(.set_text), 0, 2, 4 }, "abc"));
+    try std.testing.expectError(scene.PatchError.BadNode, s.applyPatch(&[_]u32{ op(.remove), scene.ROOT }, ""));
+}
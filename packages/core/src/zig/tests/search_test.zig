@@ -0,0 +1,264 @@
+const std = @import("std");
+const buffer = @import("../buffer.zig");
+const text_buffer = @import("../text-buffer.zig");
+const gp = @import("../grapheme.zig");
+const text_search = @import("../search.zig");
+
+const TextBuffer = text_buffer.TextBuffer;
+const TextSearch = text_search.TextSearch;
+const RGBA = text_buffer.RGBA;
+
+fn expectMatches(search: *const TextSearch, expected: []const [2]u32) !void {
+    try std.testing.expectEqual(@as(u32, @intCast(expected.len)), search.matchCount());
+    for (expected, 0..) |range, i| {
+        const m = search.getMatch(@intCast(i)).?;
+        try std.testing.expectEqual(range[0], m.start);
+        try std.testing.expectEqual(range[1], m.end);
+    }
+}
+
+fn finish(search: *TextSearch) !void {
+    try std.testing.expect(try search.run(std.math.maxInt(u32)));
+}
+
+test "TextSearch - literal matches span chunks" {
+    const pool = gp.initGlobalPool(std.testing.allocator);
+    defer gp.deinitGlobalPool();
+    const gd = gp.initGlobalUnicodeData(std.testing.allocator);
+    defer gp.deinitGlobalUnicodeData(std.testing.allocator);
+    const graphemes_ptr, const display_width_ptr = gd;
+
+    var tb = try TextBuffer.init(std.testing.allocator, pool, .wcwidth, graphemes_ptr, display_width_ptr);
+    defer tb.deinit();
+
+    _ = try tb.writeChunk("hello wor", RGBA{ 1.0, 0.0, 0.0, 1.0 }, null, null);
+    _ = try tb.writeChunk("ld foo\nworld\n", null, null, null);
+
+    const search = try tb.getSearch();
+    try search.setPattern("world", 0, 0, 10);
+    try finish(search);
+    try expectMatches(search, &.{ .{ 6, 11 }, .{ 16, 21 } });
+
+    try search.setPattern("WORLD", 0, 0, 10);
+    try finish(search);
+    try expectMatches(search, &.{});
+
+    try search.setPattern("WORLD", text_search.FLAG_IGNORE_CASE, 0, 10);
+    try finish(search);
+    try expectMatches(search, &.{ .{ 6, 11 }, .{ 16, 21 } });
+}
+
+test "TextSearch - regex subset" {
+    const pool = gp.initGlobalPool(std.testing.allocator);
+    defer gp.deinitGlobalPool();
+    const gd = gp.initGlobalUnicodeData(std.testing.allocator);
+    defer gp.deinitGlobalUnicodeData(std.testing.allocator);
+    const graphemes_ptr, const display_width_ptr = gd;
+
+    var tb = try TextBuffer.init(std.testing.allocator, pool, .wcwidth, graphemes_ptr, display_width_ptr);
+    defer tb.deinit();
+
+    // Lines start at 0, 12, 18 and 30
+    _ = try tb.writeChunk("12 ERR disk\nERR 7\nfoo fooo fx\nabc axc\n", null, null, null);
+
+    const search = try tb.getSearch();
+    const regex = text_search.FLAG_REGEX;
+
+    try search.setPattern("^\\d+ ERR", regex, 0, 10);
+    try finish(search);
+    try expectMatches(search, &.{.{ 0, 6 }});
+
+    try search.setPattern("fo+", regex, 0, 10);
+    try finish(search);
+    try expectMatches(search, &.{ .{ 18, 21 }, .{ 22, 26 } });
+
+    // The star has to give back the o's before the x can match
+    try search.setPattern("f[a-o]*x", regex, 0, 10);
+    try finish(search);
+    try expectMatches(search, &.{.{ 27, 29 }});
+
+    try search.setPattern("a.c$", regex, 0, 10);
+    try finish(search);
+    try expectMatches(search, &.{.{ 34, 37 }});
+
+    try search.setPattern("err", regex | text_search.FLAG_IGNORE_CASE, 0, 10);
+    try finish(search);
+    try expectMatches(search, &.{ .{ 3, 6 }, .{ 12, 15 } });
+
+    try std.testing.expectError(error.InvalidPattern, search.setPattern("*a", regex, 0, 10));
+    try std.testing.expectError(error.InvalidPattern, search.setPattern("[ab", regex, 0, 10));
+    try std.testing.expectError(error.InvalidPattern, search.setPattern("a\\", regex, 0, 10));
+    // A failed query leaves the previous search alone
+    try expectMatches(search, &.{ .{ 3, 6 }, .{ 12, 15 } });
+}
+
+test "TextSearch - viewport first, then the rest in steps" {
+    const pool = gp.initGlobalPool(std.testing.allocator);
+    defer gp.deinitGlobalPool();
+    const gd = gp.initGlobalUnicodeData(std.testing.allocator);
+    defer gp.deinitGlobalUnicodeData(std.testing.allocator);
+    const graphemes_ptr, const display_width_ptr = gd;
+
+    var tb = try TextBuffer.init(std.testing.allocator, pool, .wcwidth, graphemes_ptr, display_width_ptr);
+    defer tb.deinit();
+
+    var text = std.ArrayList(u8).init(std.testing.allocator);
+    defer text.deinit();
+    var i: u32 = 0;
+    while (i < 2000) : (i += 1) {
+        if (i % 10 == 0) {
+            try text.writer().print("a needle at {d}\n", .{i});
+        } else {
+            try text.writer().print("line {d} of the haystack\n", .{i});
+        }
+    }
+    _ = try tb.writeChunk(text.items, null, null, null);
+
+    const search = try tb.getSearch();
+    try search.setPattern("needle", 0, 1000, 20);
+    // Only the lines under the viewport have been scanned
+    try std.testing.expectEqual(@as(u32, 2), search.matchCount());
+    try std.testing.expectEqual(@as(u32, 20), search.getStats().lines_scanned);
+    try std.testing.expect(!search.isComplete());
+
+    try std.testing.expect(!try search.run(1000));
+    while (!try search.run(4096)) {}
+    try std.testing.expectEqual(@as(u32, 200), search.matchCount());
+
+    // Matches wrapped around from the top still come out in buffer order
+    var last: u32 = 0;
+    var index: u32 = 0;
+    while (index < search.matchCount()) : (index += 1) {
+        const m = search.getMatch(index).?;
+        try std.testing.expect(index == 0 or m.start > last);
+        last = m.start;
+    }
+    try std.testing.expectEqual(@as(u32, 2), search.getMatch(0).?.start);
+
+    const line_1000 = tb.lines.items[1000].char_offset;
+    try std.testing.expectEqual(@as(u32, 100), search.findMatch(line_1000, false));
+    try std.testing.expectEqual(@as(u32, 99), search.findMatch(line_1000, true));
+    try std.testing.expectEqual(text_search.NO_MATCH, search.findMatch(0, true));
+}
+
+test "TextSearch - a longer query refines the previous matches" {
+    const pool = gp.initGlobalPool(std.testing.allocator);
+    defer gp.deinitGlobalPool();
+    const gd = gp.initGlobalUnicodeData(std.testing.allocator);
+    defer gp.deinitGlobalUnicodeData(std.testing.allocator);
+    const graphemes_ptr, const display_width_ptr = gd;
+
+    var tb = try TextBuffer.init(std.testing.allocator, pool, .wcwidth, graphemes_ptr, display_width_ptr);
+    defer tb.deinit();
+
+    _ = try tb.writeChunk("aaab xaab aab\n", null, null, null);
+
+    const search = try tb.getSearch();
+    try search.setPattern("aa", 0, 0, 10);
+    try finish(search);
+    try expectMatches(search, &.{ .{ 0, 2 }, .{ 6, 8 }, .{ 10, 12 } });
+    const scanned = search.getStats().cells_scanned;
+
+    // "aab" starts inside the first "aa" match, not at it
+    try search.setPattern("aab", 0, 0, 10);
+    try expectMatches(search, &.{ .{ 1, 4 }, .{ 6, 9 }, .{ 10, 13 } });
+    try std.testing.expectEqual(@as(u32, 3), search.getStats().refined);
+    try std.testing.expectEqual(scanned, search.getStats().cells_scanned);
+
+    // A query that does not extend the last one scans again
+    try search.setPattern("ab", 0, 0, 10);
+    try finish(search);
+    try std.testing.expectEqual(@as(u32, 0), search.getStats().refined);
+    try expectMatches(search, &.{ .{ 2, 4 }, .{ 7, 9 }, .{ 11, 13 } });
+}
+
+test "TextSearch - a combining mark that changes the last grapheme rescans" {
+    const pool = gp.initGlobalPool(std.testing.allocator);
+    defer gp.deinitGlobalPool();
+    const gd = gp.initGlobalUnicodeData(std.testing.allocator);
+    defer gp.deinitGlobalUnicodeData(std.testing.allocator);
+    const graphemes_ptr, const display_width_ptr = gd;
+
+    var tb = try TextBuffer.init(std.testing.allocator, pool, .wcwidth, graphemes_ptr, display_width_ptr);
+    defer tb.deinit();
+
+    _ = try tb.writeChunk("be\u{301} bex\n", null, null, null);
+
+    const search = try tb.getSearch();
+    try search.setPattern("be", 0, 0, 10);
+    try finish(search);
+    try expectMatches(search, &.{.{ 3, 5 }});
+
+    // The query's bytes only grew, but its last grapheme is now "é"
+    try search.setPattern("be\u{301}", 0, 0, 10);
+    try finish(search);
+    try std.testing.expectEqual(@as(u32, 0), search.getStats().refined);
+    try expectMatches(search, &.{.{ 0, 2 }});
+}
+
+test "TextSearch - appended output is searched on the next run" {
+    const pool = gp.initGlobalPool(std.testing.allocator);
+    defer gp.deinitGlobalPool();
+    const gd = gp.initGlobalUnicodeData(std.testing.allocator);
+    defer gp.deinitGlobalUnicodeData(std.testing.allocator);
+    const graphemes_ptr, const display_width_ptr = gd;
+
+    var tb = try TextBuffer.init(std.testing.allocator, pool, .wcwidth, graphemes_ptr, display_width_ptr);
+    defer tb.deinit();
+
+    _ = try tb.writeChunk("one err\ntwo", null, null, null);
+    const search = try tb.getSearch();
+    try search.setPattern("err", 0, 0, 10);
+    try finish(search);
+    try expectMatches(search, &.{.{ 4, 7 }});
+
+    // The unterminated last line grows and new lines follow
+    _ = try tb.writeChunk(" err\nerr\n", null, null, null);
+    try std.testing.expect(!search.isComplete());
+    try finish(search);
+    try expectMatches(search, &.{ .{ 4, 7 }, .{ 12, 15 }, .{ 16, 19 } });
+
+    // Other edits start over
+    tb.reset();
+    _ = try tb.writeChunk("err\n", null, null, null);
+    try finish(search);
+    try expectMatches(search, &.{.{ 0, 3 }});
+}
+
+test "TextSearch - wide graphemes and highlighting" {
+    const pool = gp.initGlobalPool(std.testing.allocator);
+    defer gp.deinitGlobalPool();
+    const gd = gp.initGlobalUnicodeData(std.testing.allocator);
+    defer gp.deinitGlobalUnicodeData(std.testing.allocator);
+    const graphemes_ptr, const display_width_ptr = gd;
+
+    var tb = try TextBuffer.init(std.testing.allocator, pool, .wcwidth, graphemes_ptr, display_width_ptr);
+    defer tb.deinit();
+
+    // Each wide character takes two cells
+    _ = try tb.writeChunk("日本 ab 本\n", null, null, null);
+
+    const search = try tb.getSearch();
+    try search.setPattern("本", 0, 0, 10);
+    try finish(search);
+    try expectMatches(search, &.{ .{ 2, 4 }, .{ 8, 10 } });
+
+    try search.setPattern("b 本", 0, 0, 10);
+    try finish(search);
+    try expectMatches(search, &.{.{ 6, 10 }});
+
+    try search.setPattern("ab", 0, 0, 10);
+    try finish(search);
+    try std.testing.expectEqual(@as(u32, 1), try search.highlight(0, 1, 0));
+
+    var target = try buffer.OptimizedBuffer.init(std.testing.allocator, 20, 2, .{ .pool = pool }, graphemes_ptr, display_width_ptr);
+    defer target.deinit();
+    try target.drawTextBuffer(tb, 0, 0, null);
+
+    try std.testing.expectEqual(search.current_bg, target.get(5, 0).?.bg);
+    try std.testing.expectEqual(search.current_bg, target.get(6, 0).?.bg);
+    try std.testing.expect(!std.meta.eql(search.current_bg, target.get(7, 0).?.bg));
+
+    search.clear();
+    try std.testing.expectEqual(@as(usize, 0), tb.highlights.items.len);
+}
@@ -0,0 +1,129 @@
+const std = @import("std");
+const sgr = @import("../sgr.zig");
+const text_buffer = @import("../text-buffer.zig");
+const gp = @import("../grapheme.zig");
+
+const RGBA = text_buffer.RGBA;
+
+/// Records every run the parser emits
+const RecordingSink = struct {
+    const Run = struct {
+        text: []const u8,
+        fg: ?RGBA,
+        bg: ?RGBA,
+        attr: ?u8,
+    };
+
+    arena: std.heap.ArenaAllocator,
+    runs: std.ArrayListUnmanaged(Run) = .{},
+
+    fn init() RecordingSink {
+        return .{ .arena = std.heap.ArenaAllocator.init(std.testing.allocator) };
+    }
+
+    fn deinit(self: *RecordingSink) void {
+        self.arena.deinit();
+    }
+
+    pub fn writeChunk(self: *RecordingSink, bytes: []const u8, fg: ?RGBA, bg: ?RGBA, attr: ?u8) !u32 {
+        const allocator = self.arena.allocator();
+        try self.runs.append(allocator, .{ .text = try allocator.dupe(u8, bytes), .fg = fg, .bg = bg, .attr = attr });
+        return 0;
+    }
+};
+
+test "SGR - findEscape matches a scalar scan" {
+    var bytes: [100]u8 = undefined;
+    @memset(&bytes, 'a');
+    try std.testing.expectEqual(@as(usize, 100), sgr.findEscape(&bytes));
+    for ([_]usize{ 0, 15, 16, 37, 96, 99 }) |pos| {
+        @memset(&bytes, 'a');
+        bytes[pos] = 0x1B;
+        try std.testing.expectEqual(pos, sgr.findEscape(&bytes));
+    }
+}
+
+test "SGR - styles map to runs" {
+    var sink = RecordingSink.init();
+    defer sink.deinit();
+    var parser = sgr.SgrParser{};
+
+    try parser.feed(&sink, "a\x1b[1;31mb\x1b[4;44mc\x1b[22;39md\x1b[0me");
+    const runs = sink.runs.items;
+    try std.testing.expectEqual(@as(usize, 5), runs.len);
+
+    try std.testing.expectEqualStrings("a", runs[0].text);
+    try std.testing.expectEqual(@as(?RGBA, null), runs[0].fg);
+    try std.testing.expectEqual(@as(?u8, null), runs[0].attr);
+
+    try std.testing.expectEqualStrings("b", runs[1].text);
+    try std.testing.expectEqual(@as(?RGBA, sgr.paletteColor(1)), runs[1].fg);
+    try std.testing.expectEqual(@as(?u8, 1), runs[1].attr);
+
+    try std.testing.expectEqual(@as(?RGBA, sgr.paletteColor(4)), runs[2].bg);
+    try std.testing.expectEqual(@as(?u8, 1 | 8), runs[2].attr);
+
+    // Bold off and default fg keep the underline and background
+    try std.testing.expectEqual(@as(?RGBA, null), runs[3].fg);
+    try std.testing.expectEqual(@as(?RGBA, sgr.paletteColor(4)), runs[3].bg);
+    try std.testing.expectEqual(@as(?u8, 8), runs[3].attr);
+
+    try std.testing.expectEqual(@as(?RGBA, null), runs[4].bg);
+    try std.testing.expectEqual(@as(?u8, null), runs[4].attr);
+}
+
+test "SGR - extended colors and skipped sequences" {
+    var sink = RecordingSink.init();
+    defer sink.deinit();
+    var parser = sgr.SgrParser{};
+
+    try parser.feed(&sink, "\x1b[38;2;255;0;0ma\x1b[48:2::0:0:255mb\x1b[38;5;196mc");
+    // Cursor moves, private modes and OSC titles produce no text
+    try parser.feed(&sink, "\x1b[2K\x1b[?25l\x1b]0;title\x07\x1b]8;;url\x1b\\d");
+
+    const runs = sink.runs.items;
+    try std.testing.expectEqual(@as(usize, 4), runs.len);
+    try std.testing.expectEqual(@as(?RGBA, .{ 1, 0, 0, 1 }), runs[0].fg);
+    try std.testing.expectEqual(@as(?RGBA, .{ 0, 0, 1, 1 }), runs[1].bg);
+    try std.testing.expectEqual(@as(?RGBA, .{ 1, 0, 0, 1 }), runs[2].fg);
+    try std.testing.expectEqualStrings("d", runs[3].text);
+}
+
+test "SGR - sequences and characters split across feeds" {
+    var sink = RecordingSink.init();
+    defer sink.deinit();
+    var parser = sgr.SgrParser{};
+
+    try parser.feed(&sink, "x\x1b[3");
+    try parser.feed(&sink, "2my\xc3");
+    try parser.feed(&sink, "\xa9z");
+
+    const runs = sink.runs.items;
+    try std.testing.expectEqual(@as(usize, 4), runs.len);
+    try std.testing.expectEqualStrings("x", runs[0].text);
+    try std.testing.expectEqualStrings("y", runs[1].text);
+    try std.testing.expectEqual(@as(?RGBA, sgr.paletteColor(2)), runs[1].fg);
+    try std.testing.expectEqualStrings("\xc3\xa9", runs[2].text);
+    try std.testing.expectEqual(@as(?RGBA, sgr.paletteColor(2)), runs[2].fg);
+    try std.testing.expectEqualStrings("z", runs[3].text);
+}
+
+test "SGR - writeAnsi styles TextBuffer chunks" {
+    const pool = gp.initGlobalPool(std.testing.allocator);
+    defer gp.deinitGlobalPool();
+    const gd = gp.initGlobalUnicodeData(std.testing.allocator);
+    defer gp.deinitGlobalUnicodeData(std.testing.allocator);
+    const graphemes_ptr, const display_width_ptr = gd;
+
+    var tb = try text_buffer.TextBuffer.init(std.testing.allocator, pool, .wcwidth, graphemes_ptr, display_width_ptr);
+    defer tb.deinit();
+
+    try tb.writeAnsi("\x1b[32mok\x1b[0m\r\nnext");
+    tb.finalizeLineInfo();
+
+    try std.testing.expectEqual(@as(u32, 2), tb.getLineCount());
+    const first = tb.lines.items[0].chunks.items[0];
+    try std.testing.expectEqual(@as(?RGBA, sgr.paletteColor(2)), first.fg);
+    try std.testing.expectEqual(@as(u32, 2), tb.lines.items[0].width);
+    try std.testing.expectEqual(@as(u32, 4), tb.lines.items[1].width);
+}
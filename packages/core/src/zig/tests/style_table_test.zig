@@ -0,0 +1,106 @@
+const std = @import("std");
+const renderer = @import("../renderer.zig");
+const gp = @import("../grapheme.zig");
+const style_table = @import("../style_table.zig");
+
+const CliRenderer = renderer.CliRenderer;
+const StyleTable = style_table.StyleTable;
+const RGBA = renderer.RGBA;
+const Attr = renderer.TextAttributes;
+
+const black: RGBA = .{ 0.0, 0.0, 0.0, 1.0 };
+const white: RGBA = .{ 1.0, 1.0, 1.0, 1.0 };
+const red: RGBA = .{ 1.0, 0.0, 0.0, 1.0 };
+const green: RGBA = .{ 0.0, 1.0, 0.0, 1.0 };
+
+test "StyleTable - styles are interned at output precision" {
+    var table = StyleTable.init(std.testing.allocator);
+    defer table.deinit();
+
+    const a = try table.intern(white, black, 0);
+    try std.testing.expectEqual(a, try table.intern(white, black, 0));
+    // Alpha and sub-8-bit differences are invisible on the terminal
+    try std.testing.expectEqual(a, try table.intern(.{ 0.9999, 1.0, 1.0, 0.5 }, black, 0));
+    try std.testing.expect(a != try table.intern(white, black, Attr.BOLD));
+    try std.testing.expect(a != try table.intern(red, black, 0));
+    try std.testing.expectEqual(@as(u32, 3), table.count());
+}
+
+test "StyleTable - transitions write only what changes" {
+    var table = StyleTable.init(std.testing.allocator);
+    defer table.deinit();
+
+    const plain = try table.intern(white, black, 0);
+    const plain_red = try table.intern(red, black, 0);
+    const bold_red = try table.intern(red, black, Attr.BOLD | Attr.UNDERLINE);
+
+    try std.testing.expectEqualStrings(
+        "\x1b[0m\x1b[38;2;255;255;255m\x1b[48;2;0;0;0m",
+        try table.transition(style_table.NO_STYLE, plain),
+    );
+    try std.testing.expectEqualStrings("\x1b[38;2;255;0;0m", try table.transition(plain, plain_red));
+    try std.testing.expectEqualStrings("\x1b[1m\x1b[4m", try table.transition(plain_red, bold_red));
+    // Attributes can only be turned off by a reset
+    try std.testing.expectEqualStrings(
+        "\x1b[0m\x1b[38;2;255;0;0m\x1b[48;2;0;0;0m",
+        try table.transition(bold_red, plain_red),
+    );
+
+    _ = try table.transition(plain, plain_red);
+    const stats = table.getStats();
+    try std.testing.expectEqual(@as(u32, 4), stats.transitions);
+    try std.testing.expectEqual(@as(u32, 1), stats.hits);
+    try std.testing.expectEqual(@as(u32, 4), stats.misses);
+
+    table.reset();
+    try std.testing.expectEqual(@as(u32, 0), table.count());
+    try std.testing.expectEqual(@as(u32, 1), table.getStats().resets);
+}
+
+test "Style interning - cells compare by style id" {
+    const allocator = std.testing.allocator;
+
+    const pool = gp.initGlobalPool(allocator);
+    defer gp.deinitGlobalPool();
+
+    const gd = gp.initGlobalUnicodeData(allocator);
+    defer gp.deinitGlobalUnicodeData(allocator);
+    const graphemes_ptr, const display_width_ptr = gd;
+
+    const r = try CliRenderer.create(allocator, 10, 3, pool, graphemes_ptr, display_width_ptr, true);
+    defer r.destroy();
+
+    try r.setStyleInterning(true);
+    r.setRetainedMode(true);
+    try r.getNextBuffer().drawText("status", 0, 1, green, null, 0);
+    r.render(false);
+    try std.testing.expectEqual(@as(u32, 30), r.renderStats.cellsUpdated);
+    // Cleared cells and the text
+    try std.testing.expectEqual(@as(u32, 2), r.getStyleStats().?.styles);
+
+    // A color change the terminal cannot show is not a change
+    try r.getNextBuffer().drawText("status", 0, 1, .{ 0.0, 0.9999, 0.0, 1.0 }, null, 0);
+    r.render(false);
+    try std.testing.expectEqual(@as(u32, 0), r.renderStats.cellsUpdated);
+
+    try r.getNextBuffer().drawText("st", 0, 1, red, null, 0);
+    r.render(false);
+    try std.testing.expectEqual(@as(u32, 2), r.renderStats.cellsUpdated);
+    try std.testing.expectEqual(@as(u32, 3), r.getStyleStats().?.styles);
+
+    // The same transitions come from the cache
+    try r.getNextBuffer().drawText("st", 0, 1, green, null, 0);
+    r.render(false);
+    try r.getNextBuffer().drawText("st", 0, 1, red, null, 0);
+    r.render(false);
+    try std.testing.expect(r.getStyleStats().?.hits > 0);
+
+    // A resize keeps the table but repaints everything
+    try r.resize(12, 3);
+    r.render(false);
+    try std.testing.expectEqual(@as(u32, 36), r.renderStats.cellsUpdated);
+    try std.testing.expectEqual(@as(u32, 3), r.getStyleStats().?.styles);
+
+    try r.setStyleInterning(false);
+    try std.testing.expect(r.getStyleStats() == null);
+}
@@ -1489,6 +1489,170 @@ test "TextBuffer selection - no selection returns all bits set" {
     try std.testing.expectEqual(@as(u64, 0xFFFFFFFF_FFFFFFFF), packed_info);
 }
 
+test "TextBuffer selection - drag across many lines maps only end rows" {
+    const pool = gp.initGlobalPool(std.testing.allocator);
+    defer gp.deinitGlobalPool();
+
+    const gd = gp.initGlobalUnicodeData(std.testing.allocator);
+    defer gp.deinitGlobalUnicodeData(std.testing.allocator);
+    const graphemes_ptr, const display_width_ptr = gd;
+
+    var tb = try TextBuffer.init(std.testing.allocator, pool, .wcwidth, graphemes_ptr, display_width_ptr);
+    defer tb.deinit();
+
+    _ = try tb.writeChunk("Line 1\nLine 2\nLine 3\nLine 4", null, null, null);
+    tb.finalizeLineInfo();
+
+    // From "ne 1" to "Li" of line 4, focus below the last line is clamped
+    _ = tb.setLocalSelection(2, 0, 2, 3, null, null);
+    var sel = tb.getSelection().?;
+    try std.testing.expectEqual(@as(u32, 2), sel.start);
+    try std.testing.expectEqual(@as(u32, 23), sel.end);
+
+    _ = tb.setLocalSelection(2, 0, 2, 10, null, null);
+    sel = tb.getSelection().?;
+    try std.testing.expectEqual(@as(u32, 2), sel.start);
+    try std.testing.expectEqual(@as(u32, 27), sel.end);
+
+    // Anchor past the end of line 1 starts the selection on line 2
+    _ = tb.setLocalSelection(20, 0, 3, 1, null, null);
+    sel = tb.getSelection().?;
+    try std.testing.expectEqual(@as(u32, 7), sel.start);
+    try std.testing.expectEqual(@as(u32, 10), sel.end);
+}
+
+test "TextBuffer selection - dirty rows cover only the changed rows" {
+    const pool = gp.initGlobalPool(std.testing.allocator);
+    defer gp.deinitGlobalPool();
+
+    const gd = gp.initGlobalUnicodeData(std.testing.allocator);
+    defer gp.deinitGlobalUnicodeData(std.testing.allocator);
+    const graphemes_ptr, const display_width_ptr = gd;
+
+    var tb = try TextBuffer.init(std.testing.allocator, pool, .wcwidth, graphemes_ptr, display_width_ptr);
+    defer tb.deinit();
+
+    _ = try tb.writeChunk("Line 1\nLine 2\nLine 3\nLine 4\nLine 5", null, null, null);
+    tb.finalizeLineInfo();
+
+    _ = tb.setLocalSelection(0, 0, 3, 2, null, null);
+    var rows = tb.takeSelectionDirtyRows().?;
+    try std.testing.expectEqual(@as(u32, 0), rows.start);
+    try std.testing.expectEqual(@as(u32, 3), rows.end);
+    try std.testing.expect(tb.takeSelectionDirtyRows() == null);
+
+    // Extending the drag onto line 4 only touches rows 2 and 3
+    _ = tb.setLocalSelection(0, 0, 3, 3, null, null);
+    rows = tb.takeSelectionDirtyRows().?;
+    try std.testing.expectEqual(@as(u32, 2), rows.start);
+    try std.testing.expectEqual(@as(u32, 4), rows.end);
+
+    // Same coordinates again changes nothing
+    _ = tb.setLocalSelection(0, 0, 3, 3, null, null);
+    try std.testing.expect(tb.takeSelectionDirtyRows() == null);
+
+    tb.resetLocalSelection();
+    rows = tb.takeSelectionDirtyRows().?;
+    try std.testing.expectEqual(@as(u32, 0), rows.start);
+    try std.testing.expectEqual(@as(u32, 4), rows.end);
+    try std.testing.expectEqual(@as(u64, 0xFFFFFFFF_FFFFFFFF), tb.packSelectionDirtyRows());
+}
+
+test "TextBuffer selection - selected text streams in chunks" {
+    const pool = gp.initGlobalPool(std.testing.allocator);
+    defer gp.deinitGlobalPool();
+
+    const gd = gp.initGlobalUnicodeData(std.testing.allocator);
+    defer gp.deinitGlobalUnicodeData(std.testing.allocator);
+    const graphemes_ptr, const display_width_ptr = gd;
+
+    var tb = try TextBuffer.init(std.testing.allocator, pool, .wcwidth, graphemes_ptr, display_width_ptr);
+    defer tb.deinit();
+
+    _ = try tb.writeChunk("Hello\n世界 World", null, null, null);
+    tb.finalizeLineInfo();
+    tb.setSelection(1, 16, null, null);
+
+    var full_buf: [64]u8 = undefined;
+    const full_len = tb.getSelectedTextIntoBuffer(&full_buf);
+    try std.testing.expectEqualStrings("ello\n世界 World", full_buf[0..full_len]);
+
+    // A 4 byte buffer never splits a 3 byte CJK character
+    var small_buf: [4]u8 = undefined;
+    var streamed: [64]u8 = undefined;
+    var streamed_len: usize = 0;
+    var from: u32 = 0;
+    var calls: u32 = 0;
+    while (from < 16) : (calls += 1) {
+        const chunk = tb.getSelectedTextChunk(&small_buf, from);
+        @memcpy(streamed[streamed_len .. streamed_len + chunk.written], small_buf[0..chunk.written]);
+        streamed_len += chunk.written;
+        from = chunk.next;
+    }
+
+    try std.testing.expectEqualStrings("ello\n世界 World", streamed[0..streamed_len]);
+    try std.testing.expect(calls > 1);
+}
+
+test "TextBuffer storage - ASCII chunks use one byte per cell" {
+    const pool = gp.initGlobalPool(std.testing.allocator);
+    defer gp.deinitGlobalPool();
+
+    const gd = gp.initGlobalUnicodeData(std.testing.allocator);
+    defer gp.deinitGlobalUnicodeData(std.testing.allocator);
+    const graphemes_ptr, const display_width_ptr = gd;
+
+    var tb = try TextBuffer.init(std.testing.allocator, pool, .wcwidth, graphemes_ptr, display_width_ptr);
+    defer tb.deinit();
+
+    _ = try tb.writeChunk("[info] build ok\n世界\n", null, null, null);
+    tb.finalizeLineInfo();
+
+    const ascii_chunk = tb.lines.items[0].chunks.items[0];
+    const wide_chunk = tb.lines.items[1].chunks.items[0];
+    try std.testing.expect(ascii_chunk.chars == .ascii);
+    try std.testing.expect(wide_chunk.chars == .encoded);
+
+    // 16 ASCII cells at 1 byte, 5 encoded cells (2 wide chars + newline) at 4 bytes
+    try std.testing.expectEqual(@as(usize, 16 + 5 * 4), tb.getCharStorageBytes());
+
+    var out: [64]u8 = undefined;
+    const len = tb.getPlainTextIntoBuffer(&out);
+    try std.testing.expectEqualStrings("[info] build ok\n世界\n", out[0..len]);
+}
+
+test "TextBuffer storage - ASCII chunks wrap and select like encoded ones" {
+    const pool = gp.initGlobalPool(std.testing.allocator);
+    defer gp.deinitGlobalPool();
+
+    const gd = gp.initGlobalUnicodeData(std.testing.allocator);
+    defer gp.deinitGlobalUnicodeData(std.testing.allocator);
+    const graphemes_ptr, const display_width_ptr = gd;
+
+    var tb = try TextBuffer.init(std.testing.allocator, pool, .wcwidth, graphemes_ptr, display_width_ptr);
+    defer tb.deinit();
+
+    _ = try tb.writeChunk("alpha beta gamma", null, null, null);
+    tb.finalizeLineInfo();
+    tb.setWrapMode(.word);
+    tb.setWrapWidth(8);
+    try std.testing.expectEqual(@as(u32, 3), tb.getLineCount());
+
+    // Streaming through a 3 byte buffer resumes mid-chunk
+    tb.setSelection(2, 13, null, null);
+    var small_buf: [3]u8 = undefined;
+    var streamed: [32]u8 = undefined;
+    var streamed_len: usize = 0;
+    var from: u32 = 0;
+    while (from < 13) {
+        const chunk = tb.getSelectedTextChunk(&small_buf, from);
+        @memcpy(streamed[streamed_len .. streamed_len + chunk.written], small_buf[0..chunk.written]);
+        streamed_len += chunk.written;
+        from = chunk.next;
+    }
+    try std.testing.expectEqualStrings("pha beta ga", streamed[0..streamed_len]);
+}
+
 // ===== Word Wrapping Tests =====
 
 test "TextBuffer word wrapping - basic word wrap at space" {
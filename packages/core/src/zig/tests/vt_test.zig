@@ -0,0 +1,141 @@
+const std = @import("std");
+const buffer = @import("../buffer.zig");
+const gp = @import("../grapheme.zig");
+const vt = @import("../vt.zig");
+
+const Emulator = vt.Emulator;
+
+fn charAt(e: *Emulator, x: u32, y: u32) u32 {
+    const grid = if (e.on_alternate) e.alternate else e.primary;
+    return grid[@as(usize, y) * e.cols + x].char;
+}
+
+fn expectRow(e: *Emulator, y: u32, expected: []const u8) !void {
+    for (expected, 0..) |c, x| {
+        try std.testing.expectEqual(@as(u32, c), charAt(e, @intCast(x), y));
+    }
+}
+
+test "VT - wrapping and scrolling into the history" {
+    const gd = gp.initGlobalUnicodeData(std.testing.allocator);
+    defer gp.deinitGlobalUnicodeData(std.testing.allocator);
+    const display_width_ptr = gd[1];
+
+    const e = try Emulator.create(std.testing.allocator, 4, 2, 8, display_width_ptr);
+    defer e.destroy();
+
+    e.feed("abcdef\r\ngh");
+    // "abcd" scrolled off the top when "gh" needed a third row
+    try std.testing.expectEqual(@as(u32, 1), e.history_len);
+    try std.testing.expectEqualSlices(u8, "abcd", &[_]u8{
+        @intCast(e.history[0].char), @intCast(e.history[1].char),
+        @intCast(e.history[2].char), @intCast(e.history[3].char),
+    });
+    try expectRow(e, 0, "ef  ");
+    try expectRow(e, 1, "gh  ");
+    try std.testing.expectEqual(@as(u32, 2), e.cursor_x);
+    try std.testing.expectEqual(@as(u32, 1), e.cursor_y);
+}
+
+test "VT - cursor movement, erase and insert" {
+    const gd = gp.initGlobalUnicodeData(std.testing.allocator);
+    defer gp.deinitGlobalUnicodeData(std.testing.allocator);
+    const display_width_ptr = gd[1];
+
+    const e = try Emulator.create(std.testing.allocator, 6, 3, 0, display_width_ptr);
+    defer e.destroy();
+
+    e.feed("abcdef\x1b[2;3Hxy\x1b[1;2H\x1b[2@\x1b[3;1Hzz\x1b[1D\x1b[K");
+    try expectRow(e, 0, "a  bcd");
+    try expectRow(e, 1, "  xy  ");
+    try expectRow(e, 2, "z     ");
+
+    e.feed("\x1b[1;5H\x1b[1J\x1b[2;2H\x1b[2P");
+    try expectRow(e, 0, "     d");
+    try expectRow(e, 1, " y    ");
+}
+
+test "VT - scroll region, alternate screen and SGR" {
+    const gd = gp.initGlobalUnicodeData(std.testing.allocator);
+    defer gp.deinitGlobalUnicodeData(std.testing.allocator);
+    const display_width_ptr = gd[1];
+
+    const e = try Emulator.create(std.testing.allocator, 3, 4, 8, display_width_ptr);
+    defer e.destroy();
+
+    e.feed("a\r\nb\r\nc\r\nd\x1b[2;3r\x1b[3;1H\n\x1b[r");
+    // Only rows 2..3 scrolled, and nothing reached the history
+    try expectRow(e, 0, "a  ");
+    try expectRow(e, 1, "c  ");
+    try expectRow(e, 2, "   ");
+    try expectRow(e, 3, "d  ");
+    try std.testing.expectEqual(@as(u32, 0), e.history_len);
+
+    e.feed("\x1b[?1049h\x1b[31mX");
+    try std.testing.expect(e.on_alternate);
+    try expectRow(e, 0, "X  ");
+    try std.testing.expect(e.alternate[0].fg != 0);
+
+    e.feed("\x1b[?1049l");
+    try std.testing.expect(!e.on_alternate);
+    try expectRow(e, 0, "a  ");
+    try std.testing.expectEqual(@as(u32, 0), e.pen_fg);
+}
+
+test "VT - wide characters and line drawing" {
+    const gd = gp.initGlobalUnicodeData(std.testing.allocator);
+    defer gp.deinitGlobalUnicodeData(std.testing.allocator);
+    const display_width_ptr = gd[1];
+
+    const e = try Emulator.create(std.testing.allocator, 3, 2, 0, display_width_ptr);
+    defer e.destroy();
+
+    // A wide character that doesn't fit in the last column wraps whole
+    e.feed("ab\xe4\xb8\x96");
+    try std.testing.expectEqual(@as(u32, ' '), charAt(e, 2, 0));
+    try std.testing.expectEqual(@as(u32, 0x4E16), charAt(e, 0, 1));
+    try std.testing.expect(e.primary[3].wide);
+
+    // Overwriting the right half clears the left one
+    e.feed("\x1b[2;2Hx\x1b(0q\x1b(B");
+    try std.testing.expectEqual(@as(u32, ' '), charAt(e, 0, 1));
+    try std.testing.expectEqual(@as(u32, 'x'), charAt(e, 1, 1));
+    try std.testing.expectEqual(@as(u32, 0x2500), charAt(e, 2, 1));
+}
+
+test "VT - draw repaints only damaged rows" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const allocator = arena.allocator();
+
+    const pool = gp.initGlobalPool(allocator);
+    defer gp.deinitGlobalPool();
+    const gd = gp.initGlobalUnicodeData(allocator);
+    defer gp.deinitGlobalUnicodeData(allocator);
+    const graphemes_ptr, const display_width_ptr = gd;
+
+    var target = try buffer.OptimizedBuffer.init(allocator, 4, 3, .{ .pool = pool }, graphemes_ptr, display_width_ptr);
+    defer target.deinit();
+
+    const e = try Emulator.create(allocator, 4, 3, 0, display_width_ptr);
+    defer e.destroy();
+
+    e.feed("one\r\ntwo");
+    try std.testing.expect(e.hasDamage());
+    try e.draw(target, 0, 0, false, false);
+    try std.testing.expectEqual(@as(u32, 3), e.stats.drawn_rows);
+    try std.testing.expectEqual(@as(u32, 't'), target.get(0, 1).?.char);
+    try std.testing.expect(!e.hasDamage());
+
+    e.feed("\x1b[3;1Hz");
+    try e.draw(target, 0, 0, false, false);
+    try std.testing.expectEqual(@as(u32, 1), e.stats.drawn_rows);
+    try std.testing.expectEqual(@as(u32, 'z'), target.get(0, 2).?.char);
+
+    // Moving the shown cursor repaints the rows it left and entered
+    e.feed("\x1b[1;1H");
+    try e.draw(target, 0, 0, false, true);
+    try std.testing.expectEqual(@as(u32, 1), e.stats.drawn_rows);
+    try e.draw(target, 0, 0, true, true);
+    try std.testing.expectEqual(@as(u32, 3), e.stats.drawn_rows);
+}
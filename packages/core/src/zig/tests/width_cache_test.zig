@@ -0,0 +1,54 @@
+const std = @import("std");
+const gp = @import("../grapheme.zig");
+const gwidth = @import("../gwidth.zig");
+const width_cache = @import("../width_cache.zig");
+
+test "width cache - hits return the same width as gwidth" {
+    const gd = gp.initGlobalUnicodeData(std.testing.allocator);
+    defer gp.deinitGlobalUnicodeData(std.testing.allocator);
+    const graphemes_ptr, const display_width_ptr = gd;
+    _ = graphemes_ptr;
+
+    width_cache.clear();
+    width_cache.resetStats();
+
+    const clusters = [_][]const u8{ "a", "中", "│", "\xE2\x9D\xA4\xEF\xB8\x8F", "👋🏿" };
+    for ([_]gwidth.WidthMethod{ .wcwidth, .unicode }) |method| {
+        for (0..2) |_| {
+            for (clusters) |cluster| {
+                const expected = gwidth.gwidth(cluster, method, display_width_ptr);
+                try std.testing.expectEqual(expected, width_cache.clusterWidth(cluster, method, display_width_ptr));
+            }
+        }
+    }
+
+    // First pass per method misses, second pass hits; the 8-byte emoji
+    // sequence is never cached
+    const stats = width_cache.getStats();
+    try std.testing.expectEqual(@as(u64, 8), stats.misses);
+    try std.testing.expectEqual(@as(u64, 8), stats.hits);
+    try std.testing.expectEqual(@as(u64, 4), stats.uncached);
+}
+
+test "width cache - methods do not share entries" {
+    const gd = gp.initGlobalUnicodeData(std.testing.allocator);
+    defer gp.deinitGlobalUnicodeData(std.testing.allocator);
+    const graphemes_ptr, const display_width_ptr = gd;
+    _ = graphemes_ptr;
+
+    width_cache.clear();
+    const heart = "\xE2\x9D\xA4\xEF\xB8\x8F";
+    try std.testing.expectEqual(@as(u16, 1), width_cache.clusterWidth(heart, .wcwidth, display_width_ptr));
+    try std.testing.expectEqual(@as(u16, 2), width_cache.clusterWidth(heart, .unicode, display_width_ptr));
+    try std.testing.expectEqual(@as(u16, 1), width_cache.clusterWidth(heart, .wcwidth, display_width_ptr));
+}
+
+test "width cache - textWidth sums clusters" {
+    const gd = gp.initGlobalUnicodeData(std.testing.allocator);
+    defer gp.deinitGlobalUnicodeData(std.testing.allocator);
+    const graphemes_ptr, const display_width_ptr = gd;
+
+    try std.testing.expectEqual(@as(u32, 0), width_cache.textWidth("", .unicode, graphemes_ptr, display_width_ptr));
+    try std.testing.expectEqual(@as(u32, 8), width_cache.textWidth("ab中文│x", .unicode, graphemes_ptr, display_width_ptr));
+    try std.testing.expectEqual(@as(u32, 4), width_cache.textWidth("👩‍🚀ok", .unicode, graphemes_ptr, display_width_ptr));
+}
@@ -5,6 +5,9 @@ const Graphemes = @import("Graphemes");
 const DisplayWidth = @import("DisplayWidth");
 const gp = @import("grapheme.zig");
 const gwidth = @import("gwidth.zig");
+const width_cache = @import("width_cache.zig");
+const sgr = @import("sgr.zig");
+const text_search = @import("search.zig");
 const logger = @import("logger.zig");
 
 pub const RGBA = buffer.RGBA;
@@ -32,9 +35,64 @@ pub const ChunkFitResult = struct {
     width: u32,
 };
 
+/// Half-open range of virtual line rows [start, end)
+pub const RowRange = struct {
+    start: u32,
+    end: u32,
+};
+
+/// Result of a chunked selected-text read
+/// `next` is the char offset to resume from, equal to the selection end once everything was written
+pub const SelectedTextChunk = struct {
+    written: usize,
+    next: u32,
+};
+
+/// Cell storage of a chunk, one entry per cell in either form.
+/// Pure ASCII chunks (the common case for logs) keep one byte per cell;
+/// chunks with graphemes or wide characters keep the encoded u32 form.
+/// Hot loops switch once per chunk and run on the native element type.
+pub const ChunkChars = union(enum) {
+    ascii: []u8,
+    encoded: []u32,
+
+    pub fn len(self: ChunkChars) usize {
+        return switch (self) {
+            inline else => |cells| cells.len,
+        };
+    }
+
+    pub fn at(self: ChunkChars, index: usize) u32 {
+        return switch (self) {
+            inline else => |cells| cells[index],
+        };
+    }
+
+    pub fn slice(self: ChunkChars, start: usize, end: usize) ChunkChars {
+        return switch (self) {
+            .ascii => |cells| .{ .ascii = cells[start..end] },
+            .encoded => |cells| .{ .encoded = cells[start..end] },
+        };
+    }
+
+    pub fn byteSize(self: ChunkChars) usize {
+        return switch (self) {
+            inline else => |cells| std.mem.sliceAsBytes(cells).len,
+        };
+    }
+};
+
+/// A char range painted over the chunk colors, such as a search match
+pub const Highlight = struct {
+    start: u32,
+    end: u32,
+    fg: ?RGBA,
+    bg: RGBA,
+};
+
 /// A chunk represents a contiguous sequence of characters with the same styling
 pub const TextChunk = struct {
-    chars: []u32, // Chunk owns its character data
+    chars: ChunkChars, // Chunk owns its character data
     fg: ?RGBA,
     bg: ?RGBA,
     attributes: u16,
@@ -80,9 +138,9 @@ pub const VirtualChunk = struct {
     char_count: u32,
     width: u32,
 
-    pub fn getChars(self: *const VirtualChunk, text_buffer: *const TextBuffer) []const u32 {
+    pub fn getChars(self: *const VirtualChunk, text_buffer: *const TextBuffer) ChunkChars {
         const chunk = &text_buffer.lines.items[self.source_line].chunks.items[self.source_chunk];
-        return chunk.chars[self.char_start .. self.char_start + self.char_count];
+        return chunk.chars.slice(self.char_start, self.char_start + self.char_count);
     }
 
     pub fn getStyle(self: *const VirtualChunk, text_buffer: *const TextBuffer) struct {
@@ -150,6 +208,7 @@ pub const TextBuffer = struct {
     char_count: u32, // Total character count across all chunks
     selection: ?TextSelection,
     local_selection: ?LocalSelection,
+    selection_dirty_rows: ?RowRange, // Rows whose selection state changed since last taken
     default_fg: ?RGBA,
     default_bg: ?RGBA,
     default_attributes: ?u8,
@@ -180,6 +239,16 @@ pub const TextBuffer = struct {
     display_width: DisplayWidth,
     grapheme_tracker: gp.GraphemeTracker,
     width_method: gwidth.WidthMethod,
+    /// Style and escape state carried between writeAnsi calls
+    ansi_state: sgr.SgrParser,
+    /// Sorted, non-overlapping ranges drawn with their own colors; a
+    /// selection still wins where both apply
+    highlights: std.ArrayListUnmanaged(Highlight),
+    /// Created by the first search and kept across resets
+    search: ?*text_search.TextSearch,
+    /// Bumped by every edit other than appending, so state derived from the
+    /// text (search matches) can tell it is stale
+    edit_generation: u32,
 
     pub fn init(global_allocator: Allocator, pool: *gp.GraphemePool, width_method: gwidth.WidthMethod, graphemes_data: *Graphemes, display_width: *DisplayWidth) TextBufferError!*TextBuffer {
         const self = global_allocator.create(TextBuffer) catch return TextBufferError.OutOfMemory;
@@ -232,6 +301,7 @@ pub const TextBuffer = struct {
             .char_count = 0,
             .selection = null,
             .local_selection = null,
+            .selection_dirty_rows = null,
             .default_fg = null,
             .default_bg = null,
             .default_attributes = null,
@@ -255,12 +325,18 @@ pub const TextBuffer = struct {
             .display_width = dw,
             .grapheme_tracker = gp.GraphemeTracker.init(global_allocator, pool),
             .width_method = width_method,
+            .ansi_state = .{},
+            .highlights = .{},
+            .search = null,
+            .edit_generation = 0,
         };
 
         return self;
     }
 
     pub fn deinit(self: *TextBuffer) void {
+        if (self.search) |search| search.destroy();
+        self.highlights.deinit(self.global_allocator);
         self.grapheme_tracker.deinit();
         self.virtual_lines_arena.deinit();
         self.arena.deinit();
@@ -284,6 +360,7 @@ pub const TextBuffer = struct {
         self.current_line_width = 0;
         self.local_selection = null;
         self.selection = null;
+        self.selection_dirty_rows = null;
 
         self.lines = .{};
         self.chunk_groups = .{};
@@ -293,21 +370,27 @@ pub const TextBuffer = struct {
         self.cached_max_width = 0;
         // wrap_width is preserved across resets
         self.virtual_lines_dirty = true;
+        self.ansi_state.reset();
+        self.highlights.clearRetainingCapacity();
+        self.edit_generation +%= 1;
 
         const first_line = TextLine.init();
         self.lines.append(self.allocator, first_line) catch {};
     }
 
     pub fn setSelection(self: *TextBuffer, start: u32, end: u32, bgColor: ?RGBA, fgColor: ?RGBA) void {
-        self.selection = TextSelection{
+        const new_selection = TextSelection{
             .start = start,
             .end = end,
             .bgColor = bgColor,
             .fgColor = fgColor,
         };
+        self.markSelectionDirty(self.selection, new_selection);
+        self.selection = new_selection;
     }
 
     pub fn resetSelection(self: *TextBuffer) void {
+        self.markSelectionDirty(self.selection, null);
         self.selection = null;
     }
 
@@ -315,6 +398,28 @@ pub const TextBuffer = struct {
         return self.selection;
     }
 
+    /// Replace the highlighted ranges; they must be sorted and must not
+    /// overlap. The rows they cover are reported by takeSelectionDirtyRows.
+    pub fn setHighlights(self: *TextBuffer, ranges: []const Highlight) TextBufferError!void {
+        const old = self.highlights.items;
+        if (old.len > 0) self.markCharRangeDirty(old[0].start, old[old.len - 1].end);
+        self.highlights.clearRetainingCapacity();
+        self.highlights.appendSlice(self.global_allocator, ranges) catch return TextBufferError.OutOfMemory;
+        if (ranges.len > 0) self.markCharRangeDirty(ranges[0].start, ranges[ranges.len - 1].end);
+    }
+
+    pub fn clearHighlights(self: *TextBuffer) void {
+        self.setHighlights(&.{}) catch {};
+    }
+
+    /// The buffer's search, created on first use
+    pub fn getSearch(self: *TextBuffer) TextBufferError!*text_search.TextSearch {
+        if (self.search) |search| return search;
+        const created = text_search.TextSearch.create(self.global_allocator, self) catch return TextBufferError.OutOfMemory;
+        self.search = created;
+        return created;
+    }
+
     pub fn setDefaultFg(self: *TextBuffer, fg: ?RGBA) void {
         self.default_fg = fg;
     }
@@ -351,7 +456,8 @@ pub const TextBuffer = struct {
 
     /// Calculate how many characters from a chunk fit within the given width
     /// Returns the number of characters and their total width
-    fn calculateChunkFit(_: *const TextBuffer, chars: []const u32, max_width: u32) ChunkFitResult {
+    /// `chars` is a cell slice of either storage form ([]u8 or []u32)
+    fn calculateChunkFit(_: *const TextBuffer, chars: anytype, max_width: u32) ChunkFitResult {
         if (max_width == 0) return .{ .char_count = 0, .width = 0 };
         if (chars.len == 0) return .{ .char_count = 0, .width = 0 };
 
@@ -404,7 +510,7 @@ pub const TextBuffer = struct {
 
     /// Calculate how many characters from a chunk fit within the given width (word wrapping)
     /// Returns the number of characters and their total width
-    fn calculateChunkFitWord(self: *const TextBuffer, chars: []const u32, max_width: u32) ChunkFitResult {
+    fn calculateChunkFitWord(self: *const TextBuffer, chars: anytype, max_width: u32) ChunkFitResult {
         if (max_width == 0) return .{ .char_count = 0, .width = 0 };
         if (chars.len == 0) return .{ .char_count = 0, .width = 0 };
 
@@ -481,14 +587,15 @@ pub const TextBuffer = struct {
     }
 
     /// Calculate the visual width of a chunk of characters
-    fn calculateChunkWidth(_: *const TextBuffer, chars: []const u32) u32 {
-        if (chars.len == 0) return 0;
+    fn calculateChunkWidth(_: *const TextBuffer, chars: ChunkChars) u32 {
+        const len = chars.len();
+        if (len == 0) return 0;
 
-        if (chars[chars.len - 1] == '\n') {
-            return @intCast(chars.len - 1);
+        if (chars.at(len - 1) == '\n') {
+            return @intCast(len - 1);
         }
 
-        return @intCast(chars.len);
+        return @intCast(len);
     }
 
     /// Update virtual lines based on current wrap width
@@ -515,7 +622,7 @@ pub const TextBuffer = struct {
                         .source_line = line_idx,
                         .source_chunk = chunk_idx,
                         .char_start = 0,
-                        .char_count = @intCast(chunk.chars.len),
+                        .char_count = @intCast(chunk.chars.len()),
                         .width = self.calculateChunkWidth(chunk.chars),
                     }) catch {};
                 }
@@ -538,13 +645,13 @@ pub const TextBuffer = struct {
 
                 for (line.chunks.items, 0..) |*chunk, chunk_idx| {
                     var chunk_pos: u32 = 0;
+                    const chunk_len = chunk.chars.len();
 
-                    while (chunk_pos < chunk.chars.len) {
+                    while (chunk_pos < chunk_len) {
                         const remaining_width = if (line_position < wrap_w) wrap_w - line_position else 0;
-                        const remaining_chars = chunk.chars[chunk_pos..];
 
                         // Check if this is a newline at the start
-                        if (remaining_chars.len > 0 and remaining_chars[0] == '\n') {
+                        if (chunk.chars.at(chunk_pos) == '\n') {
                             // Add the newline to current line and start a new line
                             current_vline.chunks.append(virtual_allocator, VirtualChunk{
                                 .source_line = line_idx,
@@ -571,9 +678,11 @@ pub const TextBuffer = struct {
                             continue;
                         }
 
-                        const fit_result = switch (self.wrap_mode) {
-                            .char => self.calculateChunkFit(remaining_chars, remaining_width),
-                            .word => self.calculateChunkFitWord(remaining_chars, remaining_width),
+                        const fit_result = switch (chunk.chars) {
+                            inline else => |cells| switch (self.wrap_mode) {
+                                .char => self.calculateChunkFit(cells[chunk_pos..], remaining_width),
+                                .word => self.calculateChunkFitWord(cells[chunk_pos..], remaining_width),
+                            },
                         };
 
                         // If nothing fits and we have content on the line, wrap to next line
@@ -612,7 +721,7 @@ pub const TextBuffer = struct {
                         line_position += fit_result.width;
 
                         // Check if we need to wrap
-                        if (line_position >= wrap_w and chunk_pos < chunk.chars.len) {
+                        if (line_position >= wrap_w and chunk_pos < chunk_len) {
                             current_vline.width = line_position;
                             self.virtual_lines.append(virtual_allocator, current_vline) catch {};
                             self.cached_line_starts.append(virtual_allocator, current_vline.char_offset) catch {};
@@ -683,6 +792,7 @@ pub const TextBuffer = struct {
         // Temporary buffer to collect characters for current chunk
         var chunk_chars = std.ArrayList(u32).init(self.allocator);
         defer chunk_chars.deinit();
+        var chunk_is_ascii = true;
 
         var current_chunk_width: u32 = 0;
 
@@ -695,12 +805,13 @@ pub const TextBuffer = struct {
             var encoded_char: u32 = 0;
             var is_newline: bool = false;
 
-            if (bytes.len == 1 and bytes[0] == '\n') {
+            // CRLF is a single grapheme cluster; it ends the line like LF
+            if (std.mem.eql(u8, bytes, "\n") or std.mem.eql(u8, bytes, "\r\n")) {
                 required = 1;
                 is_newline = true;
                 encoded_char = '\n';
             } else {
-                const width_u16: u16 = gwidth.gwidth(bytes, self.width_method, &self.display_width);
+                const width_u16: u16 = width_cache.clusterWidth(bytes, self.width_method, &self.display_width);
                 if (width_u16 == 0) {
                     // zero-width/control cluster: skip
                     continue;
@@ -710,7 +821,9 @@ pub const TextBuffer = struct {
 
                 if (bytes.len == 1 and width == 1 and bytes[0] >= 32) {
                     encoded_char = @as(u32, bytes[0]);
+                    if (bytes[0] >= 0x80) chunk_is_ascii = false;
                 } else {
+                    chunk_is_ascii = false;
                     const gid = self.pool.alloc(bytes) catch return TextBufferError.OutOfMemory;
                     encoded_char = gp.packGraphemeStart(gid & gp.GRAPHEME_ID_MASK, width);
                     self.grapheme_tracker.add(gid);
@@ -737,12 +850,8 @@ pub const TextBuffer = struct {
 
             if (is_newline) {
                 if (chunk_chars.items.len > 0) {
-                    // Allocate permanent storage for chunk chars from arena
-                    const chunk_data = self.allocator.alloc(u32, chunk_chars.items.len) catch return TextBufferError.OutOfMemory;
-                    @memcpy(chunk_data, chunk_chars.items);
-
                     const chunk = TextChunk{
-                        .chars = chunk_data,
+                        .chars = try self.allocChunkChars(chunk_chars.items, chunk_is_ascii),
                         .fg = fg,
                         .bg = bg,
                         .attributes = attrValue,
@@ -757,6 +866,7 @@ pub const TextBuffer = struct {
                     }
 
                     chunk_chars.clearRetainingCapacity();
+                    chunk_is_ascii = true;
                     current_chunk_width = 0;
                 }
 
@@ -783,12 +893,8 @@ pub const TextBuffer = struct {
 
         // Create final chunk if there's remaining content
         if (chunk_chars.items.len > 0) {
-            // Allocate permanent storage for chunk chars from arena
-            const chunk_data = self.allocator.alloc(u32, chunk_chars.items.len) catch return TextBufferError.OutOfMemory;
-            @memcpy(chunk_data, chunk_chars.items);
-
             const chunk = TextChunk{
-                .chars = chunk_data,
+                .chars = try self.allocChunkChars(chunk_chars.items, chunk_is_ascii),
                 .fg = fg,
                 .bg = bg,
                 .attributes = attrValue,
@@ -808,6 +914,35 @@ pub const TextBuffer = struct {
         return cellCount << 1;
     }
 
+    /// Append raw terminal output, turning SGR sequences into chunk styles.
+    /// Other escape sequences are dropped. Parser state carries over to the
+    /// next call, so output can be fed in whatever slices it arrives in.
+    pub fn writeAnsi(self: *TextBuffer, bytes: []const u8) TextBufferError!void {
+        try self.ansi_state.feed(self, bytes);
+    }
+
+    /// Allocate permanent storage for chunk chars from arena, narrowed to
+    /// one byte per cell when every cell is plain ASCII
+    fn allocChunkChars(self: *TextBuffer, cells: []const u32, is_ascii: bool) TextBufferError!ChunkChars {
+        if (is_ascii) {
+            const data = self.allocator.alloc(u8, cells.len) catch return TextBufferError.OutOfMemory;
+            for (data, cells) |*dst, c| dst.* = @intCast(c);
+            return .{ .ascii = data };
+        }
+        const data = self.allocator.alloc(u32, cells.len) catch return TextBufferError.OutOfMemory;
+        @memcpy(data, cells);
+        return .{ .encoded = data };
+    }
+
+    /// Bytes used by cell storage across all chunks (excluding chunk headers)
+    pub fn getCharStorageBytes(self: *const TextBuffer) usize {
+        var total: usize = 0;
+        for (self.lines.items) |line| {
+            for (line.chunks.items) |chunk| total += chunk.chars.byteSize();
+        }
+        return total;
+    }
+
     pub fn finalizeLineInfo(self: *TextBuffer) void {
         // Update the final line's width
         if (self.current_line < self.lines.items.len) {
@@ -878,11 +1013,13 @@ pub const TextBuffer = struct {
                 selection_changed = true;
             }
 
+            self.markSelectionDirty(self.selection, new_selection);
             self.selection = new_selection;
         } else {
             if (self.selection != null) {
                 selection_changed = true;
             }
+            self.markSelectionDirty(self.selection, null);
             self.selection = null;
         }
 
@@ -890,10 +1027,105 @@ pub const TextBuffer = struct {
     }
 
     pub fn resetLocalSelection(self: *TextBuffer) void {
+        self.markSelectionDirty(self.selection, null);
         self.local_selection = null;
         self.selection = null;
     }
 
+    /// Returns the rows whose selection state changed since the last call and clears them
+    /// Callers use this to repaint only those rows while a drag is in progress
+    pub fn takeSelectionDirtyRows(self: *TextBuffer) ?RowRange {
+        const rows = self.selection_dirty_rows;
+        self.selection_dirty_rows = null;
+        return rows;
+    }
+
+    /// Format: [start:u32][end:u32] packed into u64, then clears the dirty rows
+    /// If no rows changed, returns 0xFFFFFFFF_FFFFFFFF (all bits set)
+    pub fn packSelectionDirtyRows(self: *TextBuffer) u64 {
+        if (self.takeSelectionDirtyRows()) |rows| {
+            return (@as(u64, rows.start) << 32) | @as(u64, rows.end);
+        } else {
+            return 0xFFFF_FFFF_FFFF_FFFF;
+        }
+    }
+
+    /// Accumulate the rows affected by a selection change
+    /// Only the char ranges that differ between old and new are marked, so extending a drag by
+    /// one cell touches one or two rows regardless of how large the selection is
+    fn markSelectionDirty(self: *TextBuffer, old: ?TextSelection, new: ?TextSelection) void {
+        const old_sel = old orelse {
+            if (new) |new_sel| self.markCharRangeDirty(new_sel.start, new_sel.end);
+            return;
+        };
+        const new_sel = new orelse {
+            self.markCharRangeDirty(old_sel.start, old_sel.end);
+            return;
+        };
+
+        if (!std.meta.eql(old_sel.bgColor, new_sel.bgColor) or !std.meta.eql(old_sel.fgColor, new_sel.fgColor)) {
+            self.markCharRangeDirty(old_sel.start, old_sel.end);
+            self.markCharRangeDirty(new_sel.start, new_sel.end);
+            return;
+        }
+
+        self.markCharRangeDirty(@min(old_sel.start, new_sel.start), @max(old_sel.start, new_sel.start));
+        self.markCharRangeDirty(@min(old_sel.end, new_sel.end), @max(old_sel.end, new_sel.end));
+    }
+
+    fn markCharRangeDirty(self: *TextBuffer, start: u32, end: u32) void {
+        if (start >= end) return;
+
+        self.updateVirtualLines();
+        if (self.cached_line_starts.items.len == 0) return;
+
+        const first_row: u32 = @intCast(self.findVirtualLineForChar(start));
+        const last_row: u32 = @intCast(self.findVirtualLineForChar(end - 1));
+        const rows = RowRange{ .start = first_row, .end = last_row + 1 };
+
+        self.selection_dirty_rows = if (self.selection_dirty_rows) |dirty| RowRange{
+            .start = @min(dirty.start, rows.start),
+            .end = @max(dirty.end, rows.end),
+        } else rows;
+    }
+
+    /// Binary search the cached virtual line starts for the row containing a char offset
+    /// Offsets past the end map to the last row
+    pub fn findVirtualLineForChar(self: *const TextBuffer, offset: u32) usize {
+        const starts = self.cached_line_starts.items;
+        if (starts.len == 0) return 0;
+
+        var lo: usize = 0;
+        var hi: usize = starts.len;
+        while (hi - lo > 1) {
+            const mid = lo + (hi - lo) / 2;
+            if (starts[mid] <= offset) {
+                lo = mid;
+            } else {
+                hi = mid;
+            }
+        }
+        return lo;
+    }
+
+    /// Binary search the real lines for the line containing a char offset
+    pub fn findLineForChar(self: *const TextBuffer, offset: u32) usize {
+        const lines = self.lines.items;
+        if (lines.len == 0) return 0;
+
+        var lo: usize = 0;
+        var hi: usize = lines.len;
+        while (hi - lo > 1) {
+            const mid = lo + (hi - lo) / 2;
+            if (lines[mid].char_offset <= offset) {
+                lo = mid;
+            } else {
+                hi = mid;
+            }
+        }
+        return lo;
+    }
+
     /// Calculate character positions from local selection coordinates
     /// Returns null if no valid selection
     fn calculateMultiLineSelection(self: *TextBuffer) ?struct { start: u32, end: u32 } {
@@ -902,8 +1134,8 @@ pub const TextBuffer = struct {
 
         self.updateVirtualLines();
 
-        var selectionStart: ?u32 = null;
-        var selectionEnd: ?u32 = null;
+        const line_count = self.cached_line_starts.items.len;
+        if (line_count == 0) return null;
 
         const startY = @min(local_sel.anchorY, local_sel.focusY);
         const endY = @max(local_sel.anchorY, local_sel.focusY);
@@ -922,44 +1154,39 @@ pub const TextBuffer = struct {
             selEndX = local_sel.anchorX;
         }
 
-        for (self.virtual_lines.items, 0..) |vline, i| {
-            const lineY = @as(i32, @intCast(i));
-
-            if (lineY < startY or lineY > endY) continue;
-
-            const lineStart = vline.char_offset;
-            const lineWidth = vline.width;
-            const lineEnd = if (i < self.virtual_lines.items.len - 1)
-                self.virtual_lines.items[i + 1].char_offset - 1
-            else
-                lineStart + lineWidth;
-
-            if (lineY > startY and lineY < endY) {
-                // Entire line is selected
-                if (selectionStart == null) selectionStart = lineStart;
-                selectionEnd = lineEnd;
-            } else if (lineY == startY and lineY == endY) {
-                // Selection starts and ends on this line
-                const localStartX = @max(0, @min(selStartX, @as(i32, @intCast(lineWidth))));
-                const localEndX = @max(0, @min(selEndX, @as(i32, @intCast(lineWidth))));
-                if (localStartX != localEndX) {
-                    selectionStart = lineStart + @as(u32, @intCast(localStartX));
-                    selectionEnd = lineStart + @as(u32, @intCast(localEndX));
-                }
-            } else if (lineY == startY) {
-                // Selection starts on this line
-                const localStartX = @max(0, @min(selStartX, @as(i32, @intCast(lineWidth))));
-                if (localStartX < lineWidth) {
-                    selectionStart = lineStart + @as(u32, @intCast(localStartX));
-                    selectionEnd = lineEnd;
-                }
-            } else if (lineY == endY) {
-                // Selection ends on this line
-                const localEndX = @max(0, @min(selEndX, @as(i32, @intCast(lineWidth))));
-                if (localEndX > 0) {
-                    if (selectionStart == null) selectionStart = lineStart;
-                    selectionEnd = lineStart + @as(u32, @intCast(localEndX));
-                }
+        const firstY = @max(startY, 0);
+        const lastY = @min(endY, @as(i32, @intCast(line_count - 1)));
+        if (firstY > lastY) return null;
+
+        if (startY == endY) {
+            // Selection starts and ends on this line
+            const row: usize = @intCast(startY);
+            const lineStart = self.cached_line_starts.items[row];
+            const lineWidth = self.cached_line_widths.items[row];
+            const localStartX = @max(0, @min(selStartX, @as(i32, @intCast(lineWidth))));
+            const localEndX = @max(0, @min(selEndX, @as(i32, @intCast(lineWidth))));
+            if (localStartX >= localEndX) return null;
+            return .{
+                .start = lineStart + @as(u32, @intCast(localStartX)),
+                .end = lineStart + @as(u32, @intCast(localEndX)),
+            };
+        }
+
+        // Rows strictly between startY and endY are fully selected, so only the rows at either
+        // end need coordinate mapping. Walk inward from each end until a row contributes.
+        var selectionStart: ?u32 = null;
+        var y = firstY;
+        while (y <= lastY and selectionStart == null) : (y += 1) {
+            if (self.rowSelectionSpan(@intCast(y), startY, endY, selStartX, selEndX)) |span| {
+                selectionStart = span.start;
+            }
+        }
+
+        var selectionEnd: ?u32 = null;
+        y = lastY;
+        while (y >= firstY and selectionEnd == null) : (y -= 1) {
+            if (self.rowSelectionSpan(@intCast(y), startY, endY, selStartX, selEndX)) |span| {
+                selectionEnd = span.end;
             }
         }
 
@@ -969,59 +1196,107 @@ pub const TextBuffer = struct {
             null;
     }
 
+    /// Char span a single virtual line contributes to a multi-line selection, if any
+    fn rowSelectionSpan(self: *const TextBuffer, row: usize, startY: i32, endY: i32, selStartX: i32, selEndX: i32) ?struct { start: u32, end: u32 } {
+        const starts = self.cached_line_starts.items;
+        const lineY = @as(i32, @intCast(row));
+        const lineStart = starts[row];
+        const lineWidth = self.cached_line_widths.items[row];
+        const lineEnd = if (row < starts.len - 1)
+            starts[row + 1] - 1
+        else
+            lineStart + lineWidth;
+
+        if (lineY == startY) {
+            // Selection starts on this line
+            const localStartX = @max(0, @min(selStartX, @as(i32, @intCast(lineWidth))));
+            if (localStartX >= lineWidth) return null;
+            return .{ .start = lineStart + @as(u32, @intCast(localStartX)), .end = lineEnd };
+        }
+
+        if (lineY == endY) {
+            // Selection ends on this line
+            const localEndX = @max(0, @min(selEndX, @as(i32, @intCast(lineWidth))));
+            if (localEndX <= 0) return null;
+            return .{ .start = lineStart, .end = lineStart + @as(u32, @intCast(localEndX)) };
+        }
+
+        // Entire line is selected
+        return .{ .start = lineStart, .end = lineEnd };
+    }
+
     /// Extract selected text as UTF-8 bytes from the char buffer into provided output buffer
     /// Returns the number of bytes written to the output buffer
     pub fn getSelectedTextIntoBuffer(self: *const TextBuffer, out_buffer: []u8) usize {
         const selection = self.selection orelse return 0;
-        const start = selection.start;
+        return self.getSelectedTextChunk(out_buffer, selection.start).written;
+    }
+
+    /// Extract selected text starting at char offset `from` into the output buffer
+    /// Only whole characters are written; when the buffer fills up, `next` is the offset to pass
+    /// on the following call, so huge selections can be streamed through a small fixed buffer.
+    /// The start line is found by binary search, so each call only walks the chars it emits.
+    pub fn getSelectedTextChunk(self: *const TextBuffer, out_buffer: []u8, from: u32) SelectedTextChunk {
+        const selection = self.selection orelse return .{ .written = 0, .next = from };
+        const start = @max(from, selection.start);
         const end = selection.end;
+        if (start >= end) return .{ .written = 0, .next = end };
 
         var out_index: usize = 0;
-        var count: u32 = 0;
 
-        // Iterate through all lines and chunks, similar to rendering
-        for (self.lines.items) |line| {
+        for (self.lines.items[self.findLineForChar(start)..]) |line| {
+            var pos = line.char_offset;
+            if (pos >= end) break;
+
             for (line.chunks.items) |chunk| {
-                var chunk_char_index: u32 = 0;
-                while (chunk_char_index < chunk.chars.len and count < end and out_index < out_buffer.len) : (chunk_char_index += 1) {
-                    const c = chunk.chars[chunk_char_index];
+                const chunk_len: u32 = @intCast(chunk.chars.len());
+                if (pos + chunk_len <= start) {
+                    pos += chunk_len;
+                    continue;
+                }
 
-                    if (!gp.isContinuationChar(c)) {
-                        if (count >= start) {
-                            if (gp.isGraphemeChar(c)) {
-                                const gid = gp.graphemeIdFromChar(c);
-                                const grapheme_bytes = self.pool.get(gid) catch continue;
-                                const copy_len = @min(grapheme_bytes.len, out_buffer.len - out_index);
-                                @memcpy(out_buffer[out_index .. out_index + copy_len], grapheme_bytes[0..copy_len]);
-                                out_index += copy_len;
-                            } else {
-                                var utf8_buf: [4]u8 = undefined;
-                                const utf8_len = std.unicode.utf8Encode(@intCast(c), &utf8_buf) catch 1;
-                                const copy_len = @min(utf8_len, out_buffer.len - out_index);
-                                @memcpy(out_buffer[out_index .. out_index + copy_len], utf8_buf[0..copy_len]);
-                                out_index += copy_len;
-                            }
-                        }
-                        count += 1;
+                var chunk_char_index: u32 = if (start > pos) start - pos else 0;
+
+                // ASCII cells are their own UTF-8 bytes, copy the whole range
+                if (chunk.chars == .ascii) {
+                    if (pos >= end) return .{ .written = out_index, .next = end };
+                    const range_end = @min(chunk_len, end - pos);
+                    const count = @min(range_end - chunk_char_index, out_buffer.len - out_index);
+                    @memcpy(out_buffer[out_index .. out_index + count], chunk.chars.ascii[chunk_char_index .. chunk_char_index + count]);
+                    out_index += count;
+                    chunk_char_index += @intCast(count);
+                    if (chunk_char_index < range_end) return .{ .written = out_index, .next = pos + chunk_char_index };
+                    if (range_end < chunk_len) return .{ .written = out_index, .next = end };
+                    pos += chunk_len;
+                    continue;
+                }
 
-                        // Skip continuation characters for graphemes
-                        if (gp.isGraphemeChar(c)) {
-                            const right_extent = gp.charRightExtent(c);
-                            var k: u32 = 0;
-                            while (k < right_extent and chunk_char_index + 1 < chunk.chars.len) : (k += 1) {
-                                chunk_char_index += 1;
-                                // Verify the continuation character exists
-                                if (chunk_char_index >= chunk.chars.len or !gp.isContinuationChar(chunk.chars[chunk_char_index])) {
-                                    break;
-                                }
-                            }
-                        }
+                while (chunk_char_index < chunk_len) : (chunk_char_index += 1) {
+                    const char_pos = pos + chunk_char_index;
+                    if (char_pos >= end) return .{ .written = out_index, .next = end };
+
+                    const c = chunk.chars.encoded[chunk_char_index];
+                    if (gp.isContinuationChar(c)) continue;
+
+                    var utf8_buf: [4]u8 = undefined;
+                    const char_bytes: []const u8 = if (gp.isGraphemeChar(c))
+                        self.pool.get(gp.graphemeIdFromChar(c)) catch continue
+                    else blk: {
+                        const utf8_len = std.unicode.utf8Encode(@intCast(c), &utf8_buf) catch 1;
+                        break :blk utf8_buf[0..utf8_len];
+                    };
+
+                    if (char_bytes.len > out_buffer.len - out_index) {
+                        return .{ .written = out_index, .next = char_pos };
                     }
+                    @memcpy(out_buffer[out_index .. out_index + char_bytes.len], char_bytes);
+                    out_index += char_bytes.len;
                 }
+                pos += chunk_len;
             }
         }
 
-        return out_index;
+        return .{ .written = out_index, .next = end };
     }
 
     /// Extract all text as UTF-8 bytes from the char buffer into provided output buffer
@@ -1032,9 +1307,18 @@ pub const TextBuffer = struct {
         // Iterate through all lines and chunks, similar to rendering
         for (self.lines.items) |line| {
             for (line.chunks.items) |chunk| {
+                const chars = switch (chunk.chars) {
+                    .ascii => |bytes| {
+                        const count = @min(bytes.len, out_buffer.len - out_index);
+                        @memcpy(out_buffer[out_index .. out_index + count], bytes[0..count]);
+                        out_index += count;
+                        continue;
+                    },
+                    .encoded => |cells| cells,
+                };
                 var chunk_char_index: u32 = 0;
-                while (chunk_char_index < chunk.chars.len and out_index < out_buffer.len) : (chunk_char_index += 1) {
-                    const c = chunk.chars[chunk_char_index];
+                while (chunk_char_index < chars.len and out_index < out_buffer.len) : (chunk_char_index += 1) {
+                    const c = chars[chunk_char_index];
 
                     if (!gp.isContinuationChar(c)) {
                         if (gp.isGraphemeChar(c)) {
@@ -1055,10 +1339,10 @@ pub const TextBuffer = struct {
                         if (gp.isGraphemeChar(c)) {
                             const right_extent = gp.charRightExtent(c);
                             var k: u32 = 0;
-                            while (k < right_extent and chunk_char_index + 1 < chunk.chars.len) : (k += 1) {
+                            while (k < right_extent and chunk_char_index + 1 < chars.len) : (k += 1) {
                                 chunk_char_index += 1;
                                 // Verify the continuation character exists
-                                if (chunk_char_index >= chunk.chars.len or !gp.isContinuationChar(chunk.chars[chunk_char_index])) {
+                                if (chunk_char_index >= chars.len or !gp.isContinuationChar(chars[chunk_char_index])) {
                                     break;
                                 }
                             }
@@ -1075,6 +1359,7 @@ pub const TextBuffer = struct {
     /// This maps to StyledText.insert() operation
     pub fn insertChunkGroup(self: *TextBuffer, index: usize, text_bytes: []const u8, fg: ?RGBA, bg: ?RGBA, attr: ?u8) TextBufferError!u32 {
         if (text_bytes.len == 0) return self.char_count;
+        self.edit_generation +%= 1;
 
         // Save the current state to identify newly created chunks
         const old_line_count = self.lines.items.len;
@@ -1158,6 +1443,7 @@ pub const TextBuffer = struct {
         if (index >= self.chunk_groups.items.len) return TextBufferError.InvalidIndex;
 
         const chunk_group = self.chunk_groups.items[index];
+        self.edit_generation +%= 1;
 
         var i = chunk_group.chunk_refs.items.len;
         while (i > 0) {
@@ -0,0 +1,1002 @@
+const std = @import("std");
+const builtin = @import("builtin");
+const Allocator = std.mem.Allocator;
+const ansi = @import("ansi.zig");
+const buffer = @import("buffer.zig");
+const sgr = @import("sgr.zig");
+const DisplayWidth = @import("DisplayWidth");
+
+const RGBA = ansi.RGBA;
+const Attr = ansi.TextAttributes;
+const OptimizedBuffer = buffer.OptimizedBuffer;
+
+const MAX_PARAMS = sgr.MAX_PARAMS;
+/// Bytes parsed per lock; bounds how long a draw can wait on a busy reader
+const READ_CHUNK = 16 * 1024;
+const POLL_TIMEOUT_MS = 50;
+/// Query replies queued past this are dropped
+const MAX_RESPONSE_BYTES = 1024;
+
+/// Cell colors are packed as 0xRRGGBB with bit 24 set; 0 is the pane default
+const DEFAULT_COLOR: u32 = 0;
+/// Right half of a double-width character
+const WIDE_TAIL: u32 = 0;
+
+pub const MODE_APP_CURSOR: u32 = 1 << 0;
+pub const MODE_BRACKETED_PASTE: u32 = 1 << 1;
+pub const MODE_EXITED: u32 = 1 << 2;
+pub const MODE_SCROLLED_BACK: u32 = 1 << 3;
+
+/// DEC special graphics for 0x60...0x7E, selected with ESC ( 0
+const DEC_GRAPHICS = [31]u32{
+    0x25C6, 0x2592, 0x2409, 0x240C, 0x240D, 0x240A, 0x00B0, 0x00B1,
+    0x2424, 0x240B, 0x2518, 0x2510, 0x250C, 0x2514, 0x253C, 0x23BA,
+    0x23BB, 0x2500, 0x23BC, 0x23BD, 0x251C, 0x2524, 0x2534, 0x252C,
+    0x2502, 0x2264, 0x2265, 0x03C0, 0x2260, 0x00A3, 0x00B7,
+};
+
+pub const VtError = error{
+    InvalidDimensions,
+    AlreadyAttached,
+    Unsupported,
+    OutOfMemory,
+};
+
+pub const Stats = extern struct {
+    /// Rows written into the target by the last draw
+    drawn_rows: u32 = 0,
+    /// Bytes parsed between the previous draw and the last one
+    parsed_bytes: u32 = 0,
+    /// Rows held in the scrollback
+    history_rows: u32 = 0,
+};
+
+pub const Cell = struct {
+    char: u32 = ' ',
+    fg: u32 = DEFAULT_COLOR,
+    bg: u32 = DEFAULT_COLOR,
+    attributes: u8 = 0,
+    /// Left half of a double-width character; the next cell is WIDE_TAIL
+    wide: bool = false,
+};
+
+const State = enum(u8) {
+    ground,
+    escape,
+    /// ESC followed by an intermediate byte; the next byte ends it
+    escape_intermediate,
+    csi,
+    /// OSC, DCS, SOS, PM and APC: skipped up to BEL or ST
+    string,
+    string_escape,
+};
+
+const SavedCursor = struct {
+    x: u32 = 0,
+    y: u32 = 0,
+    pen: sgr.SgrParser = .{},
+    dec_graphics: bool = false,
+};
+
+fn packColor(color: ?RGBA) u32 {
+    const c = color orelse return DEFAULT_COLOR;
+    const r: u32 = @intFromFloat(std.math.clamp(c[0], 0.0, 1.0) * 255.0 + 0.5);
+    const g: u32 = @intFromFloat(std.math.clamp(c[1], 0.0, 1.0) * 255.0 + 0.5);
+    const b: u32 = @intFromFloat(std.math.clamp(c[2], 0.0, 1.0) * 255.0 + 0.5);
+    return 0x0100_0000 | (r << 16) | (g << 8) | b;
+}
+
+fn unpackColor(value: u32, default: RGBA) RGBA {
+    if (value == DEFAULT_COLOR) return default;
+    return .{
+        @as(f32, @floatFromInt((value >> 16) & 0xFF)) / 255.0,
+        @as(f32, @floatFromInt((value >> 8) & 0xFF)) / 255.0,
+        @as(f32, @floatFromInt(value & 0xFF)) / 255.0,
+        1.0,
+    };
+}
+
+/// Copy a row between grids of different widths, dropping a wide
+/// character cut in half by the new right edge
+fn copyRow(dst: []Cell, src: []const Cell) void {
+    const n = @min(dst.len, src.len);
+    @memcpy(dst[0..n], src[0..n]);
+    @memset(dst[n..], .{});
+    if (n > 0 and dst[n - 1].wide) dst[n - 1] = .{};
+}
+
+/// VT emulator for embedded terminal panes
+///
+/// Covers the xterm subset that shells and full-screen programs rely on:
+/// cursor movement, erase and insert/delete, scroll regions, SGR (parsed by
+/// sgr.zig), the alternate screen, DEC line drawing and the cursor and
+/// device status queries. Lines scrolled off the top of the main screen go
+/// into a fixed-capacity scrollback ring.
+///
+/// Once attached to a pty master, a background thread reads and parses the
+/// child's output in chunks of at most READ_CHUNK bytes under `mutex`, so a
+/// flood of output costs the UI thread nothing but the short wait for one
+/// chunk. Every change marks the rows it touched; `damaged` tells the UI
+/// thread a frame is due and `draw` repaints only the marked rows unless
+/// the caller asks for a full repaint.
+pub const Emulator = struct {
+    allocator: Allocator,
+    display_width: *const DisplayWidth,
+    cols: u32,
+    rows: u32,
+    primary: []Cell,
+    alternate: []Cell,
+    on_alternate: bool = false,
+
+    /// Scrollback ring of history_capacity rows, cols cells each
+    history: []Cell,
+    history_capacity: u32,
+    /// Slot of the oldest row
+    history_head: u32 = 0,
+    history_len: u32 = 0,
+    /// Rows the view is scrolled back into the history
+    view_offset: u32 = 0,
+
+    cursor_x: u32 = 0,
+    cursor_y: u32 = 0,
+    /// The last column was written; the next character wraps first
+    pending_wrap: bool = false,
+    saved: SavedCursor = .{},
+    scroll_top: u32 = 0,
+    /// Inclusive
+    scroll_bottom: u32,
+    autowrap: bool = true,
+    cursor_visible: bool = true,
+    app_cursor: bool = false,
+    bracketed_paste: bool = false,
+    dec_graphics: bool = false,
+
+    pen: sgr.SgrParser = .{},
+    pen_fg: u32 = DEFAULT_COLOR,
+    pen_bg: u32 = DEFAULT_COLOR,
+    pen_attributes: u8 = 0,
+
+    state: State = .ground,
+    params: [MAX_PARAMS]u32 = undefined,
+    subparams: u32 = 0,
+    param_count: u8 = 0,
+    /// Private marker of the CSI ('?', '>', ...) or 0
+    marker: u8 = 0,
+    /// Intermediate byte of the CSI or escape, or 0
+    intermediate: u8 = 0,
+    utf8_char: u32 = 0,
+    utf8_need: u8 = 0,
+
+    /// Viewport rows changed since the last draw
+    dirty_rows: []bool,
+    all_dirty: bool = true,
+    has_dirty: bool = true,
+    drawn_cursor_x: i64 = -1,
+    drawn_cursor_y: i64 = -1,
+    default_fg: RGBA = .{ 1.0, 1.0, 1.0, 1.0 },
+    default_bg: RGBA = .{ 0.0, 0.0, 0.0, 0.0 },
+
+    /// Replies to status queries, written back to the child by the reader
+    responses: std.ArrayListUnmanaged(u8) = .{},
+    pending_bytes: u32 = 0,
+
+    mutex: std.Thread.Mutex = .{},
+    thread: ?std.Thread = null,
+    fd: ?std.posix.fd_t = null,
+    stop: std.atomic.Value(bool) = std.atomic.Value(bool).init(false),
+    exited: std.atomic.Value(bool) = std.atomic.Value(bool).init(false),
+    /// Set when rows changed since the last draw; read without the lock
+    damaged: std.atomic.Value(bool) = std.atomic.Value(bool).init(true),
+
+    stats: Stats = .{},
+
+    pub fn create(allocator: Allocator, cols: u32, rows: u32, history_capacity: u32, display_width: *const DisplayWidth) VtError!*Emulator {
+        if (cols == 0 or rows == 0) return VtError.InvalidDimensions;
+        const cells = @as(usize, cols) * rows;
+
+        const self = try allocator.create(Emulator);
+        errdefer allocator.destroy(self);
+        const primary = try allocator.alloc(Cell, cells);
+        errdefer allocator.free(primary);
+        const alternate = try allocator.alloc(Cell, cells);
+        errdefer allocator.free(alternate);
+        const history = try allocator.alloc(Cell, @as(usize, history_capacity) * cols);
+        errdefer allocator.free(history);
+        const dirty_rows = try allocator.alloc(bool, rows);
+
+        @memset(primary, .{});
+        @memset(alternate, .{});
+        @memset(history, .{});
+        @memset(dirty_rows, false);
+
+        self.* = .{
+            .allocator = allocator,
+            .display_width = display_width,
+            .cols = cols,
+            .rows = rows,
+            .primary = primary,
+            .alternate = alternate,
+            .history = history,
+            .history_capacity = history_capacity,
+            .scroll_bottom = rows - 1,
+            .dirty_rows = dirty_rows,
+        };
+        return self;
+    }
+
+    pub fn destroy(self: *Emulator) void {
+        self.stop.store(true, .release);
+        if (self.thread) |thread| thread.join();
+        if (self.fd) |fd| std.posix.close(fd);
+        self.responses.deinit(self.allocator);
+        self.allocator.free(self.primary);
+        self.allocator.free(self.alternate);
+        self.allocator.free(self.history);
+        self.allocator.free(self.dirty_rows);
+        self.allocator.destroy(self);
+    }
+
+    /// Read and parse fd (a pty master) on a background thread. The
+    /// emulator owns fd from here on and closes it on destroy.
+    pub fn attach(self: *Emulator, fd: i32) !void {
+        if (builtin.os.tag == .windows) return VtError.Unsupported;
+        if (self.fd != null) return VtError.AlreadyAttached;
+        self.fd = fd;
+        errdefer self.fd = null;
+        self.thread = try std.Thread.spawn(.{}, readLoop, .{ self, fd });
+    }
+
+    fn readLoop(self: *Emulator, fd: std.posix.fd_t) void {
+        var chunk: [READ_CHUNK]u8 = undefined;
+        var replies: [MAX_RESPONSE_BYTES]u8 = undefined;
+        var fds = [_]std.posix.pollfd{.{ .fd = fd, .events = std.posix.POLL.IN, .revents = 0 }};
+        while (!self.stop.load(.acquire)) {
+            const ready = std.posix.poll(&fds, POLL_TIMEOUT_MS) catch break;
+            if (ready == 0) continue;
+            // A pty master reports EIO once the child side is closed
+            const n = std.posix.read(fd, &chunk) catch |err| switch (err) {
+                error.WouldBlock => continue,
+                else => break,
+            };
+            if (n == 0) break;
+
+            self.mutex.lock();
+            self.feedLocked(chunk[0..n]);
+            // Replies are written after unlocking: a child that is slow to
+            // read its input must not stall draws waiting on the lock
+            const reply_len = self.responses.items.len;
+            @memcpy(replies[0..reply_len], self.responses.items);
+            self.responses.clearRetainingCapacity();
+            self.mutex.unlock();
+
+            if (reply_len > 0) {
+                _ = std.posix.write(fd, replies[0..reply_len]) catch {};
+            }
+        }
+        self.exited.store(true, .release);
+        self.damaged.store(true, .release);
+    }
+
+    /// Parse output directly, for callers that read the child themselves
+    pub fn feed(self: *Emulator, bytes: []const u8) void {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        self.feedLocked(bytes);
+    }
+
+    fn feedLocked(self: *Emulator, bytes: []const u8) void {
+        const cursor_x = self.cursor_x;
+        const cursor_y = self.cursor_y;
+        for (bytes) |b| self.step(b);
+        self.pending_bytes +|= @intCast(@min(bytes.len, std.math.maxInt(u32)));
+        // A moved cursor needs a frame even if no cell changed
+        if (self.has_dirty or self.cursor_x != cursor_x or self.cursor_y != cursor_y) {
+            self.damaged.store(true, .release);
+        }
+    }
+
+    /// Send input to the child; typing returns a scrolled-back view to the
+    /// live screen
+    pub fn writeInput(self: *Emulator, bytes: []const u8) !void {
+        const fd = self.fd orelse return;
+        self.mutex.lock();
+        self.scrollViewLocked(-@as(i32, @intCast(self.view_offset)));
+        self.mutex.unlock();
+        var written: usize = 0;
+        while (written < bytes.len) {
+            written += try std.posix.write(fd, bytes[written..]);
+        }
+    }
+
+    pub fn hasDamage(self: *const Emulator) bool {
+        return self.damaged.load(.acquire);
+    }
+
+    pub fn modes(self: *Emulator) u32 {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        var bits: u32 = 0;
+        if (self.app_cursor) bits |= MODE_APP_CURSOR;
+        if (self.bracketed_paste) bits |= MODE_BRACKETED_PASTE;
+        if (self.exited.load(.acquire)) bits |= MODE_EXITED;
+        if (self.view_offset > 0) bits |= MODE_SCROLLED_BACK;
+        return bits;
+    }
+
+    /// Colors for cells the child left at their defaults
+    pub fn setColors(self: *Emulator, fg: RGBA, bg: RGBA) void {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        self.default_fg = fg;
+        self.default_bg = bg;
+        self.markAll();
+        self.damaged.store(true, .release);
+    }
+
+    /// Move the view into the scrollback; positive delta goes back in time
+    pub fn scrollView(self: *Emulator, delta: i32) void {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        self.scrollViewLocked(delta);
+    }
+
+    fn scrollViewLocked(self: *Emulator, delta: i32) void {
+        const limit: i64 = if (self.on_alternate) 0 else self.history_len;
+        const next: u32 = @intCast(std.math.clamp(@as(i64, self.view_offset) + delta, 0, limit));
+        if (next == self.view_offset) return;
+        self.view_offset = next;
+        self.markAll();
+        self.damaged.store(true, .release);
+    }
+
+    /// Resize the grids. Rows that no longer fit above the cursor move into
+    /// the scrollback; lines are cut, not rewrapped.
+    pub fn resize(self: *Emulator, cols: u32, rows: u32) VtError!void {
+        if (cols == 0 or rows == 0) return VtError.InvalidDimensions;
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        if (cols == self.cols and rows == self.rows) return;
+
+        const cells = @as(usize, cols) * rows;
+        const primary = try self.allocator.alloc(Cell, cells);
+        errdefer self.allocator.free(primary);
+        const alternate = try self.allocator.alloc(Cell, cells);
+        errdefer self.allocator.free(alternate);
+        const history = try self.allocator.alloc(Cell, @as(usize, self.history_capacity) * cols);
+        errdefer self.allocator.free(history);
+        const dirty_rows = try self.allocator.alloc(bool, rows);
+        @memset(primary, .{});
+        @memset(alternate, .{});
+        @memset(history, .{});
+        @memset(dirty_rows, false);
+
+        const old_cols = self.cols;
+        const old_rows = self.rows;
+        const old_primary = self.primary;
+        const old_alternate = self.alternate;
+        const old_history = self.history;
+
+        var i: u32 = 0;
+        while (i < self.history_len) : (i += 1) {
+            copyRow(history[@as(usize, i) * cols ..][0..cols], self.historyRow(self.history_head + i));
+        }
+        self.history = history;
+        self.history_head = 0;
+        self.cols = cols;
+        self.rows = rows;
+        self.view_offset = 0;
+
+        const shift: u32 = if (!self.on_alternate and self.cursor_y + 1 > rows) self.cursor_y + 1 - rows else 0;
+        var r: u32 = 0;
+        while (r < shift) : (r += 1) {
+            self.pushHistory(old_primary[@as(usize, r) * old_cols ..][0..old_cols]);
+        }
+        r = 0;
+        while (r < rows and r + shift < old_rows) : (r += 1) {
+            const src = @as(usize, r + shift) * old_cols;
+            const dst = @as(usize, r) * cols;
+            copyRow(primary[dst..][0..cols], old_primary[src..][0..old_cols]);
+            copyRow(alternate[dst..][0..cols], old_alternate[@as(usize, r) * old_cols ..][0..old_cols]);
+        }
+
+        self.allocator.free(old_primary);
+        self.allocator.free(old_alternate);
+        self.allocator.free(old_history);
+        self.allocator.free(self.dirty_rows);
+        self.primary = primary;
+        self.alternate = alternate;
+        self.dirty_rows = dirty_rows;
+
+        self.cursor_y = @min(self.cursor_y - shift, rows - 1);
+        self.cursor_x = @min(self.cursor_x, cols - 1);
+        self.pending_wrap = false;
+        self.scroll_top = 0;
+        self.scroll_bottom = rows - 1;
+        self.drawn_cursor_x = -1;
+        self.drawn_cursor_y = -1;
+        self.markAll();
+        self.damaged.store(true, .release);
+    }
+
+    /// Paint the view at (x, y). Without `full`, only rows changed since
+    /// the last draw are written, for targets that keep their cells.
+    pub fn draw(self: *Emulator, target: *OptimizedBuffer, x: i32, y: i32, full: bool, show_cursor: bool) !void {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        self.stats = .{
+            .parsed_bytes = self.pending_bytes,
+            .history_rows = self.history_len,
+        };
+        self.pending_bytes = 0;
+
+        const cursor_shown = show_cursor and self.cursor_visible and self.view_offset == 0;
+        const cursor_x: i64 = if (cursor_shown) self.cursor_x else -1;
+        const cursor_y: i64 = if (cursor_shown) self.cursor_y else -1;
+        if (cursor_x != self.drawn_cursor_x or cursor_y != self.drawn_cursor_y) {
+            if (self.drawn_cursor_y >= 0 and self.drawn_cursor_y < self.rows) self.dirty_rows[@intCast(self.drawn_cursor_y)] = true;
+            if (cursor_y >= 0) self.dirty_rows[@intCast(cursor_y)] = true;
+            self.drawn_cursor_x = cursor_x;
+            self.drawn_cursor_y = cursor_y;
+        }
+
+        var r: u32 = 0;
+        while (r < self.rows) : (r += 1) {
+            if (!full and !self.all_dirty and !self.dirty_rows[r]) continue;
+            const cy = @as(i64, y) + r;
+            if (cy < 0 or cy >= target.getHeight()) continue;
+            self.stats.drawn_rows += 1;
+
+            for (self.viewLine(r), 0..) |cell, c| {
+                if (cell.char == WIDE_TAIL) continue;
+                const col: i64 = @intCast(c);
+                const cx = @as(i64, x) + col;
+                if (cx < 0 or cx >= target.getWidth()) continue;
+                var attributes = cell.attributes;
+                if (cy - y == cursor_y and col == cursor_x) attributes ^= Attr.INVERSE;
+                const fg = unpackColor(cell.fg, self.default_fg);
+                const bg = unpackColor(cell.bg, self.default_bg);
+                if (cell.wide) {
+                    var utf8: [4]u8 = undefined;
+                    const len = std.unicode.utf8Encode(@intCast(cell.char), &utf8) catch continue;
+                    try target.drawText(utf8[0..len], @intCast(cx), @intCast(cy), fg, bg, attributes);
+                } else {
+                    try target.setCellWithAlphaBlending(@intCast(cx), @intCast(cy), cell.char, fg, bg, attributes);
+                }
+            }
+        }
+
+        @memset(self.dirty_rows, false);
+        self.all_dirty = false;
+        self.has_dirty = false;
+        self.damaged.store(false, .release);
+    }
+
+    // ---- Grid access ----
+
+    fn screen(self: *Emulator) []Cell {
+        return if (self.on_alternate) self.alternate else self.primary;
+    }
+
+    fn row(self: *Emulator, y: u32) []Cell {
+        return self.screen()[@as(usize, y) * self.cols ..][0..self.cols];
+    }
+
+    /// History row by age, 0 being the oldest
+    fn historyRow(self: *Emulator, index: u32) []Cell {
+        const slot = index % self.history_capacity;
+        return self.history[@as(usize, slot) * self.cols ..][0..self.cols];
+    }
+
+    /// Row r of the view, counting scrollback rows above the screen
+    fn viewLine(self: *Emulator, r: u32) []const Cell {
+        if (r < self.view_offset) {
+            return self.historyRow(self.history_head + self.history_len - self.view_offset + r);
+        }
+        return self.row(r - self.view_offset);
+    }
+
+    fn pushHistory(self: *Emulator, line: []const Cell) void {
+        if (self.history_capacity == 0) return;
+        if (self.history_len < self.history_capacity) {
+            copyRow(self.historyRow(self.history_head + self.history_len), line);
+            self.history_len += 1;
+        } else {
+            copyRow(self.historyRow(self.history_head), line);
+            self.history_head = (self.history_head + 1) % self.history_capacity;
+        }
+        // Keep a scrolled-back view on the same lines
+        if (self.view_offset > 0) {
+            self.view_offset = @min(self.view_offset + 1, self.history_len);
+            self.markAll();
+        }
+    }
+
+    fn markRow(self: *Emulator, y: u32) void {
+        const r = y + self.view_offset;
+        if (r < self.rows) self.dirty_rows[r] = true;
+        self.has_dirty = true;
+    }
+
+    fn markRows(self: *Emulator, top: u32, bottom: u32) void {
+        var y = top;
+        while (y <= bottom) : (y += 1) self.markRow(y);
+    }
+
+    fn markAll(self: *Emulator) void {
+        self.all_dirty = true;
+        self.has_dirty = true;
+    }
+
+    fn blankCell(self: *const Emulator) Cell {
+        return .{ .bg = self.pen_bg };
+    }
+
+    /// Blank the other half of a wide character at x before x is overwritten
+    fn splitWide(self: *Emulator, line: []Cell, x: u32) void {
+        if (line[x].wide and x + 1 < line.len) {
+            line[x + 1] = self.blankCell();
+        } else if (line[x].char == WIDE_TAIL and x > 0) {
+            line[x - 1] = self.blankCell();
+        }
+    }
+
+    fn eraseCells(self: *Emulator, y: u32, from: u32, to: u32) void {
+        if (from >= to) return;
+        const line = self.row(y);
+        self.splitWide(line, from);
+        self.splitWide(line, to - 1);
+        @memset(line[from..to], self.blankCell());
+        self.markRow(y);
+    }
+
+    fn eraseRows(self: *Emulator, top: u32, bottom: u32) void {
+        var y = top;
+        while (y < bottom) : (y += 1) self.eraseCells(y, 0, self.cols);
+    }
+
+    // ---- Parser ----
+
+    fn step(self: *Emulator, b: u8) void {
+        switch (self.state) {
+            .ground => self.ground(b),
+            .escape => self.escape(b),
+            .escape_intermediate => {
+                // ESC ( 0 and ESC ( B switch G0 between line drawing and ASCII
+                if (self.intermediate == '(') self.dec_graphics = b == '0';
+                self.state = .ground;
+            },
+            .csi => self.csi(b),
+            .string => switch (b) {
+                0x07 => self.state = .ground,
+                0x1B => self.state = .string_escape,
+                else => {},
+            },
+            .string_escape => self.state = if (b == '\\') .ground else .string,
+        }
+    }
+
+    fn ground(self: *Emulator, b: u8) void {
+        if (self.utf8_need > 0) {
+            if (b & 0xC0 == 0x80) {
+                self.utf8_char = (self.utf8_char << 6) | (b & 0x3F);
+                self.utf8_need -= 1;
+                if (self.utf8_need == 0) self.print(if (self.utf8_char > 0x10FFFF) 0xFFFD else self.utf8_char);
+                return;
+            }
+            // Broken sequence: replace it and handle b on its own
+            self.utf8_need = 0;
+            self.print(0xFFFD);
+        }
+        switch (b) {
+            0x08 => {
+                if (self.cursor_x > 0) self.cursor_x -= 1;
+                self.pending_wrap = false;
+            },
+            0x09 => {
+                self.cursor_x = @min(self.cols - 1, (self.cursor_x / 8 + 1) * 8);
+                self.pending_wrap = false;
+            },
+            0x0A, 0x0B, 0x0C => self.lineFeed(),
+            0x0D => {
+                self.cursor_x = 0;
+                self.pending_wrap = false;
+            },
+            0x1B => self.state = .escape,
+            0x00...0x07, 0x0E...0x1A, 0x1C...0x1F, 0x7F => {},
+            0x20...0x7E => self.print(b),
+            0xC0...0xDF => {
+                self.utf8_char = b & 0x1F;
+                self.utf8_need = 1;
+            },
+            0xE0...0xEF => {
+                self.utf8_char = b & 0x0F;
+                self.utf8_need = 2;
+            },
+            0xF0...0xF7 => {
+                self.utf8_char = b & 0x07;
+                self.utf8_need = 3;
+            },
+            else => self.print(0xFFFD),
+        }
+    }
+
+    fn charWidth(self: *const Emulator, c: u32) u32 {
+        if (c < 0x7F) return 1;
+        const w = self.display_width.codePointWidth(@intCast(c));
+        return if (w <= 0) 0 else @min(2, @as(u32, @intCast(w)));
+    }
+
+    fn print(self: *Emulator, char: u32) void {
+        var c = char;
+        if (self.dec_graphics and c >= 0x60 and c <= 0x7E) c = DEC_GRAPHICS[c - 0x60];
+        // Combining marks have no cell of their own and are dropped
+        const width = self.charWidth(c);
+        if (width == 0) return;
+        if (width > self.cols) return;
+
+        if (self.pending_wrap and self.autowrap) {
+            self.cursor_x = 0;
+            self.lineFeed();
+        }
+        self.pending_wrap = false;
+        // A wide character that doesn't fit wraps as a whole
+        if (self.cursor_x + width > self.cols) {
+            if (self.autowrap) {
+                self.eraseCells(self.cursor_y, self.cursor_x, self.cols);
+                self.cursor_x = 0;
+                self.lineFeed();
+            } else {
+                self.cursor_x = self.cols - width;
+            }
+        }
+
+        const line = self.row(self.cursor_y);
+        const x = self.cursor_x;
+        if (width == 2) self.splitWide(line, x + 1);
+        self.splitWide(line, x);
+        line[x] = .{ .char = c, .fg = self.pen_fg, .bg = self.pen_bg, .attributes = self.pen_attributes, .wide = width == 2 };
+        if (width == 2) {
+            line[x + 1] = .{ .char = WIDE_TAIL, .fg = self.pen_fg, .bg = self.pen_bg, .attributes = self.pen_attributes };
+        }
+        self.markRow(self.cursor_y);
+
+        if (x + width >= self.cols) {
+            self.cursor_x = self.cols - 1;
+            self.pending_wrap = true;
+        } else {
+            self.cursor_x = x + width;
+        }
+    }
+
+    fn escape(self: *Emulator, b: u8) void {
+        self.state = .ground;
+        switch (b) {
+            '[' => {
+                self.state = .csi;
+                self.param_count = 0;
+                self.subparams = 0;
+                self.marker = 0;
+                self.intermediate = 0;
+            },
+            ']', 'P', 'X', '^', '_' => self.state = .string,
+            0x20...0x2F => {
+                self.intermediate = b;
+                self.state = .escape_intermediate;
+            },
+            '7' => self.saveCursor(),
+            '8' => self.restoreCursor(),
+            'D' => self.lineFeed(),
+            'E' => {
+                self.cursor_x = 0;
+                self.lineFeed();
+            },
+            'M' => self.reverseIndex(),
+            'c' => self.fullReset(),
+            0x1B => self.state = .escape,
+            // Keypad modes and other two-byte escapes
+            else => {},
+        }
+    }
+
+    fn csi(self: *Emulator, b: u8) void {
+        switch (b) {
+            '0'...'9' => {
+                if (self.param_count == 0) self.pushParam(false);
+                const p = &self.params[self.param_count - 1];
+                p.* = @min(p.* *| 10 +| (b - '0'), 0xFFFF);
+            },
+            ';', ':' => {
+                if (self.param_count == 0) self.pushParam(false);
+                self.pushParam(b == ':');
+            },
+            '<', '=', '>', '?' => self.marker = b,
+            0x20...0x2F => self.intermediate = b,
+            0x40...0x7E => {
+                self.state = .ground;
+                self.dispatchCsi(b);
+            },
+            0x1B => self.state = .escape,
+            0x18, 0x1A => self.state = .ground,
+            else => {},
+        }
+    }
+
+    fn pushParam(self: *Emulator, sub: bool) void {
+        if (self.param_count == MAX_PARAMS) return;
+        self.params[self.param_count] = 0;
+        if (sub) self.subparams |= @as(u32, 1) << @intCast(self.param_count);
+        self.param_count += 1;
+    }
+
+    /// Param i, with 0 or a missing param meaning default
+    fn param(self: *const Emulator, i: usize, default: u32) u32 {
+        if (i >= self.param_count or self.params[i] == 0) return default;
+        return self.params[i];
+    }
+
+    fn dispatchCsi(self: *Emulator, final: u8) void {
+        // Cursor style (CSI SP q), soft reset and the like
+        if (self.intermediate != 0) return;
+        if (self.marker == '?') {
+            switch (final) {
+                'h' => self.setPrivateModes(true),
+                'l' => self.setPrivateModes(false),
+                else => {},
+            }
+            return;
+        }
+        if (self.marker == '>') {
+            if (final == 'c') self.respond("\x1b[>0;10;1c");
+            return;
+        }
+        if (self.marker != 0) return;
+
+        const n = self.param(0, 1);
+        switch (final) {
+            '@' => self.insertChars(n),
+            'A' => {
+                const top: u32 = if (self.cursor_y >= self.scroll_top) self.scroll_top else 0;
+                self.setCursor(self.cursor_x, @max(top, self.cursor_y -| n));
+            },
+            'B', 'e' => {
+                const bottom: u32 = if (self.cursor_y <= self.scroll_bottom) self.scroll_bottom else self.rows - 1;
+                self.setCursor(self.cursor_x, @min(bottom, self.cursor_y +| n));
+            },
+            'C', 'a' => self.setCursor(self.cursor_x +| n, self.cursor_y),
+            'D' => self.setCursor(self.cursor_x -| n, self.cursor_y),
+            'E' => self.setCursor(0, self.cursor_y +| n),
+            'F' => self.setCursor(0, self.cursor_y -| n),
+            'G', '`' => self.setCursor(n - 1, self.cursor_y),
+            'H', 'f' => self.setCursor(self.param(1, 1) - 1, n - 1),
+            'd' => self.setCursor(self.cursor_x, n - 1),
+            'J' => self.eraseDisplay(self.param(0, 0)),
+            'K' => switch (self.param(0, 0)) {
+                0 => self.eraseCells(self.cursor_y, self.cursor_x, self.cols),
+                1 => self.eraseCells(self.cursor_y, 0, self.cursor_x + 1),
+                else => self.eraseCells(self.cursor_y, 0, self.cols),
+            },
+            'L' => if (self.inScrollRegion()) {
+                self.scrollDown(self.cursor_y, self.scroll_bottom, n);
+                self.setCursor(0, self.cursor_y);
+            },
+            'M' => if (self.inScrollRegion()) {
+                self.scrollUp(self.cursor_y, self.scroll_bottom, n, false);
+                self.setCursor(0, self.cursor_y);
+            },
+            'P' => self.deleteChars(n),
+            'S' => self.scrollUp(self.scroll_top, self.scroll_bottom, n, true),
+            'T' => self.scrollDown(self.scroll_top, self.scroll_bottom, n),
+            'X' => self.eraseCells(self.cursor_y, self.cursor_x, @min(self.cols, self.cursor_x +| n)),
+            'm' => {
+                self.pen.applyParams(self.params[0..self.param_count], self.subparams);
+                self.updatePen();
+            },
+            'r' => {
+                const top = self.param(0, 1) - 1;
+                const bottom = @min(self.param(1, self.rows), self.rows) - 1;
+                if (top < bottom) {
+                    self.scroll_top = top;
+                    self.scroll_bottom = bottom;
+                    self.setCursor(0, 0);
+                }
+            },
+            's' => self.saveCursor(),
+            'u' => self.restoreCursor(),
+            'n' => switch (self.param(0, 0)) {
+                5 => self.respond("\x1b[0n"),
+                6 => {
+                    var reply: [32]u8 = undefined;
+                    const text = std.fmt.bufPrint(&reply, "\x1b[{d};{d}R", .{ self.cursor_y + 1, self.cursor_x + 1 }) catch return;
+                    self.respond(text);
+                },
+                else => {},
+            },
+            'c' => if (self.param(0, 0) == 0) self.respond("\x1b[?62;22c"),
+            else => {},
+        }
+    }
+
+    fn setPrivateModes(self: *Emulator, on: bool) void {
+        for (self.params[0..self.param_count]) |mode| {
+            switch (mode) {
+                1 => self.app_cursor = on,
+                7 => self.autowrap = on,
+                25 => {
+                    self.cursor_visible = on;
+                    self.markRow(self.cursor_y);
+                },
+                47, 1047 => self.switchScreen(on),
+                1049 => if (on) {
+                    self.saveCursor();
+                    self.switchScreen(true);
+                } else {
+                    self.switchScreen(false);
+                    self.restoreCursor();
+                },
+                2004 => self.bracketed_paste = on,
+                else => {},
+            }
+        }
+    }
+
+    fn respond(self: *Emulator, bytes: []const u8) void {
+        if (self.fd == null) return;
+        if (self.responses.items.len + bytes.len > MAX_RESPONSE_BYTES) return;
+        self.responses.appendSlice(self.allocator, bytes) catch {};
+    }
+
+    fn updatePen(self: *Emulator) void {
+        self.pen_fg = packColor(self.pen.fg);
+        self.pen_bg = packColor(self.pen.bg);
+        self.pen_attributes = self.pen.attributes orelse 0;
+    }
+
+    // ---- Operations ----
+
+    fn setCursor(self: *Emulator, x: u32, y: u32) void {
+        self.cursor_x = @min(x, self.cols - 1);
+        self.cursor_y = @min(y, self.rows - 1);
+        self.pending_wrap = false;
+    }
+
+    fn inScrollRegion(self: *const Emulator) bool {
+        return self.cursor_y >= self.scroll_top and self.cursor_y <= self.scroll_bottom;
+    }
+
+    fn lineFeed(self: *Emulator) void {
+        if (self.cursor_y == self.scroll_bottom) {
+            self.scrollUp(self.scroll_top, self.scroll_bottom, 1, true);
+        } else if (self.cursor_y + 1 < self.rows) {
+            self.cursor_y += 1;
+        }
+        self.pending_wrap = false;
+    }
+
+    fn reverseIndex(self: *Emulator) void {
+        if (self.cursor_y == self.scroll_top) {
+            self.scrollDown(self.scroll_top, self.scroll_bottom, 1);
+        } else if (self.cursor_y > 0) {
+            self.cursor_y -= 1;
+        }
+        self.pending_wrap = false;
+    }
+
+    /// Move rows top..bottom up by count; with `save`, rows leaving the top
+    /// of the main screen go to the scrollback
+    fn scrollUp(self: *Emulator, top: u32, bottom: u32, count: u32, save: bool) void {
+        const n = @min(count, bottom - top + 1);
+        if (save and top == 0 and !self.on_alternate) {
+            var i: u32 = 0;
+            while (i < n) : (i += 1) self.pushHistory(self.row(i));
+        }
+        const grid = self.screen();
+        const cols: usize = self.cols;
+        const start = top * cols;
+        const end = (@as(usize, bottom) + 1) * cols;
+        const moved = n * cols;
+        std.mem.copyForwards(Cell, grid[start .. end - moved], grid[start + moved .. end]);
+        @memset(grid[end - moved .. end], self.blankCell());
+        self.markRows(top, bottom);
+    }
+
+    fn scrollDown(self: *Emulator, top: u32, bottom: u32, count: u32) void {
+        const n = @min(count, bottom - top + 1);
+        const grid = self.screen();
+        const cols: usize = self.cols;
+        const start = top * cols;
+        const end = (@as(usize, bottom) + 1) * cols;
+        const moved = n * cols;
+        std.mem.copyBackwards(Cell, grid[start + moved .. end], grid[start .. end - moved]);
+        @memset(grid[start .. start + moved], self.blankCell());
+        self.markRows(top, bottom);
+    }
+
+    fn insertChars(self: *Emulator, count: u32) void {
+        const line = self.row(self.cursor_y);
+        const x = self.cursor_x;
+        const n = @min(count, self.cols - x);
+        self.splitWide(line, x);
+        std.mem.copyBackwards(Cell, line[x + n ..], line[x .. self.cols - n]);
+        @memset(line[x .. x + n], self.blankCell());
+        if (line[self.cols - 1].wide) line[self.cols - 1] = self.blankCell();
+        self.markRow(self.cursor_y);
+        self.pending_wrap = false;
+    }
+
+    fn deleteChars(self: *Emulator, count: u32) void {
+        const line = self.row(self.cursor_y);
+        const x = self.cursor_x;
+        const n = @min(count, self.cols - x);
+        self.splitWide(line, x);
+        std.mem.copyForwards(Cell, line[x .. self.cols - n], line[x + n ..]);
+        @memset(line[self.cols - n ..], self.blankCell());
+        if (line[x].char == WIDE_TAIL) line[x] = self.blankCell();
+        self.markRow(self.cursor_y);
+        self.pending_wrap = false;
+    }
+
+    fn eraseDisplay(self: *Emulator, mode: u32) void {
+        switch (mode) {
+            0 => {
+                self.eraseCells(self.cursor_y, self.cursor_x, self.cols);
+                self.eraseRows(self.cursor_y + 1, self.rows);
+            },
+            1 => {
+                self.eraseRows(0, self.cursor_y);
+                self.eraseCells(self.cursor_y, 0, self.cursor_x + 1);
+            },
+            2 => self.eraseRows(0, self.rows),
+            3 => {
+                self.history_len = 0;
+                self.history_head = 0;
+                self.view_offset = 0;
+                self.markAll();
+            },
+            else => {},
+        }
+    }
+
+    fn switchScreen(self: *Emulator, alternate: bool) void {
+        if (alternate == self.on_alternate) return;
+        self.on_alternate = alternate;
+        if (alternate) @memset(self.alternate, .{});
+        self.view_offset = 0;
+        self.markAll();
+    }
+
+    fn saveCursor(self: *Emulator) void {
+        self.saved = .{
+            .x = self.cursor_x,
+            .y = self.cursor_y,
+            .pen = self.pen,
+            .dec_graphics = self.dec_graphics,
+        };
+    }
+
+    fn restoreCursor(self: *Emulator) void {
+        self.pen = self.saved.pen;
+        self.dec_graphics = self.saved.dec_graphics;
+        self.updatePen();
+        self.setCursor(self.saved.x, self.saved.y);
+    }
+
+    fn fullReset(self: *Emulator) void {
+        self.on_alternate = false;
+        @memset(self.primary, .{});
+        self.view_offset = 0;
+        self.cursor_x = 0;
+        self.cursor_y = 0;
+        self.pending_wrap = false;
+        self.saved = .{};
+        self.scroll_top = 0;
+        self.scroll_bottom = self.rows - 1;
+        self.autowrap = true;
+        self.cursor_visible = true;
+        self.app_cursor = false;
+        self.bracketed_paste = false;
+        self.dec_graphics = false;
+        self.pen = .{};
+        self.updatePen();
+        self.markAll();
+    }
+};
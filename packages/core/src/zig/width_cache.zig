@@ -0,0 +1,93 @@
+const std = @import("std");
+const Graphemes = @import("Graphemes");
+const DisplayWidth = @import("DisplayWidth");
+const gwidth = @import("gwidth.zig");
+
+/// Display-width cache for grapheme clusters
+///
+/// drawText, TextBuffer.writeChunk and text measurement run gwidth on every
+/// cluster, while most text reuses a small set of them (CJK, box drawing,
+/// icons). Each WidthMethod gets a small direct-mapped table. Clusters of up
+/// to 7 bytes are packed verbatim into the slot tag, so a hit is exact and a
+/// slot is a single u64 that is read and written atomically. Longer clusters
+/// (ZWJ sequences, flags) bypass the cache.
+///
+/// Every caller gets its width data from the process-wide unicode data, so the
+/// tables are shared across buffers, text buffers and measurement.
+pub const SLOT_BITS = 10;
+pub const SLOT_COUNT = 1 << SLOT_BITS;
+pub const MAX_CACHED_LEN = 7;
+
+/// Counters are not synchronized; they are exact when one thread draws
+pub const Stats = extern struct {
+    hits: u64 = 0,
+    misses: u64 = 0,
+    uncached: u64 = 0,
+};
+
+const METHOD_COUNT = @typeInfo(gwidth.WidthMethod).@"enum".fields.len;
+
+var tables: [METHOD_COUNT][SLOT_COUNT]u64 = [_][SLOT_COUNT]u64{[_]u64{0} ** SLOT_COUNT} ** METHOD_COUNT;
+var stats: Stats = .{};
+
+fn packKey(bytes: []const u8) u64 {
+    var key: u64 = 0;
+    for (bytes, 0..) |b, i| {
+        key |= @as(u64, b) << @intCast(i * 8);
+    }
+    return key;
+}
+
+/// Width of one grapheme cluster; same result as gwidth.gwidth
+pub fn clusterWidth(bytes: []const u8, method: gwidth.WidthMethod, data: *const DisplayWidth) u16 {
+    if (bytes.len == 0 or bytes.len > MAX_CACHED_LEN) {
+        stats.uncached += 1;
+        return gwidth.gwidth(bytes, method, data);
+    }
+    const key = packKey(bytes);
+    // An all-NUL cluster would look like an empty slot
+    if (key == 0) {
+        stats.uncached += 1;
+        return gwidth.gwidth(bytes, method, data);
+    }
+
+    const index: usize = @intCast((key *% 0x9E3779B97F4A7C15) >> (64 - SLOT_BITS));
+    const slot = &tables[@intFromEnum(method)][index];
+    const entry = @atomicLoad(u64, slot, .monotonic);
+    if (entry >> 8 == key) {
+        stats.hits += 1;
+        return @intCast(entry & 0xff);
+    }
+
+    stats.misses += 1;
+    const width = gwidth.gwidth(bytes, method, data);
+    if (width <= 0xff) {
+        @atomicStore(u64, slot, (key << 8) | width, .monotonic);
+    }
+    return width;
+}
+
+/// Width of a run of text, measured cluster by cluster through the cache
+pub fn textWidth(text: []const u8, method: gwidth.WidthMethod, graphemes_data: *const Graphemes, data: *const DisplayWidth) u32 {
+    var total: u32 = 0;
+    var iter = graphemes_data.iterator(text);
+    while (iter.next()) |gc| {
+        total += clusterWidth(gc.bytes(text), method, data);
+    }
+    return total;
+}
+
+pub fn getStats() Stats {
+    return stats;
+}
+
+pub fn resetStats() void {
+    stats = .{};
+}
+
+/// Drop all cached widths (tests, or after swapping unicode data)
+pub fn clear() void {
+    for (&tables) |*table| {
+        @memset(table, 0);
+    }
+}